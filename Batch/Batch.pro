@@ -0,0 +1,55 @@
+TEMPLATE = app
+TARGET = gcead-batch
+QT += xml svg concurrent sql
+QT -= widgets
+CONFIG += console warn_on link_prl
+CONFIG -= app_bundle
+
+HEADERS += \
+	BatchJob.h
+SOURCES += \
+	BatchJob.cpp \
+	./main.cpp
+
+unix:!macx {
+	QMAKE_CFLAGS += -static-libgcc
+	QMAKE_CXXFLAGS += -static-libgcc
+	QMAKE_LFLAGS += -static-libgcc
+}
+
+win32:CONFIG(release, debug|release): LIBS += \
+    -L$$OUT_PWD/../Model/release/ -lModel \
+    -L$$OUT_PWD/../Filters/release/ -lFilters \
+    -L$$OUT_PWD/../Core/release/ -lCore
+else:win32:CONFIG(debug, debug|release): LIBS += \
+    -L$$OUT_PWD/../Model/debug/ -lModel \
+    -L$$OUT_PWD/../Filters/debug/ -lFilters \
+    -L$$OUT_PWD/../Core/debug/ -lCore
+else:unix: LIBS += \
+    -L$$OUT_PWD/../Model/ -lModel \
+    -L$$OUT_PWD/../Filters/ -lFilters \
+    -L$$OUT_PWD/../Core/ -lCore
+
+INCLUDEPATH += \
+    $$PWD/.. \
+    $$PWD/../Model \
+    $$PWD/../Filters \
+    $$PWD/../Core
+DEPENDPATH += \
+    $$PWD/.. \
+    $$PWD/../Model \
+    $$PWD/../Filters \
+    $$PWD/../Core
+
+win32-g++:CONFIG(release, debug|release): PRE_TARGETDEPS += \
+    $$OUT_PWD/../Model/release/libModel.a \
+    $$OUT_PWD/../Filters/release/libFilters.a \
+    $$OUT_PWD/../Core/release/libCore.a
+else:win32-g++:CONFIG(debug, debug|release): PRE_TARGETDEPS += \
+    $$OUT_PWD/../Model/debug/libModel.a \
+    $$OUT_PWD/../Filters/debug/libFilters.a \
+    $$OUT_PWD/../Core/debug/libCore.a
+else:unix: PRE_TARGETDEPS += \
+    $$OUT_PWD/../Model/libModel.a \
+    $$OUT_PWD/../Filters/libFilters.a \
+    $$OUT_PWD/../Core/libCore.a
@@ -0,0 +1,224 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "BatchJob.h"
+
+#include <math.h>
+
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QMutexLocker>
+
+#include <Check.h>
+
+#include <ChartPixmap.h>
+#include <EadFile.h>
+#include <FilterInfo.h>
+#include <RecInfo.h>
+#include <ViewInfo.h>
+#include <WaveInfo.h>
+
+
+void BatchSummary::add(const BatchResult& result)
+{
+	QMutexLocker locker(&m_mutex);
+	m_results << result;
+}
+
+QList<BatchResult> BatchSummary::results() const
+{
+	QMutexLocker locker(&m_mutex);
+	return m_results;
+}
+
+
+BatchJob::BatchJob(const QString& sInputFile, const QString& sOutputBase, const BatchOptions& options, BatchSummary* summary)
+	: m_sInputFile(sInputFile), m_sOutputBase(sOutputBase), m_options(options), m_summary(summary)
+{
+	setAutoDelete(true);
+}
+
+void BatchJob::run()
+{
+	BatchResult result;
+	result.sInputFile = m_sInputFile;
+
+	// Keep a bad file from taking down the rest of the batch
+	try
+	{
+		process(result);
+	}
+	catch (...)
+	{
+		result.errors << QObject::tr("unexpected error while processing the file");
+	}
+
+	m_summary->add(result);
+}
+
+void BatchJob::process(BatchResult& result)
+{
+	QFileInfo fi(m_sOutputBase);
+	if (!QDir().mkpath(fi.absolutePath()))
+	{
+		result.errors << QObject::tr("could not create output directory %0").arg(fi.absolutePath());
+		return;
+	}
+
+	// The file is created on this thread and never leaves it
+	EadFile file;
+	LoadSaveResult loadResult = file.load(m_sInputFile);
+	if (loadResult != LoadSaveResult_Ok && loadResult != LoadSaveResult_ImportedOldEad)
+	{
+		result.errors << QObject::tr("could not load file (error %0)").arg(int(loadResult));
+		return;
+	}
+
+	if (m_options.bUpgrade)
+	{
+		upgrade(&file, loadResult, result);
+		return;
+	}
+
+	applyFilters(&file);
+
+	if (m_options.bExportData)
+	{
+		QString s = m_sOutputBase + ".csv";
+		QString sError;
+		if (file.exportData(s, &sError))
+			result.outputs << s;
+		else
+			result.errors << QObject::tr("could not export data to %0: %1").arg(s).arg(sError);
+	}
+	if (m_options.bExportNumpy)
+	{
+		QString s = m_sOutputBase + ".npz";
+		QString sError;
+		if (file.exportNumpy(s, &sError))
+			result.outputs << s;
+		else
+			result.errors << QObject::tr("could not export data to %0: %1").arg(s).arg(sError);
+	}
+	if (m_options.bExportAmplitudes)
+	{
+		QString s = m_sOutputBase + "-amplitudes.csv";
+		if (file.exportAmplitudeData(s))
+			result.outputs << s;
+		else
+			result.errors << QObject::tr("could not export amplitudes to %0").arg(s);
+	}
+	if (m_options.bExportRetention)
+	{
+		QString s = m_sOutputBase + "-retention.csv";
+		if (file.exportRetentionData(s))
+			result.outputs << s;
+		else
+			result.errors << QObject::tr("could not export retention times to %0").arg(s);
+	}
+
+	if (m_options.bRenderCharts)
+	{
+		renderChart(&file, EadView_Averages, "-averages", result);
+		renderChart(&file, EadView_EADs, "-eads", result);
+		renderChart(&file, EadView_FIDs, "-fids", result);
+		renderChart(&file, EadView_All, "-all", result);
+	}
+}
+
+void BatchJob::upgrade(EadFile* file, LoadSaveResult loadResult, BatchResult& result)
+{
+	// Files in the current format are left alone
+	if (loadResult != LoadSaveResult_ImportedOldEad)
+	{
+		result.bSkipped = true;
+		return;
+	}
+
+	QString s = m_sOutputBase + ".ead";
+	// Never replace the original archive
+	if (QFileInfo(s).absoluteFilePath() == QFileInfo(m_sInputFile).absoluteFilePath())
+		result.errors << QObject::tr("converting to %0 would overwrite the original file").arg(s);
+	else if (file->saveAs(s))
+		result.outputs << s;
+	else
+		result.errors << QObject::tr("could not save %0").arg(s);
+}
+
+/// Apply the requested filters and redo everything that depends on the display data,
+/// just as EadFile::load() does for the filters stored in the file.
+void BatchJob::applyFilters(EadFile* file)
+{
+	if (m_options.nEadFilterId < 0 && m_options.nFidFilterId < 0)
+		return;
+
+	FilterTesterInfo* filterEad = file->filters()[0];
+	FilterTesterInfo* filterFid = file->filters()[1];
+	if (m_options.nEadFilterId >= 0 && m_options.nEadFilterId <= filterEad->filterCount())
+		filterEad->setFilterId(m_options.nEadFilterId);
+	if (m_options.nFidFilterId >= 0 && m_options.nFidFilterId <= filterFid->filterCount())
+		filterFid->setFilterId(m_options.nFidFilterId);
+
+	file->updateDisplay();
+	file->updateAveWaves();
+
+	foreach (RecInfo* rec, file->recs())
+	{
+		rec->fid()->findFidPeaks();
+		rec->fid()->calcPeakAreas();
+	}
+}
+
+void BatchJob::renderChart(EadFile* file, EadView viewType, const QString& sSuffix, BatchResult& result)
+{
+	ViewInfo* view = file->viewInfo(viewType);
+	CHECK_ASSERT_RET(view != NULL);
+
+	// Find the end of the longest visible wave so that the whole run fits onto the chart
+	int tidxEnd = 0;
+	foreach (ViewWaveInfo* vwi, view->allVwis())
+	{
+		const WaveInfo* wave = vwi->wave();
+		if (vwi->isVisible() && !wave->display.isEmpty())
+			tidxEnd = qMax(tidxEnd, wave->shift() + wave->display.size());
+	}
+	// Nothing to draw
+	if (tidxEnd == 0)
+		return;
+
+	ChartPixmapParams params;
+	params.file = file;
+	params.view = view;
+	params.task = EadTask_Publish;
+	params.size = m_options.chartSize;
+	params.nSecondsPerDivision = qMax(1.0, ceil(double(tidxEnd) / EAD_SAMPLES_PER_SECOND / params.nCols));
+
+	QImage image(params.size, QImage::Format_RGB32);
+	image.fill(Qt::white);
+
+	ChartPixmap cp;
+	cp.draw(&image, params);
+
+	QRect rc = cp.borderRect();
+	rc.adjust(-1, -1, 1, 1);
+	QString s = m_sOutputBase + sSuffix + ".png";
+	if (image.copy(rc).save(s))
+		result.outputs << s;
+	else
+		result.errors << QObject::tr("could not save chart to %0").arg(s);
+}
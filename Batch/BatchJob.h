@@ -0,0 +1,125 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __BATCHJOB_H
+#define __BATCHJOB_H
+
+#include <QList>
+#include <QMutex>
+#include <QRunnable>
+#include <QSize>
+#include <QString>
+#include <QStringList>
+
+#include <EadEnums.h>
+
+
+class EadFile;
+
+
+/// Options which apply to every file of a batch run
+class BatchOptions
+{
+public:
+	/// Directory in which all output files are written
+	QString sOutputDir;
+	/// Filter to use for EAD waves, or -1 to keep the filter saved in the file
+	int nEadFilterId;
+	/// Filter to use for FID waves, or -1 to keep the filter saved in the file
+	int nFidFilterId;
+	bool bExportData;
+	bool bExportAmplitudes;
+	bool bExportRetention;
+	/// Also export the wave data as a NumPy .npz archive
+	bool bExportNumpy;
+	bool bRenderCharts;
+	/// Size of the rendered chart images
+	QSize chartSize;
+	/// Only convert files in the old "BcV" format to the current format, and skip everything else
+	bool bUpgrade;
+
+	BatchOptions()
+	{
+		nEadFilterId = -1;
+		nFidFilterId = -1;
+		bExportData = true;
+		bExportAmplitudes = true;
+		bExportRetention = true;
+		bExportNumpy = false;
+		bRenderCharts = true;
+		chartSize = QSize(1600, 1000);
+		bUpgrade = false;
+	}
+};
+
+
+/// Outcome of processing a single file
+class BatchResult
+{
+public:
+	QString sInputFile;
+	QStringList outputs;
+	QStringList errors;
+	/// True if there was nothing to do for this file
+	bool bSkipped;
+
+	BatchResult() : bSkipped(false) {}
+
+	bool isOk() const { return errors.isEmpty(); }
+};
+
+
+/// Thread-safe collection of the results of all jobs in a batch run
+class BatchSummary
+{
+public:
+	void add(const BatchResult& result);
+	QList<BatchResult> results() const;
+
+private:
+	mutable QMutex m_mutex;
+	QList<BatchResult> m_results;
+};
+
+
+/// Processes a single .ead file on a worker thread.
+/// Each job owns its own EadFile, so a failure in one file never affects
+/// the processing of any other.
+class BatchJob : public QRunnable
+{
+public:
+	/// @param sOutputBase path of the output files without suffix, e.g. "out/run1"
+	BatchJob(const QString& sInputFile, const QString& sOutputBase, const BatchOptions& options, BatchSummary* summary);
+
+// QRunnable overrides
+public:
+	void run();
+
+private:
+	void process(BatchResult& result);
+	void applyFilters(EadFile* file);
+	void upgrade(EadFile* file, LoadSaveResult loadResult, BatchResult& result);
+	void renderChart(EadFile* file, EadView viewType, const QString& sSuffix, BatchResult& result);
+
+private:
+	const QString m_sInputFile;
+	const QString m_sOutputBase;
+	const BatchOptions m_options;
+	BatchSummary* const m_summary;
+};
+
+#endif
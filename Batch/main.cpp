@@ -0,0 +1,290 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include <iostream>
+
+#include <QtDebug>
+#include <QCommandLineParser>
+#include <QDateTime>
+#include <QDir>
+#include <QDirIterator>
+#include <QFileInfo>
+#include <QGuiApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThreadPool>
+#include <QtConcurrentMap>
+
+#include <Catalog.h>
+#include <Globals.h>
+#include <SampleStore.h>
+
+#include "BatchJob.h"
+
+
+static QMutex g_logMutex;
+
+void checkLog(const char* sFile, int iLine, const QString& sType, const QString& sMessage)
+{
+	QFileInfo fi(sFile);
+	QString s = QString("%0: %1 at %2:%3: %4")
+				.arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss.zzz"))
+				.arg(sType)
+				.arg(fi.fileName())
+				.arg(iLine)
+				.arg(sMessage.trimmed());
+	// Called from the worker threads
+	QMutexLocker locker(&g_logMutex);
+	std::cerr << qPrintable(s) << std::endl;
+}
+
+void checkFailure(const char* sFile, int iLine, const char* s)
+{
+	checkLog(sFile, iLine, "CHECK FAILURE", s);
+}
+
+/// Queue a job for every .ead file in sInput, which may be either a file or a directory.
+/// Output files mirror the directory layout below sInput in sOutputDir.
+static int queueJobs(const QString& sInput, const QString& sOutputDir, bool bRecursive, const BatchOptions& options, BatchSummary* summary)
+{
+	QFileInfo fiInput(sInput);
+	QDir dirOutput(sOutputDir);
+
+	if (fiInput.isFile())
+	{
+		QString sOutputBase = dirOutput.filePath(fiInput.completeBaseName());
+		QThreadPool::globalInstance()->start(new BatchJob(fiInput.absoluteFilePath(), sOutputBase, options, summary));
+		return 1;
+	}
+
+	QDir dirInput(fiInput.absoluteFilePath());
+	QDirIterator::IteratorFlags flags = (bRecursive) ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags;
+	QDirIterator it(dirInput.path(), QStringList() << "*.ead" << "*.EAD", QDir::Files, flags);
+	int nJobs = 0;
+	while (it.hasNext())
+	{
+		QFileInfo fi(it.next());
+		QString sRelative = dirInput.relativeFilePath(fi.absolutePath());
+		QString sOutputBase = QDir(dirOutput.filePath(sRelative)).filePath(fi.completeBaseName());
+		QThreadPool::globalInstance()->start(new BatchJob(fi.absoluteFilePath(), QDir::cleanPath(sOutputBase), options, summary));
+		nJobs++;
+	}
+	return nJobs;
+}
+
+/// Add the .ead files in the inputs to the catalog.
+/// Files which haven't changed since they were last added are skipped, and files which no longer exist are removed.
+static int updateCatalog(const QString& sCatalog, const QStringList& inputs, bool bRecursive)
+{
+	Catalog catalog(sCatalog);
+	if (!catalog.isOpen())
+	{
+		std::cerr << "The catalog could not be opened: " << qPrintable(sCatalog) << std::endl;
+		return 1;
+	}
+
+	QStringList files;
+	int nUnchanged = 0;
+	foreach (const QString& sInput, inputs)
+	{
+		QFileInfo fiInput(sInput);
+		QList<QFileInfo> fis;
+		if (fiInput.isFile())
+			fis << fiInput;
+		else if (fiInput.isDir())
+		{
+			QDirIterator::IteratorFlags flags = (bRecursive) ? QDirIterator::Subdirectories : QDirIterator::NoIteratorFlags;
+			QDirIterator it(fiInput.absoluteFilePath(), QStringList() << "*.ead" << "*.EAD", QDir::Files, flags);
+			while (it.hasNext())
+				fis << QFileInfo(it.next());
+		}
+		else
+			std::cerr << "Input not found: " << qPrintable(sInput) << std::endl;
+
+		foreach (const QFileInfo& fi, fis)
+		{
+			if (catalog.isCurrent(fi))
+				nUnchanged++;
+			else
+				files << fi.absoluteFilePath();
+		}
+	}
+
+	// Load the files in parallel; the catalog itself is only written from this thread
+	QList<CatalogEntry> described = QtConcurrent::blockingMapped<QList<CatalogEntry> >(files, Catalog::describeFile);
+	QList<CatalogEntry> entries;
+	for (int i = 0; i < described.size(); i++)
+	{
+		if (described[i].sFilename.isEmpty())
+			std::cerr << qPrintable(files[i]) << ": could not load file" << std::endl;
+		else
+			entries << described[i];
+	}
+	if (!catalog.update(entries))
+	{
+		std::cerr << "The catalog could not be updated: " << qPrintable(sCatalog) << std::endl;
+		return 1;
+	}
+	int nRemoved = catalog.removeMissing();
+
+	const int nFailed = files.size() - entries.size();
+	std::cout << entries.size() << " files added to the catalog, " << nUnchanged << " unchanged, " << nFailed << " failed";
+	if (nRemoved > 0)
+		std::cout << ", " << nRemoved << " missing files removed";
+	std::cout << std::endl;
+	return (nFailed > 0) ? 1 : 0;
+}
+
+int main(int argc, char *argv[])
+{
+	// Charts are rendered into images, so no display is needed
+	if (qgetenv("QT_QPA_PLATFORM").isEmpty())
+		qputenv("QT_QPA_PLATFORM", "offscreen");
+	QGuiApplication a(argc, argv);
+	a.setApplicationName("gcead-batch");
+
+	QCommandLineParser parser;
+	parser.setApplicationDescription("Process .ead files without a display: apply filters, detect peaks, export data and render charts.");
+	parser.addHelpOption();
+	parser.addPositionalArgument("inputs", "Files or directories of .ead files to process.", "<input>...");
+	QCommandLineOption optOutput(QStringList() << "o" << "output", "Directory for the output files (default: current directory).", "dir", ".");
+	QCommandLineOption optJobs(QStringList() << "j" << "jobs", "Number of files to process in parallel (default: number of cores).", "n");
+	QCommandLineOption optRecursive(QStringList() << "r" << "recursive", "Also process the subdirectories of input directories.");
+	QCommandLineOption optEadFilter("ead-filter", "Filter for EAD waves: 0 = none, 1 or 2 (default: as saved in the file).", "id");
+	QCommandLineOption optFidFilter("fid-filter", "Filter for FID waves: 0 = none, 1 or 2 (default: as saved in the file).", "id");
+	QCommandLineOption optNoData("no-data", "Don't export the wave data.");
+	QCommandLineOption optNumpy("npz", "Also export the wave data as a NumPy .npz archive.");
+	QCommandLineOption optNoAmplitudes("no-amplitudes", "Don't export the EAD amplitudes.");
+	QCommandLineOption optNoRetention("no-retention", "Don't export the FID retention times.");
+	QCommandLineOption optNoCharts("no-charts", "Don't render charts.");
+	QCommandLineOption optUpgrade("upgrade", "Only convert files in the old \"BcV\" format to the current .ead format; no other outputs are written.");
+	QCommandLineOption optChartSize("chart-size", "Size of the rendered charts (default: 1600x1000).", "WxH");
+	QCommandLineOption optCollectStore("collect-store", "Delete the samples from a shared sample store which no .ead file uses anymore, then exit.", "dir");
+	QCommandLineOption optCatalog("catalog", QString("Add the input files to the searchable catalog <file> instead of processing them; GcEad's own catalog is %1.").arg(QDir::toNativeSeparators(Catalog::defaultFilename())), "file");
+	parser.addOption(optOutput);
+	parser.addOption(optJobs);
+	parser.addOption(optRecursive);
+	parser.addOption(optEadFilter);
+	parser.addOption(optFidFilter);
+	parser.addOption(optNoData);
+	parser.addOption(optNumpy);
+	parser.addOption(optNoAmplitudes);
+	parser.addOption(optNoRetention);
+	parser.addOption(optNoCharts);
+	parser.addOption(optChartSize);
+	parser.addOption(optUpgrade);
+	parser.addOption(optCollectStore);
+	parser.addOption(optCatalog);
+	parser.process(a);
+
+	if (parser.isSet(optCollectStore))
+	{
+		qint64 nBytesFreed = 0;
+		int nDeleted = SampleStore(parser.value(optCollectStore)).collectGarbage(&nBytesFreed);
+		if (nDeleted < 0)
+		{
+			std::cerr << "The sample store could not be cleaned up, because not all of the files which use it could be read." << std::endl;
+			return 1;
+		}
+		std::cout << nDeleted << " unused blocks removed, " << nBytesFreed << " bytes freed" << std::endl;
+		return 0;
+	}
+
+	const QStringList inputs = parser.positionalArguments();
+	if (inputs.isEmpty())
+		parser.showHelp(2);
+
+	BatchOptions options;
+	options.sOutputDir = parser.value(optOutput);
+	if (parser.isSet(optEadFilter))
+		options.nEadFilterId = parser.value(optEadFilter).toInt();
+	if (parser.isSet(optFidFilter))
+		options.nFidFilterId = parser.value(optFidFilter).toInt();
+	options.bExportData = !parser.isSet(optNoData);
+	options.bExportNumpy = parser.isSet(optNumpy);
+	options.bExportAmplitudes = !parser.isSet(optNoAmplitudes);
+	options.bExportRetention = !parser.isSet(optNoRetention);
+	options.bRenderCharts = !parser.isSet(optNoCharts);
+	options.bUpgrade = parser.isSet(optUpgrade);
+	if (parser.isSet(optChartSize))
+	{
+		QStringList dims = parser.value(optChartSize).split('x');
+		int nWidth = (dims.size() == 2) ? dims[0].toInt() : 0;
+		int nHeight = (dims.size() == 2) ? dims[1].toInt() : 0;
+		if (nWidth <= 0 || nHeight <= 0)
+		{
+			std::cerr << "Invalid chart size: " << qPrintable(parser.value(optChartSize)) << std::endl;
+			return 2;
+		}
+		options.chartSize = QSize(nWidth, nHeight);
+	}
+
+	if (parser.isSet(optJobs))
+	{
+		int nJobs = parser.value(optJobs).toInt();
+		if (nJobs > 0)
+			QThreadPool::globalInstance()->setMaxThreadCount(nJobs);
+	}
+
+	if (parser.isSet(optCatalog))
+		return updateCatalog(parser.value(optCatalog), inputs, parser.isSet(optRecursive));
+
+	// Charts use the publisher colors from the user's settings
+	Globals = new GlobalVars();
+	Globals->readSettings();
+
+	BatchSummary summary;
+	bool bRecursive = parser.isSet(optRecursive);
+	int nJobs = 0;
+	foreach (const QString& sInput, inputs)
+	{
+		if (!QFileInfo(sInput).exists())
+		{
+			std::cerr << "Input not found: " << qPrintable(sInput) << std::endl;
+			continue;
+		}
+		// With several input directories, keep their outputs apart
+		QString sOutputDir = options.sOutputDir;
+		if (inputs.size() > 1 && QFileInfo(sInput).isDir())
+			sOutputDir = QDir(sOutputDir).filePath(QDir(QFileInfo(sInput).absoluteFilePath()).dirName());
+		nJobs += queueJobs(sInput, sOutputDir, bRecursive, options, &summary);
+	}
+
+	QThreadPool::globalInstance()->waitForDone();
+
+	int nFailed = 0;
+	int nSkipped = 0;
+	foreach (const BatchResult& result, summary.results())
+	{
+		if (result.bSkipped)
+			nSkipped++;
+		if (!result.isOk())
+		{
+			nFailed++;
+			foreach (const QString& sError, result.errors)
+				std::cerr << qPrintable(result.sInputFile) << ": " << qPrintable(sError) << std::endl;
+		}
+	}
+	std::cout << nJobs << " files processed, " << nFailed << " failed";
+	if (nSkipped > 0)
+		std::cout << ", " << nSkipped << " skipped";
+	std::cout << std::endl;
+
+	delete Globals;
+
+	return (nFailed > 0) ? 1 : 0;
+}
@@ -5,8 +5,8 @@ DEFINES += QT_XML_LIB QT_SVG_LIB
 INCLUDEPATH += . ..
 DEPENDPATH += . ..
 
-HEADERS += Check.h Utils.h
-SOURCES += Utils.cpp
+HEADERS += Check.h DoubleFormat.h Utils.h
+SOURCES += DoubleFormat.cpp Utils.cpp
 
 #CONFIG(debug, debug|release) {
 #    DESTDIR = ../debug
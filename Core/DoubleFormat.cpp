@@ -0,0 +1,505 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DoubleFormat.h"
+
+#include <string.h>
+
+#include <QByteArray>
+#include <QtGlobal>
+
+
+// This is an implementation of the Grisu2 algorithm described in
+// Florian Loitsch, "Printing Floating-Point Numbers Quickly and Accurately with Integers", PLDI 2010.
+// Grisu2 always produces a string which reads back as the original double,
+// and in over 99.9% of cases it is also the shortest such string.
+
+namespace {
+
+/// A floating point number f * 2^e with a 64-bit significand
+class DiyFp
+{
+public:
+	quint64 f;
+	int e;
+
+	DiyFp(quint64 f, int e) : f(f), e(e) {}
+};
+
+DiyFp sub(const DiyFp& x, const DiyFp& y)
+{
+	return DiyFp(x.f - y.f, x.e);
+}
+
+/// Product of x and y, rounded to 64 bits
+DiyFp mul(const DiyFp& x, const DiyFp& y)
+{
+	const quint64 xLo = x.f & 0xFFFFFFFFu;
+	const quint64 xHi = x.f >> 32;
+	const quint64 yLo = y.f & 0xFFFFFFFFu;
+	const quint64 yHi = y.f >> 32;
+
+	const quint64 p0 = xLo * yLo;
+	const quint64 p1 = xLo * yHi;
+	const quint64 p2 = xHi * yLo;
+	const quint64 p3 = xHi * yHi;
+
+	quint64 q = (p0 >> 32) + (p1 & 0xFFFFFFFFu) + (p2 & 0xFFFFFFFFu);
+	// Round to nearest
+	q += quint64(1) << 31;
+
+	const quint64 h = p3 + (p2 >> 32) + (p1 >> 32) + (q >> 32);
+	return DiyFp(h, x.e + y.e + 64);
+}
+
+DiyFp normalize(DiyFp x)
+{
+	while ((x.f >> 63) == 0)
+	{
+		x.f <<= 1;
+		x.e--;
+	}
+	return x;
+}
+
+DiyFp normalizeTo(const DiyFp& x, int e)
+{
+	return DiyFp(x.f << (x.e - e), e);
+}
+
+/// Normalized v and the boundaries halfway to its neighbouring doubles, for v > 0
+void computeBoundaries(double n, DiyFp& v, DiyFp& minus, DiyFp& plus)
+{
+	const quint64 nHiddenBit = quint64(1) << 52;
+	const int nBias = 1023 + 52;
+
+	quint64 bits;
+	memcpy(&bits, &n, sizeof(bits));
+	const int E = int(bits >> 52);
+	const quint64 F = bits & (nHiddenBit - 1);
+
+	DiyFp w = (E == 0) ? DiyFp(F, 1 - nBias) : DiyFp(F + nHiddenBit, E - nBias);
+
+	// The gap to the next lower double is half as large if n is a power of two
+	bool bLowerIsCloser = (F == 0 && E > 1);
+	DiyFp mPlus(2 * w.f + 1, w.e - 1);
+	DiyFp mMinus = (bLowerIsCloser) ? DiyFp(4 * w.f - 1, w.e - 2) : DiyFp(2 * w.f - 1, w.e - 1);
+
+	plus = normalize(mPlus);
+	minus = normalizeTo(mMinus, plus.e);
+	v = normalize(w);
+}
+
+/// Normalized approximation of 10^k
+struct CachedPower
+{
+	quint64 f;
+	int e;
+	int k;
+};
+
+// Range of binary exponents which the scaled numbers are moved into.
+// This lets the integral part of the scaled number fit into 32 bits.
+const int ALPHA = -60;
+const int GAMMA = -32;
+
+const int CACHED_POWERS_MIN_K = -300;
+const int CACHED_POWERS_STEP_K = 8;
+
+const CachedPower g_cachedPowers[] =
+{
+	{ Q_UINT64_C(0xAB70FE17C79AC6CA), -1060, -300 },
+	{ Q_UINT64_C(0xFF77B1FCBEBCDC4F), -1034, -292 },
+	{ Q_UINT64_C(0xBE5691EF416BD60C), -1007, -284 },
+	{ Q_UINT64_C(0x8DD01FAD907FFC3C),  -980, -276 },
+	{ Q_UINT64_C(0xD3515C2831559A83),  -954, -268 },
+	{ Q_UINT64_C(0x9D71AC8FADA6C9B5),  -927, -260 },
+	{ Q_UINT64_C(0xEA9C227723EE8BCB),  -901, -252 },
+	{ Q_UINT64_C(0xAECC49914078536D),  -874, -244 },
+	{ Q_UINT64_C(0x823C12795DB6CE57),  -847, -236 },
+	{ Q_UINT64_C(0xC21094364DFB5637),  -821, -228 },
+	{ Q_UINT64_C(0x9096EA6F3848984F),  -794, -220 },
+	{ Q_UINT64_C(0xD77485CB25823AC7),  -768, -212 },
+	{ Q_UINT64_C(0xA086CFCD97BF97F4),  -741, -204 },
+	{ Q_UINT64_C(0xEF340A98172AACE5),  -715, -196 },
+	{ Q_UINT64_C(0xB23867FB2A35B28E),  -688, -188 },
+	{ Q_UINT64_C(0x84C8D4DFD2C63F3B),  -661, -180 },
+	{ Q_UINT64_C(0xC5DD44271AD3CDBA),  -635, -172 },
+	{ Q_UINT64_C(0x936B9FCEBB25C996),  -608, -164 },
+	{ Q_UINT64_C(0xDBAC6C247D62A584),  -582, -156 },
+	{ Q_UINT64_C(0xA3AB66580D5FDAF6),  -555, -148 },
+	{ Q_UINT64_C(0xF3E2F893DEC3F126),  -529, -140 },
+	{ Q_UINT64_C(0xB5B5ADA8AAFF80B8),  -502, -132 },
+	{ Q_UINT64_C(0x87625F056C7C4A8B),  -475, -124 },
+	{ Q_UINT64_C(0xC9BCFF6034C13053),  -449, -116 },
+	{ Q_UINT64_C(0x964E858C91BA2655),  -422, -108 },
+	{ Q_UINT64_C(0xDFF9772470297EBD),  -396, -100 },
+	{ Q_UINT64_C(0xA6DFBD9FB8E5B88F),  -369,  -92 },
+	{ Q_UINT64_C(0xF8A95FCF88747D94),  -343,  -84 },
+	{ Q_UINT64_C(0xB94470938FA89BCF),  -316,  -76 },
+	{ Q_UINT64_C(0x8A08F0F8BF0F156B),  -289,  -68 },
+	{ Q_UINT64_C(0xCDB02555653131B6),  -263,  -60 },
+	{ Q_UINT64_C(0x993FE2C6D07B7FAC),  -236,  -52 },
+	{ Q_UINT64_C(0xE45C10C42A2B3B06),  -210,  -44 },
+	{ Q_UINT64_C(0xAA242499697392D3),  -183,  -36 },
+	{ Q_UINT64_C(0xFD87B5F28300CA0E),  -157,  -28 },
+	{ Q_UINT64_C(0xBCE5086492111AEB),  -130,  -20 },
+	{ Q_UINT64_C(0x8CBCCC096F5088CC),  -103,  -12 },
+	{ Q_UINT64_C(0xD1B71758E219652C),   -77,   -4 },
+	{ Q_UINT64_C(0x9C40000000000000),   -50,    4 },
+	{ Q_UINT64_C(0xE8D4A51000000000),   -24,   12 },
+	{ Q_UINT64_C(0xAD78EBC5AC620000),     3,   20 },
+	{ Q_UINT64_C(0x813F3978F8940984),    30,   28 },
+	{ Q_UINT64_C(0xC097CE7BC90715B3),    56,   36 },
+	{ Q_UINT64_C(0x8F7E32CE7BEA5C70),    83,   44 },
+	{ Q_UINT64_C(0xD5D238A4ABE98068),   109,   52 },
+	{ Q_UINT64_C(0x9F4F2726179A2245),   136,   60 },
+	{ Q_UINT64_C(0xED63A231D4C4FB27),   162,   68 },
+	{ Q_UINT64_C(0xB0DE65388CC8ADA8),   189,   76 },
+	{ Q_UINT64_C(0x83C7088E1AAB65DB),   216,   84 },
+	{ Q_UINT64_C(0xC45D1DF942711D9A),   242,   92 },
+	{ Q_UINT64_C(0x924D692CA61BE758),   269,  100 },
+	{ Q_UINT64_C(0xDA01EE641A708DEA),   295,  108 },
+	{ Q_UINT64_C(0xA26DA3999AEF774A),   322,  116 },
+	{ Q_UINT64_C(0xF209787BB47D6B85),   348,  124 },
+	{ Q_UINT64_C(0xB454E4A179DD1877),   375,  132 },
+	{ Q_UINT64_C(0x865B86925B9BC5C2),   402,  140 },
+	{ Q_UINT64_C(0xC83553C5C8965D3D),   428,  148 },
+	{ Q_UINT64_C(0x952AB45CFA97A0B3),   455,  156 },
+	{ Q_UINT64_C(0xDE469FBD99A05FE3),   481,  164 },
+	{ Q_UINT64_C(0xA59BC234DB398C25),   508,  172 },
+	{ Q_UINT64_C(0xF6C69A72A3989F5C),   534,  180 },
+	{ Q_UINT64_C(0xB7DCBF5354E9BECE),   561,  188 },
+	{ Q_UINT64_C(0x88FCF317F22241E2),   588,  196 },
+	{ Q_UINT64_C(0xCC20CE9BD35C78A5),   614,  204 },
+	{ Q_UINT64_C(0x98165AF37B2153DF),   641,  212 },
+	{ Q_UINT64_C(0xE2A0B5DC971F303A),   667,  220 },
+	{ Q_UINT64_C(0xA8D9D1535CE3B396),   694,  228 },
+	{ Q_UINT64_C(0xFB9B7CD9A4A7443C),   720,  236 },
+	{ Q_UINT64_C(0xBB764C4CA7A44410),   747,  244 },
+	{ Q_UINT64_C(0x8BAB8EEFB6409C1A),   774,  252 },
+	{ Q_UINT64_C(0xD01FEF10A657842C),   800,  260 },
+	{ Q_UINT64_C(0x9B10A4E5E9913129),   827,  268 },
+	{ Q_UINT64_C(0xE7109BFBA19C0C9D),   853,  276 },
+	{ Q_UINT64_C(0xAC2820D9623BF429),   880,  284 },
+	{ Q_UINT64_C(0x80444B5E7AA7CF85),   907,  292 },
+	{ Q_UINT64_C(0xBF21E44003ACDD2D),   933,  300 },
+	{ Q_UINT64_C(0x8E679C2F5E44FF8F),   960,  308 },
+	{ Q_UINT64_C(0xD433179D9C8CB841),   986,  316 },
+	{ Q_UINT64_C(0x9E19DB92B4E31BA9),  1013,  324 },
+};
+
+/// Find a power of ten c such that the binary exponent of c * 2^e lies within [ALPHA, GAMMA]
+const CachedPower& cachedPowerForBinaryExponent(int e)
+{
+	// k = ceil((ALPHA - e - 1) * log10(2))
+	const int f = ALPHA - e - 1;
+	const int k = (f * 78913) / (1 << 18) + ((f > 0) ? 1 : 0);
+	const int i = (-CACHED_POWERS_MIN_K + k + (CACHED_POWERS_STEP_K - 1)) / CACHED_POWERS_STEP_K;
+	return g_cachedPowers[i];
+}
+
+/// Number of decimal digits in n, and the largest power of ten <= n
+int largestPow10(quint32 n, quint32& nPow10)
+{
+	static const quint32 anPow10[] = { 1, 10, 100, 1000, 10000, 100000, 1000000, 10000000, 100000000, 1000000000 };
+	int nDigits = 10;
+	while (nDigits > 1 && n < anPow10[nDigits - 1])
+		nDigits--;
+	nPow10 = anPow10[nDigits - 1];
+	return nDigits;
+}
+
+/// Move the last digit towards w while the result stays within the boundaries
+void roundLastDigit(char* s, int len, quint64 dist, quint64 delta, quint64 rest, quint64 tenK)
+{
+	while (rest < dist && delta - rest >= tenK && (rest + tenK < dist || dist - rest > rest + tenK - dist))
+	{
+		s[len - 1]--;
+		rest += tenK;
+	}
+}
+
+/// Generate the digits of w, which lies within (mMinus, mPlus)
+int generateDigits(char* s, int& nExp10, const DiyFp& mMinus, const DiyFp& w, const DiyFp& mPlus)
+{
+	quint64 delta = sub(mPlus, mMinus).f;
+	quint64 dist = sub(mPlus, w).f;
+
+	// Split mPlus into its integral part p1 and fractional part p2
+	const DiyFp one(quint64(1) << -mPlus.e, mPlus.e);
+	quint32 p1 = quint32(mPlus.f >> -one.e);
+	quint64 p2 = mPlus.f & (one.f - 1);
+
+	int len = 0;
+	quint32 nPow10;
+	int n = largestPow10(p1, nPow10);
+	while (n > 0)
+	{
+		s[len++] = char('0' + p1 / nPow10);
+		p1 %= nPow10;
+		n--;
+
+		const quint64 rest = (quint64(p1) << -one.e) + p2;
+		if (rest <= delta)
+		{
+			nExp10 += n;
+			roundLastDigit(s, len, dist, delta, rest, quint64(nPow10) << -one.e);
+			return len;
+		}
+		nPow10 /= 10;
+	}
+
+	int m = 0;
+	while (true)
+	{
+		p2 *= 10;
+		s[len++] = char('0' + (p2 >> -one.e));
+		p2 &= one.f - 1;
+		m++;
+
+		delta *= 10;
+		dist *= 10;
+		if (p2 <= delta)
+			break;
+	}
+	nExp10 -= m;
+	roundLastDigit(s, len, dist, delta, p2, one.f);
+	return len;
+}
+
+/// Write the shortest digits of n > 0 to s, so that n == s * 10^nExp10
+int grisu2(double n, char* s, int& nExp10)
+{
+	DiyFp v(0, 0), minus(0, 0), plus(0, 0);
+	computeBoundaries(n, v, minus, plus);
+
+	const CachedPower& cached = cachedPowerForBinaryExponent(plus.e);
+	const DiyFp c(cached.f, cached.e);
+
+	const DiyFp w = mul(v, c);
+	const DiyFp wMinus = mul(minus, c);
+	const DiyFp wPlus = mul(plus, c);
+
+	// Narrow the boundaries by one unit to account for the rounding errors of mul()
+	const DiyFp mMinus(wMinus.f + 1, wMinus.e);
+	const DiyFp mPlus(wPlus.f - 1, wPlus.e);
+
+	nExp10 = -cached.k;
+	return generateDigits(s, nExp10, mMinus, w, mPlus);
+}
+
+int appendExponent(char* s, int nExp)
+{
+	int len = 0;
+	s[len++] = 'e';
+	if (nExp < 0)
+	{
+		s[len++] = '-';
+		nExp = -nExp;
+	}
+	else
+		s[len++] = '+';
+
+	if (nExp >= 100)
+	{
+		s[len++] = char('0' + nExp / 100);
+		nExp %= 100;
+	}
+	s[len++] = char('0' + nExp / 10);
+	s[len++] = char('0' + nExp % 10);
+	return len;
+}
+
+}
+
+
+int formatDouble(double n, char* s)
+{
+	char* const sStart = s;
+
+	if (n != n)
+	{
+		strcpy(s, "nan");
+		return 3;
+	}
+	if (n == 0)
+	{
+		strcpy(s, "0");
+		return 1;
+	}
+	if (n < 0)
+	{
+		*s++ = '-';
+		n = -n;
+	}
+	if (n > 1.7976931348623157e308)
+	{
+		strcpy(s, "inf");
+		return int(s - sStart) + 3;
+	}
+
+	char digits[20];
+	int nExp10;
+	const int nDigits = grisu2(n, digits, nExp10);
+	// Position of the decimal point relative to the first digit
+	const int nPoint = nDigits + nExp10;
+
+	// 1234500
+	if (nExp10 >= 0 && nPoint <= 15)
+	{
+		memcpy(s, digits, nDigits);
+		s += nDigits;
+		memset(s, '0', nExp10);
+		s += nExp10;
+	}
+	// 123.45
+	else if (nPoint > 0 && nPoint <= 15)
+	{
+		memcpy(s, digits, nPoint);
+		s += nPoint;
+		*s++ = '.';
+		memcpy(s, digits + nPoint, nDigits - nPoint);
+		s += nDigits - nPoint;
+	}
+	// 0.0012345
+	else if (nPoint > -4 && nPoint <= 0)
+	{
+		*s++ = '0';
+		*s++ = '.';
+		memset(s, '0', -nPoint);
+		s += -nPoint;
+		memcpy(s, digits, nDigits);
+		s += nDigits;
+	}
+	// 1.2345e-07
+	else
+	{
+		*s++ = digits[0];
+		if (nDigits > 1)
+		{
+			*s++ = '.';
+			memcpy(s, digits + 1, nDigits - 1);
+			s += nDigits - 1;
+		}
+		s += appendExponent(s, nPoint - 1);
+	}
+
+	*s = 0;
+	return int(s - sStart);
+}
+
+const char* parseDouble(const char* s, const char* end, double& n, char chDecimal)
+{
+	// Powers of ten which are exactly representable as doubles
+	static const double anPow10[] =
+	{
+		1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+		1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+	};
+
+	const char* p = s;
+	bool bNegative = false;
+	if (p < end && (*p == '-' || *p == '+'))
+	{
+		bNegative = (*p == '-');
+		p++;
+	}
+
+	quint64 nMantissa = 0;
+	int nDigits = 0;
+	int nExp10 = 0;
+	bool bDigits = false;
+	bool bTruncated = false;
+
+	// Integer part
+	for (; p < end && *p >= '0' && *p <= '9'; p++)
+	{
+		bDigits = true;
+		if (nDigits < 19)
+		{
+			nMantissa = nMantissa * 10 + (*p - '0');
+			if (nMantissa != 0)
+				nDigits++;
+		}
+		else
+		{
+			nExp10++;
+			bTruncated = true;
+		}
+	}
+	// Fractional part
+	if (p < end && *p == chDecimal)
+	{
+		for (p++; p < end && *p >= '0' && *p <= '9'; p++)
+		{
+			bDigits = true;
+			if (nDigits < 19)
+			{
+				nMantissa = nMantissa * 10 + (*p - '0');
+				if (nMantissa != 0)
+					nDigits++;
+				nExp10--;
+			}
+			else
+				bTruncated = true;
+		}
+	}
+	if (!bDigits)
+		return s;
+
+	// Exponent
+	if (p < end && (*p == 'e' || *p == 'E'))
+	{
+		const char* q = p + 1;
+		bool bExpNegative = false;
+		if (q < end && (*q == '-' || *q == '+'))
+		{
+			bExpNegative = (*q == '-');
+			q++;
+		}
+		if (q < end && *q >= '0' && *q <= '9')
+		{
+			int nExp = 0;
+			for (; q < end && *q >= '0' && *q <= '9'; q++)
+			{
+				if (nExp < 10000)
+					nExp = nExp * 10 + (*q - '0');
+			}
+			nExp10 += (bExpNegative) ? -nExp : nExp;
+			p = q;
+		}
+	}
+
+	if (nMantissa == 0)
+		n = 0;
+	// Both the mantissa and the power of ten are exact, so there is only one rounding
+	else if (!bTruncated && nMantissa < (quint64(1) << 53) && nExp10 >= -22 && nExp10 <= 22)
+		n = (nExp10 < 0) ? double(nMantissa) / anPow10[-nExp10] : double(nMantissa) * anPow10[nExp10];
+	else
+	{
+		QByteArray a(s, int(p - s));
+		if (chDecimal != '.')
+			a.replace(chDecimal, '.');
+		n = a.toDouble();
+		return p;
+	}
+
+	if (bNegative)
+		n = -n;
+	return p;
+}
@@ -0,0 +1,42 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __DOUBLEFORMAT_H
+#define __DOUBLEFORMAT_H
+
+
+/// Size of a buffer which can hold any string written by formatDouble(), including the terminating null
+#define DOUBLE_FORMAT_BUFFER_SIZE 32
+
+
+/// Write the shortest decimal string which reads back as exactly n.
+/// This is several times faster than QString::number() and never depends on the locale:
+/// the decimal separator is always '.'.  Large and small magnitudes use exponent notation
+/// (e.g. "1.5e-07"), the same way as the "%g" printf format.
+/// @param s buffer of at least DOUBLE_FORMAT_BUFFER_SIZE chars
+/// @returns the number of chars written, not counting the terminating null
+extern int formatDouble(double n, char* s);
+
+/// Parse a decimal number such as "-12.5e-3" from the chars in [s, end).
+/// Numbers with up to 15 significant digits and small exponents are converted exactly
+/// without calling into the C library; anything else falls back to QByteArray::toDouble().
+/// Like formatDouble(), this never depends on the locale.
+/// @param chDecimal decimal separator, usually '.' or ','
+/// @returns pointer to the first char after the number, or s if there was no number
+extern const char* parseDouble(const char* s, const char* end, double& n, char chDecimal = '.');
+
+#endif
@@ -11,7 +11,8 @@ SUBDIRS = Core \
 win32:SUBDIRS += IdacDriverES
 SUBDIRS += \
 	ScopeTest \
-    View
+    View \
+	Batch
 #win32:SUBDIRS += IdacEs IdacEsTest
 OTHER_FILES += Todo.txt \
     UseCases.txt \
@@ -27,3 +28,4 @@ Idac.depends = IdacDriver IdacDriver2 IdacDriver4
 Scope.depends = Core Filters Model Idac
 ScopeTest.depends = Core IdacDriver IdacDriver2 IdacDriver4 Idac Filters Model Scope
 View.depends = Core IdacDriver IdacDriver2 IdacDriver4 Idac Filters Model Scope
+Batch.depends = Core Filters Model
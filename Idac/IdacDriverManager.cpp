@@ -21,10 +21,13 @@
 
 #include <Check.h>
 
+#include <IdacDriver/IdacCapture.h>
 #include <IdacDriver/IdacDriver.h>
 #include <IdacDriver/Sleeper.h>
 #include <IdacDriver2/IdacDriver2.h>
+#include <IdacDriver2/IdacDriver2Replay.h>
 #include <IdacDriver4/IdacDriver4.h>
+#include <IdacDriver4/IdacDriver4Replay.h>
 #include <IdacDriverES/IdacDriverES.h>
 
 
@@ -108,6 +111,13 @@ void IdacDriverManager::command(int _cmd)
 			m_driver->configureChannel(iChan);
 		}
 		break;
+	case IdacCommand_ConfigChannels:
+		if (m_state == IdacState_Ready || m_state == IdacState_Sampling)
+		{
+			bValid = true;
+			m_driver->configureChannels();
+		}
+		break;
 	}
 
 	m_cmd = IdacCommand_None;
@@ -173,12 +183,43 @@ void IdacDriverManager::setChannelSettings(int iChannel, const IdacChannelSettin
 	m_driver->setChannelSettings(iChannel, channel);
 }
 
-int IdacDriverManager::takeData(short* digital, short* analog1, short* analog2, int maxSize)
+void IdacDriverManager::setChannelSettings(const QVector<IdacChannelSettings>& channels)
+{
+	if (m_driver == NULL)
+		return;
+	m_driver->setChannelSettings(channels);
+}
+
+bool IdacDriverManager::takeBlock(IdacSampleBlock& block)
+{
+	if (m_driver == NULL)
+		return false;
+
+	return m_driver->takeBlock(block);
+}
+
+IdacPreview* IdacDriverManager::preview()
+{
+	if (m_driver == NULL)
+		return NULL;
+
+	return m_driver->preview();
+}
+
+IdacTelemetrySnapshot IdacDriverManager::telemetry()
+{
+	if (m_driver == NULL)
+		return IdacTelemetrySnapshot();
+
+	return m_driver->telemetrySnapshot();
+}
+
+QString IdacDriverManager::samplingThreadStatus()
 {
 	if (m_driver == NULL)
-		return 0;
+		return QString();
 
-	return m_driver->takeData(digital, analog1, analog2, maxSize);
+	return m_driver->samplingThreadStatus();
 }
 
 void IdacDriverManager::setup()
@@ -195,22 +236,15 @@ void IdacDriverManager::setup()
 	if (!m_driver->checkUsbFirmwareReady())
 	{
 		m_driver->initUsbFirmware();
-		delete m_driver;
-		m_driver = NULL;
-		m_handle = NULL;
+		closeLibusbDriver();
 
-		// After USB initialization, try to find the device again
-		bool bReady = false;
-		for (int iTry = 0; iTry < 3; iTry++)
+		// After USB initialization, the device re-enumerates with the new firmware
+		setState(IdacState_Searching);
+		bool bReady = waitForUsbFirmware(15000);
+		if (bReady)
 		{
-			setState(IdacState_Searching);
-			Sleeper::msleep(5000);
 			loadDriver();
-			if (m_driver != NULL && m_driver->checkUsbFirmwareReady())
-			{
-				bReady = true;
-				break;
-			}
+			bReady = (m_driver != NULL && m_driver->checkUsbFirmwareReady());
 		}
 
 		if (!bReady)
@@ -235,6 +269,16 @@ void IdacDriverManager::setup()
 
 void IdacDriverManager::loadDriver()
 {
+	// GCEAD_REPLAY names a capture file to play back in place of the hardware
+	QString sReplay = QString::fromLocal8Bit(qgetenv("GCEAD_REPLAY"));
+	if (!sReplay.isEmpty())
+	{
+		createReplayDriver(sReplay);
+		if (m_driver != NULL)
+			m_driver->init();
+		return;
+	}
+
 	createLibusbDriver();
 #ifdef Q_OS_WIN
 	if (m_driver == NULL) {
@@ -247,6 +291,26 @@ void IdacDriverManager::loadDriver()
 		m_driver->init();
 }
 
+void IdacDriverManager::createReplayDriver(const QString& sFilename)
+{
+	IdacCaptureReader reader;
+	if (!reader.open(sFilename))
+	{
+		qDebug() << "Could not read capture file" << sFilename;
+		return;
+	}
+
+	// Replay at the captured speed unless GCEAD_REPLAY_SPEED=max
+	bool bRealTime = (qgetenv("GCEAD_REPLAY_SPEED") != "max");
+	const QString sHardwareName = reader.header().sHardwareName;
+	if (sHardwareName == "IDAC4")
+		m_driver = new IdacDriver4Replay(sFilename, bRealTime);
+	else if (sHardwareName == "IDAC2")
+		m_driver = new IdacDriver2Replay(sFilename, bRealTime);
+	else
+		qDebug() << "Unknown hardware in capture file:" << sHardwareName;
+}
+
 /*
 void print_endpoint(struct usb_endpoint_descriptor *endpoint)
 {
@@ -21,6 +21,7 @@
 #include <QObject>
 
 #include <IdacDriver/IdacEnums.h>
+#include <IdacDriver/IdacTelemetry.h>
 
 // Using libusbx on linux/mac
 struct libusb_device_handle;
@@ -31,6 +32,8 @@ typedef void UsbDevice;
 class IdacCaps;
 class IdacChannelSettings;
 class IdacDriver;
+class IdacPreview;
+class IdacSampleBlock;
 
 
 class IdacDriverManager : public QObject
@@ -58,7 +61,15 @@ public:
 	/// Load up default channel settings for the current driver
 	const QVector<IdacChannelSettings>& defaultChannelSettings();
 	void setChannelSettings(int iChannel, const IdacChannelSettings& channel);
-	int takeData(short* digital, short* analog1, short* analog2, int maxSize);
+	void setChannelSettings(const QVector<IdacChannelSettings>& channels);
+	/// Take ownership of all samples received since the last call
+	bool takeBlock(IdacSampleBlock& block);
+	/// Display summaries maintained by the sampling thread (may be NULL)
+	IdacPreview* preview();
+	/// Current acquisition counters (all zero if there is no driver)
+	IdacTelemetrySnapshot telemetry();
+	/// Effective real-time scheduling of the sampling thread (empty if not in real-time mode)
+	QString samplingThreadStatus();
 
 public slots:
 	void command(int _cmd);
@@ -71,6 +82,8 @@ private:
 	void setState(IdacState state);
 	void setup();
 	void loadDriver();
+	/// Create a driver which replays a USB capture file instead of talking to a device
+	void createReplayDriver(const QString& sFilename);
 
 // Specialize these for the libusb library being used
 private:
@@ -78,6 +91,12 @@ private:
 	void exitLibusb();
     /// Set m_handle and m_driver, if IDAC found.
 	void createLibusbDriver();
+	/// Delete m_driver and close m_handle
+	void closeLibusbDriver();
+	/// Wait for an IDAC with freshly loaded USB firmware to re-enumerate.
+	/// Uses libusb hotplug notifications if available, and polls otherwise.
+	/// @returns true if the device appeared within nTimeout_ms
+	bool waitForUsbFirmware(int nTimeout_ms);
 	//void createDriver();
 
 private:
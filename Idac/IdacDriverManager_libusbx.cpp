@@ -24,10 +24,12 @@
 //#endif
 
 #include <QtDebug>
+#include <QElapsedTimer>
 
 #include <Check.h>
 
 #include <IdacDriver/IdacDriver.h>
+#include <IdacDriver/IdacDriverUsb24Base.h>
 #include <IdacDriver/Sleeper.h>
 #include <IdacDriver2/IdacDriver2.h>
 #include <IdacDriver4/IdacDriver4.h>
@@ -89,3 +91,102 @@ void IdacDriverManager::createLibusbDriver()
 
 	libusb_free_device_list(devs, 1);
 }
+
+void IdacDriverManager::closeLibusbDriver()
+{
+	delete m_driver;
+	m_driver = NULL;
+
+	if (m_handle != NULL) {
+		libusb_close(m_handle);
+		m_handle = NULL;
+	}
+}
+
+/// @returns true if an IDAC which is running our USB firmware is attached
+static bool findReadyIdac()
+{
+	bool bFound = false;
+
+	libusb_device** devs;
+	ssize_t cnt = libusb_get_device_list(NULL, &devs);
+	if (cnt >= 0) {
+		for (int i = 0; i < cnt && !bFound; i++) {
+			libusb_device* dev = devs[i];
+			struct libusb_device_descriptor desc;
+			int r = libusb_get_device_descriptor(dev, &desc);
+			if (r >= 0 && desc.idVendor == 0x088D && (desc.idProduct == 0x0008 || desc.idProduct == 0x0006))
+				bFound = IdacDriverUsb24Base::isUsbFirmwareReady(dev);
+		}
+		libusb_free_device_list(devs, 1);
+	}
+
+	return bFound;
+}
+
+#if defined(LIBUSB_API_VERSION) && (LIBUSB_API_VERSION >= 0x01000102)
+#define HAVE_LIBUSB_HOTPLUG
+
+static int LIBUSB_CALL hotplug_arrived_cb(libusb_context* ctx, libusb_device* dev, libusb_hotplug_event event, void* user_data)
+{
+	Q_UNUSED(ctx);
+	Q_UNUSED(dev);
+	Q_UNUSED(event);
+	*(bool*) user_data = true;
+	// Stay registered
+	return 0;
+}
+#endif
+
+bool IdacDriverManager::waitForUsbFirmware(int nTimeout_ms)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	bool bArrived = false;
+	bool bHotplug = false;
+#ifdef HAVE_LIBUSB_HOTPLUG
+	libusb_hotplug_callback_handle hotplug;
+	if (libusb_has_capability(LIBUSB_CAP_HAS_HOTPLUG)) {
+		int res = libusb_hotplug_register_callback(
+			NULL,
+			LIBUSB_HOTPLUG_EVENT_DEVICE_ARRIVED,
+			(libusb_hotplug_flag) 0,
+			0x088D, // vendor
+			LIBUSB_HOTPLUG_MATCH_ANY, // product
+			LIBUSB_HOTPLUG_MATCH_ANY, // device class
+			hotplug_arrived_cb,
+			&bArrived,
+			&hotplug);
+		bHotplug = (res == LIBUSB_SUCCESS);
+	}
+#endif
+
+	bool bReady = false;
+	while (!(bReady = findReadyIdac()) && timer.elapsed() < nTimeout_ms)
+	{
+		if (bHotplug) {
+#ifdef HAVE_LIBUSB_HOTPLUG
+			// Wait for an arrival, but look again now and then in case the notification was missed
+			bArrived = false;
+			QElapsedTimer wait;
+			wait.start();
+			while (!bArrived && wait.elapsed() < 500) {
+				struct timeval tv = { 0, 50000 };
+				libusb_handle_events_timeout_completed(NULL, &tv, NULL);
+			}
+#endif
+		}
+		else {
+			Sleeper::msleep(50);
+		}
+	}
+
+#ifdef HAVE_LIBUSB_HOTPLUG
+	if (bHotplug)
+		libusb_hotplug_deregister_callback(NULL, hotplug);
+#endif
+
+	qDebug() << "IdacDriverManager::waitForUsbFirmware:" << bReady << "after" << timer.elapsed() << "ms";
+	return bReady;
+}
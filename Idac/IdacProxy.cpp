@@ -22,6 +22,7 @@
 #include <Check.h>
 
 #include <IdacDriver/IdacChannelSettings.h>
+#include <IdacDriver/IdacPreview.h>
 
 #include "IdacDriverManager.h"
 
@@ -36,7 +37,6 @@ IdacProxy::IdacProxy(IdacDriverManager* manager, QObject* parent)
         m_bAvailable = false;
 
 	m_cmdRequested = IdacCommand_None;
-	m_cmdQueued = IdacCommand_None;
 
 	QObject::connect(m_manager, SIGNAL(stateChanged(int)), this, SLOT(setState(int)));
 	QObject::connect(m_manager, SIGNAL(commandFinished(int)), this, SLOT(commandFinished(int)));
@@ -53,6 +53,7 @@ void IdacProxy::setState(int _state)
 	if (state != m_state)
 	{
 		m_sHardwareName = m_manager->hardwareName();
+		m_sSamplingThreadStatus = (state == IdacState_Sampling) ? m_manager->samplingThreadStatus() : QString();
 
 		// REFACTOR: consider changing this so that the assignment only occurs once. -- ellis, 2009-04-20
 		bool bAvailable = (state == IdacState_Ready || state == IdacState_Sampling);
@@ -84,7 +85,7 @@ void IdacProxy::commandFinished(int _cmd)
 	Q_UNUSED(_cmd);
 
 	m_cmdRequested = IdacCommand_None;
-	if (m_cmdQueued != IdacCommand_None)
+	if (!m_cmdQueue.isEmpty())
 		handleQueue();
 
 	updateStatusError();
@@ -123,6 +124,8 @@ QString IdacProxy::statusText() const
 		break;
 	case IdacState_Sampling:
 		s = tr("%0: Receiving").arg(m_sHardwareName);
+		if (!m_sSamplingThreadStatus.isEmpty())
+			s += QString(" (%0)").arg(m_sSamplingThreadStatus);
 		break;
 	}
 
@@ -161,17 +164,50 @@ void IdacProxy::resendChannelSettings(int iChannel, const IdacChannelSettings& c
 	CHECK_PARAM_RET(iChannel >= 0 && iChannel < m_manager->defaultChannelSettings().size());
 
 	m_manager->setChannelSettings(iChannel, channel);
-	queueCommand((IdacCommand) (IdacCommand_ConfigCh0 + iChannel));
+	queueCommand(IdacCommand_ConfigChannels);
 }
 
-int IdacProxy::takeData(short* digital, short* analog1, short* analog2, int maxSize)
+void IdacProxy::setChannelSettings(const QVector<IdacChannelSettings>& channels)
 {
-	return m_manager->takeData(digital, analog1, analog2, maxSize);
+	CHECK_PARAM_RET(channels.size() <= m_manager->defaultChannelSettings().size());
+
+	m_manager->setChannelSettings(channels);
+	queueCommand(IdacCommand_ConfigChannels);
+}
+
+bool IdacProxy::takeBlock(IdacSampleBlock& block)
+{
+	return m_manager->takeBlock(block);
+}
+
+void IdacProxy::setPreviewTimebase(double nSamplesPerBucket, int nBuckets, int iSampleOrigin)
+{
+	IdacPreview* preview = m_manager->preview();
+	if (preview != NULL)
+		preview->setTimebase(nSamplesPerBucket, nBuckets, iSampleOrigin);
+}
+
+const IdacPreviewSnapshot* IdacProxy::previewSnapshot()
+{
+	IdacPreview* preview = m_manager->preview();
+	if (preview == NULL)
+		return NULL;
+
+	return preview->snapshot();
+}
+
+IdacTelemetrySnapshot IdacProxy::telemetry()
+{
+	return m_manager->telemetry();
 }
 
 void IdacProxy::queueCommand(IdacCommand cmd)
 {
-	m_cmdQueued = cmd;
+	// Repeating the last command would have no further effect.
+	// In particular, IdacCommand_ConfigChannels always applies the latest settings, so
+	// any number of settings changes made while the hardware is busy are sent together.
+	if (m_cmdQueue.isEmpty() || m_cmdQueue.last() != cmd)
+		m_cmdQueue << cmd;
 	// If we're not currently waiting for a command to finish, then send this command now.
 	if (m_cmdRequested == IdacCommand_None)
 		handleQueue();
@@ -180,91 +216,95 @@ void IdacProxy::queueCommand(IdacCommand cmd)
 void IdacProxy::handleQueue()
 {
 	CHECK_PRECOND_RET(m_cmdRequested == IdacCommand_None);
-	CHECK_PRECOND_RET(m_cmdQueued != IdacCommand_None);
+	CHECK_PRECOND_RET(!m_cmdQueue.isEmpty());
 
-	bool bValid = true;
-
-	switch (m_state)
+	while (m_cmdRequested == IdacCommand_None && !m_cmdQueue.isEmpty())
 	{
-	// These are states before we have a driver object
-	case IdacState_None:
-	case IdacState_Searching:
-	case IdacState_NotPresent:
-	case IdacState_Present:
-	case IdacState_Initializing:
-	case IdacState_InitError:
-		switch (m_cmdQueued)
-		{
-		case IdacCommand_Connect:
-		case IdacCommand_SamplingOn:
-		case IdacCommand_ConfigCh0:
-		case IdacCommand_ConfigCh1:
-		case IdacCommand_ConfigCh2:
-			m_cmdRequested = IdacCommand_Connect;
-			break;
-		case IdacCommand_Disconnect:
-			m_cmdRequested = m_cmdQueued;
-			break;
-		default:
-			bValid = false;
-			break;
-		}
-		break;
+		IdacCommand cmdQueued = m_cmdQueue.first();
+		bool bValid = true;
 
-	case IdacState_Ready:
-		switch (m_cmdQueued)
+		switch (m_state)
 		{
-		case IdacCommand_Disconnect:
-		case IdacCommand_SamplingOn:
-		case IdacCommand_ConfigCh0:
-		case IdacCommand_ConfigCh1:
-		case IdacCommand_ConfigCh2:
-			m_cmdRequested = m_cmdQueued;
-			break;
-		default:
-			bValid = false;
+		// These are states before we have a driver object
+		case IdacState_None:
+		case IdacState_Searching:
+		case IdacState_NotPresent:
+		case IdacState_Present:
+		case IdacState_Initializing:
+		case IdacState_InitError:
+			switch (cmdQueued)
+			{
+			case IdacCommand_Connect:
+			case IdacCommand_SamplingOn:
+			case IdacCommand_ConfigCh0:
+			case IdacCommand_ConfigCh1:
+			case IdacCommand_ConfigCh2:
+			case IdacCommand_ConfigChannels:
+				m_cmdRequested = IdacCommand_Connect;
+				break;
+			case IdacCommand_Disconnect:
+				m_cmdRequested = cmdQueued;
+				break;
+			default:
+				bValid = false;
+				break;
+			}
 			break;
-		}
-		break;
 
-	case IdacState_Sampling:
-		switch (m_cmdQueued)
-		{
-		case IdacCommand_Disconnect:
-		case IdacCommand_SamplingOff:
-		case IdacCommand_ConfigCh0:
-		case IdacCommand_ConfigCh1:
-		case IdacCommand_ConfigCh2:
-			m_cmdRequested = m_cmdQueued;
+		case IdacState_Ready:
+			switch (cmdQueued)
+			{
+			case IdacCommand_Disconnect:
+			case IdacCommand_SamplingOn:
+			case IdacCommand_ConfigCh0:
+			case IdacCommand_ConfigCh1:
+			case IdacCommand_ConfigCh2:
+			case IdacCommand_ConfigChannels:
+				m_cmdRequested = cmdQueued;
+				break;
+			default:
+				bValid = false;
+				break;
+			}
 			break;
-		default:
-			bValid = false;
+
+		case IdacState_Sampling:
+			switch (cmdQueued)
+			{
+			case IdacCommand_Disconnect:
+			case IdacCommand_SamplingOff:
+			case IdacCommand_ConfigCh0:
+			case IdacCommand_ConfigCh1:
+			case IdacCommand_ConfigCh2:
+			case IdacCommand_ConfigChannels:
+				m_cmdRequested = cmdQueued;
+				break;
+			default:
+				bValid = false;
+				break;
+			}
 			break;
 		}
-		break;
-	}
 
-	if (bValid)
-	{
-		if (m_cmdRequested == IdacCommand_None)
+		if (!bValid)
 		{
-			m_cmdQueued = IdacCommand_None;
+			qDebug() << "IdacProxy::handleQueue: state:" << m_state << "queued:" << cmdQueued;
+			m_cmdQueue.removeFirst();
+			CHECK_ASSERT_NORET(bValid);
+			continue;
 		}
-		else
+
+		// Remove the command from the queue if we have now requested it.
+		// Otherwise it stays queued until the requested command (e.g. connecting) has finished.
+		if (m_cmdRequested == IdacCommand_None || m_cmdRequested == cmdQueued)
+			m_cmdQueue.removeFirst();
+
+		if (m_cmdRequested != IdacCommand_None)
 		{
 			emit requestCommand(m_cmdRequested);
 			//QMetaObject::invokeMethod(m_manager, "command", Q_ARG(int, (int) m_cmdRequested));
-			// Clear the queued state if we have now requested it.
-			if (m_cmdRequested == m_cmdQueued)
-				m_cmdQueued = IdacCommand_None;
 		}
 	}
-	else
-	{
-		qDebug() << "IdacProxy::handleQueue: state:" << m_state << "queued:" << m_cmdQueued;
-		m_cmdQueued = IdacCommand_None;
-		CHECK_FAILURE_RET();
-	}
 }
 
 void IdacProxy::updateStatusError()
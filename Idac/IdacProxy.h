@@ -18,16 +18,20 @@
 #ifndef __IDACPROXY_H
 #define __IDACPROXY_H
 
+#include <QList>
 #include <QObject>
 #include <QPointer>
 #include <QStringList>
 
 #include <IdacDriver/IdacEnums.h>
+#include <IdacDriver/IdacTelemetry.h>
 
 
 class IdacCaps;
 class IdacChannelSettings;
 class IdacDriver;
+class IdacPreviewSnapshot;
+class IdacSampleBlock;
 class IdacDriverManager;
 
 
@@ -54,13 +58,27 @@ public:
 	QVector<IdacChannelSettings> loadDefaultChannelSettings();
 
 	void startSampling(const QVector<IdacChannelSettings>& channels);
-	int takeData(short* digital, short* analog1, short* analog2, int maxSize);
+	/// Take ownership of all samples received since the last call
+	bool takeBlock(IdacSampleBlock& block);
+	/// Ask the sampling thread to summarize the samples into min/max buckets for display.
+	/// Bucket k starts at sample iSampleOrigin + int(k * nSamplesPerBucket + 0.5).
+	void setPreviewTimebase(double nSamplesPerBucket, int nBuckets, int iSampleOrigin);
+	/// Get the latest buckets published by the sampling thread, or NULL if there is no driver.
+	/// The snapshot remains valid until the next call.
+	const IdacPreviewSnapshot* previewSnapshot();
+	/// Get the acquisition counters of the driver (samples, packets, drops, buffer usage, decode time, latency).
+	/// This doesn't involve the control thread, so it's cheap enough to poll for every frame.
+	IdacTelemetrySnapshot telemetry();
 
 public slots:
 	void setup();
 	void setdown();
 	void stopSampling();
 	void resendChannelSettings(int iChannel, const IdacChannelSettings& channel);
+	/// Apply new settings for all channels in one go.
+	/// Only the settings which changed are sent, and sampling keeps running (with at most one short pause).
+	/// Repeated calls while the hardware is still busy are merged.
+	void setChannelSettings(const QVector<IdacChannelSettings>& channels);
 
 signals:
 	/// This is only for internal use with IdacDriverManager
@@ -85,10 +103,13 @@ private:
 	QPointer<IdacDriverManager> m_manager;
 
 	IdacCommand m_cmdRequested;
-	IdacCommand m_cmdQueued;
+	/// Commands waiting for m_cmdRequested to finish
+	QList<IdacCommand> m_cmdQueue;
 
 	bool m_bAvailable;
 	QString m_sHardwareName;
+	/// Scheduling of the sampling thread, as reported when sampling started
+	QString m_sSamplingThreadStatus;
 	QList<int> m_anRanges;
 	QStringList m_asHighcutStrings;
 	QStringList m_asLowcutStrings;
@@ -0,0 +1,203 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IdacCapture.h"
+
+#include <string.h>
+
+#include <QtDebug>
+#include <QDateTime>
+#include <QDir>
+
+#include <Check.h>
+
+
+/// Identifies capture files
+static const char g_sCaptureMagic[8] = { 'G', 'C', 'E', 'A', 'D', 'U', 'S', 'B' };
+/// Version of the capture file format
+static const qint32 g_nCaptureVersion = 1;
+
+
+static void writeChannelSettings(QDataStream& str, const IdacChannelSettings& chan)
+{
+	str << quint8(chan.mEnabled) << quint8(chan.mInvert);
+	str << qint32(chan.nDecimation) << qint32(chan.iRange) << qint32(chan.iLowcut) << qint32(chan.iHighcut);
+	str << qint16(chan.nOffset) << qint32(chan.nExternalAmplification);
+}
+
+static void readChannelSettings(QDataStream& str, IdacChannelSettings& chan)
+{
+	quint8 mEnabled, mInvert;
+	qint32 nDecimation, iRange, iLowcut, iHighcut, nExternalAmplification;
+	qint16 nOffset;
+	str >> mEnabled >> mInvert;
+	str >> nDecimation >> iRange >> iLowcut >> iHighcut;
+	str >> nOffset >> nExternalAmplification;
+
+	chan.mEnabled = mEnabled;
+	chan.mInvert = mInvert;
+	chan.nDecimation = nDecimation;
+	chan.iRange = iRange;
+	chan.iLowcut = iLowcut;
+	chan.iHighcut = iHighcut;
+	chan.nOffset = nOffset;
+	chan.nExternalAmplification = nExternalAmplification;
+}
+
+
+IdacCaptureWriter::IdacCaptureWriter()
+{
+}
+
+IdacCaptureWriter::~IdacCaptureWriter()
+{
+	close();
+}
+
+QString IdacCaptureWriter::captureDir()
+{
+	QString sDir = QString::fromLocal8Bit(qgetenv("GCEAD_CAPTURE_DIR"));
+	if (sDir.isEmpty() || !QDir(sDir).exists())
+		return QString();
+	return sDir;
+}
+
+bool IdacCaptureWriter::open(const IdacCaptureHeader& header)
+{
+	close();
+
+	QString sDir = captureDir();
+	if (sDir.isEmpty())
+		return false;
+
+	QString sTime = QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss-zzz");
+	QString sFilename = QDir(sDir).filePath(header.sHardwareName + "-" + sTime + ".usbcap");
+	m_file.setFileName(sFilename);
+	if (!m_file.open(QIODevice::WriteOnly))
+	{
+		qDebug() << "IdacCaptureWriter: could not create" << sFilename;
+		return false;
+	}
+
+	m_str.setDevice(&m_file);
+	m_str.setVersion(QDataStream::Qt_4_3);
+	m_str.writeRawData(g_sCaptureMagic, sizeof(g_sCaptureMagic));
+	m_str << g_nCaptureVersion;
+	m_str << header.sHardwareName;
+	m_str << qint32(header.nHardwareVersion);
+	m_str << qint32(header.channels.size());
+	foreach (const IdacChannelSettings& chan, header.channels)
+		writeChannelSettings(m_str, chan);
+
+	m_clock.start();
+	return true;
+}
+
+void IdacCaptureWriter::close()
+{
+	if (m_file.isOpen())
+	{
+		m_str.setDevice(NULL);
+		m_file.close();
+	}
+}
+
+void IdacCaptureWriter::write(const char* payload, int nPayload, int nBytesReceived)
+{
+	CHECK_PRECOND_RET(m_file.isOpen());
+	CHECK_PARAM_RET(nPayload >= 0);
+
+	m_str << qint64(m_clock.nsecsElapsed());
+	m_str << qint32(nBytesReceived);
+	// Same layout as a serialized QByteArray
+	m_str.writeBytes(payload, uint(nPayload));
+}
+
+
+IdacCaptureReader::IdacCaptureReader()
+{
+}
+
+bool IdacCaptureReader::open(const QString& sFilename)
+{
+	close();
+
+	m_file.setFileName(sFilename);
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	m_str.setDevice(&m_file);
+	m_str.setVersion(QDataStream::Qt_4_3);
+
+	char sMagic[sizeof(g_sCaptureMagic)];
+	qint32 nVersion = 0;
+	if (m_str.readRawData(sMagic, sizeof(sMagic)) != int(sizeof(sMagic)) || memcmp(sMagic, g_sCaptureMagic, sizeof(sMagic)) != 0)
+	{
+		close();
+		return false;
+	}
+	m_str >> nVersion;
+	if (nVersion != g_nCaptureVersion)
+	{
+		close();
+		return false;
+	}
+
+	qint32 nHardwareVersion = 0;
+	qint32 nChannels = 0;
+	m_str >> m_header.sHardwareName;
+	m_str >> nHardwareVersion;
+	m_str >> nChannels;
+	if (m_str.status() != QDataStream::Ok || nChannels < 0 || nChannels > 16)
+	{
+		close();
+		return false;
+	}
+
+	m_header.nHardwareVersion = nHardwareVersion;
+	m_header.channels.resize(nChannels);
+	for (int iChan = 0; iChan < nChannels; iChan++)
+		readChannelSettings(m_str, m_header.channels[iChan]);
+
+	return (m_str.status() == QDataStream::Ok);
+}
+
+void IdacCaptureReader::close()
+{
+	if (m_file.isOpen())
+	{
+		m_str.setDevice(NULL);
+		m_file.close();
+	}
+	m_header = IdacCaptureHeader();
+}
+
+bool IdacCaptureReader::read(QByteArray& payload, int& nBytesReceived, qint64& nTime_ns)
+{
+	if (!m_file.isOpen() || m_str.atEnd())
+		return false;
+
+	qint64 nTime;
+	qint32 nBytes;
+	m_str >> nTime >> nBytes >> payload;
+	if (m_str.status() != QDataStream::Ok)
+		return false;
+
+	nTime_ns = nTime;
+	nBytesReceived = nBytes;
+	return true;
+}
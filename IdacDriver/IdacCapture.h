@@ -0,0 +1,101 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IDACCAPTURE_H
+#define __IDACCAPTURE_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QString>
+#include <QVector>
+
+#include "IdacChannelSettings.h"
+
+
+/// Describes the device and channel settings a capture was recorded with
+class IdacCaptureHeader
+{
+public:
+	/// Hardware name of the driver which made the capture ("IDAC2" or "IDAC4")
+	QString sHardwareName;
+	/// Firmware version reported by the device
+	int nHardwareVersion;
+	/// Actual channel settings at the time sampling started
+	QVector<IdacChannelSettings> channels;
+
+	IdacCaptureHeader() : nHardwareVersion(0) {}
+};
+
+
+/// Writes the raw USB payloads which a driver receives to a file, along with the time of their arrival,
+/// so that they can later be fed through the decoder again without the device (see IdacCaptureReader).
+///
+/// Capturing is turned on by setting the environment variable GCEAD_CAPTURE_DIR to an existing directory;
+/// every sampling session then creates a new file in it.
+class IdacCaptureWriter
+{
+public:
+	IdacCaptureWriter();
+	~IdacCaptureWriter();
+
+	/// Directory in which captures should be written, or an empty string if capturing is off
+	static QString captureDir();
+
+	/// Create a new capture file in captureDir().
+	/// @returns false if capturing is off or the file couldn't be created
+	bool open(const IdacCaptureHeader& header);
+	void close();
+	bool isOpen() const { return m_file.isOpen(); }
+
+	/// Append one USB transfer.
+	/// @param nBytesReceived the byte count which the driver got back from libusb for this transfer
+	/// WARNING: ONLY TO BE CALLED FROM THE SAMPLING THREAD
+	void write(const char* payload, int nPayload, int nBytesReceived);
+
+private:
+	QFile m_file;
+	QDataStream m_str;
+	QElapsedTimer m_clock;
+};
+
+
+/// Reads back a file created by IdacCaptureWriter
+class IdacCaptureReader
+{
+public:
+	IdacCaptureReader();
+
+	/// Open the file and read its header
+	bool open(const QString& sFilename);
+	void close();
+
+	const IdacCaptureHeader& header() const { return m_header; }
+
+	/// Read the next transfer
+	/// @param nTime_ns time of arrival, counted from the start of the capture
+	/// @returns false at the end of the file or if the file is corrupt
+	bool read(QByteArray& payload, int& nBytesReceived, qint64& nTime_ns);
+
+private:
+	QFile m_file;
+	QDataStream m_str;
+	IdacCaptureHeader m_header;
+};
+
+#endif
@@ -36,6 +36,21 @@ public:
 		nExternalAmplification = 1;
 	}
 
+	bool operator==(const IdacChannelSettings& other) const
+	{
+		return
+			mEnabled == other.mEnabled &&
+			mInvert == other.mInvert &&
+			nDecimation == other.nDecimation &&
+			iRange == other.iRange &&
+			iLowcut == other.iLowcut &&
+			iHighcut == other.iHighcut &&
+			nOffset == other.nOffset &&
+			nExternalAmplification == other.nExternalAmplification;
+	}
+
+	bool operator!=(const IdacChannelSettings& other) const { return !(*this == other); }
+
 	/// Mask for enabling this channel.
 	/// For analog channels, only the first bit is relevant.
 	/// For the digital channel, each bit represents a digital signal.
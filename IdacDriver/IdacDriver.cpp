@@ -73,6 +73,34 @@ void IdacDriver::setChannelSettings(int iChan, const IdacChannelSettings& channe
 	m_settingsDesired[iChan] = channel;
 }
 
+void IdacDriver::setChannelSettings(const QVector<IdacChannelSettings>& channels)
+{
+	CHECK_PARAM_RET(channels.size() <= 3);
+
+	QMutexLocker locker(&m_settingsMutex);
+	for (int iChan = 0; iChan < channels.size(); iChan++)
+		m_settingsDesired[iChan] = channels[iChan];
+}
+
+QVector<IdacChannelSettings> IdacDriver::desiredSettingsCopy()
+{
+	QMutexLocker locker(&m_settingsMutex);
+	return m_settingsDesired;
+}
+
+void IdacDriver::configureChannels()
+{
+	QVector<IdacChannelSettings> desired = desiredSettingsCopy();
+	for (int iChan = 0; iChan < desired.size() && iChan < m_settingsActual.size(); iChan++)
+	{
+		if (desired[iChan] != m_settingsActual[iChan])
+		{
+			configureChannel(iChan);
+			m_settingsActual[iChan] = desired[iChan];
+		}
+	}
+}
+
 const QVector<IdacChannelSettings>& IdacDriver::desiredSettings()
 {
 	//QMutexLocker locker(&m_settingsMutex);
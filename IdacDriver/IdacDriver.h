@@ -26,6 +26,11 @@
 #include "IdacCaps.h"
 #include "IdacChannelSettings.h"
 #include "IdacEnums.h"
+#include "IdacSampleBlock.h"
+#include "IdacTelemetry.h"
+
+
+class IdacPreview;
 
 
 class IdacDriver : public QObject
@@ -49,10 +54,15 @@ public:
 	/// Get a list of existing error messages and then clear the internal list.
 	/// Thread-safe.
 	QStringList errorMessages();
+	/// Get the current acquisition counters.
+	/// Thread-safe and cheap enough to be called for every frame.
+	IdacTelemetrySnapshot telemetrySnapshot() const { return m_telemetry.snapshot(); }
 
 	const QVector<IdacChannelSettings>& desiredSettings();
 	const IdacChannelSettings* desiredChannelSettings(int iChan);
 	void setChannelSettings(int iChannel, const IdacChannelSettings& channel);
+	/// Set the desired settings of all channels at once
+	void setChannelSettings(const QVector<IdacChannelSettings>& channels);
 
 public:
 	/// Load up the capabilities of the current driver
@@ -69,8 +79,21 @@ public:
 	virtual bool startSampling() = 0;
 	virtual void stopSampling() = 0;
 	virtual void configureChannel(int iChan) = 0;
+	/// Send all desired channel settings which differ from the actual ones to the hardware.
+	/// The default implementation calls configureChannel() for each channel which changed;
+	/// drivers should override this to combine the changes into as few transfers as possible.
+	virtual void configureChannels();
 
 	virtual int takeData(short* digital, short* analog1, short* analog2, int maxSize) = 0;
+	/// Take ownership of all samples received since the last call.
+	/// The samples are handed over without being copied.
+	/// @returns true if any samples were available
+	virtual bool takeBlock(IdacSampleBlock& block) = 0;
+	/// Min/max display summaries maintained by the sampling thread, or NULL if the driver doesn't provide them
+	virtual IdacPreview* preview() { return NULL; }
+	/// Effective scheduling of the sampling thread while sampling in real-time mode, e.g. "SCHED_FIFO 50, CPU 2, memory locked".
+	/// Empty if real-time mode is off or the driver has no sampling thread.
+	virtual QString samplingThreadStatus() { return QString(); }
 
 protected:
 	void setHardwareName(const QString& s) { m_sHardwareName = s; }
@@ -78,7 +101,11 @@ protected:
 	void setHighcutStrings(const QStringList& strings) { m_asHighcutStrings = strings; }
 	void setLowcutStrings(const QStringList& strings) { m_asLowcutStrings = strings; }
 	void addError(const QString& s);
+	/// Counters to be updated by the derived drivers
+	IdacTelemetry* telemetry() { return &m_telemetry; }
 
+	/// Consistent copy of the desired settings, even while they're being changed from another thread
+	QVector<IdacChannelSettings> desiredSettingsCopy();
 	const QVector<IdacChannelSettings>& actualSettings() { return m_settingsActual; }
 	IdacChannelSettings* actualChannelSettings(int iChan);
 
@@ -91,6 +118,8 @@ private:
 	QMutex m_errorMutex;
 	QStringList m_errors;
 
+	IdacTelemetry m_telemetry;
+
 	IdacCaps m_caps;
 	// NOTE: I don't think this mutex is necessary, because all members are independent and can be set atomically -- ellis, 2009-04-26
 	QMutex m_settingsMutex;
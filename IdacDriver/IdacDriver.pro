@@ -15,6 +15,13 @@ HEADERS += IdacDriver.h \
     IdacChannelSettings.h \
     IdacSettings.h \
     Sample.h \
+    IdacSampleBlock.h \
+    IdacPreTrigger.h \
+    IdacSignalMonitor.h \
+    IdacPreview.h \
+    IdacTelemetry.h \
+    IdacCapture.h \
+    IdacRealtime.h \
     Sleeper.h \
     IdacDriverUsb.h \
     IdacDriverSamplingThread.h \
@@ -25,6 +32,12 @@ HEADERS += IdacDriver.h \
 SOURCES += IdacDriver.cpp \
     IdacDriverUsb.cpp \
     IdacDriverWithThread.cpp \
+    IdacPreTrigger.cpp \
+    IdacSignalMonitor.cpp \
+    IdacPreview.cpp \
+    IdacTelemetry.cpp \
+    IdacCapture.cpp \
+    IdacRealtime.cpp \
     IdacDriverUsbEs.cpp \
     IdacDriverUsb24Base.cpp
 
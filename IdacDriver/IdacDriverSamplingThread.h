@@ -18,6 +18,7 @@
 #ifndef __IDACDRIVERSAMPLINGTHREAD_H
 #define __IDACDRIVERSAMPLINGTHREAD_H
 
+#include <QSemaphore>
 #include <QThread>
 
 #include "IdacDriverWithThread.h"
@@ -31,14 +32,23 @@ public:
 		this->driver = driver;
 	}
 
+	/// Wait until the thread has applied its scheduling options and is about to start sampling
+	void waitUntilPrepared()
+	{
+		prepared.acquire();
+	}
+
 protected:
 	void run()
 	{
+		driver->prepareSamplingThread();
+		prepared.release();
 		driver->sampleLoop();
 	}
 
 private:
 	IdacDriverWithThread* driver;
+	QSemaphore prepared;
 };
 
 #endif
@@ -20,11 +20,139 @@
 #include <libusb-1.0/libusb.h>
 
 #include <QtDebug>
+#include <QDateTime>
 #include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QMutex>
+#include <QMutexLocker>
 
 #include <Check.h>
 
-#include "Sleeper.h"
+
+/// Largest block written to the EZ-USB RAM in one control transfer (the same limit fxload uses)
+static const int g_nFirmwareChunkMax = 1023;
+/// Largest block sent to the FPGA in one bulk transfer
+static const int g_nBulkChunkMax = 64 * 1024;
+
+/// Contiguous block of firmware memory
+struct FirmwareRange
+{
+	quint32 address;
+	QByteArray data;
+};
+
+/// FPGA image read from a file, along with the file's modification time
+struct CachedImage
+{
+	QDateTime modified;
+	QByteArray data;
+};
+
+static QMutex g_cacheMutex;
+static QHash<const INTEL_HEX_RECORD*, QList<FirmwareRange> > g_firmwareCache;
+static QHash<QString, CachedImage> g_imageCache;
+
+
+/// Merge the records of a firmware into contiguous blocks of at most g_nFirmwareChunkMax bytes.
+/// The result is cached, since the firmware tables are compiled in.
+static QList<FirmwareRange> firmwareRanges(INTEL_HEX_RECORD firmware[])
+{
+	QMutexLocker locker(&g_cacheMutex);
+	if (g_firmwareCache.contains(firmware))
+		return g_firmwareCache.value(firmware);
+
+	QList<FirmwareRange> ranges;
+	for (int i = 0; firmware[i].type == 0; i++)
+	{
+		const INTEL_HEX_RECORD& d = firmware[i];
+		if (!ranges.isEmpty())
+		{
+			FirmwareRange& range = ranges.last();
+			if (d.address == range.address + range.data.size() && range.data.size() + int(d.length) <= g_nFirmwareChunkMax)
+			{
+				range.data.append((const char*) d.data, d.length);
+				continue;
+			}
+		}
+
+		FirmwareRange range;
+		range.address = d.address;
+		range.data = QByteArray((const char*) d.data, d.length);
+		ranges << range;
+	}
+
+	g_firmwareCache.insert(firmware, ranges);
+	return ranges;
+}
+
+static int hexDigitValue(char c)
+{
+	if (c >= '0' && c <= '9')
+		return c - '0';
+	if (c >= 'a' && c <= 'f')
+		return c - 'a' + 10;
+	if (c >= 'A' && c <= 'F')
+		return c - 'A' + 10;
+	return -1;
+}
+
+/// Convert hexadecimal text into binary, ignoring whitespace
+static QByteArray decodeHex(const QByteArray& hex)
+{
+	QByteArray bin;
+	bin.resize(hex.size() / 2);
+	char* p = bin.data();
+
+	int nHigh = -1;
+	for (int i = 0; i < hex.size(); i++)
+	{
+		int n = hexDigitValue(hex[i]);
+		if (n < 0)
+			continue;
+		if (nHigh < 0)
+			nHigh = n;
+		else
+		{
+			*p++ = char((nHigh << 4) | n);
+			nHigh = -1;
+		}
+	}
+
+	bin.resize(p - bin.constData());
+	return bin;
+}
+
+/// Read an FPGA image, decoding it from hexadecimal text if bHex is set.
+/// Images are cached until the file's modification time changes.
+/// @returns false if the file couldn't be read
+static bool loadImage(const QString& sFilename, bool bHex, QByteArray& image)
+{
+	QFileInfo info(sFilename);
+	QString sKey = (bHex ? "hex:" : "bin:") + info.absoluteFilePath();
+
+	QMutexLocker locker(&g_cacheMutex);
+	if (g_imageCache.contains(sKey))
+	{
+		const CachedImage& cached = g_imageCache[sKey];
+		if (cached.modified == info.lastModified())
+		{
+			image = cached.data;
+			return true;
+		}
+	}
+
+	QFile file(sFilename);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	CachedImage cached;
+	cached.modified = info.lastModified();
+	cached.data = (bHex) ? decodeHex(file.readAll()) : file.readAll();
+	g_imageCache.insert(sKey, cached);
+	image = cached.data;
+	return true;
+}
 
 
 IdacDriverUsb::IdacDriverUsb(UsbDevice* device, UsbHandle* handle, QObject* parent)
@@ -119,12 +247,9 @@ bool IdacDriverUsb::sendFirmware(INTEL_HEX_RECORD firmware[])
 
 	if (res >= 0)
 	{
-		int i = 0;
-		while (firmware[i].type == 0)
+		foreach (const FirmwareRange& range, firmwareRanges(firmware))
 		{
-			INTEL_HEX_RECORD& d = firmware[i];
-
-			res = myusb_control_transfer(0x40, 0xA0, d.address, 0, d.data, d.length, 5000);
+			res = myusb_control_transfer(0x40, 0xA0, range.address, 0, (unsigned char*) range.data.constData(), range.data.size(), 5000);
 			CHECK_USBRESULT_NORET(res);
 			if (res < 0)
 			{
@@ -133,7 +258,6 @@ bool IdacDriverUsb::sendFirmware(INTEL_HEX_RECORD firmware[])
 				qDebug() << "Failed to init: res =" << res;
 				break;
 			}
-			i++;
 		}
 	}
 
@@ -146,73 +270,38 @@ bool IdacDriverUsb::sendFirmware(INTEL_HEX_RECORD firmware[])
 		bOk = false;
 	}
 
+	// The device now re-enumerates; IdacDriverManager waits for it to come back
 	m_handle = NULL;
 
-	Sleeper::msleep(5000);
-
 	return bOk;
 }
 
 bool IdacDriverUsb::sendHexFile(QString sFilename)
 {
-	QFile file(sFilename);
-	if (!file.open(QIODevice::ReadOnly | QIODevice::Text))
+	QByteArray bin;
+	if (!loadImage(sFilename, true, bin))
 	{
 		logUsbError(__FILE__, __LINE__, QString("File not found: %0").arg(sFilename));
 		return false;
 	}
 
-	QByteArray hex = file.readAll();
-	file.close();
-
-	return sendHexData(hex);
+	return sendBinData(bin);
 }
 
 bool IdacDriverUsb::sendHexData(const QByteArray& hex)
 {
-	bool b = true;
-	quint8* buffer = new quint8[5000];
-
-	int iHex = 0;
-	while (iHex + 1 < hex.count() && b) {
-		int nHex = hex.count() - iHex;
-		if (nHex > 10000)
-			nHex = 10000;
-
-		int nData = nHex / 2;
-		QString sHex;
-		for (int iData = 0; iData < nData; iData++)
-		{
-			sHex = hex[iHex++];
-			sHex += hex[iHex++];
-			buffer[iData] = (quint8) sHex.toInt(NULL, 16);
-		}
-
-		int res = myusb_bulk_write(
-				1, // end point, TODO: don't hardcode the endpoint? -- ellis, 2009-04-26
-				buffer, // bytes
-				nData, // size
-				5000); // timeout
-		CHECK_USBRESULT_NORET(res);
-		b = (res >= 0);
-	}
-
-	delete[] buffer;
-	return b;
+	return sendBinData(decodeHex(hex));
 }
 
 bool IdacDriverUsb::sendBinFile(QString sFilename)
 {
-	QFile file(sFilename);
-	if (!file.open(QIODevice::ReadOnly))
+	QByteArray bin;
+	if (!loadImage(sFilename, false, bin))
 	{
 		logUsbError(__FILE__, __LINE__, QString("File not found: %0").arg(sFilename));
 		return false;
 	}
 
-	QByteArray bin = file.readAll();
-	file.close();
-
 	return sendBinData(bin);
 }
 
@@ -223,8 +312,8 @@ bool IdacDriverUsb::sendBinData(const QByteArray& bin)
 	int iData = 0;
 	while (iData < bin.count() && b) {
 		int nData = bin.count() - iData;
-		if (nData > 5000)
-			nData = 5000;
+		if (nData > g_nBulkChunkMax)
+			nData = g_nBulkChunkMax;
 
 		int res = myusb_bulk_write(
 				1, // end point, TODO: don't hardcode the endpoint? -- ellis, 2009-04-26
@@ -53,9 +53,14 @@ protected:
 	bool sendOutgoingMessage(int requestId, int timeout = 5000);
 	bool sendOutgoingMessage(int requestId, quint8* buffer, int size, int timeout = 5000);
 	bool sendIncomingMessage(int requestId, quint8* buffer, int size, int timeout = 5000);
+	/// Upload the firmware to the EZ-USB controller and restart it.
+	/// The device then re-enumerates, so this handle is no longer valid afterwards.
 	bool sendFirmware(INTEL_HEX_RECORD firmware[]);
+	/// Send a file with the FPGA image in hexadecimal text form.
+	/// The decoded image is cached, so the file is only read again when it changes.
 	bool sendHexFile(QString sFilename);
 	bool sendHexData(const QByteArray& hex);
+	/// Send a binary FPGA image (cached like sendHexFile())
 	bool sendBinFile(QString sFilename);
 	bool sendBinData(const QByteArray& hex);
 
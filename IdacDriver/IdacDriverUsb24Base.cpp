@@ -15,16 +15,26 @@ bool IdacDriverUsb24Base::checkUsbFirmwareReady()
 {
 	CHECK_PRECOND_RETVAL(handle() != NULL, false);
 
-	bool b = false;
 	libusb_device* dev = libusb_get_device(handle());
 	CHECK_ASSERT_RETVAL(dev != NULL, false);
+	return isUsbFirmwareReady(dev);
+}
+
+bool IdacDriverUsb24Base::isUsbFirmwareReady(UsbDevice* device)
+{
+	CHECK_PARAM_RETVAL(device != NULL, false);
+
+	bool b = false;
+	libusb_device* dev = (libusb_device*) device;
 	libusb_config_descriptor* config = NULL;
 	int res = libusb_get_config_descriptor(dev, 0, &config);
-	CHECK_USBRESULT_RETVAL(res, false);
+	if (res < 0)
+		return false;
 	if (config->bNumInterfaces == 1) {
 		const libusb_interface* interface = &config->interface[0];
 		b = (interface->num_altsetting == 1);
 	}
+	libusb_free_config_descriptor(config);
 
 	//interface[0].altsetting[0].bNumEndpoints != 3
 	return b;
@@ -74,3 +84,33 @@ bool IdacDriverUsb24Base::claim(bool bUnhalt)
 
 	return true;
 }
+
+void IdacDriverUsb24Base::startCapture(int nHardwareVersion)
+{
+	m_capture.close();
+	if (IdacCaptureWriter::captureDir().isEmpty())
+		return;
+
+	IdacCaptureHeader header;
+	header.sHardwareName = hardwareName();
+	header.nHardwareVersion = nHardwareVersion;
+	header.channels = actualSettings();
+	m_capture.open(header);
+}
+
+bool IdacDriverUsb24Base::waitForReplay(const QElapsedTimer& clock, qint64 nTime_ns, bool bRealTime)
+{
+	if (bRealTime)
+	{
+		// Sleep in short steps so that stopping isn't delayed by gaps in the capture
+		qint64 nWait_ms;
+		while (m_bSampling && (nWait_ms = (nTime_ns - clock.nsecsElapsed()) / 1000000) > 0)
+			msleep((unsigned long) qMin(nWait_ms, qint64(50)));
+	}
+	else
+	{
+		while (m_bSampling && IdacDataAvail() > sampleBufferCapacity() / 2)
+			msleep(1);
+	}
+	return m_bSampling;
+}
@@ -20,7 +20,9 @@
 
 
 #include <QtGlobal> // for quint8 and related types
+#include <QElapsedTimer>
 
+#include <IdacDriver/IdacCapture.h>
 #include <IdacDriver/IdacDriverUsb.h>
 #include <IdacDriver/IdacSettings.h>
 
@@ -38,11 +40,24 @@ public:
 	bool checkUsbFirmwareReady();
 	bool checkDataFirmwareReady();
 
+	/// Whether the given device is running our USB firmware (this doesn't require opening it)
+	static bool isUsbFirmwareReady(UsbDevice* device);
+
 protected:
 	bool claim(bool bUnhalt);
+	/// Start writing the received USB payloads to a capture file, if capturing was requested.
+	/// Must be called after the actual channel settings have been set and before the sampling thread starts.
+	void startCapture(int nHardwareVersion);
+	/// Wait until the next captured transfer should be replayed.
+	/// In real-time mode, that's when nTime_ns has passed on the clock;
+	/// otherwise it's as soon as the sample buffer is no more than half full, so that no samples get dropped.
+	/// @returns false if sampling was stopped in the meantime
+	bool waitForReplay(const QElapsedTimer& clock, qint64 nTime_ns, bool bRealTime);
 
 protected:
 	bool m_bFpgaProgrammed;
+	/// Capture of the raw USB payloads (only open if GCEAD_CAPTURE_DIR is set)
+	IdacCaptureWriter m_capture;
 };
 
 #endif
@@ -1,43 +1,105 @@
 #include "IdacDriverWithThread.h"
 
+#include <string.h>
+
 #include <Check.h>
 
 #include "IdacDriverSamplingThread.h"
+#include "IdacRealtime.h"
 #include "Sleeper.h"
 
 
 const int g_nSampleMax = 600;
+/// Number of free blocks kept ready for the sampling thread
+const int g_nBlockPoolSize = 8;
+
+
+static bool lockBlock(const IdacSampleBlock& block)
+{
+	bool bLocked = true;
+	for (int iChan = 0; iChan < 3; iChan++)
+	{
+		const QVector<short>& samples = block.channel(iChan);
+		bLocked = IdacRealtime::lockMemory(samples.constData(), samples.capacity() * sizeof(short)) && bLocked;
+	}
+	return bLocked;
+}
 
 
 IdacDriverWithThread::IdacDriverWithThread(QObject* parent)
 	: IdacDriver(parent)
 {
 	m_bSampling = false;
-	m_iSampleRead = 0;
-	m_iSampleWrite = 0;
-	m_nSamplesInBuffer = 0;
 	m_recordThread = NULL;
+	m_nSamplesInBuffer = 0;
+	m_iFirstSampleInBuffer = 0;
+	m_nFirstSampleTime_ns = 0;
+	m_bLockBlocks = false;
+	m_clock.start();
 
-	m_samplesDigital = new short[g_nSampleMax];
-	m_samplesAnalog1 = new short[g_nSampleMax];
-	m_samplesAnalog2 = new short[g_nSampleMax];
+	// Room for the pool plus the blocks which the consumer may return while it is full
+	m_blocksFree.reserve(2 * g_nBlockPoolSize);
+	IdacSampleBlock block;
+	recycleBlock(block);
+	swapWriteBlock(block);
+	m_iSampleRead = 0;
 }
 
 IdacDriverWithThread::~IdacDriverWithThread() {
-	delete[] m_samplesDigital;
-	delete[] m_samplesAnalog1;
-	delete[] m_samplesAnalog2;
 }
 
 void IdacDriverWithThread::startSamplingThread() {
 	CHECK_PRECOND_RET(m_recordThread == NULL);
 
 	m_bSampling = true;
+	m_sampleMutex.lock();
+	IdacSampleBlock block;
+	swapWriteBlock(block);
+	m_iFirstSampleInBuffer = 0;
+	// Set again by lockSamplingBuffers() in real-time mode
+	m_bLockBlocks = false;
+	m_sampleMutex.unlock();
+	recycleBlock(block);
+	recycleBlock(m_blockRead);
 	m_iSampleRead = 0;
-	m_iSampleWrite = 0;
-	m_nSamplesInBuffer = 0;
+	m_preview.restart();
+	telemetry()->reset(g_nSampleMax);
 	m_recordThread = new IdacDriverSamplingThread(this);
 	m_recordThread->start(QThread::TimeCriticalPriority);
+	// So that the status is up to date once sampling has been reported as started
+	m_recordThread->waitUntilPrepared();
+}
+
+void IdacDriverWithThread::prepareSamplingThread()
+{
+	IdacRealtimeOptions options = IdacRealtimeOptions::fromEnvironment();
+	QString sStatus;
+	if (options.isEnabled())
+	{
+		IdacRealtimeStatus status = IdacRealtime::applyToCurrentThread(options);
+		status.bMemoryLocked = lockSamplingBuffers() && status.bMemoryLocked;
+		sStatus = status.toString();
+	}
+
+	QMutexLocker locker(&m_sampleMutex);
+	m_sSamplingThreadStatus = sStatus;
+}
+
+bool IdacDriverWithThread::lockSamplingBuffers()
+{
+	// Lock the whole pool once, so that switching blocks while sampling doesn't touch new pages
+	QMutexLocker locker(&m_sampleMutex);
+	m_bLockBlocks = true;
+	bool bLocked = lockBlock(m_blockWrite);
+	for (int i = 0; i < m_blocksFree.size(); i++)
+		bLocked = lockBlock(m_blocksFree[i]) && bLocked;
+	return bLocked;
+}
+
+QString IdacDriverWithThread::samplingThreadStatus()
+{
+	QMutexLocker locker(&m_sampleMutex);
+	return m_sSamplingThreadStatus;
 }
 
 void IdacDriverWithThread::stopSampling()
@@ -61,37 +123,135 @@ void IdacDriverWithThread::msleep(unsigned long msecs) {
 }
 
 bool IdacDriverWithThread::addSample(short digital, short analog1, short analog2) {
-	if (m_nSamplesInBuffer < g_nSampleMax - 1) {
-		m_sampleMutex.lock();
-		m_samplesDigital[m_iSampleWrite] = digital;
-		m_samplesAnalog1[m_iSampleWrite] = analog1;
-		m_samplesAnalog2[m_iSampleWrite] = analog2;
-		m_iSampleWrite++;
-		if (m_iSampleWrite == g_nSampleMax)
-			m_iSampleWrite = 0;
-		m_nSamplesInBuffer++;
-		m_sampleMutex.unlock();
-		return true;
+	QMutexLocker locker(&m_sampleMutex);
+	if (m_nSamplesInBuffer >= g_nSampleMax)
+	{
+		telemetry()->addDroppedSample();
+		return false;
 	}
-	return false;
+
+	if (m_nSamplesInBuffer == 0)
+		m_nFirstSampleTime_ns = m_clock.nsecsElapsed();
+
+	// Write directly into the block which will later be handed to the consumer
+	m_samplesDigital[m_nSamplesInBuffer] = digital;
+	m_samplesAnalog1[m_nSamplesInBuffer] = analog1;
+	m_samplesAnalog2[m_nSamplesInBuffer] = analog2;
+	int iSample = m_iFirstSampleInBuffer + m_nSamplesInBuffer;
+	m_nSamplesInBuffer++;
+	int nSamplesInBuffer = m_nSamplesInBuffer;
+	locker.unlock();
+
+	telemetry()->addSample();
+	telemetry()->setBufferLevel(nSamplesInBuffer);
+
+	// Only this thread touches the producer side of the preview, so no lock is needed
+	m_preview.addSample(iSample, digital, analog1, analog2);
+	return true;
+}
+
+int IdacDriverWithThread::sampleBufferCapacity() const
+{
+	return g_nSampleMax;
+}
+
+void IdacDriverWithThread::swapWriteBlock(IdacSampleBlock& block)
+{
+	// Truncate before handing the block out, while the shrinking can still be done in place
+	m_blockWrite.truncate(m_nSamplesInBuffer);
+	m_blockWrite.iFirstSample = m_iFirstSampleInBuffer;
+	block = m_blockWrite;
+	m_iFirstSampleInBuffer += m_nSamplesInBuffer;
+	// The consumer now holds the only reference to the filled block
+	m_blockWrite = IdacSampleBlock();
+
+	if (!m_blocksFree.isEmpty())
+	{
+		// Recycled blocks already have their full size, so taking one doesn't allocate
+		m_blockWrite = m_blocksFree.last();
+		m_blocksFree.removeLast();
+	}
+	else
+	{
+		// The consumer hasn't kept up with returning blocks
+		m_blockWrite = allocateBlock(m_bLockBlocks);
+		telemetry()->addBlockAllocation();
+	}
+	m_samplesDigital = m_blockWrite.digital.data();
+	m_samplesAnalog1 = m_blockWrite.analog1.data();
+	m_samplesAnalog2 = m_blockWrite.analog2.data();
+	m_nSamplesInBuffer = 0;
+}
+
+void IdacDriverWithThread::recycleBlock(IdacSampleBlock& block)
+{
+	IdacSampleBlock recycled;
+	if (block.isDetached() && block.capacity() >= g_nSampleMax)
+		recycled = block;
+	// Release the consumer's reference, so that the pool holds the only one
+	block = IdacSampleBlock();
+	if (recycled.capacity() >= g_nSampleMax)
+		recycled.resize(g_nSampleMax);
+
+	m_sampleMutex.lock();
+	if (recycled.size() == g_nSampleMax && m_blocksFree.size() < m_blocksFree.capacity())
+		m_blocksFree << recycled;
+	int nMissing = g_nBlockPoolSize - m_blocksFree.size();
+	bool bLock = m_bLockBlocks;
+	m_sampleMutex.unlock();
+
+	// Replace the blocks which the consumer is still holding on to (e.g. for a pre-trigger window)
+	for (; nMissing > 0; nMissing--)
+	{
+		IdacSampleBlock fresh = allocateBlock(bLock);
+		QMutexLocker locker(&m_sampleMutex);
+		m_blocksFree << fresh;
+	}
+}
+
+IdacSampleBlock IdacDriverWithThread::allocateBlock(bool bLock)
+{
+	IdacSampleBlock block(g_nSampleMax);
+	if (bLock)
+		lockBlock(block);
+	return block;
+}
+
+bool IdacDriverWithThread::takeBlock(IdacSampleBlock& block)
+{
+	recycleBlock(block);
+
+	QMutexLocker locker(&m_sampleMutex);
+	if (m_nSamplesInBuffer == 0)
+		return false;
+
+	// The oldest sample in the block has been waiting the longest
+	qint64 nLatency_ns = m_clock.nsecsElapsed() - m_nFirstSampleTime_ns;
+	swapWriteBlock(block);
+	locker.unlock();
+
+	telemetry()->addLatency(nLatency_ns);
+	return true;
 }
 
 int IdacDriverWithThread::takeData(short* digital, short* analog1, short* analog2, int maxSize)
 {
 	int size = 0;
-	while (size < maxSize && m_nSamplesInBuffer > 0)
+	while (size < maxSize)
 	{
-		size++;
-		*digital++ = m_samplesDigital[m_iSampleRead];
-		*analog1++ = m_samplesAnalog1[m_iSampleRead];
-		*analog2++ = m_samplesAnalog2[m_iSampleRead];
-		m_iSampleRead++;
-		if (m_iSampleRead == g_nSampleMax)
+		if (m_iSampleRead >= m_blockRead.size())
+		{
 			m_iSampleRead = 0;
+			if (!takeBlock(m_blockRead))
+				break;
+		}
 
-		m_sampleMutex.lock();
-		m_nSamplesInBuffer--;
-		m_sampleMutex.unlock();
+		int n = qMin(maxSize - size, m_blockRead.size() - m_iSampleRead);
+		memcpy(digital + size, m_blockRead.digital.constData() + m_iSampleRead, n * sizeof(short));
+		memcpy(analog1 + size, m_blockRead.analog1.constData() + m_iSampleRead, n * sizeof(short));
+		memcpy(analog2 + size, m_blockRead.analog2.constData() + m_iSampleRead, n * sizeof(short));
+		m_iSampleRead += n;
+		size += n;
 	}
 	return size;
 }
@@ -20,8 +20,12 @@
 
 #include "IdacDriver.h"
 
+#include <QElapsedTimer>
 #include <QMutex>
 
+#include "IdacPreview.h"
+#include "IdacSampleBlock.h"
+
 
 class IdacDriverSamplingThread;
 
@@ -36,15 +40,26 @@ public:
 public:
 	virtual void stopSampling();
 	virtual int takeData(short* digital, short* analog1, short* analog2, int maxSize);
+	virtual bool takeBlock(IdacSampleBlock& block);
+	virtual IdacPreview* preview() { return &m_preview; }
+	virtual QString samplingThreadStatus();
 
 // For ES drivers
 public:
-	int IdacDataAvail() const { return m_nSamplesInBuffer; }
+	int IdacDataAvail() const { return m_nSamplesInBuffer + m_blockRead.size() - m_iSampleRead; }
 
 protected:
 	friend class IdacDriverSamplingThread;
 	/// WARNING: ONLY TO BE CALLED FROM IdacDriverSamplingThread
 	virtual void sampleLoop() = 0;
+	/// Apply the real-time options (see IdacRealtimeOptions) to the sampling thread before sampleLoop() is called.
+	/// WARNING: ONLY TO BE CALLED FROM IdacDriverSamplingThread
+	void prepareSamplingThread();
+	/// Lock the buffers which the sampling thread writes into RAM.
+	/// Only called in real-time mode.  Overrides must call the base implementation,
+	/// which locks the pool of sample blocks.
+	/// @returns false if any of the buffers couldn't be locked
+	virtual bool lockSamplingBuffers();
 
 protected:
 	void startSamplingThread();
@@ -52,19 +67,51 @@ protected:
 	void msleep(unsigned long msecs);
 	/// @returns true if there was no overflow, false if there was overflow
 	bool addSample(short digital, short analog1, short analog2);
+	/// Number of samples the buffer can hold before addSample() starts dropping them
+	int sampleBufferCapacity() const;
 
 protected:
 	bool m_bSampling;
 
 private:
-	int m_iSampleRead;
-	int m_iSampleWrite;
+	/// Swap in a free block from the pool and return the filled one.
+	/// Must be called with m_sampleMutex locked.
+	void swapWriteBlock(IdacSampleBlock& block);
+	/// Return the consumer's previous block to the pool if nothing else refers to it any more,
+	/// and allocate blocks for those which are still in use, so that the pool stays full.
+	/// New blocks are allocated (and locked) without holding m_sampleMutex, so that the sampling thread isn't held up.
+	/// Must be called with m_sampleMutex unlocked.
+	void recycleBlock(IdacSampleBlock& block);
+	/// Allocate a block with room for g_nSampleMax samples, locking it into RAM if bLock is set
+	static IdacSampleBlock allocateBlock(bool bLock);
+
+private:
+	/// Block currently being filled by the sampling thread
+	IdacSampleBlock m_blockWrite;
+	/// Preallocated blocks, which the sampling thread switches to once m_blockWrite has been taken
+	QVector<IdacSampleBlock> m_blocksFree;
+	/// Whether the blocks have to be locked into RAM (real-time mode)
+	bool m_bLockBlocks;
+	/// Number of samples in m_blockWrite
 	int m_nSamplesInBuffer;
+	/// Index of the first sample in m_blockWrite, counted from the start of sampling
+	int m_iFirstSampleInBuffer;
+	/// Time at which the first sample in m_blockWrite arrived (according to m_clock)
+	qint64 m_nFirstSampleTime_ns;
+	/// Clock for measuring how long samples wait in the buffer
+	QElapsedTimer m_clock;
+	/// Cached data pointers into m_blockWrite
 	short* m_samplesDigital;
 	short* m_samplesAnalog1;
 	short* m_samplesAnalog2;
+	/// Block which takeData() is reading from (only used by the ES drivers)
+	IdacSampleBlock m_blockRead;
+	int m_iSampleRead;
 	IdacDriverSamplingThread* m_recordThread;
 	QMutex m_sampleMutex;
+	IdacPreview m_preview;
+	/// Effective scheduling of the sampling thread (empty if real-time mode is off)
+	QString m_sSamplingThreadStatus;
 };
 
 #endif
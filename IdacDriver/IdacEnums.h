@@ -55,6 +55,8 @@ enum IdacCommand
 	IdacCommand_ConfigCh0,
 	IdacCommand_ConfigCh1,
 	IdacCommand_ConfigCh2,
+	/// Apply all channel settings which differ from the ones last sent to the hardware
+	IdacCommand_ConfigChannels,
 };
 
 #endif
@@ -0,0 +1,102 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IdacPreTrigger.h"
+
+#include <Check.h>
+
+
+IdacPreTrigger::IdacPreTrigger()
+{
+	m_bArmed = false;
+	m_nWindow = 0;
+	m_nTriggerMask = 0x01;
+	m_nTriggerPrev = -1;
+	m_iTriggerSample = -1;
+	m_nSamples = 0;
+}
+
+void IdacPreTrigger::arm(int nWindow, short nTriggerMask)
+{
+	CHECK_PARAM_RET(nWindow >= 0);
+
+	m_bArmed = true;
+	m_nWindow = nWindow;
+	m_nTriggerMask = nTriggerMask;
+	m_nTriggerPrev = -1;
+	m_iTriggerSample = -1;
+	m_blocks.clear();
+	m_nSamples = 0;
+}
+
+void IdacPreTrigger::disarm()
+{
+	m_bArmed = false;
+	m_blocks.clear();
+	m_nSamples = 0;
+}
+
+bool IdacPreTrigger::add(const IdacSampleBlock& block)
+{
+	CHECK_PRECOND_RETVAL(m_bArmed, false);
+	if (block.isEmpty())
+		return false;
+
+	m_blocks << block;
+	m_nSamples += block.size();
+
+	// Look for a rising edge.  If the trigger is already on when we start waiting, it has to go off first.
+	const short* digital = block.digital.constData();
+	const int nSamples = block.size();
+	for (int i = 0; i < nSamples; i++)
+	{
+		int nTrigger = ((digital[i] & m_nTriggerMask) != 0) ? 1 : 0;
+		if (nTrigger == 1 && m_nTriggerPrev == 0)
+		{
+			m_iTriggerSample = block.iFirstSample + i;
+			return true;
+		}
+		m_nTriggerPrev = nTrigger;
+	}
+
+	// Release the blocks which are older than the window
+	while (m_blocks.size() > 1 && m_nSamples - m_blocks.first().size() >= m_nWindow)
+	{
+		m_nSamples -= m_blocks.first().size();
+		m_blocks.removeFirst();
+	}
+
+	return false;
+}
+
+QList<IdacSampleBlock> IdacPreTrigger::takeBlocks(int& nSkip)
+{
+	nSkip = 0;
+	QList<IdacSampleBlock> blocks;
+	CHECK_PRECOND_RETVAL(m_iTriggerSample >= 0, blocks);
+
+	// Drop the blocks which lie completely before the window
+	const int iStart = m_iTriggerSample - m_nWindow;
+	while (m_blocks.size() > 1 && m_blocks.first().iFirstSample + m_blocks.first().size() <= iStart)
+		m_blocks.removeFirst();
+	if (!m_blocks.isEmpty())
+		nSkip = qBound(0, iStart - m_blocks.first().iFirstSample, m_blocks.first().size() - 1);
+
+	blocks.swap(m_blocks);
+	disarm();
+	return blocks;
+}
@@ -0,0 +1,70 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IDACPRETRIGGER_H
+#define __IDACPRETRIGGER_H
+
+#include <QList>
+
+#include "IdacSampleBlock.h"
+
+
+/// Holds on to the most recent sample blocks while a recording waits for its trigger,
+/// so that the samples before the trigger can become part of the recording.
+///
+/// The blocks are kept by reference (QVector is implicitly shared), so waiting doesn't copy any samples,
+/// and blocks which are no longer needed for the pre-trigger window are released right away,
+/// so the memory used is bounded by the window no matter how long the wait is.
+/// When the trigger fires, the blocks are handed on as they are.
+class IdacPreTrigger
+{
+public:
+	IdacPreTrigger();
+
+	/// Start waiting for a rising edge of the trigger bit in the digital channel
+	/// @param nWindow number of samples before the trigger which should be kept
+	/// @param nTriggerMask bit of the (converted) digital channel which carries the trigger, where 1 = on
+	void arm(int nWindow, short nTriggerMask);
+	/// Stop waiting and release the blocks
+	void disarm();
+	/// Whether we're waiting for the trigger
+	bool isArmed() const { return m_bArmed; }
+
+	/// Add the next block of samples.  Its digital channel must already be converted so that 1 = on.
+	/// @returns true if the trigger fired in this block, in which case the pre-trigger window
+	/// and the block should be taken with takeBlocks()
+	bool add(const IdacSampleBlock& block);
+	/// Index of the sample at which the trigger fired, counted from the start of sampling
+	int triggerSample() const { return m_iTriggerSample; }
+	/// Take the blocks which start the recording and disarm.
+	/// The first block is to be used from sample nSkip on, so that at most nWindow samples precede the trigger.
+	QList<IdacSampleBlock> takeBlocks(int& nSkip);
+
+private:
+	bool m_bArmed;
+	int m_nWindow;
+	short m_nTriggerMask;
+	/// State of the trigger bit in the last sample seen (-1 before the first sample)
+	int m_nTriggerPrev;
+	int m_iTriggerSample;
+	/// Blocks covering at least the last m_nWindow samples
+	QList<IdacSampleBlock> m_blocks;
+	/// Number of samples in m_blocks
+	int m_nSamples;
+};
+
+#endif
@@ -0,0 +1,169 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IdacPreview.h"
+
+#include <string.h>
+
+#include <QMutexLocker>
+
+#include <Check.h>
+
+
+/// Minimum number of samples between two published snapshots
+const int g_nSamplesPerPublish = 5;
+
+
+IdacPreview::IdacPreview()
+	: m_nTimebaseRequested(0), m_iMiddle(1)
+{
+	m_nSamplesPerBucketRequested = 0;
+	m_nBucketsRequested = 0;
+	m_iSampleOriginRequested = 0;
+
+	m_nTimebaseApplied = 0;
+	m_nSamplesPerBucket = 0;
+	m_iSampleOrigin = 0;
+	m_iBucket = -1;
+	m_iBucketSampleEnd = 0;
+	memset(&m_bucket, 0, sizeof(m_bucket));
+	m_iBucketFirst = -1;
+	m_iBucketEnd = 0;
+	m_nSamplesSincePublish = 0;
+
+	m_iBack = 0;
+	m_iFront = 2;
+}
+
+void IdacPreview::setTimebase(double nSamplesPerBucket, int nBuckets, int iSampleOrigin)
+{
+	CHECK_PARAM_RET(nSamplesPerBucket >= 1);
+	CHECK_PARAM_RET(nBuckets >= 0);
+
+	QMutexLocker locker(&m_timebaseMutex);
+	m_nSamplesPerBucketRequested = nSamplesPerBucket;
+	m_nBucketsRequested = nBuckets;
+	m_iSampleOriginRequested = iSampleOrigin;
+	m_nTimebaseRequested.fetchAndAddOrdered(1);
+}
+
+void IdacPreview::restart()
+{
+	applyTimebase();
+}
+
+void IdacPreview::applyTimebase()
+{
+	m_timebaseMutex.lock();
+	m_nTimebaseApplied = m_nTimebaseRequested.load();
+	m_nSamplesPerBucket = m_nSamplesPerBucketRequested;
+	m_iSampleOrigin = m_iSampleOriginRequested;
+	int nBuckets = m_nBucketsRequested;
+	m_timebaseMutex.unlock();
+
+	m_ring.resize(nBuckets);
+	m_iBucket = -1;
+	m_iBucketFirst = -1;
+	m_iBucketEnd = 0;
+
+	// Let the reader know right away that the old buckets are gone
+	publish();
+}
+
+int IdacPreview::bucketStart(int iBucket) const
+{
+	return m_iSampleOrigin + int(iBucket * m_nSamplesPerBucket + 0.5);
+}
+
+void IdacPreview::addSample(int iSample, short digital, short analog1, short analog2)
+{
+	if (m_nTimebaseRequested.load() != m_nTimebaseApplied)
+		applyTimebase();
+
+	if (m_ring.isEmpty() || iSample < m_iSampleOrigin)
+		return;
+
+	if (m_iBucket >= 0 && iSample >= m_iBucketSampleEnd)
+		completeBucket();
+
+	// Start a new bucket
+	if (m_iBucket < 0)
+	{
+		int i = int((iSample - m_iSampleOrigin) / m_nSamplesPerBucket);
+		while (i > 0 && bucketStart(i) > iSample)
+			i--;
+		while (bucketStart(i + 1) <= iSample)
+			i++;
+
+		m_iBucket = i;
+		m_iBucketSampleEnd = bucketStart(i + 1);
+		if (m_iBucketFirst < 0)
+			m_iBucketFirst = i;
+
+		m_bucket.anMin[0] = m_bucket.anMax[0] = digital;
+		m_bucket.anMin[1] = m_bucket.anMax[1] = analog1;
+		m_bucket.anMin[2] = m_bucket.anMax[2] = analog2;
+	}
+	else
+	{
+		m_bucket.anMin[0] &= digital;
+		m_bucket.anMax[0] |= digital;
+		if (analog1 < m_bucket.anMin[1])
+			m_bucket.anMin[1] = analog1;
+		else if (analog1 > m_bucket.anMax[1])
+			m_bucket.anMax[1] = analog1;
+		if (analog2 < m_bucket.anMin[2])
+			m_bucket.anMin[2] = analog2;
+		else if (analog2 > m_bucket.anMax[2])
+			m_bucket.anMax[2] = analog2;
+	}
+
+	m_nSamplesSincePublish++;
+}
+
+void IdacPreview::completeBucket()
+{
+	m_ring[m_iBucket % m_ring.size()] = m_bucket;
+	m_iBucketEnd = m_iBucket + 1;
+	m_iBucket = -1;
+
+	if (m_nSamplesSincePublish >= g_nSamplesPerPublish)
+		publish();
+}
+
+void IdacPreview::publish()
+{
+	IdacPreviewSnapshot& snap = m_buffers[m_iBack];
+	snap.nSamplesPerBucket = m_nSamplesPerBucket;
+	snap.iSampleOrigin = m_iSampleOrigin;
+	snap.iBucketEnd = m_iBucketEnd;
+	snap.iBucketFirst = (m_iBucketFirst < 0) ? m_iBucketEnd : qMax(m_iBucketFirst, m_iBucketEnd - m_ring.size());
+	// The buffer only gets reallocated when the number of buckets changes
+	snap.buckets.resize(m_ring.size());
+	if (!m_ring.isEmpty())
+		memcpy(snap.buckets.data(), m_ring.constData(), m_ring.size() * sizeof(IdacPreviewBucket));
+
+	m_iBack = m_iMiddle.fetchAndStoreOrdered(m_iBack | FreshFlag) & IndexMask;
+	m_nSamplesSincePublish = 0;
+}
+
+const IdacPreviewSnapshot* IdacPreview::snapshot()
+{
+	if ((m_iMiddle.load() & FreshFlag) != 0)
+		m_iFront = m_iMiddle.fetchAndStoreOrdered(m_iFront) & IndexMask;
+	return &m_buffers[m_iFront];
+}
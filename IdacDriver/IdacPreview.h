@@ -0,0 +1,127 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IDACPREVIEW_H
+#define __IDACPREVIEW_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QVector>
+
+
+/// Min/max summary of the raw samples which fall into one display bucket.
+/// For the digital channel, anMin holds the bitwise AND and anMax the bitwise OR of the samples.
+struct IdacPreviewBucket
+{
+	short anMin[3];
+	short anMax[3];
+};
+
+
+/// Buckets published by the sampling thread
+class IdacPreviewSnapshot
+{
+public:
+	double nSamplesPerBucket;
+	/// Sample index at which bucket 0 starts
+	int iSampleOrigin;
+	/// First completed bucket which is still held in the ring
+	int iBucketFirst;
+	/// One past the last completed bucket
+	int iBucketEnd;
+	/// Ring of the most recently completed buckets
+	QVector<IdacPreviewBucket> buckets;
+
+	IdacPreviewSnapshot()
+		: nSamplesPerBucket(0), iSampleOrigin(0), iBucketFirst(0), iBucketEnd(0)
+	{
+	}
+
+	const IdacPreviewBucket& bucket(int iBucket) const { return buckets[iBucket % buckets.size()]; }
+};
+
+
+/// Per-bucket min/max summaries which the sampling thread builds as samples arrive,
+/// so that live displays don't need to look at every sample.
+///
+/// Bucket k covers the samples from iSampleOrigin + int(k * nSamplesPerBucket + 0.5)
+/// up to (but not including) the start of bucket k + 1.
+///
+/// Snapshots are handed over through a triple buffer: the sampling thread never waits on the reader.
+/// There may only be one reader thread.
+class IdacPreview
+{
+public:
+	IdacPreview();
+
+	/// Set the timebase for the buckets.
+	/// Takes effect with the next sample; may be called from any thread.
+	void setTimebase(double nSamplesPerBucket, int nBuckets, int iSampleOrigin);
+
+	/// Forget all buckets before sampling starts.
+	/// WARNING: must not be called while the sampling thread is running
+	void restart();
+	/// Add the sample with the given index to its bucket.
+	/// WARNING: ONLY TO BE CALLED FROM THE SAMPLING THREAD
+	void addSample(int iSample, short digital, short analog1, short analog2);
+
+	/// Get the most recently published buckets.
+	/// The returned snapshot remains valid until the next call.
+	const IdacPreviewSnapshot* snapshot();
+
+private:
+	void applyTimebase();
+	int bucketStart(int iBucket) const;
+	void completeBucket();
+	void publish();
+
+private:
+	enum { FreshFlag = 0x04, IndexMask = 0x03 };
+
+	/// Requested timebase
+	QMutex m_timebaseMutex;
+	QAtomicInt m_nTimebaseRequested;
+	double m_nSamplesPerBucketRequested;
+	int m_nBucketsRequested;
+	int m_iSampleOriginRequested;
+
+	// The remaining members belong to the sampling thread, except m_iFront
+	int m_nTimebaseApplied;
+	double m_nSamplesPerBucket;
+	int m_iSampleOrigin;
+	/// Bucket currently being filled (-1 if none)
+	int m_iBucket;
+	/// Sample index at which m_iBucket ends
+	int m_iBucketSampleEnd;
+	IdacPreviewBucket m_bucket;
+	/// First bucket which was filled since the timebase was applied (-1 if none)
+	int m_iBucketFirst;
+	/// One past the last completed bucket
+	int m_iBucketEnd;
+	QVector<IdacPreviewBucket> m_ring;
+	int m_nSamplesSincePublish;
+
+	IdacPreviewSnapshot m_buffers[3];
+	/// Buffer owned by the sampling thread
+	int m_iBack;
+	/// Buffer waiting to be picked up, plus FreshFlag if it's newer than m_iFront
+	QAtomicInt m_iMiddle;
+	/// Buffer owned by the reader
+	int m_iFront;
+};
+
+#endif
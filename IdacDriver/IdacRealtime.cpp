@@ -0,0 +1,202 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IdacRealtime.h"
+
+#include <QtGlobal>
+
+#ifdef Q_OS_LINUX
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <unistd.h>
+#endif
+
+#include <QStringList>
+
+#include <Check.h>
+
+
+/// Amount of stack which is prefaulted and locked for the sampling thread
+const int g_nStackPrefault = 64 * 1024;
+
+
+IdacRealtimeOptions::IdacRealtimeOptions()
+	: policy(Policy_None), nPriority(50)
+{
+}
+
+IdacRealtimeOptions IdacRealtimeOptions::fromEnvironment()
+{
+	IdacRealtimeOptions options;
+
+	QString sPolicy = QString::fromLocal8Bit(qgetenv("GCEAD_REALTIME")).trimmed().toLower();
+	if (sPolicy == "fifo")
+		options.policy = Policy_Fifo;
+	else if (sPolicy == "rr")
+		options.policy = Policy_RoundRobin;
+
+	bool bOk = false;
+	int nPriority = QString::fromLocal8Bit(qgetenv("GCEAD_REALTIME_PRIORITY")).toInt(&bOk);
+	if (bOk)
+		options.nPriority = nPriority;
+
+	QString sCpus = QString::fromLocal8Bit(qgetenv("GCEAD_CPU_AFFINITY"));
+	foreach (QString s, sCpus.split(',', QString::SkipEmptyParts))
+	{
+		int iCpu = s.trimmed().toInt(&bOk);
+		if (bOk && iCpu >= 0)
+			options.cpus << iCpu;
+	}
+
+	return options;
+}
+
+
+QString IdacRealtimeStatus::toString() const
+{
+	QStringList parts;
+	if (warnings.isEmpty())
+		parts << sPolicy;
+	else
+		parts << QString("%0 (%1)").arg(sPolicy).arg(warnings.join("; "));
+	if (!cpus.isEmpty())
+	{
+		QStringList asCpus;
+		foreach (int iCpu, cpus)
+			asCpus << QString::number(iCpu);
+		parts << QString("CPU %0").arg(asCpus.join(","));
+	}
+	parts << (bMemoryLocked ? "memory locked" : "memory not locked");
+	return parts.join(", ");
+}
+
+
+#ifdef Q_OS_LINUX
+
+/// Highest real-time priority this process may use, taking RLIMIT_RTPRIO into account for unprivileged processes
+static int maxPermittedPriority(int policy)
+{
+	int nMax = sched_get_priority_max(policy);
+	if (geteuid() != 0)
+	{
+		struct rlimit limit;
+		if (getrlimit(RLIMIT_RTPRIO, &limit) == 0 && limit.rlim_cur != RLIM_INFINITY && limit.rlim_cur > 0)
+			nMax = qMin(nMax, int(limit.rlim_cur));
+	}
+	return nMax;
+}
+
+static void applyScheduling(const IdacRealtimeOptions& options, IdacRealtimeStatus& status)
+{
+	int policy = (options.policy == IdacRealtimeOptions::Policy_RoundRobin) ? SCHED_RR : SCHED_FIFO;
+	const char* szPolicy = (policy == SCHED_RR) ? "SCHED_RR" : "SCHED_FIFO";
+
+	sched_param param;
+	memset(&param, 0, sizeof(param));
+	param.sched_priority = qBound(sched_get_priority_min(policy), options.nPriority, maxPermittedPriority(policy));
+
+	int res = pthread_setschedparam(pthread_self(), policy, &param);
+	if (res == 0)
+	{
+		status.sPolicy = QString("%0 %1").arg(szPolicy).arg(param.sched_priority);
+		return;
+	}
+
+	// Without CAP_SYS_NICE or an RLIMIT_RTPRIO, we just keep the normal policy
+	status.sPolicy = "SCHED_OTHER";
+	if (res == EPERM)
+		status.warnings << QString("%0 not permitted").arg(szPolicy);
+	else
+		status.warnings << QString("%0 failed: %1").arg(szPolicy).arg(strerror(res));
+}
+
+static void applyAffinity(const IdacRealtimeOptions& options, IdacRealtimeStatus& status)
+{
+	if (options.cpus.isEmpty())
+		return;
+
+	cpu_set_t cpus;
+	CPU_ZERO(&cpus);
+	foreach (int iCpu, options.cpus)
+	{
+		if (iCpu < CPU_SETSIZE)
+			CPU_SET(iCpu, &cpus);
+	}
+
+	int res = pthread_setaffinity_np(pthread_self(), sizeof(cpus), &cpus);
+	if (res == 0)
+		status.cpus = options.cpus;
+	else
+		status.warnings << QString("CPU affinity failed: %0").arg(strerror(res));
+}
+
+/// Touch the stack which the sampling loop will be using, so that it doesn't page fault later on
+static bool prefaultStack()
+{
+	volatile char stack[g_nStackPrefault];
+	memset((char*) stack, 0, sizeof(stack));
+	// The pages stay locked after this frame is gone
+	return (mlock((const void*) stack, sizeof(stack)) == 0);
+}
+
+IdacRealtimeStatus IdacRealtime::applyToCurrentThread(const IdacRealtimeOptions& options)
+{
+	IdacRealtimeStatus status;
+	CHECK_PARAM_RETVAL(options.isEnabled(), status);
+
+	applyScheduling(options, status);
+	applyAffinity(options, status);
+	status.bMemoryLocked = prefaultStack();
+	return status;
+}
+
+bool IdacRealtime::lockMemory(const void* p, int nBytes)
+{
+	CHECK_PARAM_RETVAL(p != NULL && nBytes >= 0, false);
+
+	// Write to every page, so that it's actually backed by RAM before we lock it
+	long nPageSize = sysconf(_SC_PAGESIZE);
+	volatile char* pc = (volatile char*) p;
+	for (int i = 0; i < nBytes; i += nPageSize)
+		pc[i] = pc[i];
+
+	return (mlock(p, nBytes) == 0);
+}
+
+#else
+
+IdacRealtimeStatus IdacRealtime::applyToCurrentThread(const IdacRealtimeOptions& options)
+{
+	Q_UNUSED(options);
+	IdacRealtimeStatus status;
+	status.sPolicy = "normal";
+	status.warnings << "real-time mode is only supported on Linux";
+	return status;
+}
+
+bool IdacRealtime::lockMemory(const void* p, int nBytes)
+{
+	Q_UNUSED(p);
+	Q_UNUSED(nBytes);
+	return false;
+}
+
+#endif
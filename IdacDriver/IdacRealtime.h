@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IDACREALTIME_H
+#define __IDACREALTIME_H
+
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+
+/// Options for running the sampling thread with real-time scheduling.
+/// These are read from the environment:
+///   GCEAD_REALTIME=fifo|rr        scheduling policy (real-time mode is off if this isn't set)
+///   GCEAD_REALTIME_PRIORITY=n     real-time priority (default 50)
+///   GCEAD_CPU_AFFINITY=2,3        CPUs which the sampling thread may run on
+/// Real-time mode is currently only supported on Linux.
+class IdacRealtimeOptions
+{
+public:
+	enum Policy { Policy_None, Policy_Fifo, Policy_RoundRobin };
+
+	Policy policy;
+	int nPriority;
+	/// CPUs to pin the thread to (empty for no pinning)
+	QList<int> cpus;
+
+	IdacRealtimeOptions();
+
+	bool isEnabled() const { return policy != Policy_None; }
+
+	static IdacRealtimeOptions fromEnvironment();
+};
+
+
+/// What could actually be applied
+class IdacRealtimeStatus
+{
+public:
+	/// Effective scheduling policy and priority, e.g. "SCHED_FIFO 50"
+	QString sPolicy;
+	/// Problems encountered while applying the options
+	QStringList warnings;
+	/// CPUs the thread is pinned to (empty if not pinned)
+	QList<int> cpus;
+	bool bMemoryLocked;
+
+	IdacRealtimeStatus() : bMemoryLocked(false) {}
+
+	/// Short description for the status line
+	QString toString() const;
+};
+
+
+namespace IdacRealtime
+{
+	/// Apply the options to the calling thread and prefault/lock its stack.
+	/// Falls back to normal scheduling if real-time scheduling isn't permitted.
+	IdacRealtimeStatus applyToCurrentThread(const IdacRealtimeOptions& options);
+	/// Touch every page of the buffer and lock it into RAM
+	/// @returns false if locking isn't permitted (see RLIMIT_MEMLOCK) or supported
+	bool lockMemory(const void* p, int nBytes);
+}
+
+#endif
@@ -0,0 +1,91 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IDACSAMPLEBLOCK_H
+#define __IDACSAMPLEBLOCK_H
+
+#include <QVector>
+
+
+/// A block of samples which the sampling thread writes into directly.
+/// Once the block has been taken from the driver, the consumer owns it.
+/// QVector is implicitly shared, so handing a block on (e.g. into a WaveInfo)
+/// does not copy the sample data.
+class IdacSampleBlock
+{
+public:
+	QVector<short> digital;
+	QVector<short> analog1;
+	QVector<short> analog2;
+	/// Index of the first sample in this block, counted from the start of sampling
+	int iFirstSample;
+
+	IdacSampleBlock()
+		: iFirstSample(0)
+	{
+	}
+
+	/// Allocate room for nCapacity samples per channel
+	explicit IdacSampleBlock(int nCapacity)
+		: digital(nCapacity), analog1(nCapacity), analog2(nCapacity), iFirstSample(0)
+	{
+	}
+
+	int size() const { return digital.size(); }
+	bool isEmpty() const { return digital.isEmpty(); }
+	/// Number of samples per channel which fit without reallocating
+	int capacity() const { return qMin(digital.capacity(), qMin(analog1.capacity(), analog2.capacity())); }
+	/// True if no other copy of the block refers to the same data,
+	/// so that it can be written to without detaching
+	bool isDetached() const { return digital.isDetached() && analog1.isDetached() && analog2.isDetached(); }
+
+	QVector<short>& channel(int iChan)
+	{
+		return (iChan == 0) ? digital : (iChan == 1) ? analog1 : analog2;
+	}
+
+	const QVector<short>& channel(int iChan) const
+	{
+		return (iChan == 0) ? digital : (iChan == 1) ? analog1 : analog2;
+	}
+
+	/// Truncate the block to the number of samples which were actually filled.
+	/// This is only cheap while no other copy of the block shares its data (see isDetached()):
+	/// shrinking a shared QVector detaches it, which copies all the samples.
+	void truncate(int nSamples)
+	{
+		resize(nSamples);
+	}
+
+	/// Resize all channels.  This doesn't reallocate as long as the block is detached
+	/// and nSamples doesn't exceed capacity().
+	void resize(int nSamples)
+	{
+		digital.resize(nSamples);
+		analog1.resize(nSamples);
+		analog2.resize(nSamples);
+	}
+
+	void clear()
+	{
+		digital.clear();
+		analog1.clear();
+		analog2.clear();
+	}
+};
+
+#endif
@@ -30,10 +30,18 @@ class IdacSettings
 public:
 	/// Whether to record when trigger signal comes
 	bool bRecordOnTrigger;
-	/// Number of minutes to record for (0 = unlimited)
+	/// Number of seconds before the trigger which are kept when recording on trigger
+	int nPreTrigger_s;
+	/// Number of minutes to record for (0 = unlimited).
+	/// In continuous mode, the number of minutes which are kept in memory.
 	int nRecordingDuration;
+	/// Whether to keep recording until stopped, spilling older data to disk (see MonitorHistory)
+	bool bContinuous;
 	/// Preset delay for the FID signal in milliseconds (ms)
 	int nGcDelay_ms;
+	/// Per channel, cutoff of the low-pass filter which is applied to the analog signals while recording, in Hz.
+	/// 0 means no filter; the digital channel (index 0) is never filtered.
+	double anLiveLowpass_Hz[3];
 	/// Settings for the individual channels
 	QVector<IdacChannelSettings> channels;
 };
@@ -0,0 +1,168 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IdacSignalMonitor.h"
+
+#include <math.h>
+
+#include <QtGlobal>
+
+#include <Check.h>
+
+
+/// Number of window means which are kept for the drift, i.e. the drift covers up to a minute
+static const int g_nDriftWindows = 60;
+/// Raw values at which the ADC is taken to be saturated
+static const short g_nClipHigh = 32767;
+static const short g_nClipLow = -32767;
+
+
+IdacSignalQuality::IdacSignalQuality()
+{
+	nSamples = 0;
+	nMean = 0;
+	nRms = 0;
+	nDriftPerMinute = 0;
+	nMains50 = 0;
+	nMains60 = 0;
+	nClipped = 0;
+}
+
+
+IdacSignalMonitor::IdacSignalMonitor(int nSamplesPerSecond)
+{
+	m_nWindow = qMax(nSamplesPerSecond, 2);
+	m_nDamping = 0.99999;
+	m_nDampingWindow = pow(m_nDamping, m_nWindow);
+	m_ring.resize(m_nWindow);
+	m_means.resize(g_nDriftWindows + 1);
+	reset();
+}
+
+void IdacSignalMonitor::reset()
+{
+	m_ring.fill(0);
+	m_iRing = 0;
+	m_nSeen = 0;
+	m_nSum = 0;
+	m_nSumSq = 0;
+	m_nClipped = 0;
+	setupBin(m_bin50, 50);
+	setupBin(m_bin60, 60);
+	m_iMeans = 0;
+	m_nMeans = 0;
+}
+
+void IdacSignalMonitor::setupBin(Bin& bin, int nFrequency)
+{
+	// Fold the frequency into the range from 0 to the Nyquist frequency.
+	// The window is one second long, so the bin index is the frequency in Hz.
+	int k = nFrequency % m_nWindow;
+	if (k > m_nWindow / 2)
+		k = m_nWindow - k;
+
+	double nAngle = 2 * M_PI * k / m_nWindow;
+	bin.nCos = m_nDamping * cos(nAngle);
+	bin.nSin = m_nDamping * sin(nAngle);
+	bin.re = 0;
+	bin.im = 0;
+}
+
+inline void IdacSignalMonitor::addToBin(Bin& bin, double nDiff)
+{
+	// S(n) = r * e^(i*w) * (S(n-1) + x(n) - r^N * x(n-N))
+	double re = bin.re + nDiff;
+	double im = bin.im;
+	bin.re = re * bin.nCos - im * bin.nSin;
+	bin.im = re * bin.nSin + im * bin.nCos;
+}
+
+double IdacSignalMonitor::binRms(const Bin& bin) const
+{
+	double nMagnitude = sqrt(bin.re * bin.re + bin.im * bin.im) / m_nWindow;
+	// A sinusoid of amplitude A shows up with magnitude A/2 in its bin (or A on the Nyquist frequency, which only has one bin)
+	bool bNyquist = (bin.nSin > -1e-9 && bin.nSin < 1e-9 && bin.nCos < 0);
+	return (bNyquist) ? nMagnitude : nMagnitude * M_SQRT2;
+}
+
+void IdacSignalMonitor::add(const short* samples, int nSamples)
+{
+	CHECK_PARAM_RET(samples != NULL || nSamples == 0);
+
+	short* ring = m_ring.data();
+	for (int i = 0; i < nSamples; i++)
+	{
+		const short n = samples[i];
+		const short nOld = ring[m_iRing];
+		ring[m_iRing] = n;
+		if (++m_iRing == m_nWindow)
+			m_iRing = 0;
+
+		// Until the window is full, the samples leaving it are the zeros from reset()
+		m_nSum += n - nOld;
+		m_nSumSq += qint64(n) * n - qint64(nOld) * nOld;
+		if (n >= g_nClipHigh || n <= g_nClipLow)
+			m_nClipped++;
+		if (m_nSeen >= m_nWindow && (nOld >= g_nClipHigh || nOld <= g_nClipLow))
+			m_nClipped--;
+
+		const double nDiff = n - m_nDampingWindow * nOld;
+		addToBin(m_bin50, nDiff);
+		addToBin(m_bin60, nDiff);
+
+		m_nSeen++;
+		// Remember the mean at the end of each full window for the drift
+		if (m_nSeen % m_nWindow == 0)
+		{
+			m_means[m_iMeans] = double(m_nSum) / m_nWindow;
+			m_iMeans = (m_iMeans + 1) % m_means.size();
+			m_nMeans = qMin(m_nMeans + 1, m_means.size());
+		}
+	}
+}
+
+IdacSignalQuality IdacSignalMonitor::quality() const
+{
+	IdacSignalQuality q;
+	const int nSamples = int(qMin(m_nSeen, qint64(m_nWindow)));
+	if (nSamples == 0)
+		return q;
+
+	q.nSamples = nSamples;
+	q.nMean = double(m_nSum) / nSamples;
+	double nVariance = double(m_nSumSq) / nSamples - q.nMean * q.nMean;
+	q.nRms = (nVariance > 0) ? sqrt(nVariance) : 0;
+	q.nClipped = m_nClipped;
+
+	if (nSamples == m_nWindow)
+	{
+		q.nMains50 = binRms(m_bin50);
+		q.nMains60 = binRms(m_bin60);
+	}
+
+	// Compare the newest window mean with the oldest one which is still kept
+	if (m_nMeans >= 2)
+	{
+		const int nSize = m_means.size();
+		const double nNewest = m_means[(m_iMeans - 1 + nSize) % nSize];
+		const double nOldest = m_means[(m_iMeans - m_nMeans + nSize) % nSize];
+		const double nMinutes = double(m_nMeans - 1) / 60;
+		q.nDriftPerMinute = (nNewest - nOldest) / nMinutes;
+	}
+
+	return q;
+}
@@ -0,0 +1,109 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IDACSIGNALMONITOR_H
+#define __IDACSIGNALMONITOR_H
+
+#include <QVector>
+
+
+/// Signal quality figures of one channel.
+/// All values are in raw ADC units, so that they can be compared directly when adjusting
+/// the ADC zero or the notch filter of the hardware; multiply by the raw-to-voltage factor for display.
+class IdacSignalQuality
+{
+public:
+	/// Number of samples in the window which the figures are based on
+	int nSamples;
+	/// Mean over the window
+	double nMean;
+	/// RMS of the deviation from the mean over the window, i.e. the noise
+	double nRms;
+	/// Change of the mean per minute (0 until enough data has been seen)
+	double nDriftPerMinute;
+	/// RMS of the 50 Hz and 60 Hz mains components over the window
+	double nMains50;
+	double nMains60;
+	/// Number of samples in the window which are at the limits of the ADC
+	int nClipped;
+
+	IdacSignalQuality();
+
+	/// RMS of the stronger of the two mains components
+	double mains() const { return (nMains50 > nMains60) ? nMains50 : nMains60; }
+	/// Frequency of the stronger mains component
+	int mainsFrequency() const { return (nMains50 > nMains60) ? 50 : 60; }
+};
+
+
+/// Streaming signal quality monitor for one channel.
+///
+/// The figures cover a sliding window of one second and are updated for each sample at constant cost:
+/// the mean and RMS from running integer sums, the mains components by a sliding DFT (a sliding Goertzel filter) per frequency,
+/// and the drift from the window means of the last minute.
+/// The mains frequencies are folded to the sampling rate, so at 100 samples per second
+/// 50 Hz lies exactly on the Nyquist frequency and 60 Hz shows up at 40 Hz.
+class IdacSignalMonitor
+{
+public:
+	/// @param nSamplesPerSecond sampling rate of the channel, which is also the window length
+	IdacSignalMonitor(int nSamplesPerSecond = 100);
+
+	/// Forget all samples seen so far
+	void reset();
+	/// Add the given raw samples
+	void add(const short* samples, int nSamples);
+	/// Figures as of the last sample added
+	IdacSignalQuality quality() const;
+
+private:
+	/// Sliding DFT of a single frequency
+	struct Bin
+	{
+		/// Rotation per sample, damped slightly to keep the recursion stable
+		double nCos;
+		double nSin;
+		double re;
+		double im;
+	};
+
+	void setupBin(Bin& bin, int nFrequency);
+	void addToBin(Bin& bin, double nDiff);
+	double binRms(const Bin& bin) const;
+
+private:
+	int m_nWindow;
+	/// Damping per sample, and its N-th power for the sample leaving the window
+	double m_nDamping;
+	double m_nDampingWindow;
+	/// Samples in the window, as a ring
+	QVector<short> m_ring;
+	int m_iRing;
+	/// Number of samples seen since the last reset
+	qint64 m_nSeen;
+	qint64 m_nSum;
+	qint64 m_nSumSq;
+	int m_nClipped;
+	Bin m_bin50;
+	Bin m_bin60;
+	/// Window means at the end of each of the last windows, as a ring
+	QVector<double> m_means;
+	int m_iMeans;
+	int m_nMeans;
+};
+
+#endif
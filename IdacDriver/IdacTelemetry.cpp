@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IdacTelemetry.h"
+
+
+IdacTelemetrySnapshot::IdacTelemetrySnapshot()
+{
+	nSamples = 0;
+	nSamplesDropped = 0;
+	nPackets = 0;
+	nBytes = 0;
+	nInvalidPackets = 0;
+	nTransferErrors = 0;
+	for (int i = 0; i < 3; i++)
+		anDuplicates[i] = 0;
+	nBlockAllocations = 0;
+	nBufferHighWater = 0;
+	nBufferCapacity = 0;
+	nDecodeCount = 0;
+	nDecodeTotal_ns = 0;
+	nDecodeMax_ns = 0;
+	for (int i = 0; i < LatencyBucketCount; i++)
+		anLatencyHistogram[i] = 0;
+}
+
+
+IdacTelemetry::IdacTelemetry()
+{
+	reset(0);
+}
+
+void IdacTelemetry::reset(int nBufferCapacity)
+{
+	m_nSamples.store(0);
+	m_nSamplesDropped.store(0);
+	m_nPackets.store(0);
+	m_nBytes.store(0);
+	m_nInvalidPackets.store(0);
+	m_nTransferErrors.store(0);
+	for (int i = 0; i < 3; i++)
+		m_anDuplicates[i].store(0);
+	m_nBlockAllocations.store(0);
+	m_nBufferHighWater.store(0);
+	m_nBufferCapacity.store(nBufferCapacity);
+	m_nDecodeCount.store(0);
+	m_nDecodeTotal_ns.store(0);
+	m_nDecodeMax_ns.store(0);
+	for (int i = 0; i < IdacTelemetrySnapshot::LatencyBucketCount; i++)
+		m_anLatencyHistogram[i].store(0);
+}
+
+void IdacTelemetry::setBufferLevel(int nSamples)
+{
+	// Only the sampling thread writes this, so there's no need for a compare-and-swap loop
+	if (nSamples > m_nBufferHighWater.load())
+		m_nBufferHighWater.store(nSamples);
+}
+
+void IdacTelemetry::addDecodeTime(qint64 nTime_ns)
+{
+	m_nDecodeCount.fetchAndAddRelaxed(1);
+	m_nDecodeTotal_ns.fetchAndAddRelaxed(nTime_ns);
+	if (nTime_ns > m_nDecodeMax_ns.load())
+		m_nDecodeMax_ns.store(nTime_ns);
+}
+
+void IdacTelemetry::addLatency(qint64 nLatency_ns)
+{
+	qint64 nLatency_ms = nLatency_ns / 1000000;
+	int iBucket = 0;
+	while (iBucket < IdacTelemetrySnapshot::LatencyBucketCount - 1 && nLatency_ms >= IdacTelemetrySnapshot::latencyBucketStart_ms(iBucket + 1))
+		iBucket++;
+	m_anLatencyHistogram[iBucket].fetchAndAddRelaxed(1);
+}
+
+IdacTelemetrySnapshot IdacTelemetry::snapshot() const
+{
+	IdacTelemetrySnapshot snap;
+	snap.nSamples = m_nSamples.load();
+	snap.nSamplesDropped = m_nSamplesDropped.load();
+	snap.nPackets = m_nPackets.load();
+	snap.nBytes = m_nBytes.load();
+	snap.nInvalidPackets = m_nInvalidPackets.load();
+	snap.nTransferErrors = m_nTransferErrors.load();
+	for (int i = 0; i < 3; i++)
+		snap.anDuplicates[i] = m_anDuplicates[i].load();
+	snap.nBlockAllocations = m_nBlockAllocations.load();
+	snap.nBufferHighWater = m_nBufferHighWater.load();
+	snap.nBufferCapacity = m_nBufferCapacity.load();
+	snap.nDecodeCount = m_nDecodeCount.load();
+	snap.nDecodeTotal_ns = m_nDecodeTotal_ns.load();
+	snap.nDecodeMax_ns = m_nDecodeMax_ns.load();
+	for (int i = 0; i < IdacTelemetrySnapshot::LatencyBucketCount; i++)
+		snap.anLatencyHistogram[i] = m_anLatencyHistogram[i].load();
+	return snap;
+}
@@ -0,0 +1,110 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IDACTELEMETRY_H
+#define __IDACTELEMETRY_H
+
+#include <QAtomicInt>
+#include <QAtomicInteger>
+
+
+/// Values of the acquisition counters at one point in time.
+/// All counts are since sampling was last started.
+class IdacTelemetrySnapshot
+{
+public:
+	enum { LatencyBucketCount = 14 };
+
+	/// Samples put into the sample buffer
+	qint64 nSamples;
+	/// Samples lost because the sample buffer was full
+	qint64 nSamplesDropped;
+	/// USB packets received
+	qint64 nPackets;
+	/// Payload bytes received
+	qint64 nBytes;
+	/// Packets which were discarded because of an invalid size
+	qint64 nInvalidPackets;
+	/// USB transfers which failed
+	qint64 nTransferErrors;
+	/// Per channel, number of times a value arrived again before the sample was complete.
+	/// Each of these means that a value was overwritten before it could be used.
+	qint64 anDuplicates[3];
+	/// Sample blocks which had to be allocated while the sample buffer was locked, because no recycled block was free
+	qint64 nBlockAllocations;
+	/// Highest number of samples which were waiting in the sample buffer
+	int nBufferHighWater;
+	/// Size of the sample buffer
+	int nBufferCapacity;
+	/// Number of decoded transfers, and the total and maximum time spent decoding one
+	qint64 nDecodeCount;
+	qint64 nDecodeTotal_ns;
+	qint64 nDecodeMax_ns;
+	/// Histogram of the time between a sample's arrival and its being taken from the buffer.
+	/// Bucket 0 holds latencies below 1 ms, bucket i those from 2^(i-1) ms to below 2^i ms,
+	/// and the last bucket everything above.
+	qint64 anLatencyHistogram[LatencyBucketCount];
+
+	IdacTelemetrySnapshot();
+
+	/// Lower limit of the given latency bucket in milliseconds
+	static int latencyBucketStart_ms(int iBucket) { return (iBucket == 0) ? 0 : (1 << (iBucket - 1)); }
+};
+
+
+/// Acquisition counters for a driver.
+/// The sampling thread updates them without taking any locks, and snapshot() may be called from any thread.
+class IdacTelemetry
+{
+public:
+	IdacTelemetry();
+
+	/// Reset all counters
+	void reset(int nBufferCapacity);
+
+	void addPacket(int nBytes) { m_nPackets.fetchAndAddRelaxed(1); m_nBytes.fetchAndAddRelaxed(nBytes); }
+	void addInvalidPacket() { m_nInvalidPackets.fetchAndAddRelaxed(1); }
+	void addTransferError() { m_nTransferErrors.fetchAndAddRelaxed(1); }
+	void addDuplicate(int iChan) { m_anDuplicates[iChan].fetchAndAddRelaxed(1); }
+	void addSample() { m_nSamples.fetchAndAddRelaxed(1); }
+	void addDroppedSample() { m_nSamplesDropped.fetchAndAddRelaxed(1); }
+	void addBlockAllocation() { m_nBlockAllocations.fetchAndAddRelaxed(1); }
+	/// Record the number of samples currently waiting in the sample buffer
+	void setBufferLevel(int nSamples);
+	void addDecodeTime(qint64 nTime_ns);
+	void addLatency(qint64 nLatency_ns);
+
+	IdacTelemetrySnapshot snapshot() const;
+
+private:
+	QAtomicInteger<qint64> m_nSamples;
+	QAtomicInteger<qint64> m_nSamplesDropped;
+	QAtomicInteger<qint64> m_nPackets;
+	QAtomicInteger<qint64> m_nBytes;
+	QAtomicInteger<qint64> m_nInvalidPackets;
+	QAtomicInteger<qint64> m_nTransferErrors;
+	QAtomicInteger<qint64> m_anDuplicates[3];
+	QAtomicInteger<qint64> m_nBlockAllocations;
+	QAtomicInt m_nBufferHighWater;
+	QAtomicInt m_nBufferCapacity;
+	QAtomicInteger<qint64> m_nDecodeCount;
+	QAtomicInteger<qint64> m_nDecodeTotal_ns;
+	QAtomicInteger<qint64> m_nDecodeMax_ns;
+	QAtomicInteger<qint64> m_anLatencyHistogram[IdacTelemetrySnapshot::LatencyBucketCount];
+};
+
+#endif
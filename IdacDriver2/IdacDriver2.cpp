@@ -23,6 +23,7 @@
 
 #include <QtDebug>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QMutex>
 #include <QThread>
@@ -66,6 +67,7 @@ IdacDriver2::IdacDriver2(UsbDevice* device, UsbHandle* handle, QObject* parent)
 	  m_defaultChannelSettings(3)
 {
 	m_bSampling = false;
+	m_nVersion = 0;
 
 	setHardwareName("IDAC2");
 
@@ -196,6 +198,26 @@ void IdacDriver2::configureChannel(int iChan)
 	sendChannelSettings();
 }
 
+void IdacDriver2::configureChannels()
+{
+	QVector<IdacChannelSettings> desired = desiredSettingsCopy();
+	bool bChanged = false;
+	for (int iChan = 0; iChan < 3 && iChan < desired.size(); iChan++)
+	{
+		IdacChannelSettings* actual = actualChannelSettings(iChan);
+		CHECK_ASSERT_RET(actual != NULL);
+		if (*actual != desired[iChan])
+		{
+			*actual = desired[iChan];
+			bChanged = true;
+		}
+	}
+
+	// The settings of all channels go out in a single message
+	if (bChanged)
+		sendChannelSettings();
+}
+
 bool IdacDriver2::setPowerOn(bool bOn)
 {
 	return sendOutgoingMessage((bOn) ? REQUESTID_POWER_ON : REQUESTID_POWER_OFF);
@@ -307,6 +329,7 @@ bool IdacDriver2::startSampling()
 		*actualChannelSettings(iChan) = *desiredChannelSettings(iChan);
 	sendChannelSettings();
 
+	startCapture(m_nVersion);
 	startSamplingThread();
 	return true;
 }
@@ -323,18 +346,11 @@ void IdacDriver2::sampleLoop()
 	ret = myusb_control_transfer(0x02, 0x01, 0, 0x0081, NULL, 0, 0);
 	CHECK_USBRESULT_NORET(ret);
 
-	g_iDecimation = 0;
-	g_nDigitalSum = 0;
-	g_nAnalog1Sum = 0;
-	g_nAnalog2Sum = 0;
+	resetDecoder();
 
 	// Now loop till done
 	quint8 buffer[51];
 	bool bSamplingPrev = m_bSampling;
-    //bool bOverflow = false;
-	int iPart = 0;
-	quint8 parts[8];
-	parts[7] = 0;
 	while (bSamplingPrev)
 	{
 		bool bSamplingNow = m_bSampling;
@@ -346,86 +362,16 @@ void IdacDriver2::sampleLoop()
 		CHECK_USBRESULT_NORET(ret);
 		if (ret < 0)
 		{
+			telemetry()->addTransferError();
 			cout << "INTERRUPT READ ret = " << ret << endl;
 		}
 
 		//int nPackets = (ret > 0) ? (ret / 51) : 0;
 		if (ret > 0)
 		{
-			quint8* p = (quint8*) buffer;
-			int nBytes = *p++;
-			//cout << "[" << nBytes << "] ";
-			for (int iByte = 0; iByte < nBytes; iByte++) {
-				/*
-				QString sHex = QString::number(p[iByte], 16);
-				if (sHex.size() == 1)
-					sHex = "0" + sHex;
-				cout << qPrintable(sHex);
-				*/
-
-				parts[iPart++] = p[iByte];
-				if (iPart == 5)
-				{
-					CHECK_ASSERT_NORET((parts[0] & 0x80) == 0);
-					CHECK_ASSERT_NORET((parts[1] & 0x80) != 0);
-					CHECK_ASSERT_NORET((parts[2] & 0x80) != 0);
-					CHECK_ASSERT_NORET((parts[3] & 0x80) != 0);
-					CHECK_ASSERT_NORET((parts[4] & 0x80) != 0);
-
-					// The data in the 5-byte packet is distributed as follows:
-					// - 'A' bits are for analog channel 1
-					// - 'B' bits are for analog channel 2
-					// - 'D' bits are for the digital channels
-					// parts[0]	1AAAAAAA
-					// parts[1]	0AAAAAAA
-					// parts[2]	0AABBBBB
-					// parts[3]	0BBBBBBB
-					// parts[4]	0BBBBDDD
-
-					for (int i = 0; i < 5; i++)
-						parts[i] &= 0x7f;
-
-					short analog1 = -((parts[0] << 9) | (parts[1] << 2) | (parts[2] >> 5));
-					short analog2 = -(((parts[2] & 0x1f) << 11) | (parts[3] << 4) | (parts[4] >> 3));
-					short digital = 0;
-					digital |= ((parts[4] & 0x02) > 0); // Trigger
-					digital |= ((parts[4] & 0x05) > 0) << 1; // Signal?
-					digital = ~digital;
-
-					/*
-					cout << "\t" << analog1;
-					cout << "\t" << analog2;
-					cout << "\t" << ((parts[4] & 0x02) > 0 ? 'X' : '_');
-					cout << "\t" << ((parts[4] & 0x01) > 0 ? 'X' : '_');
-					cout << endl;
-					*/
-
-					iPart = 0;
-
-					g_nAnalog1Sum += analog1;
-					g_nAnalog2Sum += analog2;
-					g_nDigitalSum = digital;
-					g_iDecimation++;
-
-					if (g_iDecimation == 5)
-					{
-						analog1 = g_nAnalog1Sum / 5;
-						analog2 = g_nAnalog2Sum / 5;
-
-						g_iDecimation = 0;
-						g_nAnalog1Sum = 0;
-						g_nAnalog2Sum = 0;
-
-						// A sample was produced
-						if (!addSample(digital, analog1, analog2))
-						{
-                            //bOverflow = true;
-							//m_bSampling = false;
-							addError("OVERFLOW");
-						}
-					}
-				}
-			}
+			if (m_capture.isOpen())
+				m_capture.write((const char*) buffer, sizeof(buffer), ret);
+			processSampledData(buffer, sizeof(buffer));
 		}
 		bSamplingPrev = bSamplingNow;
 	}
@@ -433,6 +379,108 @@ void IdacDriver2::sampleLoop()
 	// End of INT xfer?
 	// 412307451 S Co:3:005:0 s 40 2a 0000 0000 0000 0
 	setIntXferEnabled(false);
+	m_capture.close();
+}
+
+void IdacDriver2::resetDecoder()
+{
+	g_iDecimation = 0;
+	g_nDigitalSum = 0;
+	g_nAnalog1Sum = 0;
+	g_nAnalog2Sum = 0;
+	m_iPart = 0;
+	m_parts[7] = 0;
+}
+
+void IdacDriver2::processSampledData(const quint8* buffer, int nLength)
+{
+	QElapsedTimer timer;
+	timer.start();
+
+	const quint8* p = buffer;
+	int nBytes = *p++;
+	// The first byte is the payload size, which can't be larger than the rest of the buffer
+	if (nBytes > nLength - 1)
+	{
+		telemetry()->addInvalidPacket();
+		nBytes = 0;
+	}
+	else
+		telemetry()->addPacket(nBytes);
+	//cout << "[" << nBytes << "] ";
+	for (int iByte = 0; iByte < nBytes; iByte++) {
+		/*
+		QString sHex = QString::number(p[iByte], 16);
+		if (sHex.size() == 1)
+			sHex = "0" + sHex;
+		cout << qPrintable(sHex);
+		*/
+
+		m_parts[m_iPart++] = p[iByte];
+		if (m_iPart == 5)
+		{
+			CHECK_ASSERT_NORET((m_parts[0] & 0x80) == 0);
+			CHECK_ASSERT_NORET((m_parts[1] & 0x80) != 0);
+			CHECK_ASSERT_NORET((m_parts[2] & 0x80) != 0);
+			CHECK_ASSERT_NORET((m_parts[3] & 0x80) != 0);
+			CHECK_ASSERT_NORET((m_parts[4] & 0x80) != 0);
+
+			// The data in the 5-byte packet is distributed as follows:
+			// - 'A' bits are for analog channel 1
+			// - 'B' bits are for analog channel 2
+			// - 'D' bits are for the digital channels
+			// m_parts[0]	1AAAAAAA
+			// m_parts[1]	0AAAAAAA
+			// m_parts[2]	0AABBBBB
+			// m_parts[3]	0BBBBBBB
+			// m_parts[4]	0BBBBDDD
+
+			for (int i = 0; i < 5; i++)
+				m_parts[i] &= 0x7f;
+
+			short analog1 = -((m_parts[0] << 9) | (m_parts[1] << 2) | (m_parts[2] >> 5));
+			short analog2 = -(((m_parts[2] & 0x1f) << 11) | (m_parts[3] << 4) | (m_parts[4] >> 3));
+			short digital = 0;
+			digital |= ((m_parts[4] & 0x02) > 0); // Trigger
+			digital |= ((m_parts[4] & 0x05) > 0) << 1; // Signal?
+			digital = ~digital;
+
+			/*
+			cout << "\t" << analog1;
+			cout << "\t" << analog2;
+			cout << "\t" << ((m_parts[4] & 0x02) > 0 ? 'X' : '_');
+			cout << "\t" << ((m_parts[4] & 0x01) > 0 ? 'X' : '_');
+			cout << endl;
+			*/
+
+			m_iPart = 0;
+
+			g_nAnalog1Sum += analog1;
+			g_nAnalog2Sum += analog2;
+			g_nDigitalSum = digital;
+			g_iDecimation++;
+
+			if (g_iDecimation == 5)
+			{
+				analog1 = g_nAnalog1Sum / 5;
+				analog2 = g_nAnalog2Sum / 5;
+
+				g_iDecimation = 0;
+				g_nAnalog1Sum = 0;
+				g_nAnalog2Sum = 0;
+
+				// A sample was produced
+				if (!addSample(digital, analog1, analog2))
+				{
+                            //bOverflow = true;
+					//m_bSampling = false;
+					addError("OVERFLOW");
+				}
+			}
+		}
+	}
+
+	telemetry()->addDecodeTime(timer.nsecsElapsed());
 }
 
 bool IdacDriver2::IdacZeroPulse(int iChan) {
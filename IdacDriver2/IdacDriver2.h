@@ -43,6 +43,7 @@ public:
 
 	bool startSampling();
 	void configureChannel(int iChan);
+	void configureChannels();
 
 public:
 	bool setPowerOn(bool bOn);
@@ -61,15 +62,27 @@ private:
 	friend class IdacDriver2Es;
 	bool IdacZeroPulse(int iChan);
 
-private:
+// For IdacDriver2Replay
+protected:
 	void initStringsAndRanges();
+	/// Reset the state of the sample decoder
+	void resetDecoder();
+	/// Decode the data of one interrupt transfer.
+	/// The first byte holds the payload size, followed by the 5-byte sample packets.
+	void processSampledData(const quint8* buffer, int nLength);
+
+protected:
+	char m_nVersion;
 
 private:
 	QVector<IdacChannelSettings> m_defaultChannelSettings;
-	char m_nVersion;
 	//ConfigData m_config;
 
 	bool m_bSamplingPaused;
+	/// Bytes of a partially received 5-byte sample packet
+	quint8 m_parts[8];
+	/// Number of bytes in m_parts
+	int m_iPart;
 };
 
 #endif
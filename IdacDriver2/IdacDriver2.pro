@@ -12,10 +12,12 @@ INCLUDEPATH += . \
     ../Core \
     ../IdacDriver
 HEADERS += IdacDriver2.h \
+    IdacDriver2Replay.h \
     IdacDriver2ReqIds.h \
     IdacDriver2Constants.h \
     IdacDriver2Es.h
 SOURCES += IdacDriver2.cpp \
+	IdacDriver2Replay.cpp \
 	IdacDriver2Firmware.cpp \
 	IdacDriver2Es.cpp
 win32:INCLUDEPATH += ../extern/win32
@@ -0,0 +1,61 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __IDACDRIVER2REPLAY_H
+#define __IDACDRIVER2REPLAY_H
+
+#include <QString>
+
+#include <IdacDriver/IdacCapture.h>
+
+#include "IdacDriver2.h"
+
+
+/// Feeds a capture file written by IdacDriver2 back through its decoder and the sample buffer,
+/// so that decoding and throughput can be examined without the device attached.
+class IdacDriver2Replay : public IdacDriver2
+{
+public:
+	/// @param bRealTime replay at the speed the data was captured, or otherwise as fast as the samples are taken
+	IdacDriver2Replay(const QString& sFilename, bool bRealTime, QObject* parent = NULL);
+
+	/// Whether the capture file could be read
+	bool isValid() const { return m_bValid; }
+
+// Implement IdacDriver
+public:
+	bool checkUsbFirmwareReady() { return m_bValid; }
+	bool checkDataFirmwareReady() { return m_bValid; }
+	void initUsbFirmware() {}
+	void initDataFirmware() {}
+
+	bool startSampling();
+	void configureChannel(int iChan) { Q_UNUSED(iChan); }
+	void configureChannels() {}
+
+// IdacDriverWithThread overrides
+protected:
+	void sampleLoop();
+
+private:
+	QString m_sFilename;
+	bool m_bRealTime;
+	bool m_bValid;
+	IdacCaptureHeader m_header;
+};
+
+#endif
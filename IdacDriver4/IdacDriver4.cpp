@@ -23,6 +23,7 @@
 
 #include <QtDebug>
 #include <QCoreApplication>
+#include <QElapsedTimer>
 #include <QFile>
 #include <QMutex>
 #include <QThread>
@@ -30,6 +31,7 @@
 #include <Check.h>
 
 #include <IdacDriver/IdacDriverSamplingThread.h>
+#include <IdacDriver/IdacRealtime.h>
 #include <IdacDriver/Sleeper.h>
 
 #include "IdacDriver4Constants.h"
@@ -113,6 +115,9 @@ IdacDriver4::IdacDriver4(UsbDevice* device, UsbHandle* handle, QObject* parent)
 	  m_defaultChannelSettings(3)
 {
 	m_bPowerOn = false;
+	m_nVersion = 0;
+	m_nDataStreamPauses = 0;
+	m_bDataStreamPaused = false;
 
 	m_bSampling = false;
 
@@ -298,22 +303,14 @@ void IdacDriver4::configureChannel(int iChan)
 	setChannelOffsetAnalogIn(iChan, chan->nOffset);
 }
 
-bool IdacDriver4::startSampling()
+void IdacDriver4::configureChannels()
 {
-	for (int iChan = 0; iChan < 3; iChan++)
-	{
-		const IdacChannelSettings* chan = desiredChannelSettings(iChan);
-		CHECK_ASSERT_RETVAL(chan != NULL, false);
+	applyChannelSettings(desiredSettingsCopy(), false);
+}
 
-		setChannelEnabled(iChan, chan->mEnabled);
-		if (iChan != 0)
-		{
-			setChannelRange(iChan, chan->iRange);
-			setChannelLowPass(iChan, chan->iHighcut);
-			setChannelHighPass(iChan, chan->iLowcut);
-			setChannelOffsetAnalogIn(iChan, chan->nOffset);
-		}
-	}
+bool IdacDriver4::startSampling()
+{
+	applyChannelSettings(desiredSettingsCopy(), true);
 
 //#ifndef Q_WS_MAC
 	sampleStart();
@@ -458,12 +455,18 @@ void IdacDriver4::sampleStart()
 		isobuf[i] = -1;
 	// ENDFIX
 
+	resetDecoder();
+	startCapture(m_nVersion);
+	startSamplingThread();
+}
+
+void IdacDriver4::resetDecoder()
+{
 	// Reset error flags
 	cdStatus = NULL_CDD32_STATUS;
 	// Reset channel state machine
 	IdacChannelState.Reset(MAX_SYNC_WORD_PER_SECOND);
-
-	startSamplingThread();
+	m_maskDataRecived = 0;
 }
 
 /// @returns libusb error code
@@ -515,7 +518,6 @@ void IdacDriver4::sampleLoop()
 	}
 
 	setIsoXferEnabled(true);
-	m_maskDataRecived = 0;
 
 	// Now cycle between reaps and submits
 	bool bSamplingPrev = m_bSampling;
@@ -530,12 +532,16 @@ void IdacDriver4::sampleLoop()
 
 			if (ret >= 0) {
 				iReapSuccess++;
-				processSampledData(i, ret);
+				const char* transfer = isobuf + ISO_TRANSFER_SIZE * i;
+				if (m_capture.isOpen())
+					captureTransfer(transfer, ret);
+				processSampledData(transfer, ret);
 			}
 			else
 			{
 				if (ret != -5) {
 					CHECK_USBRESULT_NORET(ret);
+					telemetry()->addTransferError();
 				}
 				//qDebug() << "Reap " << iReapSuccess << "/" << iReapAttempt << ", Buffer " << i << ": ISOCHRONOUS READ ret = " << ret;
 			}
@@ -550,24 +556,71 @@ void IdacDriver4::sampleLoop()
 	}
 
 	setIsoXferEnabled(false);
+	m_capture.close();
+}
+
+bool IdacDriver4::lockSamplingBuffers()
+{
+	CHECK_PRECOND_RETVAL(isobuf != NULL, false);
+	bool bLocked = IdacDriverWithThread::lockSamplingBuffers();
+	return IdacRealtime::lockMemory(isobuf, ISO_TRANSFER_SIZE * ISO_CONTEXT_COUNT) && bLocked;
+}
+
+void IdacDriver4::captureTransfer(const char* transfer, int nBytesReceived)
+{
+	// Most of each packet is unused, so only write the size word and the valid bytes
+	m_captureBuffer.resize(0);
+	for (int iPacket = 0; iPacket < ISO_PACKETS_PER_TRANSFER; iPacket++)
+	{
+		const char* packet = transfer + ISO_PACKET_SIZE * iPacket;
+		int nBytes = qMin(int(*(const quint16*) packet), ISO_PACKET_SIZE - 2);
+		m_captureBuffer.append(packet, 2 + nBytes);
+	}
+	m_capture.write(m_captureBuffer.constData(), m_captureBuffer.size(), nBytesReceived);
+}
+
+bool IdacDriver4::processCapturedTransfer(const QByteArray& payload, int nBytesReceived)
+{
+	// Restore the packet layout which captureTransfer() compacted
+	m_captureBuffer.fill(0, ISO_TRANSFER_SIZE);
+	char* transfer = m_captureBuffer.data();
+	int iPayload = 0;
+	for (int iPacket = 0; iPacket < ISO_PACKETS_PER_TRANSFER && iPayload + 2 <= payload.size(); iPacket++)
+	{
+		char* packet = transfer + ISO_PACKET_SIZE * iPacket;
+		memcpy(packet, payload.constData() + iPayload, 2);
+		int nBytes = qMin(int(*(const quint16*) packet), ISO_PACKET_SIZE - 2);
+		nBytes = qMin(nBytes, payload.size() - iPayload - 2);
+		memcpy(packet + 2, payload.constData() + iPayload + 2, nBytes);
+		iPayload += 2 + nBytes;
+	}
+	return processSampledData(transfer, nBytesReceived);
 }
 
-bool IdacDriver4::processSampledData(const int iTransfer, const int nBytesReceived) {
+bool IdacDriver4::processSampledData(const char* transfer, const int nBytesReceived) {
 	CHECK_ASSERT_NORET((nBytesReceived % ISO_PACKET_SIZE) == 0);
 
+	// The channel layout of the stream was changed by resumeDataStream()
+	if (m_nDecoderResetRequested.testAndSetOrdered(1, 0))
+		resetDecoder();
+
+	QElapsedTimer timer;
+	timer.start();
+
 	bool bOverflow = false;
 	//int nPackets = (nBytesReceived > 0) ? (nBytesReceived / ISO_PACKET_SIZE) : 0;
 	int nBytesProcessed = 0;
 
 	for (int iPacket = 0; iPacket < ISO_PACKETS_PER_TRANSFER; iPacket++ && nBytesProcessed < nBytesReceived)
 	{
-		quint16* pBuffer = (quint16*) (isobuf + ISO_TRANSFER_SIZE * iTransfer + ISO_PACKET_SIZE * iPacket);
+		const quint16* pBuffer = (const quint16*) (transfer + ISO_PACKET_SIZE * iPacket);
 		int nBytes = *pBuffer++;
 		int nWords = nBytes / 2;
 
 		if (nBytes > ISO_PACKET_SIZE - 2) {
+			telemetry()->addInvalidPacket();
 			logUsbError(__FILE__, __LINE__, QString("Invalid data size: %0").arg(nBytes));
-			cerr << iTransfer << " " << iPacket << " " << nBytes << endl;
+			cerr << iPacket << " " << nBytes << endl;
 			for (int j = 0; j < 299; j++) {
 				cerr << pBuffer[j] << " ";
 			}
@@ -575,6 +628,8 @@ bool IdacDriver4::processSampledData(const int iTransfer, const int nBytesReceiv
 			cerr.flush();
 			continue;
 		}
+		if (nBytes > 0)
+			telemetry()->addPacket(nBytes);
 
 		for (int iWord = 0; iWord < nWords; iWord++)
 		{
@@ -605,6 +660,7 @@ bool IdacDriver4::processSampledData(const int iTransfer, const int nBytesReceiv
 				}
 
 				if ((m_maskDataRecived & maskDataReceived) != 0) {
+					telemetry()->addDuplicate(cds.uChannel);
 					cerr << "Received duplicate data, mask " << maskDataReceived << endl;
 				}
 
@@ -625,6 +681,7 @@ bool IdacDriver4::processSampledData(const int iTransfer, const int nBytesReceiv
 		nBytesProcessed += nBytes;
 	}
 
+	telemetry()->addDecodeTime(timer.nsecsElapsed());
 	return bOverflow;
 }
 
@@ -731,7 +788,7 @@ bool IdacDriver4::setChannelOffsetAnalogIn (int iChan, quint32 Offset)
 {
 	CHECK_PARAM_RETVAL(iChan >= 1 && iChan < IDAC_CHANNELCOUNT, false);
 
-	long CorOffset = m_config.inputZeroAdjust[iChan - 1] + (long)Offset;
+	long CorOffset = m_config.inputZeroAdjust[iChan - 1] + (long)(qint32)Offset;
 
 	// Clip the level within the short range
 
@@ -754,8 +811,9 @@ bool IdacDriver4::setChannelOffsetAnalogIn (int iChan, quint32 Offset)
 	buffer[3] = (quint8) ADDRESS_ANALOG_OFF_LSB(iChan);
 
 	bool b = sendOutgoingMessage(REQUESTID_WRITE_FPGA_REG, buffer, sizeof(buffer));
+	// Store the requested offset rather than the corrected one, so that it can be compared with the desired settings
 	if (b)
-		actualChannelSettings(iChan)->nOffset = CorOffset;
+		actualChannelSettings(iChan)->nOffset = (short) Offset;
 	bRc &= b;
 
 	return bRc;
@@ -911,14 +969,8 @@ bool IdacDriver4::setChannelDecimation(int iChan, int nDecimation, bool bRecordS
 	CHECK_PARAM_RETVAL(iChan >= 0 && iChan <= 2, false);
 	CHECK_PARAM_RETVAL(nDecimation >= 0 && nDecimation < IDAC_DECIMATIONCOUNT, false);
 
-	bool bBusySampling = m_bSampling;
-
-	if (bBusySampling)
-		setSamplingEnabled(false);
-
-	CHECK_PARAM_RETVAL(iChan >= 0 && iChan <= 2, false);
-
-	CHECK_PARAM_RETVAL(nDecimation >= 0 && nDecimation < IDAC_DECIMATIONCOUNT, false);
+	// Unless the caller already paused the stream, this pauses it just for this change
+	pauseDataStream();
 
 	quint8 buffer[4];
 	buffer[0] = nDecimation >> 8;
@@ -940,12 +992,34 @@ bool IdacDriver4::setChannelDecimation(int iChan, int nDecimation, bool bRecordS
 	if (b && bRecordSetting)
 		actualChannelSettings(iChan)->nDecimation = nDecimation;
 
-	if (bBusySampling)
-		setSamplingEnabled(true);
+	resumeDataStream();
 
 	return true;
 }
 
+void IdacDriver4::pauseDataStream()
+{
+	if (m_nDataStreamPauses++ == 0 && m_bSampling)
+	{
+		// Only the device stops sending; the sampling thread keeps running
+		setIsoXferEnabled(false);
+		m_bDataStreamPaused = true;
+	}
+}
+
+void IdacDriver4::resumeDataStream()
+{
+	CHECK_PRECOND_RET(m_nDataStreamPauses > 0);
+
+	if (--m_nDataStreamPauses == 0 && m_bDataStreamPaused)
+	{
+		// Let the decoder resynchronize on the next sync word with the new channel layout
+		m_nDecoderResetRequested.store(1);
+		setIsoXferEnabled(true);
+		m_bDataStreamPaused = false;
+	}
+}
+
 // This function will set the range for the given channel
 void IdacDriver4::setChannelRange(int iChan, int Index)
 {
@@ -956,6 +1030,80 @@ void IdacDriver4::setChannelRange(int iChan, int Index)
 		actualChannelSettings(iChan)->iRange = Index;
 }
 
+void IdacDriver4::applyChannelSettings(const QVector<IdacChannelSettings>& desired, bool bForce)
+{
+	CHECK_PARAM_RET(desired.size() >= 3);
+
+	// Enabling or disabling channels and changing their decimation changes the layout of the data stream,
+	// so all of those changes are made during a single pause
+	int nPaused = 0;
+	for (int iChan = 0; iChan < 3; iChan++)
+	{
+		const IdacChannelSettings& chan = desired[iChan];
+		IdacChannelSettings* actual = actualChannelSettings(iChan);
+		bool bEnabled = (chan.mEnabled != 0);
+		bool bDecimation = chan.nDecimation >= 0 && chan.nDecimation < IDAC_DECIMATIONCOUNT && chan.nDecimation != actual->nDecimation;
+		// The whole mask is compared, so that a change to the digital channel's signals is recorded too
+		if (bForce || chan.mEnabled != actual->mEnabled || (bEnabled && bDecimation))
+		{
+			if (nPaused++ == 0)
+				pauseDataStream();
+			// Disabled channels get 0 as their decimation value, but keep the desired one for when they're enabled again
+			int nDecimation = 0;
+			if (bEnabled)
+				nDecimation = (bDecimation) ? chan.nDecimation : actual->nDecimation;
+			if (setChannelDecimation(iChan, nDecimation, bEnabled))
+				actual->mEnabled = chan.mEnabled;
+		}
+	}
+	if (nPaused > 0)
+		resumeDataStream();
+
+	for (int iChan = 1; iChan < 3; iChan++)
+	{
+		const IdacChannelSettings& chan = desired[iChan];
+		IdacChannelSettings* actual = actualChannelSettings(iChan);
+
+		// Range and filters are all part of the box string, so collect them and send it once
+		bool bRange = (bForce || chan.iRange != actual->iRange) && chan.iRange >= 0 && chan.iRange < IDAC_SCALERANGECOUNT;
+		bool bHighcut = (bForce || chan.iHighcut != actual->iHighcut) && chan.iHighcut >= 0 && chan.iHighcut < IDAC_LOWPASSCOUNT;
+		bool bLowcut = (bForce || chan.iLowcut != actual->iLowcut) && chan.iLowcut >= 0 && chan.iLowcut < IDAC_HIGHPASSCOUNT;
+		if (bRange)
+			SetBoxBits(iChan, BI_SCALE_ADJUST, (quint32) chan.iRange);
+		if (bHighcut)
+			SetBoxBits(iChan, BI_LOWPASS_ADJUST, (quint32) chan.iHighcut);
+		if (bLowcut)
+			SetBoxBits(iChan, BI_HIGHPASS_ADJUST, HighPassTable[chan.iLowcut]);
+		if ((bRange || bHighcut || bLowcut) && OutputBoxBits(iChan))
+		{
+			if (bRange)
+				actual->iRange = chan.iRange;
+			if (bHighcut)
+				actual->iHighcut = chan.iHighcut;
+			if (bLowcut)
+				actual->iLowcut = chan.iLowcut;
+		}
+
+		if (bForce || chan.nOffset != actual->nOffset)
+			setChannelOffsetAnalogIn(iChan, chan.nOffset);
+	}
+
+	// The device has no settings for inversion and external amplification; they're applied to the recorded samples
+	for (int iChan = 0; iChan < 3; iChan++)
+	{
+		IdacChannelSettings* actual = actualChannelSettings(iChan);
+		actual->mInvert = desired[iChan].mInvert;
+		actual->nExternalAmplification = desired[iChan].nExternalAmplification;
+	}
+
+	// Nor does the digital channel have a range, filters or an offset
+	IdacChannelSettings* digital = actualChannelSettings(0);
+	digital->iRange = desired[0].iRange;
+	digital->iLowcut = desired[0].iLowcut;
+	digital->iHighcut = desired[0].iHighcut;
+	digital->nOffset = desired[0].nOffset;
+}
+
 // Activate / deactivate isochrone transfer (SUPPINT.H)
 void IdacDriver4::setIsoXferEnabled(bool bEnabled)
 {
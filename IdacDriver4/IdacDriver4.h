@@ -19,6 +19,8 @@
 #define __IDACDRIVER4_H
 
 #include <QtGlobal> // for quint8 and related types
+#include <QAtomicInt>
+#include <QByteArray>
 
 #include <IdacDriver/IdacDriverUsb24Base.h>
 #include <IdacDriver/IdacSettings.h>
@@ -46,6 +48,7 @@ public:
 	void initDataFirmware();
 
 	void configureChannel(int iChan);
+	void configureChannels();
 
 	bool startSampling();
 
@@ -102,8 +105,19 @@ private:
 		bool	bReverse;
 	};
 
-private:
+// For IdacDriver4Replay
+protected:
 	void initStringsAndRanges();
+	/// Reset the state of the sample decoder
+	void resetDecoder();
+	/// Decode a transfer which was written to a capture file by captureTransfer()
+	/// @returns true if there was an overflow error, false otherwise
+	bool processCapturedTransfer(const QByteArray& payload, int nBytesReceived);
+
+protected:
+	quint8 m_nVersion;
+
+private:
 	/// Updates analog input stage of specific channel
 	bool UpdateAnalogIn(int iChan, BOXINDEX Bi, quint32 nValue);
 	void SetBoxBits(int iChan, BOXINDEX Bi, quint32 nValue);
@@ -112,18 +126,30 @@ private:
 	/// Send box string to IDAC (IDACINT.H)
 	bool OutputBoxBits(int iChan);
 
+	/// Send the given channel settings to the hardware: all of them if bForce, otherwise only the ones which changed.
+	/// Each channel's box string is sent once, and the data stream is paused at most once.
+	void applyChannelSettings(const QVector<IdacChannelSettings>& desired, bool bForce);
+	/// Pause the isochronous data stream while changing settings which affect its layout.
+	/// Calls may be nested; the stream is resumed by the outermost resumeDataStream().
+	void pauseDataStream();
+	void resumeDataStream();
+
 	void sampleStart();
 	void sampleInit();
 	void sampleLoop();
+	bool lockSamplingBuffers();
+	/// Decode the packets of one isochronous transfer
+	/// @param transfer ISO_PACKETS_PER_TRANSFER packets of ISO_PACKET_SIZE bytes each
 	/// @returns true if there was an overflow error, false otherwise
-	bool processSampledData(int iTransfer, int nBytesReceived);
+	bool processSampledData(const char* transfer, int nBytesReceived);
+	/// Write the used part of each packet of the transfer to the capture file
+	void captureTransfer(const char* transfer, int nBytesReceived);
 
 private:
 	static BitPosition bpIdacBox[BI_COUNT];
 
 	QVector<IdacChannelSettings> m_defaultChannelSettings;
 	bool m_bPowerOn;
-	quint8 m_nVersion;
 	ConfigData m_config;
 	/// Last digital value received
 	short m_nDig;
@@ -133,6 +159,14 @@ private:
 	short m_nAn2;
 	/// Mask to know which values (digital, analog 1, analog 2) have been received
 	short m_maskDataRecived;
+	/// Reused buffer for writing and reading captured transfers
+	QByteArray m_captureBuffer;
+	/// Nesting depth of pauseDataStream()
+	int m_nDataStreamPauses;
+	/// Whether pauseDataStream() actually stopped the stream
+	bool m_bDataStreamPaused;
+	/// Set when the sampling thread should reset its decoder before the next transfer
+	QAtomicInt m_nDecoderResetRequested;
 };
 
 #endif
@@ -12,11 +12,13 @@ INCLUDEPATH += . \
     ../Core \
     ../IdacDriver
 HEADERS += IdacDriver4.h \
+    IdacDriver4Replay.h \
     IdacDriver4Constants.h \
     IdacDriver4Channel.h \
     IdacDriver4ReqIds.h \
     IdacDriver4Es.h
 SOURCES += IdacDriver4.cpp \
+    IdacDriver4Replay.cpp \
     IdacDriver4Channel.cpp \
     IdacDriver4Firmware.cpp \
     IdacDriver4Es.cpp
@@ -0,0 +1,79 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "IdacDriver4Replay.h"
+
+#include <QtDebug>
+#include <QElapsedTimer>
+
+#include <Check.h>
+
+
+IdacDriver4Replay::IdacDriver4Replay(const QString& sFilename, bool bRealTime, QObject* parent)
+	: IdacDriver4(NULL, NULL, parent),
+	  m_sFilename(sFilename),
+	  m_bRealTime(bRealTime)
+{
+	IdacCaptureReader reader;
+	m_bValid = reader.open(sFilename) && reader.header().sHardwareName == hardwareName();
+	if (m_bValid)
+	{
+		m_header = reader.header();
+		m_nVersion = quint8(m_header.nHardwareVersion);
+	}
+	initStringsAndRanges();
+}
+
+bool IdacDriver4Replay::startSampling()
+{
+	CHECK_PRECOND_RETVAL(m_bValid, false);
+
+	// The decoder depends on the settings which were active during the capture, not on the desired ones
+	for (int iChan = 0; iChan < 3 && iChan < m_header.channels.size(); iChan++)
+		*actualChannelSettings(iChan) = m_header.channels[iChan];
+
+	resetDecoder();
+	startSamplingThread();
+	return true;
+}
+
+void IdacDriver4Replay::sampleLoop()
+{
+	IdacCaptureReader reader;
+	if (!reader.open(m_sFilename))
+	{
+		addError("Could not open the capture file " + m_sFilename);
+		return;
+	}
+
+	QElapsedTimer clock;
+	clock.start();
+
+	QByteArray payload;
+	int nBytesReceived;
+	qint64 nTime_ns;
+	int nTransfers = 0;
+	while (reader.read(payload, nBytesReceived, nTime_ns))
+	{
+		if (!waitForReplay(clock, nTime_ns, m_bRealTime))
+			break;
+		processCapturedTransfer(payload, nBytesReceived);
+		nTransfers++;
+	}
+
+	qDebug() << "IdacDriver4Replay: replayed" << nTransfers << "transfers in" << clock.elapsed() << "ms";
+}
@@ -517,6 +517,8 @@ void IdacDriverES::configureChannel(int iChan)
 	const IdacChannelSettings* chan = desiredChannelSettings(iChan);
 	CHECK_ASSERT_RET(chan != NULL);
 
+	if (iChan != 0)
+		IdacScaleRange(iChan, chan->iRange);
 	IdacLowPass(iChan, chan->iHighcut);
 	IdacHighPass(iChan, chan->iLowcut);
 	IdacSetOffsetAnalogIn(iChan, chan->nOffset);
@@ -0,0 +1,511 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "Catalog.h"
+
+#include <QtDebug>
+#include <QAtomicInt>
+#include <QBuffer>
+#include <QDir>
+#include <QFileInfo>
+#include <QImage>
+#include <QPainter>
+#include <QRegExp>
+#include <QSqlDatabase>
+#include <QSqlError>
+#include <QSqlQuery>
+#include <QStandardPaths>
+#include <QVariant>
+
+#include <Check.h>
+
+#include "AppDefines.h"
+#include "EadFile.h"
+#include "RecInfo.h"
+#include "WaveInfo.h"
+
+
+static const int THUMBNAIL_WIDTH = 160;
+static const int THUMBNAIL_HEIGHT = 64;
+
+/// Statements which create the tables and their secondary indexes.
+/// Comments are indexed by their words, so that searching for a word doesn't need to scan all comments.
+static const char* const SCHEMA[] = {
+	"CREATE TABLE IF NOT EXISTS files (id INTEGER PRIMARY KEY, path TEXT NOT NULL UNIQUE, size INTEGER, modified INTEGER, recorded INTEGER, comment TEXT, markers INTEGER)",
+	"CREATE INDEX IF NOT EXISTS files_recorded ON files (recorded)",
+	"CREATE INDEX IF NOT EXISTS files_markers ON files (markers)",
+	"CREATE TABLE IF NOT EXISTS words (file INTEGER NOT NULL REFERENCES files (id) ON DELETE CASCADE, word TEXT NOT NULL)",
+	"CREATE INDEX IF NOT EXISTS words_file ON words (file)",
+	"CREATE INDEX IF NOT EXISTS words_word ON words (word)",
+	"CREATE TABLE IF NOT EXISTS waves (file INTEGER NOT NULL REFERENCES files (id) ON DELETE CASCADE, name TEXT NOT NULL COLLATE NOCASE)",
+	"CREATE INDEX IF NOT EXISTS waves_file ON waves (file)",
+	"CREATE INDEX IF NOT EXISTS waves_name ON waves (name)",
+	"CREATE TABLE IF NOT EXISTS peaks (file INTEGER NOT NULL REFERENCES files (id) ON DELETE CASCADE, minutes REAL NOT NULL)",
+	"CREATE INDEX IF NOT EXISTS peaks_file ON peaks (file)",
+	"CREATE INDEX IF NOT EXISTS peaks_minutes ON peaks (minutes)",
+	"CREATE TABLE IF NOT EXISTS thumbnails (file INTEGER PRIMARY KEY REFERENCES files (id) ON DELETE CASCADE, png BLOB)",
+	NULL
+};
+
+static QAtomicInt g_nConnections;
+
+
+static bool exec(QSqlQuery& query)
+{
+	if (query.exec())
+		return true;
+	qWarning() << "Catalog:" << query.lastError().text();
+	return false;
+}
+
+static bool exec(QSqlDatabase db, const QString& sSql)
+{
+	QSqlQuery query(db);
+	query.prepare(sSql);
+	return exec(query);
+}
+
+/// Lower-case words of a comment, as they're kept in the words table
+static QStringList commentWords(const QString& s)
+{
+	QStringList words = s.toLower().split(QRegExp("\\W+"), QString::SkipEmptyParts);
+	words.removeDuplicates();
+	return words;
+}
+
+/// Upper limit for a range query which finds the strings that start with sPrefix
+static QString prefixEnd(const QString& sPrefix)
+{
+	return sPrefix + QChar(0xFFFF);
+}
+
+static qint64 toMSecs(const QDateTime& time)
+{
+	return (time.isValid()) ? time.toMSecsSinceEpoch() : 0;
+}
+
+static QDateTime fromMSecs(const QVariant& v)
+{
+	return (v.isNull() || v.toLongLong() == 0) ? QDateTime() : QDateTime::fromMSecsSinceEpoch(v.toLongLong());
+}
+
+
+QString Catalog::defaultFilename()
+{
+	// Shared by the program and gcead-batch, like the QSettings
+	QDir dir(QStandardPaths::writableLocation(QStandardPaths::GenericDataLocation));
+	return dir.filePath(QString("Syntech/%1/catalog.sqlite").arg(APPSETTINGSKEY));
+}
+
+Catalog::Catalog(const QString& sFilename)
+	: m_sFilename(sFilename)
+{
+	m_sConnection = QString("catalog%1").arg(g_nConnections.fetchAndAddRelaxed(1));
+	QDir().mkpath(QFileInfo(sFilename).absolutePath());
+
+	QSqlDatabase db = QSqlDatabase::addDatabase("QSQLITE", m_sConnection);
+	db.setDatabaseName(sFilename);
+	m_bOpen = db.open();
+	if (m_bOpen)
+		m_bOpen = createSchema();
+	else
+		qWarning() << "Catalog:" << db.lastError().text();
+}
+
+Catalog::~Catalog()
+{
+	{
+		QSqlDatabase db = QSqlDatabase::database(m_sConnection, false);
+		db.close();
+	}
+	QSqlDatabase::removeDatabase(m_sConnection);
+}
+
+bool Catalog::createSchema()
+{
+	QSqlDatabase db = QSqlDatabase::database(m_sConnection, false);
+
+	// Let gcead-batch add files while the program is searching the catalog
+	exec(db, "PRAGMA journal_mode = WAL");
+	if (!exec(db, "PRAGMA foreign_keys = ON"))
+		return false;
+
+	for (int i = 0; SCHEMA[i] != NULL; i++)
+	{
+		if (!exec(db, SCHEMA[i]))
+			return false;
+	}
+	return true;
+}
+
+CatalogEntry Catalog::describe(const EadFile* file, const QString& sFilename)
+{
+	CHECK_PARAM_RETVAL(file != NULL, CatalogEntry());
+	CHECK_PRECOND_RETVAL(!file->isLoading(), CatalogEntry());
+
+	CatalogEntry entry;
+	QFileInfo fi(sFilename);
+	entry.sFilename = fi.absoluteFilePath();
+	entry.nSize = fi.size();
+	entry.lastModified = fi.lastModified();
+	entry.sComment = file->comment();
+
+	foreach (const RecInfo* rec, file->recs())
+	{
+		foreach (const WaveInfo* wave, rec->waves())
+		{
+			if (wave == NULL)
+				continue;
+
+			entry.nMarkers += wave->peaksChosen.size();
+			// The averaged waves of rec 0 aren't recordings of their own
+			if (rec->id() > 0 && !wave->raw.isEmpty() && !wave->sName.isEmpty() && !entry.waveNames.contains(wave->sName))
+				entry.waveNames << wave->sName;
+		}
+
+		if (rec->id() > 0 && rec->timeOfRecording().isValid())
+		{
+			if (!entry.timeOfRecording.isValid() || rec->timeOfRecording() < entry.timeOfRecording)
+				entry.timeOfRecording = rec->timeOfRecording();
+		}
+
+		// Retention times are calculated the same way as by EadFile::exportRetentionData()
+		const WaveInfo* fid = rec->wave(WaveType_FID);
+		if (fid != NULL)
+		{
+			foreach (const WavePeakChosenInfo& peak, fid->peaksChosen)
+			{
+				if (peak.type == MarkerType_FidPeak && peak.didxs.size() == 3)
+					entry.peakTimes << double(peak.didxs[1] + fid->shift()) / (EAD_SAMPLES_PER_SECOND * 60);
+			}
+		}
+	}
+
+	entry.thumbnail = renderThumbnail(file);
+	return entry;
+}
+
+CatalogEntry Catalog::describeFile(const QString& sFilename)
+{
+	EadFile file;
+	LoadSaveResult result = file.load(sFilename);
+	if (result != LoadSaveResult_Ok && result != LoadSaveResult_ImportedOldEad)
+		return CatalogEntry();
+	return describe(&file, sFilename);
+}
+
+/// Draw the minimum and maximum of the samples under each column of rc
+static void drawThumbnailWave(QPainter& painter, const QVector<double>& display, const QRect& rc)
+{
+	const int nSamples = display.size();
+	if (nSamples == 0)
+		return;
+
+	double nMin = display[0];
+	double nMax = display[0];
+	foreach (double n, display)
+	{
+		nMin = qMin(nMin, n);
+		nMax = qMax(nMax, n);
+	}
+	const double nRange = (nMax > nMin) ? nMax - nMin : 1;
+	const double nScale = (rc.height() - 1) / nRange;
+
+	for (int x = 0; x < rc.width(); x++)
+	{
+		int i0 = int(qint64(x) * nSamples / rc.width());
+		int i1 = qMax(i0 + 1, int(qint64(x + 1) * nSamples / rc.width()));
+		double nColMin = display[i0];
+		double nColMax = display[i0];
+		for (int i = i0 + 1; i < i1 && i < nSamples; i++)
+		{
+			nColMin = qMin(nColMin, display[i]);
+			nColMax = qMax(nColMax, display[i]);
+		}
+		int yTop = rc.bottom() - int((nColMax - nMin) * nScale);
+		int yBottom = rc.bottom() - int((nColMin - nMin) * nScale);
+		painter.drawLine(rc.left() + x, yTop, rc.left() + x, yBottom);
+	}
+}
+
+QByteArray Catalog::renderThumbnail(const EadFile* file)
+{
+	QImage image(THUMBNAIL_WIDTH, THUMBNAIL_HEIGHT, QImage::Format_RGB32);
+	image.fill(Qt::white);
+
+	QPainter painter(&image);
+	painter.setPen(QColor(180, 180, 255));
+	painter.drawRect(0, 0, THUMBNAIL_WIDTH - 1, THUMBNAIL_HEIGHT - 1);
+
+	// Like in the charts, the EAD is drawn above the FID
+	const int nHalf = (THUMBNAIL_HEIGHT - 4) / 2;
+	const QRect rcEad(2, 2, THUMBNAIL_WIDTH - 4, nHalf);
+	const QRect rcFid(2, 2 + nHalf, THUMBNAIL_WIDTH - 4, nHalf);
+
+	// Preview the averaged waves, or the first recording which has any data
+	foreach (const RecInfo* rec, file->recs())
+	{
+		const WaveInfo* ead = rec->wave(WaveType_EAD);
+		const WaveInfo* fid = rec->wave(WaveType_FID);
+		bool bEad = (ead != NULL && !ead->display.isEmpty());
+		bool bFid = (fid != NULL && !fid->display.isEmpty());
+		if (!bEad && !bFid)
+			continue;
+
+		painter.setPen((rec->id() == 0) ? QColor(0, 80, 0) : QColor(Qt::black));
+		if (bEad)
+			drawThumbnailWave(painter, ead->display, rcEad);
+		if (bFid)
+			drawThumbnailWave(painter, fid->display, rcFid);
+		break;
+	}
+	painter.end();
+
+	QByteArray png;
+	QBuffer buffer(&png);
+	buffer.open(QIODevice::WriteOnly);
+	image.save(&buffer, "PNG");
+	return png;
+}
+
+bool Catalog::update(const CatalogEntry& entry)
+{
+	return update(QList<CatalogEntry>() << entry);
+}
+
+bool Catalog::update(const QList<CatalogEntry>& entries)
+{
+	CHECK_PRECOND_RETVAL(m_bOpen, false);
+
+	QSqlDatabase db = QSqlDatabase::database(m_sConnection, false);
+	if (!db.transaction())
+		return false;
+
+	QSqlQuery deleteFile(db);
+	deleteFile.prepare("DELETE FROM files WHERE path = ?");
+	QSqlQuery insertFile(db);
+	insertFile.prepare("INSERT INTO files (path, size, modified, recorded, comment, markers) VALUES (?, ?, ?, ?, ?, ?)");
+	QSqlQuery insertWord(db);
+	insertWord.prepare("INSERT INTO words (file, word) VALUES (?, ?)");
+	QSqlQuery insertWave(db);
+	insertWave.prepare("INSERT INTO waves (file, name) VALUES (?, ?)");
+	QSqlQuery insertPeak(db);
+	insertPeak.prepare("INSERT INTO peaks (file, minutes) VALUES (?, ?)");
+	QSqlQuery insertThumbnail(db);
+	insertThumbnail.prepare("INSERT INTO thumbnails (file, png) VALUES (?, ?)");
+
+	bool bOk = true;
+	foreach (const CatalogEntry& entry, entries)
+	{
+		// Files which couldn't be described are left out
+		if (entry.sFilename.isEmpty())
+			continue;
+
+		// The old entry's words, waves, peaks and thumbnail are deleted along with it
+		deleteFile.addBindValue(entry.sFilename);
+		bOk = exec(deleteFile);
+
+		if (bOk)
+		{
+			insertFile.addBindValue(entry.sFilename);
+			insertFile.addBindValue(entry.nSize);
+			insertFile.addBindValue(toMSecs(entry.lastModified));
+			insertFile.addBindValue(toMSecs(entry.timeOfRecording));
+			insertFile.addBindValue(entry.sComment);
+			insertFile.addBindValue(entry.nMarkers);
+			bOk = exec(insertFile);
+		}
+		if (!bOk)
+			break;
+
+		const qint64 id = insertFile.lastInsertId().toLongLong();
+		foreach (const QString& sWord, commentWords(entry.sComment))
+		{
+			insertWord.addBindValue(id);
+			insertWord.addBindValue(sWord);
+			bOk = bOk && exec(insertWord);
+		}
+		foreach (const QString& sName, entry.waveNames)
+		{
+			insertWave.addBindValue(id);
+			insertWave.addBindValue(sName);
+			bOk = bOk && exec(insertWave);
+		}
+		foreach (double nMinutes, entry.peakTimes)
+		{
+			insertPeak.addBindValue(id);
+			insertPeak.addBindValue(nMinutes);
+			bOk = bOk && exec(insertPeak);
+		}
+		if (!entry.thumbnail.isEmpty())
+		{
+			insertThumbnail.addBindValue(id);
+			insertThumbnail.addBindValue(entry.thumbnail);
+			bOk = bOk && exec(insertThumbnail);
+		}
+		if (!bOk)
+			break;
+	}
+
+	if (bOk)
+		bOk = db.commit();
+	else
+		db.rollback();
+	return bOk;
+}
+
+bool Catalog::remove(const QString& sFilename)
+{
+	CHECK_PRECOND_RETVAL(m_bOpen, false);
+
+	QSqlQuery query(QSqlDatabase::database(m_sConnection, false));
+	query.prepare("DELETE FROM files WHERE path = ?");
+	query.addBindValue(QFileInfo(sFilename).absoluteFilePath());
+	return exec(query);
+}
+
+bool Catalog::isCurrent(const QFileInfo& fi) const
+{
+	CHECK_PRECOND_RETVAL(m_bOpen, false);
+
+	QSqlQuery query(QSqlDatabase::database(m_sConnection, false));
+	query.prepare("SELECT size, modified FROM files WHERE path = ?");
+	query.addBindValue(fi.absoluteFilePath());
+	if (!exec(query) || !query.next())
+		return false;
+	return (query.value(0).toLongLong() == fi.size() && query.value(1).toLongLong() == toMSecs(fi.lastModified()));
+}
+
+int Catalog::removeMissing()
+{
+	CHECK_PRECOND_RETVAL(m_bOpen, -1);
+
+	QSqlDatabase db = QSqlDatabase::database(m_sConnection, false);
+	QStringList missing;
+	{
+		QSqlQuery query(db);
+		query.prepare("SELECT path FROM files");
+		if (!exec(query))
+			return -1;
+		while (query.next())
+		{
+			QString sFilename = query.value(0).toString();
+			if (!QFileInfo(sFilename).exists())
+				missing << sFilename;
+		}
+	}
+
+	if (!db.transaction())
+		return -1;
+	bool bOk = true;
+	QSqlQuery deleteFile(db);
+	deleteFile.prepare("DELETE FROM files WHERE path = ?");
+	foreach (const QString& sFilename, missing)
+	{
+		deleteFile.addBindValue(sFilename);
+		bOk = bOk && exec(deleteFile);
+	}
+	if (bOk)
+		bOk = db.commit();
+	else
+		db.rollback();
+	return (bOk) ? missing.size() : -1;
+}
+
+QList<CatalogEntry> Catalog::find(const CatalogQuery& query) const
+{
+	QList<CatalogEntry> entries;
+	CHECK_PRECOND_RETVAL(m_bOpen, entries);
+
+	// Each condition narrows the files down through its own index
+	QString sSql =
+		"SELECT f.path, f.size, f.modified, f.recorded, f.comment, f.markers,"
+		" (SELECT group_concat(name, char(10)) FROM waves WHERE file = f.id),"
+		" (SELECT group_concat(minutes, ' ') FROM peaks WHERE file = f.id)"
+		" FROM files f WHERE 1";
+	QVariantList values;
+	if (query.dateFrom.isValid())
+	{
+		sSql += " AND f.recorded >= ?";
+		values << toMSecs(QDateTime(query.dateFrom));
+	}
+	if (query.dateTo.isValid())
+	{
+		sSql += " AND f.recorded < ?";
+		values << toMSecs(QDateTime(query.dateTo.addDays(1)));
+	}
+	foreach (const QString& sWord, commentWords(query.sComment))
+	{
+		sSql += " AND f.id IN (SELECT file FROM words WHERE word >= ? AND word < ?)";
+		values << sWord << prefixEnd(sWord);
+	}
+	if (!query.sWaveName.isEmpty())
+	{
+		sSql += " AND f.id IN (SELECT file FROM waves WHERE name >= ? AND name < ?)";
+		values << query.sWaveName << prefixEnd(query.sWaveName);
+	}
+	if (query.nMinMarkers > 0)
+	{
+		sSql += " AND f.markers >= ?";
+		values << query.nMinMarkers;
+	}
+	if (query.nPeakTimeFrom >= 0 || query.nPeakTimeTo >= 0)
+	{
+		sSql += " AND f.id IN (SELECT file FROM peaks WHERE minutes >= ? AND minutes <= ?)";
+		values << qMax(query.nPeakTimeFrom, 0.0);
+		values << ((query.nPeakTimeTo >= 0) ? query.nPeakTimeTo : 1e9);
+	}
+	sSql += " ORDER BY f.recorded DESC, f.path LIMIT ?";
+	values << query.nMaxResults;
+
+	QSqlQuery q(QSqlDatabase::database(m_sConnection, false));
+	q.setForwardOnly(true);
+	q.prepare(sSql);
+	foreach (const QVariant& v, values)
+		q.addBindValue(v);
+	if (!exec(q))
+		return entries;
+
+	while (q.next())
+	{
+		CatalogEntry entry;
+		entry.sFilename = q.value(0).toString();
+		entry.nSize = q.value(1).toLongLong();
+		entry.lastModified = fromMSecs(q.value(2));
+		entry.timeOfRecording = fromMSecs(q.value(3));
+		entry.sComment = q.value(4).toString();
+		entry.nMarkers = q.value(5).toInt();
+		entry.waveNames = q.value(6).toString().split('\n', QString::SkipEmptyParts);
+		foreach (const QString& s, q.value(7).toString().split(' ', QString::SkipEmptyParts))
+			entry.peakTimes << s.toDouble();
+		entries << entry;
+	}
+	return entries;
+}
+
+QByteArray Catalog::thumbnail(const QString& sFilename) const
+{
+	CHECK_PRECOND_RETVAL(m_bOpen, QByteArray());
+
+	QSqlQuery query(QSqlDatabase::database(m_sConnection, false));
+	query.prepare("SELECT t.png FROM thumbnails t JOIN files f ON t.file = f.id WHERE f.path = ?");
+	query.addBindValue(sFilename);
+	if (!exec(query) || !query.next())
+		return QByteArray();
+	return query.value(0).toByteArray();
+}
@@ -0,0 +1,139 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __CATALOG_H
+#define __CATALOG_H
+
+#include <QByteArray>
+#include <QDate>
+#include <QDateTime>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+
+class QFileInfo;
+
+class EadFile;
+
+
+/// Summary of an .ead file, as kept in the Catalog
+class CatalogEntry
+{
+public:
+	/// Absolute path of the file
+	QString sFilename;
+	/// Size and modification time of the file when it was summarized
+	qint64 nSize;
+	QDateTime lastModified;
+	/// Start of the earliest recording
+	QDateTime timeOfRecording;
+	QString sComment;
+	/// Names of the recorded waves
+	QStringList waveNames;
+	/// Number of markers on all waves
+	int nMarkers;
+	/// Retention times of the FID peak markers in minutes
+	QList<double> peakTimes;
+	/// PNG preview of the averaged waves
+	QByteArray thumbnail;
+
+	CatalogEntry()
+		: nSize(0), nMarkers(0)
+	{
+	}
+};
+
+
+/// Conditions for Catalog::find(); conditions which are left at their defaults match all files
+class CatalogQuery
+{
+public:
+	/// Range of recording dates, inclusive
+	QDate dateFrom;
+	QDate dateTo;
+	/// Text which the file comment must contain (case-insensitive)
+	QString sComment;
+	/// Start of the name of any of the file's waves (case-insensitive)
+	QString sWaveName;
+	int nMinMarkers;
+	/// Range in minutes within which the file must have an FID peak marker, or -1 for no limit
+	double nPeakTimeFrom;
+	double nPeakTimeTo;
+	int nMaxResults;
+
+	CatalogQuery()
+		: nMinMarkers(0), nPeakTimeFrom(-1), nPeakTimeTo(-1), nMaxResults(200)
+	{
+	}
+};
+
+
+/// Searchable index of .ead files, kept in a single SQLite file.
+/// Files are summarized by describe() when they're saved or indexed, so that they can be found
+/// by date, comment, wave names, marker count and peak retention times, and previewed, without opening them.
+/// Each Catalog object has its own database connection, which may only be used from the thread that created it.
+class Catalog
+{
+public:
+	/// Catalog in the user's application data directory
+	static QString defaultFilename();
+
+	/// Open the catalog, creating it if it doesn't exist yet
+	Catalog(const QString& sFilename);
+	~Catalog();
+
+	const QString& filename() const { return m_sFilename; }
+	bool isOpen() const { return m_bOpen; }
+
+	/// Summarize a file which has been loaded completely
+	/// @param sFilename the file which it was loaded from or saved to
+	static CatalogEntry describe(const EadFile* file, const QString& sFilename);
+	/// Load and summarize a file, e.g. on a worker thread while indexing a directory
+	/// @returns an entry with an empty filename if the file couldn't be loaded
+	static CatalogEntry describeFile(const QString& sFilename);
+
+	/// Add the entry, replacing any previous entry for the same file
+	bool update(const CatalogEntry& entry);
+	/// Add several entries at once, which is much faster than adding them one by one
+	bool update(const QList<CatalogEntry>& entries);
+	bool remove(const QString& sFilename);
+	/// Whether the catalog's entry for the file is up-to-date with its size and modification time
+	bool isCurrent(const QFileInfo& fi) const;
+	/// Remove the entries of files which no longer exist
+	/// @returns the number of removed entries, or -1 on error
+	int removeMissing();
+
+	/// Find the matching files, most recently recorded first.
+	/// The entries' thumbnails are left empty; use thumbnail() to get them.
+	QList<CatalogEntry> find(const CatalogQuery& query) const;
+	/// PNG preview of a file, or empty if the file isn't in the catalog
+	QByteArray thumbnail(const QString& sFilename) const;
+
+private:
+	bool createSchema();
+	static QByteArray renderThumbnail(const EadFile* file);
+
+private:
+	const QString m_sFilename;
+	/// Name of the QSqlDatabase connection
+	QString m_sConnection;
+	bool m_bOpen;
+};
+
+#endif
@@ -20,6 +20,7 @@
 #include <QtDebug>
 #include <QPainter>
 
+#include "MonitorHistory.h"
 #include "RecInfo.h"
 #include "RenderData.h"
 #include "ViewInfo.h"
@@ -457,9 +458,18 @@ void ChartPixmap::drawWaveform(QPainter& painter, ChartWaveInfo* cwi)
 	if (render->nSamplesPerPixel != renderCheck.nSamplesPerPixel ||
 		render->didxFirst > renderCheck.didxFirst ||
 		render->didxLast < renderCheck.didxLast ||
-		render->nPixels != renderCheck.nPixels)
+		render->nPixels != renderCheck.nPixels ||
+		// Pixels before the first sample may have been taken from a preview
+		(renderCheck.didxFirstRequested < 0 && render->tidxStart != renderCheck.tidxStart))
 	{
-		render->render(vwi, m_params.nSampleOffset, xWidth, p.nXToIndexFactor);
+		// Use the pixels summarized while recording, if there are any
+		const RenderPreview* preview = m_params.previews.value(wave, NULL);
+		// Before the first sample of a recording, show the continuous monitoring which preceded it
+		RenderPreview history;
+		if (preview == NULL && renderCheck.didxFirstRequested < 0 && historyPreview(vwi, renderCheck, history))
+			preview = &history;
+		if (preview == NULL || !render->renderPreview(vwi, m_params.nSampleOffset, xWidth, p.nXToIndexFactor, *preview))
+			render->render(vwi, m_params.nSampleOffset, xWidth, p.nXToIndexFactor);
 		if (cwi->renderStd != NULL)
 			cwi->renderStd->renderStd(vwi, m_params.nSampleOffset, xWidth, p.nXToIndexFactor);
 	}
@@ -482,6 +492,25 @@ void ChartPixmap::drawWaveform(QPainter& painter, ChartWaveInfo* cwi)
 	drawMarkers(painter, cwi);
 }
 
+bool ChartPixmap::historyPreview(const ViewWaveInfo* vwi, const RenderData& render, RenderPreview& preview) const
+{
+	const WaveInfo* wave = vwi->wave();
+	const MonitorHistory* history = (wave->rec() != NULL) ? wave->rec()->monitorHistory() : NULL;
+	if (history == NULL || history->spilledSamples() == 0 || render.nSamplesPerPixel < 1)
+		return false;
+
+	// Pixel indexes as calculated in RenderData::setup(), where pixel 0 starts at the wave's first sample
+	const int iPixelFirst = int((render.tidxStart - vwi->shift()) / render.nSamplesPerPixel);
+	const int iPixelEnd = qMin(iPixelFirst + render.nPixelsRequested, 0);
+	if (iPixelFirst >= iPixelEnd)
+		return false;
+
+	preview.nSamplesPerPixel = render.nSamplesPerPixel;
+	preview.iPixelFirst = iPixelFirst;
+	history->summarize(MonitorHistory::channel(wave->type), history->spilledSamples(), render.nSamplesPerPixel, iPixelFirst, iPixelEnd - iPixelFirst, preview.pixels);
+	return true;
+}
+
 void ChartPixmap::drawWaveformRough(QPainter& painter, const ChartWaveInfo* cwi)
 {
 	const ViewWaveInfo* vwi = cwi->vwi;
@@ -31,6 +31,7 @@ class QPainter;
 
 class EadFile;
 class RenderData;
+class RenderPreview;
 class ViewInfo;
 class ViewWaveInfo;
 class WaveInfo;
@@ -63,6 +64,9 @@ public:
 	QPointer<ViewWaveInfo> vwiHilight;
 	bool bSelectedWaveIsActive;
 
+	/// Ready-made pixels for waves which are currently being recorded
+	QHash<const WaveInfo*, const RenderPreview*> previews;
+
 	ChartPixmapParams()
 	{
 		file = NULL;
@@ -110,6 +114,8 @@ public:
 	int centerSample() const;
 	/// Last sample index which fits onto the pixmap
 	int lastSample() const;
+	/// Number of samples drawn per pixel
+	double samplesPerPixel() const { return p.nXToIndexFactor; }
 
 	/// Calculate the size of the chart given the available area and number of columns
 	QSize sizeForAvailableArea(const QSize& size, int nCols) const;
@@ -213,6 +219,9 @@ private:
 	QColor color(ChartColor color);
 	void drawGrid(QPainter& painter);
 	void drawWaveform(QPainter& painter, ChartWaveInfo* vwi);
+	/// Summarize the part of the monitoring history of the wave's recording which lies before its first sample
+	/// @returns false if the wave has no history, or none of it is visible
+	bool historyPreview(const ViewWaveInfo* vwi, const RenderData& render, RenderPreview& preview) const;
 	void drawWaveformRough(QPainter& painter, const ChartWaveInfo* vwi);
 	void drawWaveformSmooth(QPainter& painter, const ChartWaveInfo* vwi);
 	void drawWaveformStd(QPainter& painter, const ChartWaveInfo* cwi);
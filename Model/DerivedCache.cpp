@@ -0,0 +1,284 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "DerivedCache.h"
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <Check.h>
+
+#include "EadFile.h"
+#include "FilterInfo.h"
+#include "RecInfo.h"
+#include "WaveInfo.h"
+
+
+/// Identifies cache files
+static const quint32 CACHE_MAGIC = 0x45414443; // "EADC"
+/// Increase this whenever the calculation of any of the cached data changes
+static const qint32 CACHE_VERSION = 1;
+
+
+/// Derived data of one wave as read from the cache
+class CachedWave
+{
+public:
+	QVector<double> display;
+	QVector<double> std;
+	QList<WavePeakInfo> peaks0;
+	QList<double> areas;
+	QList<double> percents;
+};
+
+
+/// Vectors are written as raw memory, which is why the byte order is part of the key
+static void writeVector(QDataStream& str, const QVector<double>& v)
+{
+	str << qint32(v.size());
+	str.writeRawData((const char*) v.constData(), v.size() * int(sizeof(double)));
+}
+
+static bool readVector(QDataStream& str, QVector<double>& v)
+{
+	qint32 n = -1;
+	str >> n;
+	if (n < 0 || n > str.device()->bytesAvailable() / qint64(sizeof(double)))
+		return false;
+	v.resize(n);
+	return (str.readRawData((char*) v.data(), n * int(sizeof(double))) == n * int(sizeof(double)));
+}
+
+static void writePoint(QDataStream& str, const WavePoint& pt)
+{
+	str << qint32(pt.i) << pt.n;
+}
+
+static void readPoint(QDataStream& str, WavePoint& pt)
+{
+	qint32 i;
+	str >> i >> pt.n;
+	pt.i = i;
+}
+
+
+QString DerivedCache::cacheFilename(const QString& sFilename)
+{
+	const QString sDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation);
+	QFileInfo fi(sFilename);
+	if (sDir.isEmpty() || !fi.exists())
+		return QString();
+
+	// A modified or replaced .ead file gets a new cache file, and the old one is simply never read again
+	QByteArray id;
+	QDataStream str(&id, QIODevice::WriteOnly);
+	str << fi.canonicalFilePath() << fi.lastModified().toMSecsSinceEpoch() << fi.size();
+	const QByteArray hash = QCryptographicHash::hash(id, QCryptographicHash::Sha1).toHex();
+	return sDir + "/derived/" + QString::fromLatin1(hash) + ".cache";
+}
+
+QByteArray DerivedCache::key(EadFile* file)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	QByteArray header;
+	QDataStream str(&header, QIODevice::WriteOnly);
+	str << CACHE_VERSION << qint32(Q_BYTE_ORDER);
+
+	foreach (FilterTesterInfo* filter, file->filters())
+	{
+		str << qint32(filter->waveType()) << qint32(filter->filterId());
+		str << filter->properties(filter->filterId());
+	}
+	hash.addData(header);
+
+	foreach (RecInfo* rec, file->recs())
+	{
+		// The averages are derived from the other recordings
+		if (rec->id() == 0)
+			continue;
+
+		foreach (WaveInfo* wave, rec->waves())
+		{
+			QByteArray info;
+			QDataStream strInfo(&info, QIODevice::WriteOnly);
+			strInfo << qint32(rec->id()) << qint32(wave->type) << qint32(wave->shift()) << wave->pos.bVisible;
+			strInfo << qint32(wave->nRawToVoltageFactorNum) << qint32(wave->nRawToVoltageFactorDen) << wave->nRawToVoltageFactor;
+			strInfo << qint32(wave->raw.size()) << qint32(wave->peaksChosen.size());
+			foreach (const WavePeakChosenInfo& peak, wave->peaksChosen)
+			{
+				strInfo << qint32(peak.type) << qint32(peak.didxs.size());
+				foreach (int didx, peak.didxs)
+					strInfo << qint32(didx);
+			}
+			hash.addData(info);
+			hash.addData((const char*) wave->raw.constData(), wave->raw.size() * int(sizeof(short)));
+		}
+	}
+
+	return hash.result();
+}
+
+bool DerivedCache::save(EadFile* file, const QString& sCacheFilename)
+{
+	CHECK_PARAM_RETVAL(file != NULL, false);
+	if (sCacheFilename.isEmpty())
+		return false;
+	if (!QDir().mkpath(QFileInfo(sCacheFilename).absolutePath()))
+		return false;
+
+	// Written to a temporary file first, so that a crash never leaves a partial cache behind
+	QSaveFile out(sCacheFilename);
+	if (!out.open(QIODevice::WriteOnly))
+		return false;
+
+	QDataStream str(&out);
+	str << CACHE_MAGIC << CACHE_VERSION << key(file);
+	str << qint32(file->recs().size());
+	foreach (RecInfo* rec, file->recs())
+	{
+		str << qint32(rec->waves().size());
+		foreach (WaveInfo* wave, rec->waves())
+		{
+			writeVector(str, wave->display);
+			writeVector(str, wave->std);
+
+			str << qint32(wave->peaks0.size());
+			foreach (const WavePeakInfo& peak, wave->peaks0)
+			{
+				str << peak.bEnabled;
+				writePoint(str, peak.left);
+				writePoint(str, peak.middle);
+				writePoint(str, peak.right);
+			}
+
+			str << qint32(wave->peaksChosen.size());
+			foreach (const WavePeakChosenInfo& peak, wave->peaksChosen)
+				str << peak.nArea << peak.nPercent;
+		}
+	}
+
+	if (str.status() != QDataStream::Ok)
+	{
+		out.cancelWriting();
+		return false;
+	}
+	return out.commit();
+}
+
+bool DerivedCache::load(EadFile* file, const QString& sCacheFilename)
+{
+	CHECK_PARAM_RETVAL(file != NULL, false);
+	if (sCacheFilename.isEmpty())
+		return false;
+
+	QFile in(sCacheFilename);
+	if (!in.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream str(&in);
+	quint32 nMagic = 0;
+	qint32 nVersion = 0;
+	QByteArray cacheKey;
+	str >> nMagic >> nVersion;
+	if (nMagic != CACHE_MAGIC || nVersion != CACHE_VERSION)
+		return false;
+	str >> cacheKey;
+	if (cacheKey != key(file))
+		return false;
+
+	const QList<RecInfo*>& recs = file->recs();
+	qint32 nRecs = -1;
+	str >> nRecs;
+	if (nRecs != recs.size())
+		return false;
+
+	// Read everything before changing anything
+	QList<CachedWave> cached;
+	foreach (RecInfo* rec, recs)
+	{
+		qint32 nWaves = -1;
+		str >> nWaves;
+		if (nWaves != rec->waves().size())
+			return false;
+
+		foreach (WaveInfo* wave, rec->waves())
+		{
+			CachedWave cw;
+			if (!readVector(str, cw.display) || !readVector(str, cw.std))
+				return false;
+			// Display data always matches the raw data, except for the averages which have none
+			if (rec->id() != 0 && cw.display.size() != wave->raw.size())
+				return false;
+
+			qint32 nPeaks = -1;
+			str >> nPeaks;
+			if (nPeaks < 0 || nPeaks > cw.display.size())
+				return false;
+			for (int i = 0; i < nPeaks; i++)
+			{
+				WavePeakInfo peak;
+				str >> peak.bEnabled;
+				readPoint(str, peak.left);
+				readPoint(str, peak.middle);
+				readPoint(str, peak.right);
+				cw.peaks0 << peak;
+			}
+
+			qint32 nChosen = -1;
+			str >> nChosen;
+			if (nChosen != wave->peaksChosen.size())
+				return false;
+			for (int i = 0; i < nChosen; i++)
+			{
+				double nArea, nPercent;
+				str >> nArea >> nPercent;
+				cw.areas << nArea;
+				cw.percents << nPercent;
+			}
+
+			if (str.status() != QDataStream::Ok)
+				return false;
+			cached << cw;
+		}
+	}
+
+	int iWave = 0;
+	foreach (RecInfo* rec, recs)
+	{
+		foreach (WaveInfo* wave, rec->waves())
+		{
+			const CachedWave& cw = cached[iWave++];
+			wave->display = cw.display;
+			wave->std = cw.std;
+			wave->peaks0 = cw.peaks0;
+			for (int i = 0; i < wave->peaksChosen.size(); i++)
+			{
+				wave->peaksChosen[i].nArea = cw.areas[i];
+				wave->peaksChosen[i].nPercent = cw.percents[i];
+			}
+		}
+	}
+
+	return true;
+}
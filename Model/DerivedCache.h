@@ -0,0 +1,54 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __DERIVEDCACHE_H
+#define __DERIVEDCACHE_H
+
+#include <QByteArray>
+#include <QString>
+
+
+class QDataStream;
+
+class EadFile;
+
+
+/// File in the user's cache directory which holds the data that EadFile::load() would otherwise
+/// derive from the raw data: the display data, the averaged waves with their standard deviation,
+/// the possible FID peaks and the areas of the chosen peaks.
+/// The cache is keyed by a hash of everything this data depends on (raw data, voltage factors,
+/// shifts, visibility, chosen peaks and filter parameters), so a stale cache is simply ignored.
+class DerivedCache
+{
+public:
+	/// Name of the cache file for the given .ead file in its current state, keyed by its path and modification time.
+	/// Empty if there is no writable cache directory.
+	static QString cacheFilename(const QString& sFilename);
+
+	/// Restore the derived data of file from the cache.
+	/// Nothing is changed unless the whole cache is valid and matches the file.
+	static bool load(EadFile* file, const QString& sCacheFilename);
+	/// Write the derived data of file to the cache.
+	/// Failure, e.g. in a read-only directory, is harmless: the data is simply recalculated next time.
+	static bool save(EadFile* file, const QString& sCacheFilename);
+
+private:
+	/// Hash of all inputs to the derived data
+	static QByteArray key(EadFile* file);
+};
+
+#endif
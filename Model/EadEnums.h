@@ -156,6 +156,20 @@ enum LoadSaveResult
 	LoadSaveResult_VersionTooHigh,
 	LoadSaveResult_ImportedOldEad,
 	LoadSaveResult_DataCorrupt,
+	/// The file refers to samples which are missing from its sample store
+	LoadSaveResult_SamplesMissing,
+};
+
+/// How to write a file which already exists
+enum SaveMode
+{
+	/// Append new data to the file, leaving unchanged data where it is.
+	/// Only files which are already in the appendable format are appended to.
+	SaveMode_Incremental,
+	/// Rewrite the whole file, which also frees the space of data that's no longer used
+	SaveMode_Rewrite,
+	/// Rewrite the whole file in the appendable format, which older versions of GcEad can't read
+	SaveMode_Convert,
 };
 
 /// Type of wave (EAD, FID, or digital)
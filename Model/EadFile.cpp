@@ -17,17 +17,34 @@
 
 #include "EadFile.h"
 
+#include <limits.h>
 #include <math.h>
+#include <string.h>
 
 #include <QtDebug>
 #include <QDataStream>
+#include <QDir>
 #include <QDomDocument>
 #include <QFile>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QLockFile>
+#include <QSaveFile>
+#include <QScopedPointer>
 #include <QStringList>
 #include <QTextStream>
+#include <QTimer>
+#include <QtConcurrentMap>
+#include <QtConcurrentRun>
+#include <QtEndian>
 
 #include "Check.h"
 
+#include "DerivedCache.h"
+#include "MonitorHistory.h"
+#include "SampleStore.h"
+#include "WaveExporter.h"
+
 
 /// Channel 1 of fake EAD data
 extern short g_anChannel1[3999];
@@ -47,17 +64,45 @@ EadFile::EadFile()
 
 	createAveWaves();
 	createViewInfo();
+	m_editHistory = new EditHistory(this);
 
 	m_bDirty = false;
+
+	m_bLoading = false;
+	m_iLoadingRec = 0;
+	m_loadWatcher = new QFutureWatcher<DisplayJob>(this);
+	connect(m_loadWatcher, SIGNAL(resultReadyAt(int)), this, SLOT(on_loadWatcher_resultReadyAt(int)));
+	connect(m_loadWatcher, SIGNAL(finished()), this, SLOT(on_loadWatcher_finished()));
+	m_decodeWatcher = new QFutureWatcher<void>(this);
+	connect(m_decodeWatcher, SIGNAL(finished()), this, SLOT(on_decodeWatcher_finished()));
+	m_decodingFile = NULL;
+
+	m_nRevision = 0;
+	m_bSaving = false;
+	m_bSaveOk = true;
+	m_nSavingRevision = 0;
+	m_saveWatcher = new QFutureWatcher<SaveResult>(this);
+
+	m_nStoredSize = -1;
+	m_nStoredVersion = 0;
+	m_nStoredUnused = 0;
+	connect(m_saveWatcher, SIGNAL(finished()), this, SLOT(on_saveWatcher_finished()));
 }
 
 EadFile::~EadFile()
 {
+	// Don't lose the data which is still being written
+	waitForSave();
+	cancelLoading();
 	qDeleteAll(m_views);
 	m_views.clear();
 	qDeleteAll(m_recs);
 	m_recs.clear();
 	delete m_newRec;
+	delete m_editHistory;
+
+	// Release the samples which were only shared with this file
+	SampleStore::purgeInterned();
 }
 
 ViewInfo* EadFile::viewInfo(EadView view)
@@ -71,13 +116,28 @@ void EadFile::setComment(const QString& s)
 	if (s != m_sComment)
 	{
 		m_sComment = s;
-		m_bDirty = true;
-		emit dirtyChanged();
+		setDirty(NULL, NULL);
+	}
+}
+
+void EadFile::setSampleStore(const QString& sPath)
+{
+	QString s;
+	if (!sPath.isEmpty())
+		s = SampleStore(sPath).path();
+
+	if (s != m_sSampleStore)
+	{
+		m_sSampleStore = s;
+		setDirty(NULL, NULL);
 	}
 }
 
 void EadFile::clear()
 {
+	waitForSave();
+	cancelLoading();
+
 	// Clear all but EadView_Averages
 	for (int i = EadView_EADs; i <= EadView_Recording; i++)
 		m_views[i]->clearWaves();
@@ -91,19 +151,119 @@ void EadFile::clear()
 	m_sFilename.clear();
 	m_sComment.clear();
 	m_bDirty = false;
+	m_storedBlocks.clear();
+	m_nStoredSize = -1;
+	m_nStoredVersion = 0;
+	m_nStoredUnused = 0;
+	m_sSampleStore.clear();
 	if (m_newRec)
 	{
 		delete m_newRec;
 		m_newRec = NULL;
 	}
+
+	m_editHistory->clear();
+	emit historyChanged();
 }
 
 //
 // SAVE functions
 //
 
-bool EadFile::saveAs(const QString& sFilename)
+/// Ends the index of a version 3 file, preceded by the index's offset
+static const char INDEX_MAGIC[8] = { 'E', 'A', 'D', 'I', 'N', 'D', 'E', 'X' };
+/// Size of the format id and version number at the start of the file
+static const qint64 HEADER_SIZE = 8;
+/// Size of the index offset and INDEX_MAGIC at the end of the index
+static const qint64 FOOTER_SIZE = 16;
+/// Version of the file format which is written
+static const qint32 FILE_VERSION = 4;
+/// Version of the format without an index, which older versions of GcEad can read
+static const qint32 SEQUENTIAL_FILE_VERSION = 2;
+
+struct EadFile::SaveSnapshot
+{
+	QString sFilename;
+	/// Write the format with an index at the end, which can be appended to
+	bool bIndexed;
+	/// Append to the existing file instead of rewriting it
+	bool bAppend;
+	/// The DOM is converted to text by writeSnapshot(), so that this also happens off the GUI thread
+	QDomDocument doc;
+	/// The non-averaged waves in file order; these may only be dereferenced on the GUI thread
+	QList<WaveInfo*> waves;
+	/// Raw data of the waves
+	QList< QVector<short> > raws;
+	/// Offset of each wave's sample block in the file, or -1 if it still needs to be written
+	QList<qint64> offsets;
+	/// Directory of the sample store to put the blocks into, or empty to put them in the file
+	QString sSampleStore;
+	/// Hash of each wave's samples if it's already known, otherwise empty
+	QList<QByteArray> hashes;
+};
+
+struct EadFile::SaveResult
+{
+	bool bOk;
+	/// The snapshot which was saved, with the offsets of the newly written blocks filled in
+	SaveSnapshot snapshot;
+	/// Size of the file after saving
+	qint64 nSize;
+	/// Bytes which the new index no longer refers to
+	qint64 nUnused;
+};
+
+bool EadFile::saveAs(const QString& sFilename, SaveMode mode)
+{
+	waitForSave();
+	finishLoading();
+
+	SaveResult result = writeSnapshot(createSnapshot(sFilename, mode), NULL);
+	if (!result.bOk)
+		return false;
+
+	applySaveResult(result);
+	m_bDirty = false;
+	return true;
+}
+
+bool EadFile::saveAsync(const QString& sFilename, SaveMode mode)
+{
+	CHECK_PRECOND_RETVAL(!m_bSaving, false);
+
+	finishLoading();
+
+	m_bSaving = true;
+	m_nSavingRevision = m_nRevision;
+	m_saveWatcher->setFuture(QtConcurrent::run(writeSnapshot, createSnapshot(sFilename, mode), this));
+	return true;
+}
+
+bool EadFile::waitForSave()
+{
+	if (m_bSaving)
+	{
+		m_saveWatcher->waitForFinished();
+		completeSave();
+	}
+	return m_bSaveOk;
+}
+
+EadFile::SaveSnapshot EadFile::createSnapshot(const QString& sFilename, SaveMode mode)
 {
+	SaveSnapshot snapshot;
+	snapshot.sFilename = sFilename;
+
+	// Files stay readable by older versions of GcEad unless they're converted explicitly.
+	// Only the index can refer to a sample store, though.
+	snapshot.bIndexed = (mode == SaveMode_Convert || !m_sSampleStore.isEmpty() ||
+		(sFilename == m_sFilename && m_nStoredVersion >= 3));
+
+	// Only append to the file which was last loaded or saved, and only if nobody else has changed it since
+	QFileInfo fi(sFilename);
+	snapshot.bAppend = (snapshot.bIndexed && mode == SaveMode_Incremental && m_nStoredSize >= 0 && sFilename == m_sFilename &&
+		fi.size() == m_nStoredSize && fi.lastModified() == m_storedLastModified);
+
 	QDomDocument doc("ead");
 	QDomElement root = doc.createElement("ead");
 	root.setAttribute("comment", m_sComment);
@@ -113,38 +273,291 @@ bool EadFile::saveAs(const QString& sFilename)
 	root.appendChild(tag);
 
 	foreach (RecInfo* rec, m_recs)
-		createRecNode(doc, tag, rec);
+		createRecNode(doc, tag, rec, fi.absoluteDir());
 	foreach (ViewInfo* view, m_views)
 		createViewNode(doc, tag, view);
+	snapshot.doc = doc;
 
-	QString xml = doc.toString();
+	snapshot.sSampleStore = m_sSampleStore;
 
-	QFile file(sFilename);
-	if (!file.open(QIODevice::WriteOnly))
-		return false;
+	// Implicit sharing makes this cheap; a wave which is changed later gets its own copy
+	for (int i = 1; i < m_recs.size(); i++)
+	{
+		foreach (WaveInfo* wave, m_recs[i]->waves())
+		{
+			// A stored block can be reused as long as the wave still shares its data
+			qint64 nOffset = -1;
+			QByteArray hash;
+			if (!wave->raw.isEmpty() && m_storedBlocks.contains(wave))
+			{
+				const StoredBlock& block = m_storedBlocks[wave];
+				if (block.raw.constData() == wave->raw.constData() && block.raw.size() == wave->raw.size())
+				{
+					hash = block.hash;
+					if (snapshot.bAppend && snapshot.sSampleStore.isEmpty())
+						nOffset = block.nOffset;
+				}
+			}
+
+			snapshot.waves << wave;
+			snapshot.raws << wave->raw;
+			snapshot.offsets << nOffset;
+			snapshot.hashes << hash;
+		}
+	}
+
+	return snapshot;
+}
+
+EadFile::SaveResult EadFile::writeSnapshot(const SaveSnapshot& snapshot, EadFile* progress)
+{
+	SaveResult result;
+	result.bOk = false;
+	result.snapshot = snapshot;
+	result.nSize = 0;
+	result.nUnused = 0;
+
+	// Keep collectGarbage() from deleting the store's new blocks until the index which refers to them is written
+	QScopedPointer<QLockFile> lock;
+	if (!snapshot.sSampleStore.isEmpty())
+	{
+		SampleStore store(snapshot.sSampleStore);
+		if (!store.addReferrer(snapshot.sFilename))
+			return result;
+		lock.reset(new QLockFile(store.lockFilename()));
+		if (!lock->lock())
+			return result;
+	}
+
+	if (snapshot.bAppend)
+	{
+		QFile file(snapshot.sFilename);
+		if (!file.open(QIODevice::ReadWrite))
+			return result;
+
+		// The previous index stays intact until the new one has been completely written
+		const qint64 nOriginalSize = file.size();
+		if (!file.seek(nOriginalSize) || !writeBlocksAndIndex(file, result, progress) || !file.flush())
+		{
+			file.resize(nOriginalSize);
+			return result;
+		}
+	}
+	else
+	{
+		QSaveFile file(snapshot.sFilename);
+		if (!file.open(QIODevice::WriteOnly))
+			return result;
+
+		QDataStream str(&file);
+		qint32 nVersion = (snapshot.bIndexed) ? FILE_VERSION : SEQUENTIAL_FILE_VERSION;
+		str.writeRawData("EAD", 4);
+		str << nVersion;
+		bool bOk = (str.status() == QDataStream::Ok);
+		if (bOk && snapshot.bIndexed)
+			bOk = writeBlocksAndIndex(file, result, progress);
+		else if (bOk)
+			bOk = writeSequential(file, result, progress);
+		if (!bOk)
+		{
+			file.cancelWriting();
+			return result;
+		}
+		// Replaces the original file only if everything could be written
+		if (!file.commit())
+			return result;
+	}
+
+	result.bOk = true;
+	return result;
+}
+
+/// Let progress know how much of the sample data has been written, if the percentage has changed
+static void reportSaveProgress(EadFile* progress, qint64 nWritten, qint64 nTotal, int& nPercentReported)
+{
+	int nPercent = (int) (nWritten * 100 / nTotal);
+	if (progress != NULL && nPercent != nPercentReported)
+	{
+		nPercentReported = nPercent;
+		QMetaObject::invokeMethod(progress, "on_save_progress", Qt::QueuedConnection, Q_ARG(int, nPercent));
+	}
+}
+
+bool EadFile::writeSequential(QIODevice& device, SaveResult& result, EadFile* progress)
+{
+	SaveSnapshot& snapshot = result.snapshot;
 
-	QDataStream str(&file);
-	qint32 nVersion = 2;
-	str.writeRawData("EAD", 4);
-	str << nVersion;
+	QDataStream str(&device);
 	str.setVersion(QDataStream::Qt_4_3);
-	str << xml;
-	saveData(str);
+	str << snapshot.doc.toString();
 
-	//qDebug() << "XML:" << endl << xml;
+	qint64 nTotal = 0;
+	foreach (const QVector<short>& raw, snapshot.raws)
+		nTotal += raw.size();
 
-	m_sFilename = sFilename;
-	m_bDirty = false;
-	return true;
+	qint64 nWritten = 0;
+	int nPercentReported = -1;
+	for (int i = 0; i < snapshot.raws.size(); i++)
+	{
+		// The blocks are identified by their order, so empty waves are written too
+		const QVector<short>& raw = snapshot.raws[i];
+		snapshot.offsets[i] = (raw.isEmpty()) ? -1 : device.pos();
+		snapshot.hashes[i].clear();
+		str << raw;
+
+		if (!raw.isEmpty())
+		{
+			nWritten += raw.size();
+			reportSaveProgress(progress, nWritten, nTotal, nPercentReported);
+		}
+	}
+
+	result.nSize = device.pos();
+	result.nUnused = 0;
+	return (str.status() == QDataStream::Ok);
 }
 
-LoadSaveResult EadFile::load(const QString& sFilename)
+bool EadFile::writeBlocksAndIndex(QIODevice& device, SaveResult& result, EadFile* progress)
 {
-	QFile file(sFilename);
-	if (!file.open(QIODevice::ReadOnly))
+	SaveSnapshot& snapshot = result.snapshot;
+
+	QDataStream str(&device);
+	str.setVersion(QDataStream::Qt_4_3);
+
+	const bool bStore = !snapshot.sSampleStore.isEmpty();
+	SampleStore store(snapshot.sSampleStore);
+
+	// Progress only depends on the data which actually needs to be hashed or written
+	qint64 nTotal = 0;
+	for (int i = 0; i < snapshot.raws.size(); i++)
+	{
+		if ((bStore) ? snapshot.hashes[i].isEmpty() : snapshot.offsets[i] < 0)
+			nTotal += snapshot.raws[i].size();
+	}
+
+	qint64 nWritten = 0;
+	int nPercentReported = -1;
+	qint64 nUsed = HEADER_SIZE;
+	for (int i = 0; i < snapshot.raws.size(); i++)
+	{
+		const QVector<short>& raw = snapshot.raws[i];
+		if (raw.isEmpty())
+			continue;
+
+		bool bWritten = false;
+		if (bStore)
+		{
+			// Blocks which are already in the store, e.g. from another file, aren't written again
+			bWritten = snapshot.hashes[i].isEmpty();
+			if (bWritten)
+				snapshot.hashes[i] = SampleStore::hash(raw);
+			if (!store.put(raw, snapshot.hashes[i]))
+				return false;
+			snapshot.offsets[i] = -1;
+		}
+		else if (snapshot.offsets[i] < 0)
+		{
+			snapshot.offsets[i] = device.pos();
+			str << raw;
+			bWritten = true;
+		}
+
+		if (bWritten)
+		{
+			nWritten += raw.size();
+			reportSaveProgress(progress, nWritten, nTotal, nPercentReported);
+		}
+		if (!bStore)
+			nUsed += 4 + 2 * (qint64) raw.size();
+	}
+
+	// The index holds the XML, the location of the sample store, and the offsets or hashes of the waves' sample blocks
+	const qint64 nIndexOffset = device.pos();
+	str << snapshot.doc.toString();
+	QString sSampleStore;
+	if (bStore)
+		sSampleStore = QFileInfo(snapshot.sFilename).absoluteDir().relativeFilePath(snapshot.sSampleStore);
+	str << sSampleStore;
+	str << (qint32) snapshot.offsets.size();
+	for (int i = 0; i < snapshot.offsets.size(); i++)
+	{
+		// Hashes are only kept for blocks in the store
+		str << snapshot.offsets[i];
+		str << ((bStore) ? snapshot.hashes[i] : QByteArray());
+	}
+	str << nIndexOffset;
+	str.writeRawData(INDEX_MAGIC, sizeof(INDEX_MAGIC));
+
+	result.nSize = device.pos();
+	result.nUnused = nIndexOffset - nUsed;
+	return (str.status() == QDataStream::Ok);
+}
+
+void EadFile::applySaveResult(const SaveResult& result)
+{
+	const SaveSnapshot& snapshot = result.snapshot;
+
+	m_sFilename = snapshot.sFilename;
+
+	// Remember where the samples are, so that the next save only needs to append what has changed
+	m_storedBlocks.clear();
+	for (int i = 0; i < snapshot.waves.size(); i++)
+	{
+		if (snapshot.offsets[i] >= 0 || !snapshot.hashes[i].isEmpty())
+		{
+			StoredBlock block;
+			block.nOffset = snapshot.offsets[i];
+			block.hash = snapshot.hashes[i];
+			block.raw = snapshot.raws[i];
+			m_storedBlocks[snapshot.waves[i]] = block;
+		}
+	}
+	// Files without an index can't be appended to
+	m_nStoredSize = (snapshot.bIndexed) ? result.nSize : -1;
+	m_nStoredVersion = (snapshot.bIndexed) ? FILE_VERSION : SEQUENTIAL_FILE_VERSION;
+	m_storedLastModified = QFileInfo(m_sFilename).lastModified();
+	m_nStoredUnused = result.nUnused;
+}
+
+void EadFile::on_saveWatcher_finished()
+{
+	completeSave();
+}
+
+void EadFile::on_save_progress(int nPercent)
+{
+	if (m_bSaving)
+		emit saveProgress(nPercent);
+}
+
+void EadFile::completeSave()
+{
+	// May already have been completed by waitForSave()
+	if (!m_bSaving)
+		return;
+
+	m_bSaving = false;
+	const SaveResult result = m_saveWatcher->result();
+	m_bSaveOk = result.bOk;
+	if (m_bSaveOk)
+	{
+		applySaveResult(result);
+		// Changes made while the file was being written still need to be saved
+		if (m_nRevision == m_nSavingRevision)
+			m_bDirty = false;
+		emit dirtyChanged();
+	}
+
+	emit saveFinished(m_bSaveOk);
+}
+
+LoadSaveResult EadFile::load(const QString& sFilename, bool bProgressive)
+{
+	QScopedPointer<QFile> file(new QFile(sFilename));
+	if (!file->open(QIODevice::ReadOnly))
 		return LoadSaveResult_CouldNotOpen;
 
-	QDataStream str(&file);
+	QDataStream str(file.data());
 
 	blockSignals(true);
 
@@ -154,106 +567,430 @@ LoadSaveResult EadFile::load(const QString& sFilename)
 	char sFormatId[4];
 	str.readRawData(sFormatId, 4);
 
+	// Both formats are decoded directly from memory
+	QByteArray buffer;
+	qint64 nSize = file->size();
+	const char* data = (const char*) file->map(0, nSize);
+	if (data == NULL)
+	{
+		const qint64 nPos = file->pos();
+		file->seek(0);
+		buffer = file->readAll();
+		file->seek(nPos);
+		data = buffer.constData();
+		nSize = buffer.size();
+	}
+
+	// Reuse the derived data from the cache if it still matches the file's contents.
+	// Only interactive opens use the cache, so batch runs and imports leave nothing behind.
+	const QString sCacheFilename = (bProgressive) ? DerivedCache::cacheFilename(sFilename) : QString();
+	// Checking the cache needs all the samples, so only leave waves for the background if there's no cache
+	const bool bDefer = (bProgressive && !QFile::exists(sCacheFilename));
+
 	LoadSaveResult result;
 	// If this is the old EAD format:
 	if (QString(sFormatId).startsWith("BcV"))
-		result = loadOld(str);
+		result = loadOld(data, nSize);
 	// If this is the current EAD format:
 	else if (QString("EAD") == sFormatId)
-		result = loadCurrent(str);
+		result = loadCurrent(str, data, nSize, sFilename, bDefer);
 	else
 		result = LoadSaveResult_WrongFormat;
+	if (result != LoadSaveResult_Ok)
+		m_deferredBlocks.clear();
 
-	updateDisplay();
-	updateViewInfo();
-	updateAveWaves();
+	if (result == LoadSaveResult_Ok && !bDefer && DerivedCache::load(this, sCacheFilename))
+	{
+		updateViewInfo();
+	}
+	// Only convert the raw data of the first screen for display now, and leave the rest for the background
+	else if (result == LoadSaveResult_Ok && bProgressive)
+	{
+		for (int i = 1; i < m_recs.count(); i++)
+		{
+			foreach (WaveInfo* wave, m_recs[i]->waves())
+			{
+				if (!wave->raw.isEmpty())
+					wave->calcDisplayData(QList<FilterTesterInfo*>());
+			}
+		}
+		updateViewInfo();
+		// Averaging is cheap, and the averages are the first thing the user sees
+		updateAveWave(WaveType_EAD);
+		updateAveWave(WaveType_FID);
 
-	// Perform FID peak detection && calculation of verified peak areas
-	for (int i = 0; i < m_recs.count(); i++)
+		// The deferred waves are decoded from the file's data, which has to stay around until then
+		if (!m_deferredBlocks.isEmpty())
+		{
+			m_decodingFile = file.take();
+			m_decodingBuffer = buffer;
+		}
+		startLoading(sCacheFilename);
+	}
+	else
 	{
-		RecInfo* rec = m_recs[i];
-		rec->fid()->findFidPeaks();
-		rec->fid()->calcPeakAreas();
+		updateDisplay();
+		updateViewInfo();
+		updateAveWaves();
+
+		// Perform FID peak detection && calculation of verified peak areas
+		QtConcurrent::blockingMap(m_recs, calcRecPeaks);
 	}
 
 	if (result == LoadSaveResult_Ok)
+	{
 		m_sFilename = sFilename;
+		m_storedLastModified = QFileInfo(sFilename).lastModified();
+	}
 
 	m_bDirty = false;
+	// Loading isn't an edit which can be undone
+	m_editHistory->clear();
 
 	blockSignals(false);
 
 	emit waveListChanged();
+	emit historyChanged();
 
 	return result;
 }
 
-static int getInt(char* data_) {
-	uchar* data = (uchar*) data_;
-	int n = 0;
-	n |= data[0];
-	n |= data[1] << 8;
-	n |= data[2] << 16;
-	n |= data[3] << 24;
-	return n;
+void EadFile::readStoreBlock(StoreBlock& block)
+{
+	block.bOk = block.store->get(block.hash, block.wave->raw);
 }
 
-LoadSaveResult EadFile::loadOld(QDataStream& str)
+/// Decode nSamples big-endian samples
+static void decodeSamples(const char* data, int nSamples, QVector<short>& raw)
 {
-	char data[4];
+	raw.resize(nSamples);
+	const uchar* src = (const uchar*) data;
+	short* dest = raw.data();
+	for (int i = 0; i < nSamples; i++)
+		dest[i] = qFromBigEndian<qint16>(src + i * 2);
+}
 
-	bool bFoundStart = false;
-	bool bDone = false;
-	const QString sSeek = "BcDataSet";
-	QString s;
-	while (!bFoundStart && !bDone) {
-		char c;
-		int n = str.readRawData(&c, 1);
-		if (n <= 0)
-			return LoadSaveResult_DataCorrupt;
-		s = s.right(sSeek.length() - 1) + c;
-		// If we've found the string we're scanning for:
-		if (s == sSeek) {
-			for (int i = 0; i < 7; i++) {
-				str.readRawData(&c, 1);
+void EadFile::decodeRawBlock(RawBlock& block)
+{
+	decodeSamples(block.data, block.nSamples, block.wave->raw);
+}
+
+void EadFile::decodeDeferredBlock(RawBlock& block)
+{
+	// The wave may be looked at on the GUI thread meanwhile, so it only gets the samples in finishDecoding()
+	decodeSamples(block.data, block.nSamples, block.raw);
+}
+
+bool EadFile::isOnFirstScreen(const WaveInfo* wave) const
+{
+	// The first view is EadView_Averages, whose averages are made of the visible EAD and FID waves
+	if (wave->type != WaveType_Digital && wave->pos.bVisible)
+		return true;
+	foreach (ViewInfo* view, m_views)
+	{
+		if (view->vwiUser.waveInfo() == wave)
+			return true;
+	}
+	return false;
+}
+
+void EadFile::decodeRawBlocks(const QList<RawBlock>& blocks, bool bDefer)
+{
+	QList<RawBlock> blocksNow;
+	foreach (const RawBlock& block, blocks)
+	{
+		if (bDefer && !isOnFirstScreen(block.wave))
+			m_deferredBlocks << block;
+		else
+			blocksNow << block;
+	}
+	QtConcurrent::blockingMap(blocksNow, decodeRawBlock);
+}
+
+void EadFile::calcWaveDisplay(WaveInfo*& wave)
+{
+	wave->calcDisplayData(wave->rec()->file()->filters());
+}
+
+void EadFile::calcRecPeaks(RecInfo*& rec)
+{
+	rec->fid()->findFidPeaks();
+	rec->fid()->calcPeakAreas();
+}
+
+EadFile::DisplayJob EadFile::filterDisplay(const DisplayJob& job)
+{
+	DisplayJob result = job;
+	FilterTesterInfo::filter(result.filterId, result.display);
+	return result;
+}
+
+void EadFile::startLoading(const QString& sCacheFilename)
+{
+	m_bLoading = true;
+	m_iLoadingRec = 0;
+	m_sLoadingCacheFilename = sCacheFilename;
+
+	if (m_deferredBlocks.isEmpty())
+		startFiltering();
+	else
+		m_decodeWatcher->setFuture(QtConcurrent::map(m_deferredBlocks, decodeDeferredBlock));
+}
+
+void EadFile::on_decodeWatcher_finished()
+{
+	finishDecoding();
+}
+
+void EadFile::finishDecoding()
+{
+	// Also ignores a watcher which finishes after the decoding has already been waited for
+	if (!m_bLoading || m_deferredBlocks.isEmpty())
+		return;
+
+	m_decodeWatcher->waitForFinished();
+	foreach (const RawBlock& block, m_deferredBlocks)
+	{
+		WaveInfo* wave = block.wave;
+		wave->raw = block.raw;
+		wave->calcDisplayData(QList<FilterTesterInfo*>());
+		// Loading the samples isn't an edit
+		m_editHistory->adoptSamples(wave);
+		if (m_storedBlocks.contains(wave))
+			m_storedBlocks[wave].raw = wave->raw;
+	}
+	m_deferredBlocks.clear();
+	delete m_decodingFile;
+	m_decodingFile = NULL;
+	m_decodingBuffer.clear();
+
+	// This may be called while a wave in one of the views is being edited,
+	// so the views only get the new waves once control returns to the event loop
+	QTimer::singleShot(0, this, SLOT(updateDecodedViews()));
+
+	startFiltering();
+}
+
+void EadFile::updateDecodedViews()
+{
+	updateViewInfo();
+	emit waveListChanged();
+}
+
+void EadFile::startFiltering()
+{
+	// Filter the waves on worker threads, starting from their unfiltered display data
+	QList<DisplayJob> jobs;
+	for (int i = 1; i < m_recs.count(); i++)
+	{
+		foreach (WaveInfo* wave, m_recs[i]->waves())
+		{
+			foreach (FilterTesterInfo* filter, m_filters)
+			{
+				if (filter->waveType() == wave->type && filter->filterId() != 0 && !wave->display.isEmpty())
+				{
+					DisplayJob job;
+					job.wave = wave;
+					job.filterId = filter->filterId();
+					job.display = wave->display;
+					jobs << job;
+				}
 			}
-			bDone = true;
 		}
 	}
 
-	//createAveWaves();
+	m_loadApplied.fill(false, jobs.size());
 
-	RecInfo* rec = new RecInfo(this, 1);
-	WaveInfo* wave = rec->ead();
+	if (jobs.isEmpty())
+		QTimer::singleShot(0, this, SLOT(continueLoading()));
+	else
+		m_loadWatcher->setFuture(QtConcurrent::mapped(jobs, filterDisplay));
+}
 
-	str.readRawData(data, 4);
-	int nSamples = getInt(data);
-	wave->nRawToVoltageFactorDen *= 2048;
-	wave->nRawToVoltageFactor = double(wave->nRawToVoltageFactorNum) / wave->nRawToVoltageFactorDen;
-	wave->raw.resize(nSamples * 10);
-	for (int i = 0; i < nSamples; i++) {
-		str.readRawData(data, 4);
-		int n = -getInt(data);
-		for (int j = 0; j < 10; j++)
-			wave->raw[i * 10 + j] = (short) n;
+void EadFile::cancelLoading()
+{
+	if (!m_bLoading)
+		return;
+
+	m_bLoading = false;
+	// The decoding writes into m_deferredBlocks, so it has to stop before they go
+	m_decodeWatcher->cancel();
+	m_decodeWatcher->waitForFinished();
+	m_deferredBlocks.clear();
+	delete m_decodingFile;
+	m_decodingFile = NULL;
+	m_decodingBuffer.clear();
+	// The jobs only work on copies of the data, so they don't need to be waited for
+	m_loadWatcher->cancel();
+	m_loadApplied.clear();
+}
+
+void EadFile::finishLoading()
+{
+	if (!m_bLoading)
+		return;
+
+	finishDecoding();
+	m_loadWatcher->waitForFinished();
+	for (int i = 0; i < m_loadApplied.size(); i++)
+		applyLoadResult(i);
+
+	// Detect the peaks of the remaining recordings in parallel
+	QList<RecInfo*> recs = m_recs.mid(m_iLoadingRec);
+	QtConcurrent::blockingMap(recs, calcRecPeaks);
+	m_iLoadingRec = m_recs.count();
+
+	while (loadingStep())
+		;
+}
+
+void EadFile::applyLoadResult(int i)
+{
+	CHECK_PARAM_RET(i >= 0 && i < m_loadApplied.size());
+	if (m_loadApplied[i])
+		return;
+
+	const DisplayJob job = m_loadWatcher->resultAt(i);
+	CHECK_ASSERT_RET(job.display.size() == job.wave->display.size());
+	job.wave->display = job.display;
+	m_loadApplied[i] = true;
+
+	emit displayChanged();
+}
+
+bool EadFile::loadingStep()
+{
+	CHECK_PRECOND_RETVAL(m_bLoading, false);
+
+	// Detect the peaks of one recording per step, so that the GUI stays responsive
+	if (m_iLoadingRec < m_recs.count())
+	{
+		RecInfo* rec = m_recs[m_iLoadingRec++];
+		if (rec->id() != 0)
+		{
+			rec->fid()->findFidPeaks();
+			emit displayChanged();
+		}
+		return true;
 	}
 
-	// Skip 11 bytes
-	wave = rec->fid();
-	for (int i = 0; i < 11; i++) {
-		char c;
-		str.readRawData(&c, 1);
+	// Now that all waves have their final display data, recalculate the averages and the peak areas
+	updateAveWave(WaveType_EAD);
+	updateAveWave(WaveType_FID);
+	foreach (RecInfo* rec, m_recs)
+	{
+		if (rec->id() == 0)
+			rec->fid()->findFidPeaks();
+		rec->fid()->calcPeakAreas();
 	}
-	str.readRawData(data, 4);
-	nSamples = getInt(data);
+
+	m_bLoading = false;
+	m_loadApplied.clear();
+
+	// Only cache the results if the file hasn't been changed in the meantime
+	if (!m_bDirty)
+		DerivedCache::save(this, m_sLoadingCacheFilename);
+
+	emit displayChanged();
+	emit waveListChanged();
+	return false;
+}
+
+void EadFile::on_loadWatcher_resultReadyAt(int i)
+{
+	// Ignore results which arrive after the load was cancelled or finished synchronously
+	if (m_bLoading && i < m_loadApplied.size())
+		applyLoadResult(i);
+}
+
+void EadFile::on_loadWatcher_finished()
+{
+	continueLoading();
+}
+
+void EadFile::continueLoading()
+{
+	if (!m_bLoading || m_loadWatcher->isRunning())
+		return;
+
+	if (loadingStep())
+		QTimer::singleShot(0, this, SLOT(continueLoading()));
+}
+
+/// Find the first occurrence of marker in [p, end), or return NULL
+static const char* findMarker(const char* p, const char* end, const QByteArray& marker)
+{
+	const int nLen = marker.size();
+	while (end - p >= nLen)
+	{
+		// memchr() is vectorized by the C library, so this skips through the data in large steps
+		p = (const char*) memchr(p, marker[0], end - p - nLen + 1);
+		if (p == NULL)
+			return NULL;
+		if (memcmp(p, marker.constData(), nLen) == 0)
+			return p;
+		p++;
+	}
+	return NULL;
+}
+
+/// Read one wave of the old format at p: a sample count followed by little-endian 32-bit samples.
+/// Each sample is stored negated and repeated 10 times, because the old format has 10 samples per second.
+/// @returns false if the data runs past end
+static bool loadOldWave(const char*& p, const char* end, WaveInfo* wave)
+{
+	if (end - p < 4)
+		return false;
+	const qint32 nSamples = qFromLittleEndian<qint32>((const uchar*) p);
+	p += 4;
+	if (nSamples < 0 || nSamples > (end - p) / 4 || nSamples > INT_MAX / 10)
+		return false;
+
 	wave->nRawToVoltageFactorDen *= 2048;
 	wave->nRawToVoltageFactor = double(wave->nRawToVoltageFactorNum) / wave->nRawToVoltageFactorDen;
 	wave->raw.resize(nSamples * 10);
-	for (int i = 0; i < nSamples; i++) {
-		str.readRawData(data, 4);
-		int n = -getInt(data);
+
+	const uchar* src = (const uchar*) p;
+	short* dest = wave->raw.data();
+	for (int i = 0; i < nSamples; i++)
+	{
+		// Unsigned negation keeps the same low 16 bits as the old int negation, without overflow
+		const short n = (short) (0u - qFromLittleEndian<quint32>(src + i * 4));
 		for (int j = 0; j < 10; j++)
-			wave->raw[i * 10 + j] = (short) n;
+			*dest++ = n;
+	}
+
+	p += nSamples * 4;
+	return true;
+}
+
+LoadSaveResult EadFile::loadOld(const char* data, qint64 nSize)
+{
+	const char* const end = data + nSize;
+
+	// Find the start of the data, after the 4-byte format id
+	const QByteArray marker("BcDataSet");
+	const char* p = findMarker(data + qMin(nSize, qint64(4)), end, marker);
+	if (p == NULL)
+		return LoadSaveResult_DataCorrupt;
+	p += marker.size() + 7;
+	if (p > end)
+		return LoadSaveResult_DataCorrupt;
+
+	//createAveWaves();
+
+	RecInfo* rec = new RecInfo(this, 1);
+	if (!loadOldWave(p, end, rec->ead()))
+	{
+		delete rec;
+		return LoadSaveResult_DataCorrupt;
+	}
+
+	// Skip 11 bytes.  If the FID data is missing, keep the EAD wave anyway.
+	if (end - p >= 11)
+	{
+		p += 11;
+		loadOldWave(p, end, rec->fid());
 	}
 
 	m_recs << rec;
@@ -261,21 +998,265 @@ LoadSaveResult EadFile::loadOld(QDataStream& str)
 	return LoadSaveResult_ImportedOldEad;
 }
 
-LoadSaveResult EadFile::loadCurrent(QDataStream& str)
+LoadSaveResult EadFile::loadCurrent(QDataStream& str, const char* data, qint64 nSize, const QString& sFilename, bool bDefer)
 {
 	// Check the file format version
 	qint32 nVersion;
 	str >> nVersion;
 	if (nVersion < 1)
 		return LoadSaveResult_VersionTooLow;
-	else if (nVersion > 2)
+	else if (nVersion > 4)
 		return LoadSaveResult_VersionTooHigh;
+	m_nStoredVersion = nVersion;
+
+	if (nVersion >= 3)
+		return loadIndexed(data, nSize, sFilename, bDefer);
 
 	str.setVersion(QDataStream::Qt_4_3);
 
 	// Read in the XML
 	QString xml;
 	str >> xml;
+	LoadSaveResult result = loadXml(xml, sFilename);
+	if (result != LoadSaveResult_Ok)
+		return result;
+
+	// Load data for non-averaged waves
+	QList<WaveInfo*> waves;
+	for (int i = 1; i < m_recs.count(); i++)
+		waves << m_recs[i]->waves();
+
+	// Each wave is stored as a QVector<short>: a 32-bit sample count followed by the big-endian samples.
+	// Locate all the blocks first, then decode them in parallel.
+	QList<RawBlock> blocks;
+	qint64 nPos = str.device()->pos();
+	foreach (WaveInfo* wave, waves)
+	{
+		// Like QDataStream, leave this and all following waves empty if the file is truncated
+		if (nSize - nPos < 4)
+			break;
+		const quint32 nSamples = qFromBigEndian<quint32>((const uchar*) data + nPos);
+		nPos += 4;
+		if (nSamples > (quint64) (nSize - nPos) / 2)
+			break;
+
+		RawBlock block;
+		block.wave = wave;
+		block.data = data + nPos;
+		block.nSamples = (int) nSamples;
+		blocks << block;
+		nPos += 2 * (qint64) nSamples;
+	}
+	decodeRawBlocks(blocks, bDefer);
+
+	return LoadSaveResult_Ok;
+}
+
+struct EadFile::FileIndex
+{
+	qint32 nVersion;
+	qint64 nIndexOffset;
+	qint64 nFooter;
+	QString xml;
+	/// Directory of the sample store relative to the file, or empty if all samples are in the file
+	QString sSampleStore;
+	/// Offset of each wave's sample block in the file, or -1
+	QList<qint64> offsets;
+	/// Hash of each wave's sample block in the sample store, or empty
+	QList<QByteArray> hashes;
+};
+
+bool EadFile::readIndex(const char* data, qint64 nSize, FileIndex& index)
+{
+	if (nSize < HEADER_SIZE)
+		return false;
+	const qint32 nVersion = qFromBigEndian<qint32>((const uchar*) data + 4);
+
+	// Find the last complete index.  If saving was interrupted while appending to the file,
+	// this skips the incomplete data at the end and uses the index of the previous save.
+	for (qint64 nFooter = nSize - FOOTER_SIZE; nFooter >= HEADER_SIZE; nFooter--)
+	{
+		if (memcmp(data + nFooter + 8, INDEX_MAGIC, sizeof(INDEX_MAGIC)) != 0)
+			continue;
+		const qint64 nIndexOffset = qFromBigEndian<qint64>((const uchar*) data + nFooter);
+		if (nIndexOffset < HEADER_SIZE || nIndexOffset >= nFooter)
+			continue;
+
+		QDataStream str(QByteArray::fromRawData(data + nIndexOffset, nFooter - nIndexOffset));
+		str.setVersion(QDataStream::Qt_4_3);
+		qint32 nWaves;
+		index.sSampleStore.clear();
+		str >> index.xml;
+		if (nVersion >= 4)
+			str >> index.sSampleStore;
+		str >> nWaves;
+		if (str.status() != QDataStream::Ok || nWaves < 0 || nWaves > (nFooter - nIndexOffset) / 8)
+			continue;
+
+		// Each offset must point to a complete sample block before the index
+		index.offsets.clear();
+		index.hashes.clear();
+		bool bValid = true;
+		for (int i = 0; i < nWaves && bValid; i++)
+		{
+			qint64 nOffset;
+			QByteArray hash;
+			str >> nOffset;
+			if (nVersion >= 4)
+				str >> hash;
+
+			if (nOffset >= 0)
+			{
+				bValid = (hash.isEmpty() && nOffset >= HEADER_SIZE && nOffset <= nIndexOffset - 4);
+				if (bValid)
+				{
+					const quint32 nSamples = qFromBigEndian<quint32>((const uchar*) data + nOffset);
+					bValid = (nSamples <= (quint64) (nIndexOffset - nOffset - 4) / 2);
+				}
+			}
+			else
+				bValid = (nOffset == -1);
+
+			index.offsets << nOffset;
+			index.hashes << hash;
+		}
+		if (!bValid || str.status() != QDataStream::Ok)
+			continue;
+
+		index.nVersion = nVersion;
+		index.nIndexOffset = nIndexOffset;
+		index.nFooter = nFooter;
+		return true;
+	}
+
+	return false;
+}
+
+bool EadFile::readBlockReferences(const QString& sFilename, QSet<QByteArray>& hashes, QString* psSampleStore)
+{
+	QFile file(sFilename);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QByteArray buffer;
+	qint64 nSize = file.size();
+	const char* data = (const char*) file.map(0, nSize);
+	if (data == NULL)
+	{
+		buffer = file.readAll();
+		data = buffer.constData();
+		nSize = buffer.size();
+	}
+
+	if (psSampleStore != NULL)
+		psSampleStore->clear();
+
+	// Older formats keep all their samples in the file
+	if (nSize < HEADER_SIZE || memcmp(data, "EAD", 4) != 0)
+		return false;
+	if (qFromBigEndian<qint32>((const uchar*) data + 4) < 3)
+		return true;
+
+	FileIndex index;
+	if (!readIndex(data, nSize, index))
+		return false;
+
+	foreach (const QByteArray& hash, index.hashes)
+	{
+		if (!hash.isEmpty())
+			hashes << hash;
+	}
+	if (psSampleStore != NULL && !index.sSampleStore.isEmpty())
+		*psSampleStore = QDir::cleanPath(QFileInfo(sFilename).absoluteDir().absoluteFilePath(index.sSampleStore));
+	return true;
+}
+
+LoadSaveResult EadFile::loadIndexed(const char* data, qint64 nSize, const QString& sFilename, bool bDefer)
+{
+	FileIndex index;
+	if (!readIndex(data, nSize, index))
+		return LoadSaveResult_DataCorrupt;
+
+	LoadSaveResult result = loadXml(index.xml, sFilename);
+	if (result != LoadSaveResult_Ok)
+		return result;
+
+	QList<WaveInfo*> waves;
+	for (int i = 1; i < m_recs.count(); i++)
+		waves << m_recs[i]->waves();
+	if (waves.size() != index.offsets.size())
+		return LoadSaveResult_DataCorrupt;
+
+	if (!index.sSampleStore.isEmpty())
+		m_sSampleStore = QDir::cleanPath(QFileInfo(sFilename).absoluteDir().absoluteFilePath(index.sSampleStore));
+	SampleStore store(m_sSampleStore);
+	// A file which was copied or moved needs to be known to the store, so that its blocks aren't collected.
+	// This fails harmlessly for a read-only store, in which nothing is collected anyway.
+	if (!m_sSampleStore.isEmpty())
+		store.addReferrer(sFilename);
+
+	// Decode the blocks in the file and read the blocks in the sample store in parallel.
+	// The sample store is always read right away, so that missing samples can be reported.
+	QList<RawBlock> blocks;
+	QList<StoreBlock> storeBlocks;
+	qint64 nUsed = HEADER_SIZE;
+	for (int i = 0; i < waves.size(); i++)
+	{
+		if (index.offsets[i] >= 0)
+		{
+			RawBlock block;
+			block.wave = waves[i];
+			block.data = data + index.offsets[i] + 4;
+			block.nSamples = (int) qFromBigEndian<quint32>((const uchar*) data + index.offsets[i]);
+			blocks << block;
+			nUsed += 4 + 2 * (qint64) block.nSamples;
+		}
+		else if (!index.hashes[i].isEmpty())
+		{
+			if (m_sSampleStore.isEmpty())
+				return LoadSaveResult_DataCorrupt;
+
+			StoreBlock block;
+			block.wave = waves[i];
+			block.store = &store;
+			block.hash = index.hashes[i];
+			block.bOk = false;
+			storeBlocks << block;
+		}
+	}
+	decodeRawBlocks(blocks, bDefer);
+	QtConcurrent::blockingMap(storeBlocks, readStoreBlock);
+
+	// Share the memory with other open files which use the same samples
+	foreach (const StoreBlock& block, storeBlocks)
+	{
+		if (!block.bOk)
+			return LoadSaveResult_SamplesMissing;
+		block.wave->raw = SampleStore::intern(block.wave->raw, block.hash);
+	}
+
+	// Remember the stored blocks, so that saving only needs to append new data.
+	// Deferred waves get their samples here in finishDecoding().
+	for (int i = 0; i < waves.size(); i++)
+	{
+		if (index.offsets[i] >= 0 || !index.hashes[i].isEmpty())
+		{
+			StoredBlock block;
+			block.nOffset = index.offsets[i];
+			block.hash = index.hashes[i];
+			block.raw = waves[i]->raw;
+			m_storedBlocks[waves[i]] = block;
+		}
+	}
+	// The index format of version 3 files can't be appended to
+	m_nStoredSize = (index.nVersion == FILE_VERSION) ? nSize : -1;
+	m_nStoredUnused = index.nIndexOffset - nUsed + (nSize - index.nFooter - FOOTER_SIZE);
+
+	return LoadSaveResult_Ok;
+}
+
+LoadSaveResult EadFile::loadXml(const QString& xml, const QString& sFilename)
+{
 	QDomDocument doc("ead");
 	if (!doc.setContent(xml))
 		return LoadSaveResult_DataCorrupt;
@@ -289,7 +1270,7 @@ LoadSaveResult EadFile::loadCurrent(QDataStream& str)
 	for (int i = 0; i < recs.size(); i++)
 	{
 		QDomElement elem = recs.at(i).toElement();
-		loadRecNode(elem);
+		loadRecNode(elem, QFileInfo(sFilename).absoluteDir());
 	}
 	// At least we should have our two averaged waves
 	CHECK_ASSERT_RETVAL(m_recs.size() >= 1, LoadSaveResult_DataCorrupt);
@@ -304,32 +1285,31 @@ LoadSaveResult EadFile::loadCurrent(QDataStream& str)
 		loadViewNode(elem, view);
 	}
 
-	// Load data for non-averaged waves
-	for (int i = 1; i < m_recs.count(); i++)
-	{
-		RecInfo* rec = m_recs[i];
-		foreach (WaveInfo* wave, rec->waves())
-		{
-			str >> wave->raw;
-		}
-	}
+	// The recordings and views are known before any samples are decoded.
+	// load() blocks the other signals until the file is consistent again.
+	const bool bBlocked = blockSignals(false);
+	emit waveListChanged();
+	blockSignals(bBlocked);
 
 	return LoadSaveResult_Ok;
 }
 
-void EadFile::createRecNode(QDomDocument& doc, QDomElement& parent, RecInfo* rec)
+void EadFile::createRecNode(QDomDocument& doc, QDomElement& parent, RecInfo* rec, const QDir& dir)
 {
 	QDomElement elem = doc.createElement("rec");
 	parent.appendChild(elem);
 	
 	elem.setAttribute("id", rec->id());
 	elem.setAttribute("time", rec->timeOfRecording().toTime_t());
+	// Like the sample store, the monitoring history is referred to relative to the file
+	if (rec->monitorHistory() != NULL)
+		elem.setAttribute("monitorHistory", dir.relativeFilePath(rec->monitorHistory()->directory()));
 
 	foreach (WaveInfo* wave, rec->waves())
 		createWaveNode(doc, elem, wave);
 }
 
-void EadFile::loadRecNode(QDomElement& elem)
+void EadFile::loadRecNode(QDomElement& elem, const QDir& dir)
 {
 	int id = elem.attribute("id").toInt();
 	uint nSeconds = elem.attribute("time").toUInt();
@@ -337,6 +1317,19 @@ void EadFile::loadRecNode(QDomElement& elem)
 	RecInfo* rec = new RecInfo(this, id);
 	rec->setTimeOfRecording(QDateTime::fromTime_t(nSeconds));
 
+	QString sHistory = elem.attribute("monitorHistory");
+	if (!sHistory.isEmpty())
+	{
+		MonitorHistory* history = new MonitorHistory;
+		if (history->attach(QDir::cleanPath(dir.absoluteFilePath(sHistory))))
+			rec->setMonitorHistory(history);
+		else
+		{
+			qDebug() << "EadFile: the monitoring history" << sHistory << "is missing";
+			delete history;
+		}
+	}
+
 	QDomNodeList waves = elem.elementsByTagName("wave");
 	for (int i = 0; i < waves.size(); i++)
 	{
@@ -578,16 +1571,6 @@ void EadFile::loadViewWaveNode(QDomElement& elem, ViewInfo* view, bool bExtra)
 	vwi->setDivisionOffset(nDivisionOffset);
 }
 
-void EadFile::saveData(QDataStream& str)
-{
-	for (int i = 1; i < m_recs.size(); i++)
-	{
-		RecInfo* rec = m_recs[i];
-		foreach (WaveInfo* wave, rec->waves())
-			str << wave->raw;
-	}
-}
-
 void EadFile::importWaves(const EadFile* other)
 {
 	CHECK_PARAM_RET(other != NULL);
@@ -604,71 +1587,41 @@ void EadFile::importWaves(const EadFile* other)
 		m_newRec->ead()->copyFrom(rec->ead());
 		m_newRec->fid()->copyFrom(rec->fid());
 		m_newRec->digital()->copyFrom(rec->digital());
+		// Keep only one copy in memory of samples that are imported into several files
+		foreach (WaveInfo* wave, m_newRec->waves())
+			wave->raw = SampleStore::intern(wave->raw, SampleStore::hash(wave->raw));
 		saveNewRecording();
 	}
 }
 
-bool EadFile::exportData(const QString& sFilename /*, EadFile::ExportFormat format*/)
+bool EadFile::exportData(const QString& sFilename /*, EadFile::ExportFormat format*/, QString* psError)
 {
-	QFile file(sFilename);
-	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
-		return false;
-
-	QTextStream str(&file);
-
-	// Build list of waves with data
-	QList<WaveInfo*> waves;
-	foreach (RecInfo* rec, m_recs)
-	{
-		foreach (WaveInfo* wave, rec->waves())
-		{
-			if (!wave->display.isEmpty())
-				waves << wave;
-		}
-	}
-
-	if (waves.isEmpty())
-		return false;
-
-	// Header row
-	QStringList cols;
-	foreach (WaveInfo* wave, waves)
-		cols << QString("\"%0\"").arg(wave->sName);
-	str << cols.join(",") << endl;
-
-	// Data rows
-	int tidx = 0;
-	while (true)
-	{
-		cols.clear();
-		bool bFound = false;
-		foreach (WaveInfo* wave, waves)
-		{
-			double n = 0;
-			//int didxEnd = wave->display.size() + wave->rec()->shift();
-			//int didx = tidx - wave->rec()->shift();
-			int didxEnd = wave->display.size() + wave->shift();
-			int didx = tidx - wave->shift();
-			if (didx < didxEnd)
-			{
-				bFound = true;
-				if (didx >= 0)
-					n = wave->display[didx];
-			}
-			cols << QString::number(n);
-		}
-		if (!bFound)
-			break;
-
-		str << cols.join(",") << endl;
-		tidx++;
-	}
+	finishLoading();
+	WaveExporter exporter(this);
+	bool bOk = exporter.exportCsv(sFilename);
+	if (!bOk && psError != NULL)
+		*psError = exporter.errorString();
+	return bOk;
+}
 
-	return true;
+bool EadFile::exportNumpy(const QString& sFilename, QString* psError)
+{
+	finishLoading();
+	WaveExporter exporter(this);
+	bool bOk;
+	if (sFilename.endsWith(".npz", Qt::CaseInsensitive))
+		bOk = exporter.exportNpz(sFilename);
+	else
+		bOk = exporter.exportNpy(sFilename);
+	if (!bOk && psError != NULL)
+		*psError = exporter.errorString();
+	return bOk;
 }
 
 bool EadFile::exportAmplitudeData(const QString& sFilename /*, EadFile::ExportFormat format*/)
 {
+	finishLoading();
+
 	QFile file(sFilename);
 	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
 		return false;
@@ -717,6 +1670,8 @@ bool EadFile::exportAmplitudeData(const QString& sFilename /*, EadFile::ExportFo
 
 bool EadFile::exportRetentionData(const QString& sFilename /*, EadFile::ExportFormat format*/)
 {
+	finishLoading();
+
 	QFile file(sFilename);
 	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
 		return false;
@@ -804,12 +1759,12 @@ void EadFile::addImportedRecording(RecInfo* rec)
 	updateViewInfo();
 	updateAveWaves();
 
-	rec->fid()->findFidPeaks();
+	// For a new recording, most of the peaks were already found while it was being recorded
+	rec->fid()->updateFidPeaks(true);
 
 	emit waveListChanged();
 
-	m_bDirty = true;
-	emit dirtyChanged();
+	setDirty();
 }
 
 void EadFile::remove(WaveInfo* wave)
@@ -819,6 +1774,8 @@ void EadFile::remove(WaveInfo* wave)
 	// Can only remove recorded waves
 	CHECK_PRECOND_RET(wave->recId() > 0);
 
+	finishLoading();
+
 	// Delete the raw data
 	wave->raw.clear();
 
@@ -827,8 +1784,7 @@ void EadFile::remove(WaveInfo* wave)
 
 	emit waveListChanged();
 
-	m_bDirty = true;
-	emit dirtyChanged();
+	setDirty(wave, NULL);
 }
 
 
@@ -958,12 +1914,79 @@ void EadFile::updateViewInfo()
 
 void EadFile::updateAveWaves()
 {
+	finishLoading();
+
 	updateAveWave(WaveType_EAD);
 	updateAveWave(WaveType_FID);
 
 	m_recs[0]->fid()->findFidPeaks();
 }
 
+void EadFile::applyFilters()
+{
+	updateDisplay();
+	updateAveWaves();
+
+	checkpoint();
+}
+
+void EadFile::checkpoint()
+{
+	// As in setDirty()
+	finishDecoding();
+	if (m_editHistory->checkpoint())
+		emit historyChanged();
+}
+
+void EadFile::undo()
+{
+	EditHistory::Restored restored;
+	if (m_editHistory->undo(restored))
+		applyRestored(restored);
+	else
+		emit historyChanged();
+}
+
+void EadFile::redo()
+{
+	EditHistory::Restored restored;
+	if (m_editHistory->redo(restored))
+		applyRestored(restored);
+	else
+		emit historyChanged();
+}
+
+void EadFile::applyRestored(const EditHistory::Restored& restored)
+{
+	if (restored.bFilters)
+		updateDisplay();
+	else
+		updateDisplay(restored.displayWaves);
+
+	foreach (WaveInfo* wave, restored.displayWaves)
+	{
+		// If this is an FID, we'll have to recalculate the peaks
+		if (wave->type == WaveType_FID)
+			wave->findFidPeaks();
+		wave->calcPeakAreas();
+	}
+	foreach (WaveInfo* wave, restored.peakWaves)
+		wave->calcPeakAreas();
+
+	if (restored.bWaveList)
+		updateViewInfo();
+	updateAveWaves();
+
+	// The history already holds the restored state, so this doesn't record another step
+	setDirty(NULL, NULL);
+
+	if (restored.bFilters)
+		emit filterModeChanged();
+	emit waveListChanged();
+	emit displayChanged();
+	emit historyChanged();
+}
+
 void EadFile::updateAveWave(WaveType type)
 {
 	WaveInfo* ave = m_recs[0]->wave(type);
@@ -1052,11 +2075,10 @@ void EadFile::updateAveWave(WaveType type)
 
 void EadFile::updateDisplay()
 {
+	QList<WaveInfo*> waves;
 	for (int i = 1; i < m_recs.count(); i++)
-	{
-		RecInfo* rec = m_recs[i];
-		updateDisplay(rec);
-	}
+		waves << m_recs[i]->waves();
+	updateDisplay(waves);
 }
 
 void EadFile::updateDisplay(RecInfo* rec)
@@ -1067,13 +2089,22 @@ void EadFile::updateDisplay(RecInfo* rec)
 
 void EadFile::updateDisplay(const QList<WaveInfo*>& waves)
 {
+	finishLoading();
+
+	// The waves don't depend on each other, so they can be filtered in parallel
+	QList<WaveInfo*> list;
 	foreach (WaveInfo* wave, waves)
-		updateDisplay(wave);
+	{
+		CHECK_PARAM_RET(wave != NULL);
+		list << wave;
+	}
+	QtConcurrent::blockingMap(list, calcWaveDisplay);
 }
 
 void EadFile::updateDisplay(WaveInfo* wave)
 {
 	CHECK_PARAM_RET(wave != NULL);
+	finishLoading();
 	wave->calcDisplayData(filters());
 }
 
@@ -1207,6 +2238,22 @@ QVector<short> EadFile::createFakeData4(const QVector<short>& orig, int nShift,
 
 void EadFile::setDirty()
 {
+	m_editHistory->touchAll();
+	setDirty(NULL, NULL);
+}
+
+void EadFile::setDirty(WaveInfo* wave, WavePos* pos)
+{
+	if (wave != NULL)
+		m_editHistory->touch(wave);
+	if (pos != NULL)
+		m_editHistory->touch(pos);
+
+	m_nRevision++;
 	m_bDirty = true;
+	// The history needs all the samples before it can tell what changed
+	finishDecoding();
+	if (m_editHistory->checkpoint())
+		emit historyChanged();
 	emit dirtyChanged();
 }
@@ -18,11 +18,15 @@
 #ifndef _EADFILE_H
 #define _EADFILE_H
 
+#include <QDateTime>
+#include <QHash>
 #include <QList>
 #include <QObject>
 #include <QPair>
+#include <QSet>
 
 #include "EadEnums.h"
+#include "EditHistory.h"
 #include "FilterInfo.h"
 #include "RecInfo.h"
 #include "WaveInfo.h"
@@ -30,9 +34,14 @@
 
 
 class QDataStream;
+class QDir;
 class QDomDocument;
 class QDomElement;
 class QFile;
+class QIODevice;
+
+class SampleStore;
+template <typename T> class QFutureWatcher;
 
 
 class EadFile : public QObject
@@ -50,6 +59,15 @@ public:
 		TAB,
 	};
 	*/
+
+	/// Filter job for a single wave, run on a worker thread during a progressive load
+	struct DisplayJob
+	{
+		WaveInfo* wave;
+		int filterId;
+		QVector<double> display;
+	};
+
 public:
 	EadFile();
 	~EadFile();
@@ -65,10 +83,59 @@ public:
 	ViewInfo* viewInfo(EadView view);
 	
 	void clear();
-	bool saveAs(const QString& sFilename);
-	LoadSaveResult load(const QString& sFilename);
+	/// Save the file.
+	/// With SaveMode_Incremental, only the sample data which isn't in the file yet is appended, followed by a new index.
+	/// This requires sFilename to be the file which was last loaded or saved, in the appendable format, and not to
+	/// have been changed since; otherwise the whole file is written, as with SaveMode_Rewrite.
+	/// A rewritten file keeps the format that older versions of GcEad can read, unless it's already in the
+	/// appendable format, the samples go to a sample store, or mode is SaveMode_Convert.
+	/// A rewritten file goes to a temporary file which only replaces sFilename once it's complete.
+	bool saveAs(const QString& sFilename, SaveMode mode = SaveMode_Incremental);
+	/// Save the file like saveAs(), but on a worker thread.
+	/// A snapshot of the project is taken right away, so it can continue to be edited while the data is written.
+	/// saveProgress() and saveFinished() report on the save.
+	/// @returns false if another save is still in progress
+	bool saveAsync(const QString& sFilename, SaveMode mode = SaveMode_Incremental);
+	/// Format version of the file as it was last loaded or saved, or 0 if it's new or in the old BcV format.
+	/// Only files of version 3 and later can be saved incrementally.
+	qint32 fileVersion() const { return m_nStoredVersion; }
+	/// Number of bytes in the saved file which are no longer used, and which SaveMode_Rewrite would free
+	qint64 unusedFileSize() const { return m_nStoredUnused; }
+	/// Directory of the shared SampleStore which the raw data is saved to, or empty if it's saved in the file itself
+	const QString& sampleStore() const { return m_sSampleStore; }
+	/// Save the raw data to the given SampleStore from now on, or into the file itself if sPath is empty
+	void setSampleStore(const QString& sPath);
+	/// Collect the hashes of the SampleStore blocks which an .ead file refers to, without loading the file
+	/// @param psSampleStore if not NULL, receives the directory of the file's sample store
+	static bool readBlockReferences(const QString& sFilename, QSet<QByteArray>& hashes, QString* psSampleStore = NULL);
+	/// True while a saveAsync() is in progress
+	bool isSaving() const { return m_bSaving; }
+	/// Wait for a saveAsync() to complete
+	/// @returns the result of the most recent save
+	bool waitForSave();
+	/// Load a file.
+	/// waveListChanged() is emitted as soon as the recordings and views have been read from the XML,
+	/// before any samples are decoded.
+	/// If bProgressive is true, load() then only decodes the waves on the first screen, i.e. the visible
+	/// EAD and FID waves which make up the averages and the waves which views show as their user wave,
+	/// and returns once their unfiltered display data and the averages are available.
+	/// The other waves (digital channels and hidden recordings) are decoded in the background, after which
+	/// waveListChanged() is emitted again, and filtering, peak detection, averaging and peak areas follow,
+	/// with displayChanged() emitted as the results come in.
+	/// Functions which need the complete data call finishLoading() first; edits wait for the decoding only.
+	/// All waves are decoded before load() returns if there is a cache of derived data to check, and
+	/// samples in a sample store are always read right away, so that missing ones can be reported.
+	LoadSaveResult load(const QString& sFilename, bool bProgressive = false);
+	/// True while a progressive load() is still decoding waves or computing derived data in the background
+	bool isLoading() const { return m_bLoading; }
+	/// Complete the background work of a progressive load() immediately
+	void finishLoading();
 	void importWaves(const EadFile* other);
-	bool exportData(const QString& sFilename /*, ExportFormat format*/);
+	/// @param psError if not NULL, receives a description of the error if the export fails
+	bool exportData(const QString& sFilename /*, ExportFormat format*/, QString* psError = NULL);
+	/// Export the same data as exportData() as float64 arrays:
+	/// a .npz archive with one array per wave if sFilename ends with ".npz", otherwise a single 2D .npy array
+	bool exportNumpy(const QString& sFilename, QString* psError = NULL);
 	bool exportAmplitudeData(const QString& sFilename /*, ExportFormat format*/);
 	bool exportRetentionData(const QString& sFilename /*, ExportFormat format*/);
 
@@ -93,6 +160,20 @@ public:
 
 	/// Force a recalculation of the averaged waves
 	void updateAveWaves();
+	/// Recalculate the display data after the filter settings have been changed.
+	/// Unlike updateDisplay(), this records the new settings as a step which can be undone.
+	void applyFilters();
+	/// Record changes to the filter settings, which aren't saved with the file, as a step which can be undone
+	void checkpoint();
+
+	/// True if there is an edit which undo() can revert
+	bool canUndo() const { return m_editHistory->canUndo(); }
+	/// True if there is an undone edit which redo() can apply again
+	bool canRedo() const { return m_editHistory->canRedo(); }
+	/// Revert the most recent edit of the waves, markers, wave positions, filters or file comment
+	void undo();
+	/// Apply the most recently undone edit again
+	void redo();
 
 	void updateDisplay();
 	void updateDisplay(RecInfo* rec);
@@ -101,8 +182,11 @@ public:
 
 	void createFakeData();
 
-	/// Called by ViewInfo when the user changes stuff
+	/// Mark the file as changed.  Since it isn't known what changed, the edit history compares all waves.
 	void setDirty();
+	/// Called by ViewInfo when the user changes stuff: only the given wave and position, either of which may be NULL,
+	/// need to be compared for the edit history
+	void setDirty(WaveInfo* wave, WavePos* pos);
 
 signals:
 	/// Emitted when the file has been changed (used by MainWindow to know when the user should save)
@@ -111,20 +195,118 @@ signals:
 	void waveListChanged();
 	/// Emitted when the filter mode is changed
 	void filterModeChanged();
+	/// Emitted when the display data, peaks or averages of existing waves have been recalculated in the background
+	void displayChanged();
+	/// Emitted during saveAsync() with the percentage of the sample data which has been written
+	void saveProgress(int nPercent);
+	/// Emitted when saveAsync() has completed
+	void saveFinished(bool bOk);
+	/// Emitted when canUndo() or canRedo() may have changed
+	void historyChanged();
+
+private slots:
+	void on_loadWatcher_resultReadyAt(int i);
+	void on_loadWatcher_finished();
+	void on_decodeWatcher_finished();
+	void updateDecodedViews();
+	void continueLoading();
+	void on_saveWatcher_finished();
+	void on_save_progress(int nPercent);
 
 private:
+	/// The XML and sample data of a file to be saved
+	struct SaveSnapshot;
+	struct SaveResult;
+	/// Index at the end of a file in version 3 or later
+	struct FileIndex;
+
+	/// Location of a wave's sample data in the saved file
+	struct StoredBlock
+	{
+		/// Offset of the block in the file, or -1 if it's in the sample store
+		qint64 nOffset;
+		/// Hash of the samples, or empty if it hasn't been calculated
+		QByteArray hash;
+		/// Shares the data with the wave for as long as the wave's samples remain unchanged
+		QVector<short> raw;
+	};
+
+	/// Take a snapshot of the current project; the sample data is shared, not copied
+	SaveSnapshot createSnapshot(const QString& sFilename, SaveMode mode);
+	/// Write the snapshot to disk; this may be called from a worker thread
+	/// @param progress if not NULL, its on_save_progress() slot receives progress updates
+	static SaveResult writeSnapshot(const SaveSnapshot& snapshot, EadFile* progress);
+	/// Write the XML followed by all sample blocks, in the format of version 2
+	static bool writeSequential(QIODevice& device, SaveResult& result, EadFile* progress);
+	/// Write the sample blocks which aren't stored yet, followed by the index
+	static bool writeBlocksAndIndex(QIODevice& device, SaveResult& result, EadFile* progress);
+	void applySaveResult(const SaveResult& result);
+	void completeSave();
+
+	/// A wave's serialized raw data within a memory-mapped file
+	struct RawBlock
+	{
+		WaveInfo* wave;
+		const char* data;
+		int nSamples;
+		/// Samples which were decoded in the background, until they are handed to the wave on the GUI thread
+		QVector<short> raw;
+	};
+
+	/// A wave's raw data in the sample store
+	struct StoreBlock
+	{
+		WaveInfo* wave;
+		const SampleStore* store;
+		QByteArray hash;
+		bool bOk;
+	};
+
+	static void decodeRawBlock(RawBlock& block);
+	static void decodeDeferredBlock(RawBlock& block);
+	/// Whether the wave's samples are needed for the first screen after loading
+	bool isOnFirstScreen(const WaveInfo* wave) const;
+	/// Decode the blocks.  If bDefer is true, the blocks of waves which aren't on the first screen
+	/// are left in m_deferredBlocks for startLoading() to decode in the background.
+	void decodeRawBlocks(const QList<RawBlock>& blocks, bool bDefer);
+	static void readStoreBlock(StoreBlock& block);
+	static void calcWaveDisplay(WaveInfo*& wave);
+	static void calcRecPeaks(RecInfo*& rec);
+	static DisplayJob filterDisplay(const DisplayJob& job);
+	/// Start the background computations after the unfiltered display data of the first screen has been set:
+	/// first decode the deferred waves, then filter all waves
+	void startLoading(const QString& sCacheFilename);
+	/// Hand the deferred waves to the file once they are decoded, waiting for them if necessary, and start filtering
+	void finishDecoding();
+	void startFiltering();
+	/// Abandon a progressive load, e.g. because the file is being cleared
+	void cancelLoading();
+	void applyLoadResult(int i);
+	/// Perform the next step of the derived computations
+	/// @returns true if more steps remain
+	bool loadingStep();
+
 	//void addRec(RecInfo* rec);
 
-	void createRecNode(QDomDocument& doc, QDomElement& parent, RecInfo* rec);
+	/// @param dir directory of the file which is being saved, which paths are stored relative to
+	void createRecNode(QDomDocument& doc, QDomElement& parent, RecInfo* rec, const QDir& dir);
 	void createWaveNode(QDomDocument& doc, QDomElement& parent, WaveInfo* wave);
 	void createPeakNode(QDomDocument& doc, QDomElement& parent, const WavePeakChosenInfo* peak);
 	void createViewNode(QDomDocument& doc, QDomElement& parent, ViewInfo* view);
 	void createViewWaveNode(QDomDocument& doc, QDomElement& parent, ViewWaveInfo *vwi);
-	void saveData(QDataStream& str);
 
-	LoadSaveResult loadOld(QDataStream& str);
-	LoadSaveResult loadCurrent(QDataStream& str);
-	void loadRecNode(QDomElement& elem);
+	/// Load the old "BcV" format from the complete contents of the file
+	LoadSaveResult loadOld(const char* data, qint64 nSize);
+	/// @param data the complete contents of the file
+	/// @param bDefer whether to defer decoding the waves which aren't on the first screen, see decodeRawBlocks()
+	LoadSaveResult loadCurrent(QDataStream& str, const char* data, qint64 nSize, const QString& sFilename, bool bDefer);
+	/// Find the last complete index of a file in version 3 or later
+	static bool readIndex(const char* data, qint64 nSize, FileIndex& index);
+	/// Load the last complete index of a file in version 3 or later, and the sample blocks it refers to
+	LoadSaveResult loadIndexed(const char* data, qint64 nSize, const QString& sFilename, bool bDefer);
+	/// Reconstruct the recordings and views from the file's XML
+	LoadSaveResult loadXml(const QString& xml, const QString& sFilename);
+	void loadRecNode(QDomElement& elem, const QDir& dir);
 	void loadWaveNode(QDomElement& elem, WaveInfo* wave);
 	void loadPeakNode(QDomElement& elem, WaveInfo* wave);
 	void loadViewNode(QDomElement& elem, ViewInfo* view);
@@ -142,6 +324,8 @@ private:
 	void updateViewInfo();
 
 	void updateAveWave(WaveType type);
+	/// Recalculate what depends on the state which undo() or redo() restored
+	void applyRestored(const EditHistory::Restored& restored);
 
 	/// @param nSize number of doubles in 'data'
 	void createFakeData2(WaveInfo* wave, short* data, int nSize, short yOffset);
@@ -161,6 +345,44 @@ private:
 	//QList<FilterInfo*> m_filtersDefault;
 	//QList<FilterInfo*> m_filtersAdvanced;
 	QList<FilterTesterInfo*> m_filters;
+
+	/// True while a progressive load is in progress
+	bool m_bLoading;
+	QFutureWatcher<DisplayJob>* m_loadWatcher;
+	/// Which results of m_loadWatcher have already been copied to their waves
+	QVector<bool> m_loadApplied;
+	/// Index of the next recording for FID peak detection
+	int m_iLoadingRec;
+	QString m_sLoadingCacheFilename;
+	/// Blocks of the waves which a progressive load decodes in the background
+	QList<RawBlock> m_deferredBlocks;
+	QFutureWatcher<void>* m_decodeWatcher;
+	/// Keeps the data which m_deferredBlocks point into: the mapped file, or its contents if it couldn't be mapped
+	QFile* m_decodingFile;
+	QByteArray m_decodingBuffer;
+
+	/// Incremented on every change, so that a background save can tell whether it's still current
+	int m_nRevision;
+	/// True while a saveAsync() is in progress
+	bool m_bSaving;
+	/// Result of the most recent save
+	bool m_bSaveOk;
+	QFutureWatcher<SaveResult>* m_saveWatcher;
+	int m_nSavingRevision;
+
+	/// Where the waves' samples are stored in m_sFilename
+	QHash<const WaveInfo*, StoredBlock> m_storedBlocks;
+	/// Size of m_sFilename when it was last loaded or saved, or -1 if it can't be appended to
+	qint64 m_nStoredSize;
+	/// Format version of m_sFilename, see fileVersion()
+	qint32 m_nStoredVersion;
+	QDateTime m_storedLastModified;
+	/// Bytes in m_sFilename which the index no longer refers to
+	qint64 m_nStoredUnused;
+	QString m_sSampleStore;
+
+	/// The user's edits, for undo and redo
+	EditHistory* m_editHistory;
 };
 
 #endif
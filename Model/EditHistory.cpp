@@ -0,0 +1,375 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "EditHistory.h"
+
+#include <Check.h>
+
+#include "EadFile.h"
+#include "FilterInfo.h"
+#include "RecInfo.h"
+#include "ViewInfo.h"
+
+
+/// Maximum number of steps which can be undone
+static const int MAX_STEPS = 100;
+/// Changes which follow each other within this many milliseconds may be merged into one step
+static const qint64 MERGE_INTERVAL = 500;
+
+
+template <typename Key, typename T>
+static bool sameKeys(const QHash<Key, T>& a, const QHash<Key, T>& b)
+{
+	if (a.size() != b.size())
+		return false;
+	for (typename QHash<Key, T>::const_iterator it = a.constBegin(); it != a.constEnd(); ++it)
+	{
+		if (!b.contains(it.key()))
+			return false;
+	}
+	return true;
+}
+
+
+bool EditHistory::WaveState::operator==(const WaveState& other) const
+{
+	// The containers only compare their contents if they don't share their data
+	return
+		raw == other.raw &&
+		nRawToVoltageFactorNum == other.nRawToVoltageFactorNum &&
+		nRawToVoltageFactor == other.nRawToVoltageFactor &&
+		nShift == other.nShift &&
+		peaksChosen == other.peaksChosen &&
+		sName == other.sName &&
+		sComment == other.sComment;
+}
+
+bool EditHistory::FilterState::operator==(const FilterState& other) const
+{
+	return filterId == other.filterId && properties == other.properties;
+}
+
+bool EditHistory::Step::isEmpty() const
+{
+	return waves.isEmpty() && positions.isEmpty() && userWaves.isEmpty() && filters.isEmpty() && !bComment;
+}
+
+bool EditHistory::Step::canMerge(const Step& next) const
+{
+	// Deleting waves, choosing other waves, filtering and editing the comment are always steps of their own
+	if (bSamples || next.bSamples)
+		return false;
+	if (!userWaves.isEmpty() || !next.userWaves.isEmpty())
+		return false;
+	if (!filters.isEmpty() || !next.filters.isEmpty())
+		return false;
+	if (bComment || next.bComment)
+		return false;
+	return sameKeys(waves, next.waves) && sameKeys(positions, next.positions);
+}
+
+
+EditHistory::EditHistory(EadFile* file)
+	: m_file(file)
+{
+	m_bRestoring = false;
+	clear();
+}
+
+void EditHistory::clear()
+{
+	m_undo.clear();
+	m_redo.clear();
+	m_timer.invalidate();
+
+	m_waves.clear();
+	m_positions.clear();
+	m_userWaves.clear();
+	m_filters.clear();
+	m_sComment = m_file->comment();
+
+	// Take the current state without recording a step
+	m_touchedWaves.clear();
+	m_touchedPositions.clear();
+	m_bTouchedAll = true;
+	checkpoint();
+}
+
+void EditHistory::touch(WaveInfo* wave)
+{
+	CHECK_PARAM_RET(wave != NULL);
+	m_touchedWaves << wave;
+}
+
+void EditHistory::touch(WavePos* pos)
+{
+	CHECK_PARAM_RET(pos != NULL);
+	m_touchedPositions << pos;
+}
+
+void EditHistory::touchAll()
+{
+	m_bTouchedAll = true;
+}
+
+void EditHistory::adoptSamples(WaveInfo* wave)
+{
+	CHECK_PARAM_RET(wave != NULL);
+	QHash<WaveInfo*, WaveState>::iterator it = m_waves.find(wave);
+	if (it != m_waves.end() && wave->recId() > 0)
+		it->raw = wave->raw;
+}
+
+EditHistory::WaveState EditHistory::captureWave(const WaveInfo* wave)
+{
+	WaveState state;
+	if (wave->recId() > 0)
+		state.raw = wave->raw;
+	state.nRawToVoltageFactorNum = wave->nRawToVoltageFactorNum;
+	state.nRawToVoltageFactor = wave->nRawToVoltageFactor;
+	state.nShift = wave->shift();
+	state.peaksChosen = wave->peaksChosen;
+	state.sName = wave->sName;
+	state.sComment = wave->sComment;
+	return state;
+}
+
+EditHistory::FilterState EditHistory::captureFilter(const FilterTesterInfo* filter)
+{
+	FilterState state;
+	state.filterId = filter->filterId();
+	state.properties = filter->allProperties();
+	return state;
+}
+
+void EditHistory::checkWave(WaveInfo* wave, Step& step)
+{
+	const WaveState state = captureWave(wave);
+	QHash<WaveInfo*, WaveState>::iterator it = m_waves.find(wave);
+	if (it == m_waves.end())
+		m_waves.insert(wave, state);
+	else
+	{
+		if (!(state == *it))
+		{
+			if (!(state.raw == it->raw))
+				step.bSamples = true;
+			step.waves.insert(wave, *it);
+		}
+		// Even if the contents are equal, share the wave's current data so that the next comparison is quick
+		*it = state;
+	}
+}
+
+void EditHistory::checkPosition(WavePos* pos, Step& step)
+{
+	QHash<WavePos*, WavePos>::iterator it = m_positions.find(pos);
+	if (it == m_positions.end())
+		m_positions.insert(pos, *pos);
+	else if (!(*pos == *it))
+	{
+		step.positions.insert(pos, *it);
+		*it = *pos;
+	}
+}
+
+bool EditHistory::checkpoint()
+{
+	if (m_bRestoring)
+		return false;
+
+	Step step;
+
+	if (m_bTouchedAll)
+	{
+		foreach (RecInfo* rec, m_file->recs())
+		{
+			foreach (WaveInfo* wave, rec->waves())
+			{
+				checkWave(wave, step);
+				checkPosition(&wave->pos, step);
+			}
+		}
+		for (int i = 0; i < EadViewCount; i++)
+		{
+			foreach (WavePos* pos, m_file->viewInfo((EadView) i)->positions())
+				checkPosition(pos, step);
+		}
+	}
+	else
+	{
+		foreach (WaveInfo* wave, m_touchedWaves)
+			checkWave(wave, step);
+		foreach (WavePos* pos, m_touchedPositions)
+			checkPosition(pos, step);
+	}
+	m_touchedWaves.clear();
+	m_touchedPositions.clear();
+	m_bTouchedAll = false;
+
+	for (int i = 0; i < EadViewCount; i++)
+	{
+		ViewInfo* view = m_file->viewInfo((EadView) i);
+		WaveInfo* wave = view->vwiUser.waveInfo();
+		QHash<ViewInfo*, WaveInfo*>::iterator it = m_userWaves.find(view);
+		if (it == m_userWaves.end())
+			m_userWaves.insert(view, wave);
+		else if (wave != *it)
+		{
+			step.userWaves.insert(view, *it);
+			*it = wave;
+		}
+	}
+
+	foreach (FilterTesterInfo* filter, m_file->filters())
+	{
+		const FilterState state = captureFilter(filter);
+		QHash<FilterTesterInfo*, FilterState>::iterator it = m_filters.find(filter);
+		if (it == m_filters.end())
+			m_filters.insert(filter, state);
+		else if (!(state == *it))
+		{
+			step.filters.insert(filter, *it);
+			*it = state;
+		}
+	}
+
+	if (m_file->comment() != m_sComment)
+	{
+		step.bComment = true;
+		step.sComment = m_sComment;
+		m_sComment = m_file->comment();
+	}
+
+	if (step.isEmpty())
+		return false;
+
+	m_redo.clear();
+	// The previous step already holds the state before both changes, so a merged change needs no more space
+	bool bMerge = (!m_undo.isEmpty() && m_timer.isValid() && m_timer.elapsed() < MERGE_INTERVAL && m_undo.last().canMerge(step));
+	if (!bMerge)
+	{
+		m_undo << step;
+		if (m_undo.size() > MAX_STEPS)
+			m_undo.removeFirst();
+	}
+	m_timer.start();
+	return true;
+}
+
+bool EditHistory::undo(Restored& restored)
+{
+	// Changes which haven't been recorded yet are undone first
+	checkpoint();
+	if (m_undo.isEmpty())
+		return false;
+
+	Step step = m_undo.takeLast();
+	swap(step, restored);
+	m_redo << step;
+	m_timer.invalidate();
+	return true;
+}
+
+bool EditHistory::redo(Restored& restored)
+{
+	// A change which hasn't been recorded yet discards the redo steps
+	checkpoint();
+	if (m_redo.isEmpty())
+		return false;
+
+	Step step = m_redo.takeLast();
+	swap(step, restored);
+	m_undo << step;
+	m_timer.invalidate();
+	return true;
+}
+
+void EditHistory::swap(Step& step, Restored& restored)
+{
+	m_bRestoring = true;
+
+	for (QHash<WaveInfo*, WaveState>::iterator it = step.waves.begin(); it != step.waves.end(); ++it)
+	{
+		WaveInfo* wave = it.key();
+		const WaveState state = it.value();
+		const WaveState current = m_waves.value(wave);
+
+		if (!(state.raw == current.raw))
+		{
+			wave->raw = state.raw;
+			if (state.raw.isEmpty() || current.raw.isEmpty())
+				restored.bWaveList = true;
+		}
+		wave->nRawToVoltageFactorNum = state.nRawToVoltageFactorNum;
+		wave->nRawToVoltageFactor = state.nRawToVoltageFactor;
+		wave->setShift(state.nShift);
+		wave->peaksChosen = state.peaksChosen;
+		wave->sName = state.sName;
+		wave->sComment = state.sComment;
+
+		if (!(state.raw == current.raw) || state.nRawToVoltageFactor != current.nRawToVoltageFactor)
+			restored.displayWaves << wave;
+		if (!(state.peaksChosen == current.peaksChosen))
+			restored.peakWaves << wave;
+
+		m_waves[wave] = state;
+		it.value() = current;
+	}
+
+	for (QHash<ViewInfo*, WaveInfo*>::iterator it = step.userWaves.begin(); it != step.userWaves.end(); ++it)
+	{
+		ViewInfo* view = it.key();
+		WaveInfo* current = m_userWaves.value(view);
+		view->setUserWave(it.value());
+		// setUserWave() resets the position, which is restored below if it was part of the step
+		view->posExtra = m_positions.value(&view->posExtra);
+		m_userWaves[view] = it.value();
+		it.value() = current;
+	}
+
+	for (QHash<WavePos*, WavePos>::iterator it = step.positions.begin(); it != step.positions.end(); ++it)
+	{
+		WavePos* pos = it.key();
+		const WavePos current = m_positions.value(pos);
+		*pos = it.value();
+		m_positions[pos] = it.value();
+		it.value() = current;
+	}
+
+	for (QHash<FilterTesterInfo*, FilterState>::iterator it = step.filters.begin(); it != step.filters.end(); ++it)
+	{
+		FilterTesterInfo* filter = it.key();
+		const FilterState current = m_filters.value(filter);
+		filter->setFilterId(it.value().filterId);
+		filter->setAllProperties(it.value().properties);
+		m_filters[filter] = it.value();
+		it.value() = current;
+		restored.bFilters = true;
+	}
+
+	if (step.bComment)
+	{
+		const QString sCurrent = m_sComment;
+		m_file->setComment(step.sComment);
+		m_sComment = step.sComment;
+		step.sComment = sCurrent;
+	}
+
+	m_bRestoring = false;
+}
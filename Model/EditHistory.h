@@ -0,0 +1,178 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __EDITHISTORY_H
+#define __EDITHISTORY_H
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QVariantMap>
+#include <QVector>
+
+#include "WaveInfo.h"
+
+
+class EadFile;
+class FilterTesterInfo;
+class ViewInfo;
+
+
+/// Undo and redo for the user's edits of an EadFile.
+/// Rather than needing a command object for every kind of edit, the history compares the editable state
+/// of the file with its state at the previous step whenever the file changes, and keeps only what differs.
+/// Edits say which waves and positions they touched, so that only those need to be compared;
+/// the view selections, filters and file comment are few enough to always be compared.
+/// The state is held in Qt's implicitly shared containers, so taking or restoring a step never copies
+/// the samples or marker lists: e.g. the samples of a deleted wave remain shared with the history until
+/// the step is discarded, and undoing the deletion just hands them back.
+class EditHistory
+{
+public:
+	/// What needs to be recalculated after undo() or redo()
+	struct Restored
+	{
+		/// Waves whose samples or voltage factor were restored, so that their display data is out of date
+		QList<WaveInfo*> displayWaves;
+		/// Waves whose markers were restored, so that their peak areas are out of date
+		QList<WaveInfo*> peakWaves;
+		/// True if a wave was deleted or restored, so that the views need to be updated
+		bool bWaveList;
+		/// True if the filter settings were restored, so that the display data of all waves is out of date
+		bool bFilters;
+
+		Restored()
+			: bWaveList(false), bFilters(false)
+		{
+		}
+	};
+
+public:
+	EditHistory(EadFile* file);
+
+	/// Forget all steps and take the current state of the file as the starting point
+	void clear();
+	/// Compare the wave with its state at the previous step at the next checkpoint().
+	/// A wave which isn't known yet is taken as it is.
+	void touch(WaveInfo* wave);
+	/// Compare the position with its state at the previous step at the next checkpoint()
+	void touch(WavePos* pos);
+	/// Compare all waves and positions at the next checkpoint(), for changes which don't say what they touched
+	void touchAll();
+	/// Take the wave's current samples as its state at the previous step, without recording a step,
+	/// e.g. for samples which a progressive load decoded after the history was started
+	void adoptSamples(WaveInfo* wave);
+	/// Save the changes since the previous step as a new step.
+	/// Changes which quickly follow the previous step and touch the same things, e.g. while the user
+	/// drags a wave or marker, are merged into it.
+	/// New waves are taken as they are, since adding a recording can't be undone.
+	/// @returns true if a step was added or extended
+	bool checkpoint();
+
+	bool canUndo() const { return !m_undo.isEmpty(); }
+	bool canRedo() const { return !m_redo.isEmpty(); }
+	/// Restore the state before the most recent step
+	/// @returns false if there was nothing to undo
+	bool undo(Restored& restored);
+	/// Restore the state after the most recently undone step
+	/// @returns false if there was nothing to redo
+	bool redo(Restored& restored);
+
+private:
+	/// The fields of a wave which the user can edit
+	struct WaveState
+	{
+		/// Empty for the averaged waves, whose samples are calculated from the others
+		QVector<short> raw;
+		int nRawToVoltageFactorNum;
+		double nRawToVoltageFactor;
+		int nShift;
+		QList<WavePeakChosenInfo> peaksChosen;
+		QString sName;
+		QString sComment;
+
+		bool operator==(const WaveState& other) const;
+	};
+
+	struct FilterState
+	{
+		int filterId;
+		QList<QVariantMap> properties;
+
+		bool operator==(const FilterState& other) const;
+	};
+
+	/// The parts of the state which differ between two consecutive steps.
+	/// Each holds its value on the other side of the step, so that undo and redo both just swap it with the file's.
+	struct Step
+	{
+		QHash<WaveInfo*, WaveState> waves;
+		QHash<WavePos*, WavePos> positions;
+		QHash<ViewInfo*, WaveInfo*> userWaves;
+		QHash<FilterTesterInfo*, FilterState> filters;
+		bool bComment;
+		QString sComment;
+		/// True if the samples of a wave changed, i.e. a wave was deleted
+		bool bSamples;
+
+		Step()
+			: bComment(false), bSamples(false)
+		{
+		}
+
+		bool isEmpty() const;
+		/// Whether the changes of 'next' can be folded into this step
+		bool canMerge(const Step& next) const;
+	};
+
+private:
+	static WaveState captureWave(const WaveInfo* wave);
+	static FilterState captureFilter(const FilterTesterInfo* filter);
+	/// Compare the wave with its saved state, and add it to the step if it has changed
+	void checkWave(WaveInfo* wave, Step& step);
+	/// Compare the position with its saved state, and add it to the step if it has changed
+	void checkPosition(WavePos* pos, Step& step);
+	/// Exchange the state in the step with the file's
+	void swap(Step& step, Restored& restored);
+
+private:
+	EadFile* const m_file;
+
+	/// The state at the most recent step
+	QHash<WaveInfo*, WaveState> m_waves;
+	QHash<WavePos*, WavePos> m_positions;
+	QHash<ViewInfo*, WaveInfo*> m_userWaves;
+	QHash<FilterTesterInfo*, FilterState> m_filters;
+	QString m_sComment;
+
+	/// What the next checkpoint() needs to compare
+	QSet<WaveInfo*> m_touchedWaves;
+	QSet<WavePos*> m_touchedPositions;
+	bool m_bTouchedAll;
+
+	QList<Step> m_undo;
+	QList<Step> m_redo;
+	/// Time since the last step was added or extended, for merging
+	QElapsedTimer m_timer;
+	/// True while swap() changes the file, so that the resulting change notifications are ignored
+	bool m_bRestoring;
+};
+
+#endif
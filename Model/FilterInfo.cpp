@@ -143,7 +143,12 @@ void FilterTesterInfo::setFilterId(int filterId)
 
 void FilterTesterInfo::filter(QVector<double>& signal)
 {
-	if (m_filterId == 0 || signal.size() == 0)
+	filter(m_filterId, signal);
+}
+
+void FilterTesterInfo::filter(int filterId, QVector<double>& signal)
+{
+	if (filterId == 0 || signal.size() == 0)
 		return;
 
 	double* x = signal.data();
@@ -152,7 +157,7 @@ void FilterTesterInfo::filter(QVector<double>& signal)
 	Filters* whitef = new Filters;
 	whitef->calcWhiteningFilterYW(x);
 
-	if (m_filterId == 1) {
+	if (filterId == 1) {
 		whitef->calcNWMFFilter();
 		double* xy = new double[whitef->get_NWMFlen()+len-1];
 		whitef->convolve_NWMF(x,len,xy);
@@ -163,7 +168,7 @@ void FilterTesterInfo::filter(QVector<double>& signal)
 		}
 		delete[] xy;
 	}
-	else if (m_filterId == 2) {
+	else if (filterId == 2) {
 		whitef->calcWienerFilter();
 		double* xy = new double[whitef->get_wienerFiltlen() + len - 1];
 		whitef->convolve_wiener(x, len, xy);
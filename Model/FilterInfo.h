@@ -109,6 +109,10 @@ public:
 	void filter(QVector<double>& data);
 
 public:
+	/// Apply the filter with the given id to the signal.
+	/// This doesn't touch any FilterTesterInfo state, so it may be called from worker threads.
+	static void filter(int filterId, QVector<double>& signal);
+
 	//WaveType waveType() const { return m_waveType; }
 	int filterCount() const;
 
@@ -117,6 +121,9 @@ public:
 	/// @param filterId 0 means no filter.  filterId must be <= filterCount()
 	void setFilterId(int filterId);
 	QVariantMap& properties(int filterId) { return m_properties[filterId]; }
+	/// The properties of all filters, indexed by filter id
+	const QList<QVariantMap>& allProperties() const { return m_properties; }
+	void setAllProperties(const QList<QVariantMap>& properties) { m_properties = properties; }
 
 private:
 	//const WaveType m_waveType;
@@ -38,8 +38,12 @@ GlobalVars::GlobalVars()
 	m_idacSettings = new IdacSettings();
 
 	m_idacSettings->bRecordOnTrigger = false;
+	m_idacSettings->nPreTrigger_s = 10;
 	m_idacSettings->nRecordingDuration = 180;
+	m_idacSettings->bContinuous = false;
 	m_idacSettings->nGcDelay_ms = 0;
+	for (int i = 0; i < 3; i++)
+		m_idacSettings->anLiveLowpass_Hz[i] = 0;
 }
 
 GlobalVars::~GlobalVars()
@@ -88,7 +92,9 @@ void GlobalVars::readIdacChannelSettings(const QString& sIdacName)
 
 	settings.beginGroup("Hardware-" + sIdacName);
 	m_idacSettings->bRecordOnTrigger = settings.value("RecordOnTrigger", false).toBool();
+	m_idacSettings->nPreTrigger_s = settings.value("PreTrigger", 10).toInt();
 	m_idacSettings->nRecordingDuration = settings.value("RecordingDuration", 0).toInt();
+	m_idacSettings->bContinuous = settings.value("Continuous", false).toBool();
 	m_idacSettings->nGcDelay_ms = settings.value("GcDelay", 0).toInt();
 
 	IdacChannelSettings* chan = &m_idacSettings->channels[0];
@@ -102,6 +108,7 @@ void GlobalVars::readIdacChannelSettings(const QString& sIdacName)
 	chan->iLowcut = settings.value("EAD_Lowcut", chan->iLowcut).toInt();
 	chan->nOffset = settings.value("EAD_Offset", chan->nOffset).toInt();
 	chan->nExternalAmplification = settings.value("EAD_ExternalAmplification", chan->nExternalAmplification).toInt();
+	m_idacSettings->anLiveLowpass_Hz[1] = settings.value("EAD_LiveLowpass", 0).toDouble();
 
 	chan = &m_idacSettings->channels[2];
 	chan->mInvert = settings.value("FID_Invert", chan->mInvert).toInt();
@@ -110,6 +117,7 @@ void GlobalVars::readIdacChannelSettings(const QString& sIdacName)
 	chan->iLowcut = settings.value("FID_Lowcut", chan->iLowcut).toInt();
 	chan->nOffset = settings.value("FID_Offset", chan->nOffset).toInt();
 	chan->nExternalAmplification = settings.value("FID_ExternalAmplification", chan->nExternalAmplification).toInt();
+	m_idacSettings->anLiveLowpass_Hz[2] = settings.value("FID_LiveLowpass", 0).toDouble();
 	settings.endGroup();
 }
 
@@ -152,7 +160,9 @@ void GlobalVars::writeIdacChannelSettings(const QString& sIdacName)
 
 	settings.beginGroup("Hardware-" + sIdacName);
 	settings.setValue("RecordOnTrigger", m_idacSettings->bRecordOnTrigger);
+	settings.setValue("PreTrigger", m_idacSettings->nPreTrigger_s);
 	settings.setValue("RecordingDuration", m_idacSettings->nRecordingDuration);
+	settings.setValue("Continuous", m_idacSettings->bContinuous);
 	settings.setValue("GcDelay", m_idacSettings->nGcDelay_ms);
 	
 	settings.setValue("DIG_Enabled", m_idacSettings->channels[0].mEnabled);
@@ -164,6 +174,7 @@ void GlobalVars::writeIdacChannelSettings(const QString& sIdacName)
 	settings.setValue("EAD_Lowcut", m_idacSettings->channels[1].iLowcut);
 	settings.setValue("EAD_Offset", m_idacSettings->channels[1].nOffset);
 	settings.setValue("EAD_ExternalAmplification", m_idacSettings->channels[1].nExternalAmplification);
+	settings.setValue("EAD_LiveLowpass", m_idacSettings->anLiveLowpass_Hz[1]);
 	
 	settings.setValue("FID_Invert", m_idacSettings->channels[2].mInvert);
 	settings.setValue("FID_Range", m_idacSettings->channels[2].iRange);
@@ -171,6 +182,7 @@ void GlobalVars::writeIdacChannelSettings(const QString& sIdacName)
 	settings.setValue("FID_Lowcut", m_idacSettings->channels[2].iLowcut);
 	settings.setValue("FID_Offset", m_idacSettings->channels[2].nOffset);
 	settings.setValue("FID_ExternalAmplification", m_idacSettings->channels[2].nExternalAmplification);
+	settings.setValue("FID_LiveLowpass", m_idacSettings->anLiveLowpass_Hz[2]);
 	settings.endGroup();
 }
 
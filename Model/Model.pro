@@ -1,16 +1,32 @@
 TEMPLATE = lib
-QT += xml svg
+QT += xml svg concurrent sql
 CONFIG += warn_on staticlib create_prl debug_and_release
 DEFINES += QT_XML_LIB QT_SVG_LIB
 INCLUDEPATH += . .. ../Core
 DEPENDPATH += . .. ../Core
 
 HEADERS += AppDefines.h ChartPixmap.h EadEnums.h EadFile.h Globals.h PublisherSettings.h RecInfo.h RenderData.h ViewInfo.h ViewSettings.h WaveInfo.h \
-	FilterInfo.h
+	Catalog.h \
+	DerivedCache.h \
+	EditHistory.h \
+	FilterInfo.h \
+	MonitorHistory.h \
+	SampleStore.h \
+	StreamFilter.h \
+	TextImporter.h \
+	WaveExporter.h
 	#PropertyRowModel.h \
 	#Datastore.h
 SOURCES += ChartPixmap.cpp EadFile.cpp FakeData.cpp Globals.cpp PublisherSettings.cpp RecInfo.cpp RenderData.cpp ViewInfo.cpp WaveInfo.cpp \
+    Catalog.cpp \
+    DerivedCache.cpp \
+    EditHistory.cpp \
     FilterInfo.cpp \
+    MonitorHistory.cpp \
+    SampleStore.cpp \
+    StreamFilter.cpp \
+    TextImporter.cpp \
+    WaveExporter.cpp \
     PropertyRowModel.cpp \
 	#Datastore.cpp
 
@@ -0,0 +1,587 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "MonitorHistory.h"
+
+#include <math.h>
+#include <string.h>
+
+#include <QtDebug>
+#include <QDataStream>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+
+#include <Check.h>
+
+#include "WaveInfo.h"
+
+
+/// Identifies segment files
+static const char g_sSegmentMagic[8] = { 'G', 'C', 'E', 'A', 'D', 'S', 'E', 'G' };
+/// Version of the segment file format
+static const qint32 g_nSegmentVersion = 1;
+/// Identifies the summary file
+static const char g_sSummaryMagic[8] = { 'G', 'C', 'E', 'A', 'D', 'S', 'U', 'M' };
+/// Version of the summary file format
+static const qint32 g_nSummaryVersion = 1;
+/// Name of the summary file
+static const char* g_sSummaryName = "summary.gcsum";
+
+/// Number of summary levels per channel
+const int g_nSummaryLevels = 6;
+/// Number of buckets held by each level
+const int g_nSummaryCapacity = 4096;
+/// Samples per bucket of the finest level (a tenth of a second)
+const int g_nSummaryFinestWidth = 10;
+/// Factor between the widths of two neighbouring levels
+const int g_nSummaryLevelRatio = 4;
+/// Number of segments which are kept in memory after being read back in
+const int g_nPageCount = 8;
+
+
+static void combine(MinMax& mm, const MinMax& other)
+{
+	if (other.yBot < mm.yBot)
+		mm.yBot = other.yBot;
+	if (other.yTop > mm.yTop)
+		mm.yTop = other.yTop;
+}
+
+
+static QDataStream& operator<<(QDataStream& str, const MinMax& mm)
+{
+	return str << mm.yBot << mm.yTop;
+}
+
+static QDataStream& operator>>(QDataStream& str, MinMax& mm)
+{
+	return str >> mm.yBot >> mm.yTop;
+}
+
+
+MonitorHistory::MonitorHistory()
+{
+	m_bWriting = false;
+	m_nSpilled = 0;
+}
+
+int MonitorHistory::channel(WaveType type)
+{
+	switch (type)
+	{
+	case WaveType_Digital: return 0;
+	case WaveType_EAD: return 1;
+	case WaveType_FID: return 2;
+	}
+	return 0;
+}
+
+bool MonitorHistory::open(const QString& sDir)
+{
+	CHECK_PRECOND_RETVAL(!isOpen(), false);
+
+	QString sName = "monitor-" + QDateTime::currentDateTime().toString("yyyyMMdd-hhmmss");
+	QDir dir(sDir);
+	if (!dir.mkpath(sName))
+	{
+		qDebug() << "MonitorHistory: couldn't create" << dir.filePath(sName);
+		return false;
+	}
+	m_sDir = dir.filePath(sName);
+	m_bWriting = true;
+	m_nSpilled = 0;
+	m_segments.clear();
+	m_pages.clear();
+
+	for (int iChan = 0; iChan < 3; iChan++)
+	{
+		QVector<Level>& levels = m_levels[iChan];
+		levels.resize(g_nSummaryLevels);
+		qint64 nWidth = g_nSummaryFinestWidth;
+		for (int iLevel = 0; iLevel < g_nSummaryLevels; iLevel++)
+		{
+			Level& level = levels[iLevel];
+			level.nWidth = nWidth;
+			level.nPerBucket = (iLevel == 0) ? g_nSummaryFinestWidth : g_nSummaryLevelRatio;
+			// The last level grows up to the capacity and is then halved
+			level.buckets.clear();
+			if (iLevel < g_nSummaryLevels - 1)
+				level.buckets.resize(g_nSummaryCapacity);
+			else
+				level.buckets.reserve(g_nSummaryCapacity);
+			level.iEnd = 0;
+			level.nCurrent = 0;
+			nWidth *= g_nSummaryLevelRatio;
+		}
+	}
+
+	return true;
+}
+
+bool MonitorHistory::finish()
+{
+	CHECK_PRECOND_RETVAL(m_bWriting, false);
+
+	m_bWriting = false;
+	if (!writeSummary())
+	{
+		qDebug() << "MonitorHistory: couldn't write the summary to" << m_sDir;
+		return false;
+	}
+	return true;
+}
+
+bool MonitorHistory::attach(const QString& sDir)
+{
+	CHECK_PRECOND_RETVAL(!isOpen(), false);
+
+	m_sDir = sDir;
+	m_bWriting = false;
+	m_pages.clear();
+	// Without the summary (e.g. if the program stopped while recording), the segments themselves are still there
+	if (!readSummary() && !scanSegments())
+	{
+		close();
+		return false;
+	}
+
+	m_nSpilled = 0;
+	if (!m_segments.isEmpty())
+		m_nSpilled = m_segments.last().iFirstSample + m_segments.last().nSamples;
+	return true;
+}
+
+void MonitorHistory::close()
+{
+	m_sDir.clear();
+	m_bWriting = false;
+	m_nSpilled = 0;
+	m_segments.clear();
+	m_pages.clear();
+	for (int iChan = 0; iChan < 3; iChan++)
+		m_levels[iChan].clear();
+}
+
+void MonitorHistory::addSamples(int iChan, const double* data, int nSamples)
+{
+	CHECK_PARAM_RET(iChan >= 0 && iChan < 3);
+	CHECK_PARAM_RET(data != NULL || nSamples == 0);
+	if (m_levels[iChan].isEmpty())
+		return;
+
+	MinMax mm;
+	for (int i = 0; i < nSamples; i++)
+	{
+		mm.yBot = mm.yTop = data[i];
+		add(iChan, 0, mm);
+	}
+}
+
+void MonitorHistory::add(int iChan, int iLevel, const MinMax& mm)
+{
+	QVector<Level>& levels = m_levels[iChan];
+	Level& level = levels[iLevel];
+
+	if (level.nCurrent == 0)
+		level.current = mm;
+	else
+		combine(level.current, mm);
+	level.nCurrent++;
+	if (level.nCurrent < level.nPerBucket)
+		return;
+
+	const MinMax done = level.current;
+	level.nCurrent = 0;
+
+	if (iLevel < levels.size() - 1)
+	{
+		level.buckets[level.iEnd % level.buckets.size()] = done;
+		level.iEnd++;
+		add(iChan, iLevel + 1, done);
+	}
+	else
+	{
+		level.buckets << done;
+		level.iEnd++;
+		// Halve the resolution, so that this level keeps covering the whole history.
+		// The number of buckets is even here, so the bucket being filled stays aligned.
+		if (level.buckets.size() >= g_nSummaryCapacity)
+		{
+			const int n = level.buckets.size() / 2;
+			MinMax* buckets = level.buckets.data();
+			for (int i = 0; i < n; i++)
+			{
+				buckets[i] = buckets[2 * i];
+				combine(buckets[i], buckets[2 * i + 1]);
+			}
+			level.buckets.resize(n);
+			level.iEnd = n;
+			level.nWidth *= 2;
+			level.nPerBucket *= 2;
+		}
+	}
+}
+
+bool MonitorHistory::spill(const WaveInfo* digital, const WaveInfo* ead, const WaveInfo* fid, int nSamples)
+{
+	CHECK_PRECOND_RETVAL(m_bWriting, false);
+	CHECK_PARAM_RETVAL(digital != NULL && ead != NULL && fid != NULL, false);
+	CHECK_PARAM_RETVAL(nSamples > 0, false);
+
+	Segment segment;
+	segment.sName = QString("segment-%0.gcseg").arg(m_segments.size() + 1, 6, 10, QChar('0'));
+	segment.iFirstSample = m_nSpilled;
+	segment.nSamples = nSamples;
+
+	QString sFilename = QDir(m_sDir).filePath(segment.sName);
+	QFile file(sFilename);
+	if (!file.open(QIODevice::WriteOnly))
+	{
+		qDebug() << "MonitorHistory: couldn't write" << sFilename;
+		return false;
+	}
+
+	QDataStream str(&file);
+	str.setVersion(QDataStream::Qt_4_3);
+	str.writeRawData(g_sSegmentMagic, sizeof(g_sSegmentMagic));
+	str << g_nSegmentVersion << qint64(m_nSpilled) << qint32(nSamples);
+
+	const WaveInfo* waves[3] = { digital, ead, fid };
+	for (int i = 0; i < 3; i++)
+	{
+		const WaveInfo* wave = waves[i];
+		CHECK_ASSERT_RETVAL(wave->raw.size() >= nSamples, false);
+		str << qint32(wave->type) << qint32(wave->nRawToVoltageFactorNum) << qint32(wave->nRawToVoltageFactorDen);
+		str << wave->raw.mid(0, nSamples);
+	}
+
+	if (str.status() != QDataStream::Ok)
+	{
+		qDebug() << "MonitorHistory: error while writing" << sFilename;
+		return false;
+	}
+
+	m_segments << segment;
+	m_nSpilled += nSamples;
+	return true;
+}
+
+bool MonitorHistory::writeSummary() const
+{
+	QFile file(QDir(m_sDir).filePath(g_sSummaryName));
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	QDataStream str(&file);
+	str.setVersion(QDataStream::Qt_4_3);
+	str.writeRawData(g_sSummaryMagic, sizeof(g_sSummaryMagic));
+	str << g_nSummaryVersion;
+
+	str << qint32(m_segments.size());
+	foreach (const Segment& segment, m_segments)
+		str << segment.sName << segment.iFirstSample << qint32(segment.nSamples);
+
+	for (int iChan = 0; iChan < 3; iChan++)
+	{
+		const QVector<Level>& levels = m_levels[iChan];
+		str << qint32(levels.size());
+		foreach (const Level& level, levels)
+		{
+			str << level.nWidth << qint32(level.nPerBucket) << level.iEnd;
+			str << level.current << qint32(level.nCurrent);
+			str << level.buckets;
+		}
+	}
+
+	return (str.status() == QDataStream::Ok);
+}
+
+bool MonitorHistory::readSummary()
+{
+	QFile file(QDir(m_sDir).filePath(g_sSummaryName));
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QDataStream str(&file);
+	str.setVersion(QDataStream::Qt_4_3);
+	char magic[sizeof(g_sSummaryMagic)];
+	qint32 nVersion = 0;
+	if (str.readRawData(magic, sizeof(magic)) != int(sizeof(magic)) || memcmp(magic, g_sSummaryMagic, sizeof(magic)) != 0)
+		return false;
+	str >> nVersion;
+	if (nVersion != g_nSummaryVersion)
+		return false;
+
+	qint32 nSegments = 0;
+	str >> nSegments;
+	m_segments.clear();
+	for (int i = 0; i < nSegments && str.status() == QDataStream::Ok; i++)
+	{
+		Segment segment;
+		qint32 nSamples = 0;
+		str >> segment.sName >> segment.iFirstSample >> nSamples;
+		segment.nSamples = nSamples;
+		m_segments << segment;
+	}
+
+	for (int iChan = 0; iChan < 3; iChan++)
+	{
+		QVector<Level>& levels = m_levels[iChan];
+		qint32 nLevels = 0;
+		str >> nLevels;
+		levels.resize(qBound(0, int(nLevels), g_nSummaryLevels));
+		for (int iLevel = 0; iLevel < levels.size(); iLevel++)
+		{
+			Level& level = levels[iLevel];
+			qint32 nPerBucket = 0, nCurrent = 0;
+			str >> level.nWidth >> nPerBucket >> level.iEnd;
+			str >> level.current >> nCurrent;
+			str >> level.buckets;
+			level.nPerBucket = nPerBucket;
+			level.nCurrent = nCurrent;
+			// Only the coarsest level may be empty, the others are rings
+			if (level.nWidth <= 0 || (iLevel < levels.size() - 1 && level.buckets.isEmpty()))
+				str.setStatus(QDataStream::ReadCorruptData);
+		}
+	}
+
+	if (str.status() != QDataStream::Ok)
+	{
+		m_segments.clear();
+		for (int iChan = 0; iChan < 3; iChan++)
+			m_levels[iChan].clear();
+		return false;
+	}
+	return true;
+}
+
+bool MonitorHistory::scanSegments()
+{
+	m_segments.clear();
+	QDir dir(m_sDir);
+	foreach (const QString& sName, dir.entryList(QStringList("segment-*.gcseg"), QDir::Files, QDir::Name))
+	{
+		QFile file(dir.filePath(sName));
+		if (!file.open(QIODevice::ReadOnly))
+			break;
+		QDataStream str(&file);
+		str.setVersion(QDataStream::Qt_4_3);
+		char magic[sizeof(g_sSegmentMagic)];
+		qint32 nVersion = 0, nSamples = 0;
+		Segment segment;
+		if (str.readRawData(magic, sizeof(magic)) != int(sizeof(magic)) || memcmp(magic, g_sSegmentMagic, sizeof(magic)) != 0)
+			break;
+		str >> nVersion >> segment.iFirstSample >> nSamples;
+		// The segments must follow on from each other
+		qint64 iExpected = (m_segments.isEmpty()) ? 0 : m_segments.last().iFirstSample + m_segments.last().nSamples;
+		if (str.status() != QDataStream::Ok || nVersion != g_nSegmentVersion || segment.iFirstSample != iExpected || nSamples <= 0)
+			break;
+		segment.sName = sName;
+		segment.nSamples = nSamples;
+		m_segments << segment;
+	}
+	return !m_segments.isEmpty();
+}
+
+const MonitorHistory::Page* MonitorHistory::page(int iSegment) const
+{
+	CHECK_PARAM_RETVAL(iSegment >= 0 && iSegment < m_segments.size(), NULL);
+
+	for (int i = 0; i < m_pages.size(); i++)
+	{
+		if (m_pages[i].iSegment == iSegment)
+		{
+			if (i > 0)
+				m_pages.move(i, 0);
+			return &m_pages.first();
+		}
+	}
+
+	const Segment& segment = m_segments[iSegment];
+	QFile file(QDir(m_sDir).filePath(segment.sName));
+	if (!file.open(QIODevice::ReadOnly))
+	{
+		qDebug() << "MonitorHistory: couldn't read" << file.fileName();
+		return NULL;
+	}
+
+	QDataStream str(&file);
+	str.setVersion(QDataStream::Qt_4_3);
+	char magic[sizeof(g_sSegmentMagic)];
+	qint32 nVersion = 0, nSamples = 0;
+	qint64 iFirstSample = 0;
+	if (str.readRawData(magic, sizeof(magic)) != int(sizeof(magic)) || memcmp(magic, g_sSegmentMagic, sizeof(magic)) != 0)
+		return NULL;
+	str >> nVersion >> iFirstSample >> nSamples;
+	if (nVersion != g_nSegmentVersion || iFirstSample != segment.iFirstSample || nSamples != segment.nSamples)
+		return NULL;
+
+	Page page;
+	page.iSegment = iSegment;
+	for (int i = 0; i < 3; i++)
+	{
+		qint32 nType = 0, nNum = 0, nDen = 0;
+		QVector<short> raw;
+		str >> nType >> nNum >> nDen >> raw;
+		if (str.status() != QDataStream::Ok || nType < 0 || nType > WaveType_Digital || nDen == 0 || raw.size() != nSamples)
+		{
+			qDebug() << "MonitorHistory: error while reading" << file.fileName();
+			return NULL;
+		}
+
+		// Convert to the same units as the waves' display data
+		const double nFactor = double(nNum) / nDen;
+		QVector<double>& display = page.display[channel(WaveType(nType))];
+		display.resize(nSamples);
+		for (int iSample = 0; iSample < nSamples; iSample++)
+			display[iSample] = raw[iSample] * nFactor;
+	}
+
+	m_pages.prepend(page);
+	while (m_pages.size() > g_nPageCount)
+		m_pages.removeLast();
+	return &m_pages.first();
+}
+
+int MonitorHistory::segmentAt(qint64 iSample) const
+{
+	// Binary search for the last segment which starts at or before iSample
+	int iLow = 0;
+	int iHigh = m_segments.size() - 1;
+	while (iLow < iHigh)
+	{
+		int iMid = (iLow + iHigh + 1) / 2;
+		if (m_segments[iMid].iFirstSample <= iSample)
+			iLow = iMid;
+		else
+			iHigh = iMid - 1;
+	}
+	return iLow;
+}
+
+bool MonitorHistory::pagedMinMax(int iChan, qint64 iSample0, qint64 iSample1, MinMax& mm) const
+{
+	iSample0 = qMax(iSample0, qint64(0));
+	iSample1 = qMin(iSample1, m_nSpilled);
+	if (iSample0 >= iSample1 || m_segments.isEmpty())
+		return false;
+
+	bool bAny = false;
+	for (int iSegment = segmentAt(iSample0); iSegment < m_segments.size(); iSegment++)
+	{
+		const Segment& segment = m_segments[iSegment];
+		if (segment.iFirstSample >= iSample1)
+			break;
+		const Page* p = page(iSegment);
+		if (p == NULL)
+			return false;
+
+		const QVector<double>& display = p->display[iChan];
+		const int iStart = int(qMax(iSample0 - segment.iFirstSample, qint64(0)));
+		const int iEnd = int(qMin(iSample1 - segment.iFirstSample, qint64(segment.nSamples)));
+		for (int i = iStart; i < iEnd; i++)
+		{
+			const double n = display[i];
+			if (!bAny)
+			{
+				mm.yBot = mm.yTop = n;
+				bAny = true;
+			}
+			else if (n < mm.yBot)
+				mm.yBot = n;
+			else if (n > mm.yTop)
+				mm.yTop = n;
+		}
+	}
+	return bAny;
+}
+
+void MonitorHistory::summarize(int iChan, qint64 iSampleOrigin, double nSamplesPerPixel, int iPixelFirst, int nPixels, QVector<MinMax>& pixels) const
+{
+	CHECK_PARAM_RET(iChan >= 0 && iChan < 3);
+	CHECK_PARAM_RET(nSamplesPerPixel > 0);
+
+	pixels.resize(qMax(nPixels, 0));
+	const QVector<Level>& levels = m_levels[iChan];
+	if (levels.isEmpty() && m_segments.isEmpty())
+		return;
+
+	// Only read the segment files back in if the pixels don't need more of them than can be cached;
+	// otherwise the summaries are fine enough
+	bool bPaging = false;
+	if (nPixels > 0 && !m_segments.isEmpty())
+	{
+		const qint64 iSampleFirst = iSampleOrigin + qint64(floor(iPixelFirst * nSamplesPerPixel + 0.5));
+		const qint64 iSampleEnd = iSampleOrigin + qint64(floor((iPixelFirst + nPixels) * nSamplesPerPixel + 0.5));
+		bPaging = (iSampleFirst < m_nSpilled && segmentAt(qMin(iSampleEnd, m_nSpilled) - 1) - segmentAt(iSampleFirst) < g_nPageCount);
+	}
+
+	const int iLevelLast = levels.size() - 1;
+	for (int i = 0; i < nPixels; i++)
+	{
+		const qint64 iSample0 = iSampleOrigin + qint64(floor((iPixelFirst + i) * nSamplesPerPixel + 0.5));
+		const qint64 iSample1 = iSampleOrigin + qint64(floor((iPixelFirst + i + 1) * nSamplesPerPixel + 0.5));
+
+		// Find the finest level which still covers the pixel, but don't use a level finer than the pixel
+		int iLevel = 0;
+		while (iLevel < iLevelLast && levels[iLevel].first(true) * levels[iLevel].nWidth > iSample0)
+			iLevel++;
+		while (iLevel < iLevelLast && levels[iLevel + 1].nWidth <= nSamplesPerPixel)
+			iLevel++;
+
+		// Read the samples themselves where the summaries are coarser than the pixel
+		if (bPaging && (levels.isEmpty() || levels[iLevel].nWidth > nSamplesPerPixel) && pagedMinMax(iChan, iSample0, iSample1, pixels[i]))
+			continue;
+		if (levels.isEmpty())
+		{
+			pixels[i] = (i > 0) ? pixels[i - 1] : MinMax();
+			continue;
+		}
+
+		const Level& level = levels[iLevel];
+		const bool bRing = (iLevel < iLevelLast);
+		qint64 iBucket = qMax(iSample0 / level.nWidth, level.first(bRing));
+		qint64 iBucketLast = (iSample1 - 1) / level.nWidth;
+
+		bool bAny = false;
+		MinMax mm;
+		for (; iBucket <= iBucketLast && iBucket < level.iEnd; iBucket++)
+		{
+			const MinMax& bucket = level.buckets[(bRing) ? int(iBucket % level.buckets.size()) : int(iBucket)];
+			if (!bAny)
+				mm = bucket;
+			else
+				combine(mm, bucket);
+			bAny = true;
+		}
+		// Include the bucket which is still being filled
+		if (iBucketLast >= level.iEnd && level.nCurrent > 0 && iSample1 > iSample0)
+		{
+			if (!bAny)
+				mm = level.current;
+			else
+				combine(mm, level.current);
+			bAny = true;
+		}
+
+		if (bAny)
+			pixels[i] = mm;
+		else
+			pixels[i] = (i > 0) ? pixels[i - 1] : MinMax();
+	}
+}
@@ -0,0 +1,144 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __MONITORHISTORY_H
+#define __MONITORHISTORY_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "EadEnums.h"
+#include "RenderData.h"
+
+
+class WaveInfo;
+
+
+/// History of a continuous recording, which runs for longer than its samples can be kept in memory.
+///
+/// Samples which are removed from the front of the recording's waves are written to segment files on disk,
+/// and min/max summaries of all samples are kept at several resolutions so that the whole history can still be scrolled.
+/// The memory used doesn't depend on how long the recording runs:
+/// the finer levels only cover the recent past, and the coarsest level halves its resolution whenever it fills up.
+///
+/// Once the recording has stopped, the history stays attached to it (see RecInfo::monitorHistory()),
+/// and the chart pages the segments back in when it's scrolled to before the recording's first sample.
+///
+/// Each segment file starts with the magic "GCEADSEG", a qint32 version, the qint64 index of its first sample
+/// and the qint32 number of samples.  Then for each wave (digital, EAD, FID) follow the qint32 wave type,
+/// the qint32 raw-to-voltage numerator and denominator, and a QVector<short> with the raw data.
+///
+/// When the recording stops, finish() writes the file "summary.gcsum", so that the history can be attached
+/// again without reading every segment.  It starts with the magic "GCEADSUM" and a qint32 version,
+/// followed by the qint32 number of segments and their file names, first samples and sample counts.
+/// Then for each channel come the qint32 number of levels and the state of each level.
+class MonitorHistory
+{
+public:
+	MonitorHistory();
+
+	/// Start a new history, with its segment files in a new subdirectory of sDir
+	bool open(const QString& sDir);
+	/// Stop adding to the history and save its summaries; it can still be read afterwards
+	bool finish();
+	/// Attach to the history which was written to sDir, in order to read it
+	bool attach(const QString& sDir);
+	void close();
+	bool isOpen() const { return !m_sDir.isEmpty(); }
+	/// True between open() and finish()
+	bool isWriting() const { return m_bWriting; }
+	/// Directory containing the segment files
+	const QString& directory() const { return m_sDir; }
+
+	/// Index of the channel which holds waves of the given type
+	static int channel(WaveType type);
+
+	/// Add the display data of newly recorded samples to the summaries of the given channel.
+	/// All channels must be given the same number of samples.
+	void addSamples(int iChan, const double* data, int nSamples);
+	/// Write the first nSamples samples of the given waves to a new segment file.
+	/// The caller then removes them from the waves.
+	bool spill(const WaveInfo* digital, const WaveInfo* ead, const WaveInfo* fid, int nSamples);
+	/// Number of samples which were written to disk
+	qint64 spilledSamples() const { return m_nSpilled; }
+
+	/// Fill pixels from the summaries.  Where the summaries are coarser than the pixels,
+	/// the samples are read back from the segment files instead.
+	/// Pixel i covers the samples from iSampleOrigin + floor((iPixelFirst + i) * nSamplesPerPixel + 0.5) up to the start of the next pixel.
+	void summarize(int iChan, qint64 iSampleOrigin, double nSamplesPerPixel, int iPixelFirst, int nPixels, QVector<MinMax>& pixels) const;
+
+private:
+	/// Min/max buckets of one resolution
+	struct Level
+	{
+		/// Number of samples per bucket
+		qint64 nWidth;
+		/// Number of buckets of the next finer level (or samples for level 0) per bucket
+		int nPerBucket;
+		/// Completed buckets.  All levels but the last are rings.
+		QVector<MinMax> buckets;
+		/// Number of buckets completed so far
+		qint64 iEnd;
+		/// Bucket being filled, and how many finer buckets (or samples) it holds
+		MinMax current;
+		int nCurrent;
+
+		/// Index of the oldest completed bucket which is still held
+		qint64 first(bool bRing) const { return (bRing) ? qMax(iEnd - buckets.size(), qint64(0)) : 0; }
+	};
+
+	/// A segment file
+	struct Segment
+	{
+		QString sName;
+		qint64 iFirstSample;
+		int nSamples;
+	};
+
+	/// Display data of a segment which has been read back in
+	struct Page
+	{
+		int iSegment;
+		QVector<double> display[3];
+	};
+
+	void add(int iChan, int iLevel, const MinMax& mm);
+	bool writeSummary() const;
+	bool readSummary();
+	/// Rebuild the list of segments from the segment files themselves
+	bool scanSegments();
+	/// Read the given segment, or take it from the cache
+	const Page* page(int iSegment) const;
+	/// Index of the segment which holds the given sample
+	int segmentAt(qint64 iSample) const;
+	/// Combine the samples from iSample0 up to iSample1 read back from the segment files
+	bool pagedMinMax(int iChan, qint64 iSample0, qint64 iSample1, MinMax& mm) const;
+
+private:
+	QString m_sDir;
+	bool m_bWriting;
+	qint64 m_nSpilled;
+	/// Segment files in the order of their samples
+	QVector<Segment> m_segments;
+	/// Per channel, the summary levels from finest to coarsest
+	QVector<Level> m_levels[3];
+	/// Recently read segments, most recently used first
+	mutable QList<Page> m_pages;
+};
+
+#endif
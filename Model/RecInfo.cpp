@@ -18,12 +18,14 @@
 #include "RecInfo.h"
 
 #include "EadFile.h"
+#include "MonitorHistory.h"
 
 
 RecInfo::RecInfo(EadFile* file, int id)
 	: QObject(file), m_file(file)
 {
 	m_id = id;
+	m_history = NULL;
 	//m_nShift = 0;
 
 	for (int i = 0; i < WaveTypeCount; i++)
@@ -34,6 +36,16 @@ RecInfo::~RecInfo()
 {
 	qDeleteAll(m_waves);
 	m_waves.clear();
+	delete m_history;
+}
+
+void RecInfo::setMonitorHistory(MonitorHistory* history)
+{
+	if (history != m_history)
+	{
+		delete m_history;
+		m_history = history;
+	}
 }
 
 /*void RecInfo::setShift(int nShift)
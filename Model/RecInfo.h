@@ -26,6 +26,7 @@
 
 
 class EadFile;
+class MonitorHistory;
 
 
 class RecInfo : public QObject
@@ -56,6 +57,12 @@ public:
 	const WaveInfo* wave(WaveType type) const { return m_waves[type]; }
 	const QList<WaveInfo*>& waves() const { return m_waves; }
 
+	/// History of the continuous monitoring which preceded the samples of this recording, or NULL.
+	/// Sample iSample of a wave corresponds to sample spilledSamples() + iSample of the history.
+	MonitorHistory* monitorHistory() const { return m_history; }
+	/// Attach a history to the recording, which takes ownership of it
+	void setMonitorHistory(MonitorHistory* history);
+
 private:
 	WaveInfo* createWave(WaveType type);
 
@@ -65,6 +72,7 @@ private:
 	QList<WaveInfo*> m_waves;
 	/// Date/time of recording
 	QDateTime m_time;
+	MonitorHistory* m_history;
 	//int m_nShift;
 };
 
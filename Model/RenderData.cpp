@@ -206,3 +206,81 @@ void RenderData::renderStd(ViewWaveInfo* vwi, int tidxStart_, int nPixels_, doub
 		}
 	}
 }
+
+bool RenderData::renderPreview(ViewWaveInfo* vwi, int tidxStart_, int nPixels_, double nSamplesPerPixel_, const RenderPreview& preview)
+{
+	CHECK_PARAM_RETVAL(vwi != NULL, false);
+	CHECK_PARAM_RETVAL(vwi->wave() != NULL && vwi->isVisible(), false);
+
+	// The preview only makes sense when each pixel summarizes at least one sample
+	if (nSamplesPerPixel_ < 1 || preview.nSamplesPerPixel != nSamplesPerPixel_)
+		return false;
+
+	setup(vwi, tidxStart_, nPixels_, nSamplesPerPixel_);
+
+	pixels.resize(nPixels);
+	if (nPixels == 0)
+	{
+		prependPreviewBeforeData(vwi, preview);
+		return true;
+	}
+
+	const WaveInfo* wave = vwi->wave();
+	const double* data = wave->display.constData();
+	MinMax* pixdata = pixels.data();
+
+	const int iPixelFirst = int(didxFirst / nSamplesPerPixel);
+	const int iPreviewEnd = preview.iPixelFirst + preview.pixels.size();
+	for (int i = 0; i < nPixels; i++)
+	{
+		int iPixel = iPixelFirst + i;
+		if (iPixel >= preview.iPixelFirst && iPixel < iPreviewEnd)
+		{
+			pixdata[i] = preview.pixels[iPixel - preview.iPixelFirst];
+			continue;
+		}
+
+		// Pixels which haven't been summarized yet (normally just the last few) are rendered from the data
+		int iSample = qMax(int(iPixel * nSamplesPerPixel + 0.5), didxFirst);
+		int iSampleEnd = qMin(int((iPixel + 1) * nSamplesPerPixel + 0.5), didxLast + 1);
+		if (iSample >= iSampleEnd)
+		{
+			pixdata[i] = (i > 0) ? pixdata[i - 1] : MinMax();
+			continue;
+		}
+
+		double nMin = data[iSample];
+		double nMax = nMin;
+		for (iSample++; iSample < iSampleEnd; iSample++)
+		{
+			double n = data[iSample];
+			if (n < nMin)
+				nMin = n;
+			else if (n > nMax)
+				nMax = n;
+		}
+		pixdata[i].yBot = nMin;
+		pixdata[i].yTop = nMax;
+	}
+
+	prependPreviewBeforeData(vwi, preview);
+	return true;
+}
+
+void RenderData::prependPreviewBeforeData(ViewWaveInfo* vwi, const RenderPreview& preview)
+{
+	// Pixel indexes as calculated in setup()
+	const int iPixelFirstRequested = int((tidxStart - vwi->shift()) / nSamplesPerPixel);
+	const int iPixelStart = qMax(iPixelFirstRequested, preview.iPixelFirst);
+	const int iPixelEnd = qMin(qMin(0, iPixelFirstRequested + nPixelsRequested), preview.iPixelFirst + preview.pixels.size());
+	if (iPixelStart >= iPixelEnd)
+		return;
+
+	// The rendered pixels must follow on directly
+	if (nPixels > 0 && iPixelEnd != iPixelFirstRequested + xOffset)
+		return;
+
+	pixels = preview.pixels.mid(iPixelStart - preview.iPixelFirst, iPixelEnd - iPixelStart) + pixels;
+	nPixels = pixels.size();
+	xOffset = iPixelStart - iPixelFirstRequested;
+}
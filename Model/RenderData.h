@@ -41,6 +41,30 @@ struct MinMax
 };
 
 
+/// Ready-made min/max values for consecutive pixels of a wave, e.g. summarized by the sampling thread while recording.
+/// Pixel i covers the data indexes from int(i * nSamplesPerPixel + 0.5) up to the start of pixel i + 1.
+class RenderPreview
+{
+public:
+	double nSamplesPerPixel;
+	/// Pixel index of pixels[0]
+	int iPixelFirst;
+	QVector<MinMax> pixels;
+
+	RenderPreview()
+		: nSamplesPerPixel(0), iPixelFirst(0)
+	{
+	}
+
+	void clear()
+	{
+		nSamplesPerPixel = 0;
+		iPixelFirst = 0;
+		pixels.clear();
+	}
+};
+
+
 /// Class to calculate rendering points for wave for fast rendering later.
 class RenderData
 {
@@ -72,6 +96,15 @@ public:
 	void render(ViewWaveInfo* wave, int tidxStart, int nPixels, double nSamplesPerPixel);
 	/// Render the standard deviation area around the average
 	void renderStd(ViewWaveInfo* wave, int tidxStart, int nPixels, double nSamplesPerPixel);
+	/// Take the pixels from the given preview where possible, only rendering any pixels which it doesn't cover yet.
+	/// Preview pixels with negative indexes lie before the wave's first sample (e.g. data which was
+	/// spilled to disk during continuous monitoring) and are drawn too.
+	/// @returns false if the preview doesn't match the timebase, in which case nothing is rendered
+	bool renderPreview(ViewWaveInfo* wave, int tidxStart, int nPixels, double nSamplesPerPixel, const RenderPreview& preview);
+
+private:
+	/// Prepend the preview pixels which lie before the wave's first sample
+	void prependPreviewBeforeData(ViewWaveInfo* wave, const RenderPreview& preview);
 };
 
 #endif
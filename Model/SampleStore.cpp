@@ -0,0 +1,344 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "SampleStore.h"
+
+#include <limits.h>
+
+#include <QCryptographicHash>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QLockFile>
+#include <QMutex>
+#include <QSaveFile>
+#include <QSet>
+#include <QtEndian>
+
+#include <Check.h>
+
+#include "EadFile.h"
+
+
+/// Number of samples which are converted to big-endian at a time
+static const int CHUNK_SAMPLES = 64 * 1024;
+/// Number of bytes of a block file which are hashed at a time
+static const qint64 HASH_CHUNK_BYTES = 1 << 24;
+
+static QMutex g_internMutex;
+static QHash<QByteArray, QVector<short> > g_interned;
+
+
+/// Convert samples to the big-endian order used in the block files
+static void toBigEndian(const short* src, int nSamples, QByteArray& dest)
+{
+	dest.resize(nSamples * 2);
+	uchar* p = (uchar*) dest.data();
+	for (int i = 0; i < nSamples; i++)
+		qToBigEndian<qint16>(src[i], p + i * 2);
+}
+
+static bool isHexDigit(char c)
+{
+	return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'f');
+}
+
+/// Path of a file or directory with symbolic links and relative parts resolved, so that
+/// different ways of referring to the same file compare equal.  The file itself needn't exist yet.
+static QString canonicalPath(const QString& sPath)
+{
+	QFileInfo fi(QDir::cleanPath(QFileInfo(sPath).absoluteFilePath()));
+	if (fi.exists())
+		return fi.canonicalFilePath();
+
+	const QString sDir = QFileInfo(fi.absolutePath()).canonicalFilePath();
+	if (sDir.isEmpty())
+		return fi.absoluteFilePath();
+	return QDir(sDir).filePath(fi.fileName());
+}
+
+
+SampleStore::SampleStore(const QString& sPath)
+	: m_sPath(QDir::cleanPath(QFileInfo(sPath).absoluteFilePath()))
+{
+}
+
+QByteArray SampleStore::hash(const QVector<short>& raw)
+{
+	QCryptographicHash hash(QCryptographicHash::Sha1);
+
+	// Hash the same bytes as are stored in the block file
+	uchar header[4];
+	qToBigEndian<quint32>(raw.size(), header);
+	hash.addData((const char*) header, 4);
+
+	QByteArray buffer;
+	for (int i = 0; i < raw.size(); i += CHUNK_SAMPLES)
+	{
+		toBigEndian(raw.constData() + i, qMin(CHUNK_SAMPLES, raw.size() - i), buffer);
+		hash.addData(buffer);
+	}
+
+	return hash.result().toHex();
+}
+
+bool SampleStore::put(const QVector<short>& raw, const QByteArray& hash)
+{
+	const QString sFilename = blockFilename(hash);
+	CHECK_PARAM_RETVAL(!sFilename.isEmpty(), false);
+
+	// Identical samples are already stored
+	if (QFileInfo(sFilename).exists())
+		return true;
+
+	if (!QDir().mkpath(QFileInfo(sFilename).absolutePath()))
+		return false;
+
+	// The block either appears completely or not at all
+	QSaveFile file(sFilename);
+	if (!file.open(QIODevice::WriteOnly))
+		return false;
+
+	uchar header[4];
+	qToBigEndian<quint32>(raw.size(), header);
+	bool bOk = (file.write((const char*) header, 4) == 4);
+
+	QByteArray buffer;
+	for (int i = 0; bOk && i < raw.size(); i += CHUNK_SAMPLES)
+	{
+		toBigEndian(raw.constData() + i, qMin(CHUNK_SAMPLES, raw.size() - i), buffer);
+		bOk = (file.write(buffer) == buffer.size());
+	}
+
+	if (!bOk)
+	{
+		file.cancelWriting();
+		return false;
+	}
+	// Another process may have stored the same block in the meantime
+	return file.commit() || QFileInfo(sFilename).exists();
+}
+
+bool SampleStore::get(const QByteArray& hash, QVector<short>& raw) const
+{
+	const QString sFilename = blockFilename(hash);
+	if (sFilename.isEmpty())
+		return false;
+
+	QFile file(sFilename);
+	if (!file.open(QIODevice::ReadOnly))
+		return false;
+
+	QByteArray buffer;
+	qint64 nSize = file.size();
+	const uchar* data = file.map(0, nSize);
+	if (data == NULL)
+	{
+		buffer = file.readAll();
+		data = (const uchar*) buffer.constData();
+		nSize = buffer.size();
+	}
+
+	if (nSize < 4)
+		return false;
+	const quint32 nSamples = qFromBigEndian<quint32>(data);
+	if (nSamples > INT_MAX / 2 || nSize != 4 + 2 * (qint64) nSamples)
+		return false;
+	// The block file holds exactly the bytes which hash() covers
+	QCryptographicHash blockHash(QCryptographicHash::Sha1);
+	for (qint64 i = 0; i < nSize; i += HASH_CHUNK_BYTES)
+		blockHash.addData((const char*) data + i, (int) qMin(HASH_CHUNK_BYTES, nSize - i));
+	if (blockHash.result().toHex() != hash)
+		return false;
+
+	raw.resize(nSamples);
+	short* dest = raw.data();
+	for (int i = 0; i < (int) nSamples; i++)
+		dest[i] = qFromBigEndian<qint16>(data + 4 + i * 2);
+	return true;
+}
+
+bool SampleStore::addReferrer(const QString& sEadFile)
+{
+	if (!QDir().mkpath(m_sPath))
+		return false;
+
+	QLockFile lock(lockFilename());
+	if (!lock.lock())
+		return false;
+
+	const QString sFile = canonicalPath(sEadFile);
+	QStringList asFiles = readReferrers();
+	if (asFiles.contains(sFile))
+		return true;
+	asFiles << sFile;
+	return writeReferrers(asFiles);
+}
+
+bool SampleStore::removeReferrer(const QString& sEadFile)
+{
+	QLockFile lock(lockFilename());
+	if (!lock.lock())
+		return false;
+
+	QStringList asFiles = readReferrers();
+	if (asFiles.removeAll(canonicalPath(sEadFile)) == 0)
+		return true;
+	return writeReferrers(asFiles);
+}
+
+QString SampleStore::lockFilename() const
+{
+	return QDir(m_sPath).filePath("lock");
+}
+
+int SampleStore::collectGarbage(qint64* pnBytesFreed, QStringList* pasProblems)
+{
+	if (pnBytesFreed != NULL)
+		*pnBytesFreed = 0;
+	if (pasProblems != NULL)
+		pasProblems->clear();
+
+	QLockFile lock(lockFilename());
+	if (!lock.lock())
+		return -1;
+
+	// Find all blocks which the referring files still use.
+	// Without knowing what every file needs, nothing can safely be deleted.
+	QSet<QByteArray> used;
+	QStringList asProblems;
+	const QString sPath = canonicalPath(m_sPath);
+	foreach (const QString& sFile, readReferrers())
+	{
+		QSet<QByteArray> hashes;
+		QString sStore;
+		if (!EadFile::readBlockReferences(sFile, hashes, &sStore) || sStore.isEmpty() || canonicalPath(sStore) != sPath)
+			asProblems << sFile;
+		else
+			used.unite(hashes);
+	}
+	if (pasProblems != NULL)
+		*pasProblems = asProblems;
+	if (!asProblems.isEmpty())
+		return -1;
+
+	int nDeleted = 0;
+	QDirIterator it(m_sPath, QDir::Files, QDirIterator::Subdirectories);
+	while (it.hasNext())
+	{
+		QFileInfo fi(it.next());
+		// Blocks are stored as "xx/yyyy...", where xxyyyy... is the hash
+		const QByteArray hash = (fi.dir().dirName() + fi.fileName()).toLatin1();
+		if (blockFilename(hash).isEmpty() || used.contains(hash))
+			continue;
+
+		const qint64 nSize = fi.size();
+		if (QFile::remove(fi.absoluteFilePath()))
+		{
+			nDeleted++;
+			if (pnBytesFreed != NULL)
+				*pnBytesFreed += nSize;
+			// Fails harmlessly if other blocks remain in the directory
+			QDir(m_sPath).rmdir(fi.dir().dirName());
+		}
+	}
+
+	return nDeleted;
+}
+
+QVector<short> SampleStore::intern(const QVector<short>& raw, const QByteArray& hash)
+{
+	if (raw.isEmpty())
+		return raw;
+
+	QMutexLocker locker(&g_internMutex);
+	QHash<QByteArray, QVector<short> >::const_iterator it = g_interned.constFind(hash);
+	if (it != g_interned.constEnd() && it.value().size() == raw.size())
+		return it.value();
+
+	g_interned[hash] = raw;
+	return raw;
+}
+
+void SampleStore::purgeInterned()
+{
+	QMutexLocker locker(&g_internMutex);
+	QHash<QByteArray, QVector<short> >::iterator it = g_interned.begin();
+	while (it != g_interned.end())
+	{
+		// Only the registry still refers to the data
+		if (it.value().isDetached())
+			it = g_interned.erase(it);
+		else
+			++it;
+	}
+}
+
+QString SampleStore::blockFilename(const QByteArray& hash) const
+{
+	// The hash comes from files, so make sure it can't point outside of the store
+	if (hash.size() != 40)
+		return QString();
+	for (int i = 0; i < hash.size(); i++)
+	{
+		if (!isHexDigit(hash[i]))
+			return QString();
+	}
+
+	return QDir(m_sPath).filePath(QString::fromLatin1(hash.left(2)) + "/" + QString::fromLatin1(hash.mid(2)));
+}
+
+QString SampleStore::referrersFilename() const
+{
+	return QDir(m_sPath).filePath("referrers.txt");
+}
+
+QStringList SampleStore::readReferrers() const
+{
+	QStringList asFiles;
+	QFile file(referrersFilename());
+	if (file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		// Older lists may refer to the same file in different ways
+		foreach (const QString& s, QString::fromUtf8(file.readAll()).split('\n', QString::SkipEmptyParts))
+		{
+			const QString sFile = canonicalPath(s.trimmed());
+			if (!asFiles.contains(sFile))
+				asFiles << sFile;
+		}
+	}
+	return asFiles;
+}
+
+bool SampleStore::writeReferrers(const QStringList& asFiles) const
+{
+	QSaveFile file(referrersFilename());
+	if (!file.open(QIODevice::WriteOnly | QIODevice::Text))
+		return false;
+	QByteArray data;
+	foreach (const QString& s, asFiles)
+		data += s.toUtf8() + '\n';
+	if (file.write(data) != data.size())
+	{
+		file.cancelWriting();
+		return false;
+	}
+	return file.commit();
+}
@@ -0,0 +1,85 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __SAMPLESTORE_H
+#define __SAMPLESTORE_H
+
+#include <QByteArray>
+#include <QStringList>
+#include <QVector>
+
+
+/// Content-addressed store for the raw data of waves, which several .ead files can share.
+/// Each block of samples is kept in a file named after the SHA-1 hash of its contents,
+/// so a recording which is imported into several project files is only stored once.
+///
+/// The store also keeps a list of the .ead files which refer to it, by their canonical paths.
+/// Files add themselves to the list whenever they're saved or loaded, so copies and moved files are found as well.
+/// collectGarbage() reads the indexes of these files to find out which blocks are still needed.
+class SampleStore
+{
+public:
+	/// @param sPath directory of the store; it's created when the first block is added
+	SampleStore(const QString& sPath);
+
+	const QString& path() const { return m_sPath; }
+
+	/// Hex-encoded SHA-1 hash of the samples, which identifies their block in the store
+	static QByteArray hash(const QVector<short>& raw);
+
+	/// Add a block to the store, unless it's already there.
+	/// Hold a QLockFile on lockFilename() until the .ead file which refers to the block has been written,
+	/// so that collectGarbage() can't delete the block in the meantime.
+	bool put(const QVector<short>& raw, const QByteArray& hash);
+	/// Read a block from the store.
+	/// The contents are checked against the hash, since intern() shares them with every other wave of the same hash.
+	/// @returns false if the block is missing, truncated or corrupt
+	bool get(const QByteArray& hash, QVector<short>& raw) const;
+
+	/// Record that sEadFile refers to blocks in this store
+	bool addReferrer(const QString& sEadFile);
+	/// Forget that sEadFile refers to this store, e.g. because it has been deleted
+	bool removeReferrer(const QString& sEadFile);
+	/// Lock file which serializes collectGarbage() with the saving of files that refer to the store
+	QString lockFilename() const;
+	/// Delete the blocks which none of the referring files use anymore.
+	/// Nothing is deleted if any of the referring files is missing, can't be read, or refers to a different store,
+	/// since it may just be out of reach for the moment, e.g. on a network drive.  removeReferrer() forgets such files.
+	/// @param pnBytesFreed if not NULL, receives the size of the deleted blocks
+	/// @param pasProblems if not NULL, receives the referring files which kept the blocks from being deleted
+	/// @returns the number of deleted blocks, or -1 on error
+	int collectGarbage(qint64* pnBytesFreed = NULL, QStringList* pasProblems = NULL);
+
+	/// Return a vector which shares its data with an identical vector that was interned before, if any.
+	/// This keeps just one copy in memory of samples which several open files refer to.
+	static QVector<short> intern(const QVector<short>& raw, const QByteArray& hash);
+	/// Forget interned vectors which nobody else uses anymore
+	static void purgeInterned();
+
+private:
+	/// @returns an empty string if hash isn't a valid hash
+	QString blockFilename(const QByteArray& hash) const;
+	QString referrersFilename() const;
+	QStringList readReferrers() const;
+	bool writeReferrers(const QStringList& asFiles) const;
+
+private:
+	const QString m_sPath;
+};
+
+#endif
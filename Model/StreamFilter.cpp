@@ -0,0 +1,182 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "StreamFilter.h"
+
+#include <qmath.h>
+
+#include <Check.h>
+
+
+StreamFilter::StreamFilter()
+{
+	m_bPrimed = false;
+}
+
+void StreamFilter::clear()
+{
+	m_stages.clear();
+	m_bPrimed = false;
+}
+
+void StreamFilter::addFir(const QVector<double>& taps)
+{
+	CHECK_PARAM_RET(!taps.isEmpty());
+
+	Stage stage;
+	stage.coefs = taps;
+	stage.bBiquad = false;
+	stage.state.fill(0, 2 * taps.size());
+	stage.iState = 0;
+	m_stages << stage;
+	m_bPrimed = false;
+}
+
+void StreamFilter::addBiquad(double b0, double b1, double b2, double a1, double a2)
+{
+	Stage stage;
+	stage.coefs << b0 << b1 << b2 << a1 << a2;
+	stage.bBiquad = true;
+	stage.state.fill(0, 4);
+	stage.iState = 0;
+	m_stages << stage;
+	m_bPrimed = false;
+}
+
+void StreamFilter::reset()
+{
+	m_bPrimed = false;
+}
+
+void StreamFilter::prime(double n)
+{
+	for (int iStage = 0; iStage < m_stages.size(); iStage++)
+	{
+		Stage& stage = m_stages[iStage];
+		const double* c = stage.coefs.constData();
+		double nGain;
+		if (stage.bBiquad)
+		{
+			double nDen = 1 + c[3] + c[4];
+			nGain = (nDen != 0) ? (c[0] + c[1] + c[2]) / nDen : 1;
+			double* s = stage.state.data();
+			s[0] = s[1] = n;
+			s[2] = s[3] = n * nGain;
+		}
+		else
+		{
+			nGain = 0;
+			for (int i = 0; i < stage.coefs.size(); i++)
+				nGain += c[i];
+			stage.state.fill(n);
+			stage.iState = 0;
+		}
+		// The next stage sees this stage's steady-state output
+		n *= nGain;
+	}
+	m_bPrimed = true;
+}
+
+void StreamFilter::process(double* data, int nSamples)
+{
+	CHECK_PARAM_RET(data != NULL || nSamples == 0);
+
+	if (m_stages.isEmpty() || nSamples <= 0)
+		return;
+
+	if (!m_bPrimed)
+		prime(data[0]);
+
+	for (int iStage = 0; iStage < m_stages.size(); iStage++)
+	{
+		Stage& stage = m_stages[iStage];
+		const double* c = stage.coefs.constData();
+		double* s = stage.state.data();
+
+		if (stage.bBiquad)
+		{
+			// Direct form I, with the state kept in locals for the duration of the block
+			double x1 = s[0], x2 = s[1], y1 = s[2], y2 = s[3];
+			for (int i = 0; i < nSamples; i++)
+			{
+				double x = data[i];
+				double y = c[0] * x + c[1] * x1 + c[2] * x2 - c[3] * y1 - c[4] * y2;
+				x2 = x1;
+				x1 = x;
+				y2 = y1;
+				y1 = y;
+				data[i] = y;
+			}
+			s[0] = x1;
+			s[1] = x2;
+			s[2] = y1;
+			s[3] = y2;
+		}
+		else
+		{
+			const int nTaps = stage.coefs.size();
+			int iState = stage.iState;
+			for (int i = 0; i < nSamples; i++)
+			{
+				iState = (iState == 0) ? nTaps - 1 : iState - 1;
+				s[iState] = s[iState + nTaps] = data[i];
+
+				const double* x = s + iState;
+				double y = 0;
+				for (int k = 0; k < nTaps; k++)
+					y += c[k] * x[k];
+				data[i] = y;
+			}
+			stage.iState = iState;
+		}
+	}
+}
+
+StreamFilter StreamFilter::lowpass(double nCutoff_Hz, double nSampleRate_Hz, int nOrder)
+{
+	StreamFilter filter;
+	CHECK_PARAM_RETVAL(nSampleRate_Hz > 0, filter);
+	CHECK_PARAM_RETVAL(nCutoff_Hz > 0 && nCutoff_Hz < nSampleRate_Hz / 2, filter);
+	CHECK_PARAM_RETVAL(nOrder >= 2 && nOrder % 2 == 0, filter);
+
+	// Bilinear transform of the analog Butterworth poles, one biquad per conjugate pair
+	const double w0 = 2 * M_PI * nCutoff_Hz / nSampleRate_Hz;
+	const double nCos = cos(w0);
+	const double nSin = sin(w0);
+	for (int k = 0; k < nOrder / 2; k++)
+	{
+		double nQ = 1 / (2 * cos(M_PI * (2 * k + 1) / (2 * nOrder)));
+		double nAlpha = nSin / (2 * nQ);
+		double a0 = 1 + nAlpha;
+		double b0 = (1 - nCos) / 2 / a0;
+		double b1 = (1 - nCos) / a0;
+		double a1 = -2 * nCos / a0;
+		double a2 = (1 - nAlpha) / a0;
+		filter.addBiquad(b0, b1, b0, a1, a2);
+	}
+	return filter;
+}
+
+StreamFilter StreamFilter::movingAverage(int nSamples)
+{
+	StreamFilter filter;
+	CHECK_PARAM_RETVAL(nSamples > 0, filter);
+
+	QVector<double> taps(nSamples, 1.0 / nSamples);
+	filter.addFir(taps);
+	return filter;
+}
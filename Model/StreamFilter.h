@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __STREAMFILTER_H
+#define __STREAMFILTER_H
+
+#include <QVector>
+
+
+/// Causal filter which processes a signal block by block, e.g. while it's being recorded.
+/// The filter state is carried over from one block to the next, so filtering a signal
+/// in several blocks gives the same result as filtering it all at once.
+/// The cost per sample only depends on the number of coefficients, not on how much has been filtered before.
+///
+/// The filter is a cascade of stages, each either an FIR filter or a second-order IIR section (biquad).
+class StreamFilter
+{
+public:
+	StreamFilter();
+
+	/// A filter without any stages leaves the signal unchanged
+	bool isEmpty() const { return m_stages.isEmpty(); }
+	void clear();
+
+	/// Append an FIR stage: y[n] = sum(taps[k] * x[n - k])
+	void addFir(const QVector<double>& taps);
+	/// Append a biquad stage: y[n] = b0 x[n] + b1 x[n-1] + b2 x[n-2] - a1 y[n-1] - a2 y[n-2]
+	void addBiquad(double b0, double b1, double b2, double a1, double a2);
+
+	/// Forget the previous samples.
+	/// The state will be initialized from the next sample, as if the signal had been constant up till then,
+	/// so that there's no step response at the start of a recording.
+	void reset();
+	/// Filter the samples in place
+	void process(double* data, int nSamples);
+
+	/// Butterworth low-pass filter made of biquad stages
+	/// @param nOrder must be even
+	static StreamFilter lowpass(double nCutoff_Hz, double nSampleRate_Hz, int nOrder = 2);
+	/// Moving average over the last nSamples samples
+	static StreamFilter movingAverage(int nSamples);
+
+private:
+	struct Stage
+	{
+		/// FIR taps, or b0, b1, b2, a1, a2 for a biquad
+		QVector<double> coefs;
+		bool bBiquad;
+		/// FIR: the last taps.size() inputs, stored twice so that they can be read without wrapping around.
+		/// Biquad: x[n-1], x[n-2], y[n-1], y[n-2].
+		QVector<double> state;
+		/// FIR: position of the most recent input in state
+		int iState;
+	};
+
+	/// Fill the state of each stage as if its input had always been n
+	void prime(double n);
+
+private:
+	QVector<Stage> m_stages;
+	bool m_bPrimed;
+};
+
+#endif
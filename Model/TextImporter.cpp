@@ -0,0 +1,433 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TextImporter.h"
+
+#include <limits.h>
+#include <math.h>
+#include <string.h>
+
+#include <QRegExp>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <Check.h>
+#include <DoubleFormat.h>
+
+#include "EadEnums.h"
+#include "WaveInfo.h"
+
+
+/// Only this much of the file is read in order to show the column mapping
+static const qint64 FIRST_CHUNK_SIZE = 64 * 1024;
+/// Number of rows kept for the preview
+static const int PREVIEW_ROWS = 10;
+/// Largest raw value used when quantizing imported values
+static const double RAW_MAX = 32000;
+
+
+/// Convert a value to a raw sample
+static inline short toRaw(double n, double nScale)
+{
+	return (short) qBound(-32768, qRound(n * nScale), 32767);
+}
+
+/// Return the end of the line starting at p: either the '\n' or end
+static const char* findLineEnd(const char* p, const char* end)
+{
+	const char* eol = (const char*) memchr(p, '\n', end - p);
+	return (eol != NULL) ? eol : end;
+}
+
+static bool isBlankOrComment(const char* p, const char* end)
+{
+	while (p < end && (*p == ' ' || *p == '\t' || *p == '\r'))
+		p++;
+	return (p == end || *p == '#');
+}
+
+
+TextImporter::TextImporter()
+	: m_data(NULL), m_nSize(0), m_iBody(0),
+	  m_chDelimiter(','), m_chDecimal('.'), m_iTimeColumn(-1), m_nSampleRate(0)
+{
+}
+
+TextImporter::~TextImporter()
+{
+	close();
+}
+
+void TextImporter::close()
+{
+	// Unmaps the file
+	m_file.close();
+	m_buffer.clear();
+	m_data = NULL;
+	m_nSize = 0;
+	m_iBody = 0;
+	m_chDelimiter = ',';
+	m_chDecimal = '.';
+	m_asNames.clear();
+	m_previewRows.clear();
+	m_iTimeColumn = -1;
+	m_nSampleRate = 0;
+}
+
+bool TextImporter::open(const QString& sFilename)
+{
+	close();
+
+	m_file.setFileName(sFilename);
+	if (!m_file.open(QIODevice::ReadOnly))
+		return false;
+
+	m_nSize = m_file.size();
+	if (m_nSize <= 0 || m_nSize > INT_MAX)
+	{
+		close();
+		return false;
+	}
+	m_data = (const char*) m_file.map(0, m_nSize);
+	if (m_data == NULL)
+	{
+		m_buffer = m_file.readAll();
+		m_data = m_buffer.constData();
+		m_nSize = m_buffer.size();
+	}
+
+	const char* const end = m_data + m_nSize;
+	const char* const endFirst = (m_nSize > FIRST_CHUNK_SIZE) ? m_data + FIRST_CHUNK_SIZE : end;
+
+	// Skip UTF-8 byte order mark, blank lines and comments
+	const char* line = m_data;
+	if (m_nSize >= 3 && memcmp(line, "\xEF\xBB\xBF", 3) == 0)
+		line += 3;
+	while (line < endFirst && isBlankOrComment(line, findLineEnd(line, end)))
+		line = findLineEnd(line, end) + 1;
+	if (line >= endFirst)
+	{
+		close();
+		return false;
+	}
+
+	const char* eol = findLineEnd(line, end);
+	QByteArray first(line, int(eol - line));
+	if (first.endsWith('\r'))
+		first.chop(1);
+
+	if (first.contains('\t'))
+		m_chDelimiter = '\t';
+	else if (first.contains(';'))
+		m_chDelimiter = ';';
+	else if (first.contains(','))
+		m_chDelimiter = ',';
+	else
+		m_chDelimiter = ' ';
+
+	// Split the first line into fields
+	QStringList asFields;
+	if (m_chDelimiter == ' ')
+		asFields = QString::fromUtf8(first).split(QRegExp("\\s+"), QString::SkipEmptyParts);
+	else
+		asFields = QString::fromUtf8(first).split(m_chDelimiter);
+	for (int i = 0; i < asFields.size(); i++)
+	{
+		QString s = asFields[i].trimmed();
+		if (s.startsWith('"') && s.endsWith('"') && s.size() >= 2)
+			s = s.mid(1, s.size() - 2);
+		asFields[i] = s;
+	}
+
+	// The first line is a header unless it starts with a number
+	QByteArray sFirstField = asFields.value(0).toLatin1();
+	double n;
+	bool bHeader = (parseDouble(sFirstField.constData(), sFirstField.constData() + sFirstField.size(), n) == sFirstField.constData());
+	if (bHeader)
+	{
+		m_asNames = asFields;
+		m_iBody = qMin(eol + 1, end) - m_data;
+	}
+	else
+	{
+		for (int i = 0; i < asFields.size(); i++)
+			m_asNames << QObject::tr("Column %0").arg(i + 1);
+		m_iBody = line - m_data;
+	}
+
+	// A comma which isn't the delimiter is the decimal separator, e.g. "1,5;2,25"
+	const char* data = m_data + m_iBody;
+	const char* eolData = findLineEnd(data, end);
+	if (m_chDelimiter != ',' && memchr(data, ',', eolData - data) != NULL && memchr(data, '.', eolData - data) == NULL)
+		m_chDecimal = ',';
+
+	// Look for a time column
+	double nTimeUnit = 1;
+	for (int i = 0; i < m_asNames.size() && bHeader; i++)
+	{
+		QString s = m_asNames[i].toLower();
+		if (s == "t" || s.startsWith("t ") || s.startsWith("time") || s.startsWith("rt") || s.startsWith("retention"))
+		{
+			m_iTimeColumn = i;
+			if (s.contains("min"))
+				nTimeUnit = 60;
+			else if (s.contains("ms"))
+				nTimeUnit = 0.001;
+			break;
+		}
+	}
+
+	// Parse the complete lines of the first chunk for the preview and the sample rate
+	QVector<double> values(m_asNames.size());
+	QVector<double> times;
+	const char* p = data;
+	while (p < end)
+	{
+		const char* eolLine = findLineEnd(p, end);
+		if (eolLine >= endFirst && eolLine != end)
+			break;
+		bool bData;
+		p = parseLine(p, end, values, bData);
+		if (!bData)
+			continue;
+		if (m_previewRows.size() < PREVIEW_ROWS)
+			m_previewRows << values;
+		if (m_iTimeColumn >= 0)
+			times << values[m_iTimeColumn];
+	}
+
+	if (m_iTimeColumn >= 0)
+	{
+		for (int i = 1; i < times.size(); i++)
+		{
+			// Not a time column after all
+			if (times[i] <= times[i - 1])
+			{
+				m_iTimeColumn = -1;
+				break;
+			}
+		}
+		if (m_iTimeColumn >= 0 && times.size() >= 2)
+			m_nSampleRate = (times.size() - 1) / ((times.last() - times.first()) * nTimeUnit);
+	}
+
+	return true;
+}
+
+bool TextImporter::isCommentLine(const char* p, const char* end)
+{
+	return isBlankOrComment(p, end);
+}
+
+const char* TextImporter::parseLine(const char* p, const char* end, QVector<double>& values, bool& bData) const
+{
+	const int nColumns = values.size();
+	bData = false;
+
+	const char* eol = findLineEnd(p, end);
+	if (isCommentLine(p, eol))
+		return (eol < end) ? eol + 1 : end;
+
+	int iCol = 0;
+	while (p < eol)
+	{
+		// Skip leading spaces and quotes; runs of spaces are a single delimiter
+		while (p < eol && (*p == ' ' || *p == '"' || *p == '\r') && *p != m_chDelimiter)
+			p++;
+		while (m_chDelimiter == ' ' && p < eol && *p == ' ')
+			p++;
+
+		double n = 0;
+		const char* q = parseDouble(p, eol, n, m_chDecimal);
+		if (q != p)
+			bData = true;
+		if (iCol < nColumns)
+			values[iCol] = (q != p) ? n : 0;
+		iCol++;
+
+		// Skip the rest of the field
+		p = q;
+		while (p < eol && *p != m_chDelimiter)
+			p++;
+		if (p < eol)
+			p++;
+	}
+	for (; iCol < nColumns; iCol++)
+		values[iCol] = 0;
+
+	return (eol < end) ? eol + 1 : end;
+}
+
+void TextImporter::parseChunk(Chunk& chunk)
+{
+	int nColumns = 0;
+	foreach (int iCol, chunk.columns)
+		nColumns = qMax(nColumns, iCol + 1);
+
+	const int nWanted = chunk.columns.size();
+	chunk.values.resize(nWanted);
+	chunk.maxAbs.fill(0, nWanted);
+	chunk.nRows = 0;
+
+	QVector<double> values(nColumns);
+	const char* p = chunk.begin;
+	while (p < chunk.end)
+	{
+		bool bData;
+		p = chunk.importer->parseLine(p, chunk.end, values, bData);
+		if (!bData)
+			continue;
+
+		for (int i = 0; i < nWanted; i++)
+		{
+			double n = values[chunk.columns[i]];
+			chunk.values[i] << n;
+			chunk.maxAbs[i] = qMax(chunk.maxAbs[i], fabs(n));
+		}
+		chunk.nRows++;
+	}
+}
+
+void TextImporter::quantizeChunk(Chunk& chunk)
+{
+	for (int i = 0; i < chunk.columns.size(); i++)
+	{
+		const double* src = chunk.values[i].constData();
+		short* dest = chunk.dest[i];
+		const double nScale = chunk.scale[i];
+		for (int iRow = 0; iRow < chunk.nRows; iRow++)
+			dest[iRow] = toRaw(src[iRow], nScale);
+	}
+}
+
+void TextImporter::resample(const QVector<double>& values, double nSampleRate, double nScale, QVector<short>& raw) const
+{
+	const double nIndexRatio = nSampleRate / EAD_SAMPLES_PER_SECOND;
+	const int nSize = int(values.size() / nIndexRatio);
+	raw.resize(nSize);
+	for (int iOut = 0; iOut < nSize; iOut++)
+	{
+		double i = iOut * nIndexRatio;
+		int i0 = qMin((int) floor(i), values.size() - 1);
+		double n = values[i0];
+		// Interpolate when upsampling, pick the nearest earlier value when downsampling
+		if (nIndexRatio < 1 && i0 + 1 < values.size())
+			n += (values[i0 + 1] - n) * (i - i0);
+		raw[iOut] = toRaw(n, nScale);
+	}
+}
+
+bool TextImporter::read(const QMap<int, WaveInfo*>& columns, double nSampleRate)
+{
+	CHECK_PRECOND_RETVAL(m_data != NULL, false);
+	CHECK_PARAM_RETVAL(nSampleRate > 0, false);
+	if (columns.isEmpty())
+		return true;
+
+	const QList<int> cols = columns.keys();
+
+	// Split the body into chunks which end at line boundaries
+	const char* p = m_data + m_iBody;
+	const char* const end = m_data + m_nSize;
+	const int nThreads = qMax(1, QThread::idealThreadCount());
+	const qint64 nChunkSize = qBound(qint64(1 << 20), (end - p) / (nThreads * 4) + 1, qint64(16 << 20));
+	QVector<Chunk> chunks;
+	while (p < end)
+	{
+		const char* q = (end - p > nChunkSize) ? p + nChunkSize : end;
+		q = (q < end) ? findLineEnd(q, end) : end;
+		if (q < end)
+			q++;
+
+		Chunk chunk;
+		chunk.importer = this;
+		chunk.begin = p;
+		chunk.end = q;
+		chunk.columns = cols;
+		chunk.nRows = 0;
+		chunk.iRowFirst = 0;
+		chunks << chunk;
+		p = q;
+	}
+
+	QtConcurrent::blockingMap(chunks, parseChunk);
+
+	int nRows = 0;
+	QVector<double> maxAbs(cols.size(), 0);
+	for (int iChunk = 0; iChunk < chunks.size(); iChunk++)
+	{
+		chunks[iChunk].iRowFirst = nRows;
+		nRows += chunks[iChunk].nRows;
+		for (int i = 0; i < cols.size(); i++)
+			maxAbs[i] = qMax(maxAbs[i], chunks[iChunk].maxAbs[i]);
+	}
+	if (nRows == 0)
+		return false;
+
+	// Choose a voltage factor for each wave which makes full use of the raw range
+	QVector<double> scales(cols.size());
+	for (int i = 0; i < cols.size(); i++)
+	{
+		WaveInfo* wave = columns[cols[i]];
+		int nNum = 1;
+		int nDen = 1;
+		if (maxAbs[i] > RAW_MAX)
+			nNum = (int) ceil(maxAbs[i] / RAW_MAX);
+		else if (maxAbs[i] > 0)
+			nDen = (int) qMin(RAW_MAX / maxAbs[i], 1e9);
+		wave->nRawToVoltageFactorNum = nNum;
+		wave->nRawToVoltageFactorDen = nDen;
+		wave->nRawToVoltageFactor = double(nNum) / nDen;
+		scales[i] = double(nDen) / nNum;
+	}
+
+	// If the file already has our sample rate, each chunk can be written straight into the waves
+	if (qAbs(nSampleRate - EAD_SAMPLES_PER_SECOND) < 0.005 * EAD_SAMPLES_PER_SECOND)
+	{
+		QVector<short*> dest(cols.size());
+		for (int i = 0; i < cols.size(); i++)
+		{
+			WaveInfo* wave = columns[cols[i]];
+			wave->raw.resize(nRows);
+			dest[i] = wave->raw.data();
+		}
+		for (int iChunk = 0; iChunk < chunks.size(); iChunk++)
+		{
+			Chunk& chunk = chunks[iChunk];
+			chunk.dest.resize(cols.size());
+			for (int i = 0; i < cols.size(); i++)
+				chunk.dest[i] = dest[i] + chunk.iRowFirst;
+			chunk.scale = scales;
+		}
+		QtConcurrent::blockingMap(chunks, quantizeChunk);
+	}
+	else
+	{
+		for (int i = 0; i < cols.size(); i++)
+		{
+			QVector<double> values(nRows);
+			foreach (const Chunk& chunk, chunks)
+			{
+				if (chunk.nRows > 0)
+					memcpy(values.data() + chunk.iRowFirst, chunk.values[i].constData(), chunk.nRows * sizeof(double));
+			}
+			resample(values, nSampleRate, scales[i], columns[cols[i]]->raw);
+		}
+	}
+
+	return true;
+}
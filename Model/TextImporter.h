@@ -0,0 +1,107 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TEXTIMPORTER_H
+#define __TEXTIMPORTER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+
+
+class WaveInfo;
+
+
+/// Imports waveforms from CSV/TSV text exports of other systems.
+/// The file is memory-mapped and only the first chunk is read by open(), so that the column
+/// mapping can be shown immediately.  read() then splits the rest of the file into chunks at
+/// line boundaries, parses them in parallel and writes the values directly into WaveInfo::raw.
+class TextImporter
+{
+public:
+	TextImporter();
+	~TextImporter();
+
+	/// Map the file and detect its delimiter, header and columns from the first chunk
+	bool open(const QString& sFilename);
+	void close();
+
+	/// Column names from the header row, or "Column 1", "Column 2", ... if the file has none
+	const QStringList& columnNames() const { return m_asNames; }
+	/// The first rows of the file
+	const QList<QVector<double> >& previewRows() const { return m_previewRows; }
+	/// Index of the column holding the sample times, or -1 if there is none
+	int timeColumn() const { return m_iTimeColumn; }
+	/// Sample rate in Hz estimated from the time column, or 0 if unknown
+	double sampleRate() const { return m_nSampleRate; }
+
+	/// Parse the whole file and fill the raw data of the given waves, resampled to EAD_SAMPLES_PER_SECOND.
+	/// Each wave's voltage factor is chosen so that its values fit into the raw 16-bit range.
+	/// @param columns maps column indexes to the waves which receive their data
+	/// @param nSampleRate sample rate of the file in Hz
+	bool read(const QMap<int, WaveInfo*>& columns, double nSampleRate);
+
+private:
+	class Chunk
+	{
+	public:
+		const TextImporter* importer;
+		const char* begin;
+		const char* end;
+		/// Columns to parse
+		QList<int> columns;
+		/// Parsed values for each entry of columns
+		QVector< QVector<double> > values;
+		/// Largest absolute value for each entry of columns
+		QVector<double> maxAbs;
+		int nRows;
+		/// Index of the chunk's first row in the file
+		int iRowFirst;
+		/// Quantization for each entry of columns: destination and scale
+		QVector<short*> dest;
+		QVector<double> scale;
+	};
+
+	/// Parse the line starting at p into values and return the start of the next line.
+	/// bData is false for blank lines, comments and lines without any numbers.
+	const char* parseLine(const char* p, const char* end, QVector<double>& values, bool& bData) const;
+	static bool isCommentLine(const char* p, const char* end);
+	static void parseChunk(Chunk& chunk);
+	static void quantizeChunk(Chunk& chunk);
+	void resample(const QVector<double>& values, double nSampleRate, double nScale, QVector<short>& raw) const;
+
+private:
+	QFile m_file;
+	/// Fallback buffer if the file couldn't be mapped
+	QByteArray m_buffer;
+	const char* m_data;
+	qint64 m_nSize;
+	/// Offset of the first data row
+	qint64 m_iBody;
+
+	char m_chDelimiter;
+	char m_chDecimal;
+	QStringList m_asNames;
+	QList<QVector<double> > m_previewRows;
+	int m_iTimeColumn;
+	double m_nSampleRate;
+};
+
+#endif
@@ -213,7 +213,7 @@ void ViewWaveInfo::setMarkerPoint(int iMarker, int iDidx, int didx)
 void ViewWaveInfo::emitChanged(ViewChangeEvents e)
 {
 	CHECK_PRECOND_RET(m_view != NULL);
-	m_view->emitChanged(e);
+	m_view->emitChanged(e, m_wave, m_pos);
 }
 
 /*void ViewWaveInfo::on_wave_destroyed(QObject* obj)
@@ -291,11 +291,19 @@ ViewWaveInfo* ViewInfo::addExtraWave(WaveInfo* wave)
 	ViewWaveInfo* vwi = new ViewWaveInfo(this, wave, pos);
 	setEditorFlags(vwi);
 	m_vwiExtras << vwi;
-	emitChanged(ViewChangeEvent_Paint);
+	// Let the edit history know about the new position
+	emitChanged(ViewChangeEvent_Paint, NULL, pos);
 
 	return vwi;
 }
 
+QList<WavePos*> ViewInfo::positions()
+{
+	QList<WavePos*> list;
+	list << m_posExtras << &posExtra;
+	return list;
+}
+
 void ViewInfo::remove(WaveInfo* wave)
 {
 	m_file->remove(wave);
@@ -319,7 +327,7 @@ void ViewInfo::setUserWave(WaveInfo* wave)
 	// Use the default position information
 	if (wave != NULL)
 		posExtra = wave->pos;
-	emitChanged(ViewChangeEvent_Paint);
+	emitChanged(ViewChangeEvent_Paint, NULL, &posExtra);
 }
 
 void ViewInfo::setEditorFlags(ViewWaveInfo* vwi)
@@ -341,7 +349,7 @@ void ViewInfo::setEditorFlags(ViewWaveInfo* vwi)
 	//qDebug() << "setEditorFlags:" << vwi->wave()->sName << vwi->editorFlags;
 }
 
-void ViewInfo::emitChanged(ViewChangeEvents e)
+void ViewInfo::emitChanged(ViewChangeEvents e, WaveInfo* wave, WavePos* pos)
 {
 	if (e == ViewChangeEvent_CalcAve)
 	{
@@ -350,6 +358,6 @@ void ViewInfo::emitChanged(ViewChangeEvents e)
 		e = ViewChangeEvent_Render;
 	}
 	if (m_file != NULL)
-		m_file->setDirty();
+		m_file->setDirty(wave, pos);
 	emit changed(e);
 }
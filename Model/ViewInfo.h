@@ -122,6 +122,8 @@ public:
 	ViewWaveInfo* addWave(WaveInfo* wave);
 	/// Add a wave whose chart position is given by this ViewInfo
 	ViewWaveInfo* addExtraWave(WaveInfo* wave);
+	/// Get the WavePos objects which belong to this view rather than to a wave, i.e. posExtra and those of the extra waves
+	QList<WavePos*> positions();
 	
 	/// Delete the raw data for the given wave
 	void remove(WaveInfo* vwi);
@@ -132,7 +134,8 @@ public:
 	void setUserWave(WaveInfo* wave);
 
 	/// For use by ViewInfo only
-	void emitChanged(ViewChangeEvents e);
+	/// @param wave, pos what was changed, if anything, so that the edit history only needs to compare that
+	void emitChanged(ViewChangeEvents e, WaveInfo* wave = NULL, WavePos* pos = NULL);
 
 signals:
 	/// Emitted when wave info or position is changed.
@@ -0,0 +1,379 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "WaveExporter.h"
+
+#include <string.h>
+
+#include <QFile>
+#include <QSet>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <Check.h>
+#include <DoubleFormat.h>
+
+#include "EadFile.h"
+#include "RecInfo.h"
+#include "WaveInfo.h"
+
+
+#ifdef Q_OS_WIN
+static const char g_sNewline[] = "\r\n";
+#else
+static const char g_sNewline[] = "\n";
+#endif
+
+/// Size of the buffer which one task of the CSV export formats its rows into.
+/// The number of rows per task follows from this, so that wide files don't need huge buffers.
+static const int CSV_CHUNK_BYTES = 1 << 20;
+/// Number of zeros written at once when padding a column
+static const int ZERO_BUFFER_SIZE = 8192;
+static const double g_anZeros[ZERO_BUFFER_SIZE] = { 0 };
+
+
+namespace {
+
+class Crc32Table
+{
+public:
+	quint32 table[256];
+
+	Crc32Table()
+	{
+		for (quint32 i = 0; i < 256; i++)
+		{
+			quint32 c = i;
+			for (int k = 0; k < 8; k++)
+				c = (c & 1) ? (0xEDB88320u ^ (c >> 1)) : (c >> 1);
+			table[i] = c;
+		}
+	}
+};
+
+/// Update a zip-style CRC-32 with the given data
+quint32 crc32(quint32 nCrc, const char* p, qint64 n)
+{
+	static const Crc32Table crc;
+	nCrc = ~nCrc;
+	while (n-- > 0)
+		nCrc = crc.table[(nCrc ^ uchar(*p++)) & 0xFF] ^ (nCrc >> 8);
+	return ~nCrc;
+}
+
+void appendUInt16(QByteArray& a, quint16 n)
+{
+	a.append(char(n & 0xFF));
+	a.append(char(n >> 8));
+}
+
+void appendUInt32(QByteArray& a, quint32 n)
+{
+	appendUInt16(a, quint16(n & 0xFFFF));
+	appendUInt16(a, quint16(n >> 16));
+}
+
+/// Write the data, and update the CRC if pnCrc isn't NULL.
+/// device may be NULL in order to only calculate the CRC.
+bool writeData(QIODevice* device, const char* p, qint64 n, quint32* pnCrc)
+{
+	if (pnCrc != NULL)
+		*pnCrc = crc32(*pnCrc, p, n);
+	return (device == NULL || device->write(p, n) == n);
+}
+
+}
+
+
+WaveExporter::WaveExporter(EadFile* file)
+	: m_nRows(0)
+{
+	CHECK_PARAM_RET(file != NULL);
+
+	// Same waves as the original CSV export: all waves with data
+	foreach (RecInfo* rec, file->recs())
+	{
+		foreach (WaveInfo* wave, rec->waves())
+		{
+			if (!wave->display.isEmpty())
+			{
+				Column col;
+				col.sName = wave->sName;
+				col.data = wave->display;
+				col.nShift = wave->shift();
+				m_columns << col;
+				m_nRows = qMax(m_nRows, col.nShift + col.data.size());
+			}
+		}
+	}
+}
+
+void WaveExporter::formatCsvChunk(CsvChunk& chunk)
+{
+	const QList<Column>& columns = chunk.exporter->m_columns;
+	const int nCols = columns.size();
+	const int nNewline = int(sizeof(g_sNewline)) - 1;
+
+	// Format straight into the chunk's buffer, which is large enough for the longest possible rows
+	chunk.text.resize(chunk.nRows * (nCols * DOUBLE_FORMAT_BUFFER_SIZE + nNewline));
+	char* s = chunk.text.data();
+	for (int tidx = chunk.iRowFirst; tidx < chunk.iRowFirst + chunk.nRows; tidx++)
+	{
+		for (int iCol = 0; iCol < nCols; iCol++)
+		{
+			const Column& col = columns[iCol];
+			int didx = tidx - col.nShift;
+			double n = (didx >= 0 && didx < col.data.size()) ? col.data[didx] : 0;
+			if (iCol > 0)
+				*s++ = ',';
+			s += formatDouble(n, s);
+		}
+		memcpy(s, g_sNewline, nNewline);
+		s += nNewline;
+	}
+	chunk.text.resize(int(s - chunk.text.constData()));
+}
+
+bool WaveExporter::exportCsv(const QString& sFilename) const
+{
+	if (isEmpty())
+		return fail(tr("There is no data to export."));
+
+	QFile file(sFilename);
+	if (!file.open(QIODevice::WriteOnly))
+		return fail(file.errorString());
+
+	// Header row
+	QStringList cols;
+	foreach (const Column& col, m_columns)
+		cols << QString("\"%0\"").arg(col.sName);
+	QByteArray header = cols.join(",").toLocal8Bit() + g_sNewline;
+	if (file.write(header) != header.size())
+		return fail(file.errorString());
+
+	// Data rows: format a batch of chunks in parallel, then write them in order.
+	// Only one batch is held in memory at a time.
+	const int nChunksPerBatch = qMax(1, QThread::idealThreadCount()) * 4;
+	const int nChunkRows = qMax(1, CSV_CHUNK_BYTES / (m_columns.size() * DOUBLE_FORMAT_BUFFER_SIZE));
+	QVector<CsvChunk> chunks;
+	for (int iRow = 0; iRow < m_nRows; )
+	{
+		chunks.clear();
+		for (int i = 0; i < nChunksPerBatch && iRow < m_nRows; i++)
+		{
+			CsvChunk chunk;
+			chunk.exporter = this;
+			chunk.iRowFirst = iRow;
+			chunk.nRows = qMin(nChunkRows, m_nRows - iRow);
+			chunks << chunk;
+			iRow += chunk.nRows;
+		}
+
+		QtConcurrent::blockingMap(chunks, formatCsvChunk);
+
+		for (int i = 0; i < chunks.size(); i++)
+		{
+			if (file.write(chunks[i].text) != chunks[i].text.size())
+				return fail(file.errorString());
+		}
+	}
+
+	return true;
+}
+
+bool WaveExporter::fail(const QString& sError) const
+{
+	m_sError = sError;
+	return false;
+}
+
+QByteArray WaveExporter::npyHeader(const QByteArray& sShape)
+{
+	const char* sDescr = (Q_BYTE_ORDER == Q_LITTLE_ENDIAN) ? "<f8" : ">f8";
+	QByteArray dict = QByteArray("{'descr': '") + sDescr + "', 'fortran_order': True, 'shape': " + sShape + ", }";
+
+	// Magic string, version 1.0 and the length of the header dictionary
+	const int nPrefix = 10;
+	// Pad with spaces and a final newline so that the data starts at a multiple of 64 bytes
+	int nDict = dict.size() + 1;
+	nDict += (64 - (nPrefix + nDict) % 64) % 64;
+	dict = dict.leftJustified(nDict - 1, ' ') + '\n';
+
+	QByteArray a("\x93NUMPY\x01\x00", 8);
+	appendUInt16(a, quint16(dict.size()));
+	a += dict;
+	return a;
+}
+
+bool WaveExporter::writeColumn(QIODevice* device, int iCol, quint32* pnCrc) const
+{
+	const Column& col = m_columns[iCol];
+
+	// Range of the column's data which lies on the timeline
+	const int didxFirst = qMax(0, -col.nShift);
+	const int didxEnd = qMin(col.data.size(), m_nRows - col.nShift);
+	const int nBefore = qBound(0, col.nShift, m_nRows);
+	const int nData = qMax(0, didxEnd - didxFirst);
+	const int nAfter = m_nRows - nBefore - nData;
+
+	for (int n = nBefore; n > 0; n -= ZERO_BUFFER_SIZE)
+	{
+		if (!writeData(device, (const char*) g_anZeros, qint64(qMin(n, ZERO_BUFFER_SIZE)) * sizeof(double), pnCrc))
+			return false;
+	}
+	if (nData > 0 && !writeData(device, (const char*) (col.data.constData() + didxFirst), qint64(nData) * sizeof(double), pnCrc))
+		return false;
+	for (int n = nAfter; n > 0; n -= ZERO_BUFFER_SIZE)
+	{
+		if (!writeData(device, (const char*) g_anZeros, qint64(qMin(n, ZERO_BUFFER_SIZE)) * sizeof(double), pnCrc))
+			return false;
+	}
+	return true;
+}
+
+bool WaveExporter::exportNpy(const QString& sFilename) const
+{
+	if (isEmpty())
+		return fail(tr("There is no data to export."));
+
+	QFile file(sFilename);
+	if (!file.open(QIODevice::WriteOnly))
+		return fail(file.errorString());
+
+	QByteArray header = npyHeader(QString("(%0, %1)").arg(m_nRows).arg(m_columns.size()).toLatin1());
+	if (file.write(header) != header.size())
+		return fail(file.errorString());
+
+	// Fortran order: one column after the other
+	for (int iCol = 0; iCol < m_columns.size(); iCol++)
+	{
+		if (!writeColumn(&file, iCol, NULL))
+			return fail(file.errorString());
+	}
+	return true;
+}
+
+QStringList WaveExporter::npzNames() const
+{
+	QStringList names;
+	QSet<QString> used;
+	foreach (const Column& col, m_columns)
+	{
+		// Restrict names to valid Python identifiers so they can be used as attributes
+		QString sBase;
+		foreach (QChar c, col.sName.trimmed())
+			sBase += (c.unicode() < 128 && (c.isLetterOrNumber() || c == '_')) ? c : QChar('_');
+		if (sBase.isEmpty() || sBase[0].isDigit())
+			sBase.prepend("wave_");
+
+		QString sName = sBase;
+		for (int i = 2; used.contains(sName); i++)
+			sName = QString("%0_%1").arg(sBase).arg(i);
+		used << sName;
+		names << sName;
+	}
+	return names;
+}
+
+bool WaveExporter::exportNpz(const QString& sFilename) const
+{
+	if (isEmpty())
+		return fail(tr("There is no data to export."));
+
+	// Without zip64 records, sizes and offsets are limited to 32 bits
+	const qint64 nColumnBytes = qint64(m_nRows) * sizeof(double);
+	if ((nColumnBytes + 1024) * m_columns.size() >= Q_INT64_C(0xFFFFFFFF))
+		return fail(tr("The data is too large for a .npz archive, which is limited to 4 GB.  Please export it as a .npy file instead."));
+
+	QFile file(sFilename);
+	if (!file.open(QIODevice::WriteOnly))
+		return fail(file.errorString());
+
+	const QByteArray header = npyHeader(QString("(%0,)").arg(m_nRows).toLatin1());
+	const quint32 nSize = quint32(header.size() + nColumnBytes);
+	// MS-DOS date 1980-01-01
+	const quint16 nDate = 0x21;
+
+	const QStringList names = npzNames();
+	QByteArray centralDirectory;
+	for (int iCol = 0; iCol < m_columns.size(); iCol++)
+	{
+		const QByteArray sEntry = (names[iCol] + ".npy").toLatin1();
+		const quint32 nOffset = quint32(file.pos());
+
+		// The CRC is needed before the data, so run over the column once without writing
+		quint32 nCrc = crc32(0, header.constData(), header.size());
+		writeColumn(NULL, iCol, &nCrc);
+
+		// Local file header
+		QByteArray local;
+		appendUInt32(local, 0x04034b50);
+		appendUInt16(local, 20); // version needed to extract
+		appendUInt16(local, 0); // flags
+		appendUInt16(local, 0); // stored
+		appendUInt16(local, 0); // time
+		appendUInt16(local, nDate);
+		appendUInt32(local, nCrc);
+		appendUInt32(local, nSize); // compressed size
+		appendUInt32(local, nSize); // uncompressed size
+		appendUInt16(local, quint16(sEntry.size()));
+		appendUInt16(local, 0); // extra field length
+		local += sEntry;
+		local += header;
+		if (file.write(local) != local.size())
+			return fail(file.errorString());
+		if (!writeColumn(&file, iCol, NULL))
+			return fail(file.errorString());
+
+		// Central directory entry
+		appendUInt32(centralDirectory, 0x02014b50);
+		appendUInt16(centralDirectory, 20); // version made by
+		appendUInt16(centralDirectory, 20); // version needed to extract
+		appendUInt16(centralDirectory, 0); // flags
+		appendUInt16(centralDirectory, 0); // stored
+		appendUInt16(centralDirectory, 0); // time
+		appendUInt16(centralDirectory, nDate);
+		appendUInt32(centralDirectory, nCrc);
+		appendUInt32(centralDirectory, nSize);
+		appendUInt32(centralDirectory, nSize);
+		appendUInt16(centralDirectory, quint16(sEntry.size()));
+		appendUInt16(centralDirectory, 0); // extra field length
+		appendUInt16(centralDirectory, 0); // comment length
+		appendUInt16(centralDirectory, 0); // disk number
+		appendUInt16(centralDirectory, 0); // internal attributes
+		appendUInt32(centralDirectory, 0); // external attributes
+		appendUInt32(centralDirectory, nOffset);
+		centralDirectory += sEntry;
+	}
+
+	// End of central directory record
+	const quint32 nDirectoryOffset = quint32(file.pos());
+	QByteArray end;
+	appendUInt32(end, 0x06054b50);
+	appendUInt16(end, 0); // this disk
+	appendUInt16(end, 0); // disk with the central directory
+	appendUInt16(end, quint16(m_columns.size()));
+	appendUInt16(end, quint16(m_columns.size()));
+	appendUInt32(end, quint32(centralDirectory.size()));
+	appendUInt32(end, nDirectoryOffset);
+	appendUInt16(end, 0); // comment length
+	centralDirectory += end;
+
+	if (file.write(centralDirectory) != centralDirectory.size())
+		return fail(file.errorString());
+	return true;
+}
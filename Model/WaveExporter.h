@@ -0,0 +1,97 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __WAVEEXPORTER_H
+#define __WAVEEXPORTER_H
+
+#include <QByteArray>
+#include <QCoreApplication>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+
+class QIODevice;
+
+class EadFile;
+
+
+/// Fast export of the display data of all waves in a file.
+/// Every wave is a column aligned on the common timeline, so row i holds the values
+/// at time i / EAD_SAMPLES_PER_SECOND, with zeros where a wave has no data.
+class WaveExporter
+{
+	Q_DECLARE_TR_FUNCTIONS(WaveExporter)
+
+public:
+	WaveExporter(EadFile* file);
+
+	/// True if no wave has any data to export
+	bool isEmpty() const { return m_columns.isEmpty(); }
+	int columnCount() const { return m_columns.size(); }
+	int rowCount() const { return m_nRows; }
+
+	/// Write a CSV file with a header row of wave names.
+	/// Rows are formatted in parallel, in chunks which are then written in order.
+	bool exportCsv(const QString& sFilename) const;
+	/// Write a NumPy .npy file holding a float64 array of shape (rows, columns).
+	/// The array is stored in Fortran order so that each column is written straight from the wave's data.
+	bool exportNpy(const QString& sFilename) const;
+	/// Write an uncompressed NumPy .npz archive with one float64 array per wave, named after the wave.
+	/// This fails if the archive would be larger than 4 GB, since zip64 isn't supported.
+	bool exportNpz(const QString& sFilename) const;
+	/// Description of the error if an export failed
+	const QString& errorString() const { return m_sError; }
+
+private:
+	class Column
+	{
+	public:
+		QString sName;
+		/// Shared copy of WaveInfo::display
+		QVector<double> data;
+		/// Timeline index of data[0]
+		int nShift;
+	};
+
+	class CsvChunk
+	{
+	public:
+		const WaveExporter* exporter;
+		int iRowFirst;
+		int nRows;
+		QByteArray text;
+	};
+
+	/// Remember the error and return false
+	bool fail(const QString& sError) const;
+	static void formatCsvChunk(CsvChunk& chunk);
+	/// Header of a .npy file with the given shape, e.g. "(100, 3)"
+	static QByteArray npyHeader(const QByteArray& sShape);
+	/// Write column iCol padded to the full timeline, and update the CRC if pnCrc isn't NULL
+	bool writeColumn(QIODevice* device, int iCol, quint32* pnCrc) const;
+	/// Unique names of the arrays in the .npz archive
+	QStringList npzNames() const;
+
+private:
+	QList<Column> m_columns;
+	int m_nRows;
+	mutable QString m_sError;
+};
+
+#endif
@@ -29,6 +29,12 @@
 #define RADIUS (EAD_SAMPLES_PER_SECOND / 2)
 
 
+WavePeakScan::WavePeakScan()
+	: bValid(false), nSamples(0), iNext(RADIUS)
+{
+}
+
+
 QString WaveInfo::getWaveTypeName(WaveType type)
 {
 	QString sType;
@@ -70,6 +76,7 @@ void WaveInfo::copyFrom(const WaveInfo* other)
 	peaks0 << other->peaks0;
 	peaksChosen.clear();
 	peaksChosen << other->peaksChosen;
+	m_peakScan = WavePeakScan();
 	type = other->type;
 	//sName;
 	sComment = other->sComment;
@@ -92,10 +99,73 @@ void WaveInfo::setShift(int nShift)
 	m_nShift = nShift;
 }
 
+void WaveInfo::removeFront(int nSamples)
+{
+	CHECK_PARAM_RET(nSamples >= 0 && nSamples <= raw.size());
+	if (nSamples == 0)
+		return;
+
+	raw.remove(0, nSamples);
+	if (display.size() >= nSamples)
+		display.remove(0, nSamples);
+	if (std.size() >= nSamples)
+		std.remove(0, nSamples);
+	m_nShift += nSamples;
+
+	for (int i = peaks0.size() - 1; i >= 0; i--)
+	{
+		WavePeakInfo& peak = peaks0[i];
+		if (peak.left.i < nSamples)
+			peaks0.removeAt(i);
+		else
+		{
+			peak.left.i -= nSamples;
+			peak.middle.i -= nSamples;
+			peak.right.i -= nSamples;
+		}
+	}
+
+	for (int i = peaksChosen.size() - 1; i >= 0; i--)
+	{
+		WavePeakChosenInfo& peak = peaksChosen[i];
+		if (!peak.didxs.isEmpty() && peak.didxs.first() < nSamples)
+			peaksChosen.removeAt(i);
+		else
+		{
+			for (int iDidx = 0; iDidx < peak.didxs.size(); iDidx++)
+				peak.didxs[iDidx] -= nSamples;
+		}
+	}
+
+	// Keep the incremental peak search going on the remaining samples
+	WavePeakScan& scan = m_peakScan;
+	if (scan.bValid)
+	{
+		scan.nSamples = qMax(scan.nSamples - nSamples, 0);
+		scan.iNext = qMax(scan.iNext - nSamples, RADIUS);
+		for (int i = scan.pending.size() - 1; i >= 0; i--)
+		{
+			WavePeakCandidate& candidate = scan.pending[i];
+			if (candidate.info.left.i < nSamples)
+				scan.pending.removeAt(i);
+			else
+			{
+				candidate.info.left.i -= nSamples;
+				candidate.info.middle.i -= nSamples;
+				candidate.iWalk -= nSamples;
+				candidate.iMin -= nSamples;
+			}
+		}
+	}
+}
+
 void WaveInfo::calcDisplayData(const QList<FilterTesterInfo*> filters)
 {
 	const short* orig = raw.constData();
-	
+
+	// Peaks which were found incrementally remain valid if the display data doesn't actually change,
+	// e.g. when a recording is saved without any filters
+	bool bChanged = (display.size() != raw.size());
 	display.resize(raw.size());
 	double* changed = display.data();
 
@@ -103,55 +173,122 @@ void WaveInfo::calcDisplayData(const QList<FilterTesterInfo*> filters)
 	{
 		double n = *orig++;
 		n *= nRawToVoltageFactor;
+		if (*changed != n)
+			bChanged = true;
 		*changed++ = n;
 	}
 
-	foreach (FilterInfo* filter, filters) {
+	foreach (FilterTesterInfo* filter, filters) {
 		//if (filter->waves().contains(this)) {
 		if (filter->waveType() == this->type) {
 			filter->filter(display);
+			if (filter->filterId() != 0)
+				bChanged = true;
 		}
 	}
+
+	if (bChanged)
+		m_peakScan = WavePeakScan();
 }
 
 void WaveInfo::findFidPeaks()
 {
-	// First find all maximums
-	QList<WavePoint> peaksAll;
-	const double* data = display.constData();
-	for (int i = RADIUS; i < display.size() - RADIUS; i++)
+	m_peakScan = WavePeakScan();
+	peaks0.clear();
+	scanFidPeaks(true);
+}
+
+void WaveInfo::updateFidPeaks(bool bFinal)
+{
+	// Start over if the data was replaced since the last scan
+	if (!m_peakScan.bValid || m_peakScan.nSamples > display.size())
 	{
-		double n = data[i];
-		double nComp = n + 1e-10;
+		m_peakScan = WavePeakScan();
+		peaks0.clear();
+	}
+	scanFidPeaks(bFinal);
 
-		// Find whether there is a peak at 'i' with RADIUS samples
-		bool bMax = true;
-		for (int j = i - RADIUS; j < i; j++)
-		{
-			if (data[j] >= nComp)
-			{
-				bMax = false;
-				break;
-			}
-		}
-		for (int j = i + 1; j <= i + RADIUS; j++)
+	// The user may have chosen peaks in the meantime
+	if (bFinal)
+	{
+		for (int i = 0; i < peaks0.size(); i++)
+			peaks0[i].bEnabled = !isPeakChosen(peaks0[i].middle.i);
+	}
+}
+
+void WaveInfo::scanFidPeaks(bool bFinal)
+{
+	WavePeakScan& scan = m_peakScan;
+	scan.bValid = true;
+	scan.nSamples = display.size();
+
+	// Find new maximums; the look-ahead of RADIUS samples is all that's needed
+	while (scan.iNext < display.size() - RADIUS)
+	{
+		const int i = scan.iNext;
+		scan.iNext = i + 1;
+		if (isFidMaximum(i))
 		{
-			if (data[j] >= nComp)
-			{
-				bMax = false;
-				break;
-			}
+			WavePeakCandidate candidate(WavePoint(i, display[i]));
+			candidate.info.left = findFidPeakLeft(candidate.info.middle);
+			scan.pending << candidate;
+			scan.iNext = i + RADIUS / 2 + 1;
 		}
+	}
 
-		if (bMax)
+	// Continue looking for the right edges of the pending peaks
+	for (int i = 0; i < scan.pending.size(); i++)
+	{
+		WavePeakCandidate& candidate = scan.pending[i];
+		if (!candidate.bDone)
+			candidate.bDone = findFidPeakRight(candidate, bFinal);
+	}
+
+	// Hand over the finished peaks in order
+	while (!scan.pending.isEmpty() && scan.pending.first().bDone)
+	{
+		WavePeakCandidate candidate = scan.pending.takeFirst();
+		if (isFidPeakWideEnough(candidate.info))
 		{
-			//qDebug() << "Peak:" << i << n;
-			peaksAll << WavePoint(i, n);
-			i += RADIUS / 2;
+			candidate.info.bEnabled = !isPeakChosen(candidate.info.middle.i);
+			peaks0 << candidate.info;
 		}
 	}
+}
+
+bool WaveInfo::isFidMaximum(int i) const
+{
+	const double* data = display.constData();
+	double nComp = data[i] + 1e-10;
 
-	findFidPeaks(peaksAll, peaks0);
+	// Find whether there is a peak at 'i' with RADIUS samples
+	for (int j = i - RADIUS; j < i; j++)
+	{
+		if (data[j] >= nComp)
+			return false;
+	}
+	for (int j = i + 1; j <= i + RADIUS; j++)
+	{
+		if (data[j] >= nComp)
+			return false;
+	}
+	return true;
+}
+
+bool WaveInfo::isFidPeakWideEnough(const WavePeakInfo& info) const
+{
+	return (info.left.i + RADIUS < info.middle.i && info.right.i - RADIUS > info.middle.i);
+}
+
+bool WaveInfo::isPeakChosen(int didx) const
+{
+	// Check whether this peak has already been chosen by the user:
+	for (int iChosen = 0; iChosen < peaksChosen.size(); iChosen++)
+	{
+		if (peaksChosen[iChosen].didxs[1] == didx)
+			return true;
+	}
+	return false;
 }
 
 bool WaveInfo::findFidPeak(int didxLeft, int didxRight, WavePeakInfo* peak) const
@@ -161,38 +298,14 @@ bool WaveInfo::findFidPeak(int didxLeft, int didxRight, WavePeakInfo* peak) cons
 	didxLeft = qMax(didxLeft, RADIUS);
 	didxRight = qMin(didxRight, display.size() - RADIUS - 1);
 
-	// REFACTOR: mostly duplicates code from above
 	// First find all maximums
 	QList<WavePoint> peaksAll;
-	const double* data = display.constData();
 	for (int i = didxLeft; i < didxRight; i++)
 	{
-		double n = data[i];
-		double nComp = n + 1e-10;
-
-		// Find whether there is a peak at 'i' with RADIUS samples
-		bool bMax = true;
-		for (int j = i - RADIUS; j < i; j++)
-		{
-			if (data[j] >= nComp)
-			{
-				bMax = false;
-				break;
-			}
-		}
-		for (int j = i + 1; j <= i + RADIUS; j++)
-		{
-			if (data[j] >= nComp)
-			{
-				bMax = false;
-				break;
-			}
-		}
-
-		if (bMax)
+		if (isFidMaximum(i))
 		{
 			//qDebug() << "Peak:" << i << n;
-			peaksAll << WavePoint(i, n);
+			peaksAll << WavePoint(i, display[i]);
 			i += RADIUS / 2;
 		}
 	}
@@ -225,116 +338,113 @@ bool WaveInfo::findFidPeak(int didxLeft, int didxRight, WavePeakInfo* peak) cons
 
 void WaveInfo::findFidPeaks(const QList<WavePoint>& peaksAll, QList<WavePeakInfo>& peaks) const
 {
-	WavePeakInfo info;
 	peaks.clear();
 	foreach (WavePoint pt, peaksAll)
 	{
-		{
-			// Distance to the left from pt.i
-			int nIncreasing = 0;
-			double nMin = pt.n;
-			double nPrev = pt.n;
-			int iMin = pt.i;
-			int i = pt.i;
-			int nSamples = 1;
-			while(true)
-			{
-				i--;
-				nSamples++;
+		WavePeakCandidate candidate(pt);
+		candidate.info.left = findFidPeakLeft(pt);
+		findFidPeakRight(candidate, true);
 
-				double n = display[i];
-				double nComp = n - 1e-10;
-				if (n < nMin)
-				{
-					nMin = n;
-					iMin = i;
-				}
-				if (nComp <= nPrev)
-					nIncreasing++;
-
-				nPrev = n;
+		//qDebug() << "Width:" << info.left.i << pt.i << info.right.i;
 
-				double nFraction = double(nIncreasing) / nSamples;
-				if (i <= 0)
-					break;
-				if (nSamples > RADIUS / 2 && nFraction < 0.8)
-					break;
-			}
+		if (isFidPeakWideEnough(candidate.info))
+		{
+			candidate.info.bEnabled = !isPeakChosen(pt.i);
+			//qDebug() << "\tOK";
+			peaks << candidate.info;
+		}
+	}
+}
 
-			double nMinThreshold = nMin + (pt.n - nMin) * 0.05;
-			for (i = pt.i - 1; i > iMin; i--)
-			{
-				if (display[i] <= nMinThreshold)
-					break;
-			}
-			i++;
+WavePoint WaveInfo::findFidPeakLeft(const WavePoint& pt) const
+{
+	// Distance to the left from pt.i
+	int nIncreasing = 0;
+	double nMin = pt.n;
+	double nPrev = pt.n;
+	int iMin = pt.i;
+	int i = pt.i;
+	int nSamples = 1;
+	while(true)
+	{
+		i--;
+		nSamples++;
 
-			info.left = WavePoint(i, display[i]);
+		double n = display[i];
+		double nComp = n - 1e-10;
+		if (n < nMin)
+		{
+			nMin = n;
+			iMin = i;
 		}
+		if (nComp <= nPrev)
+			nIncreasing++;
 
-		{
-			// Distance to the right from pt.i
-			int nDecreasing = 0;
-			double nMin = pt.n;
-			double nPrev = pt.n;
-			int iMin = pt.i;
-			int i = pt.i;
-			int nSamples = 1;
-			while (true)
-			{
-				i++;
-				nSamples++;
-				double n = display[i];
-				double nComp = n - 1e-10;
-				if (n < nMin)
-				{
-					nMin = n;
-					iMin = i;
-				}
-				if (nComp <= nPrev)
-					nDecreasing++;
+		nPrev = n;
 
-				nPrev = n;
+		double nFraction = double(nIncreasing) / nSamples;
+		if (i <= 0)
+			break;
+		if (nSamples > RADIUS / 2 && nFraction < 0.8)
+			break;
+	}
 
-				double nFraction = double(nDecreasing) / nSamples;
-				if (i == display.size() - 1)
-					break;
-				if (nSamples > RADIUS / 2 && nFraction < 0.8)
-					break;
-			}
+	double nMinThreshold = nMin + (pt.n - nMin) * 0.05;
+	for (i = pt.i - 1; i > iMin; i--)
+	{
+		if (display[i] <= nMinThreshold)
+			break;
+	}
+	i++;
 
-			double nMinThreshold = nMin + (pt.n - nMin) * 0.05;
-			for (i = pt.i + 1; i < iMin; i++)
-			{
-				if (display[i] <= nMinThreshold)
-					break;
-			}
-			i--;
+	return WavePoint(i, display[i]);
+}
+
+bool WaveInfo::findFidPeakRight(WavePeakCandidate& candidate, bool bFinal) const
+{
+	const WavePoint& pt = candidate.info.middle;
 
-			info.right = WavePoint(i, display[i]);
+	// Distance to the right from pt.i
+	bool bEdge = false;
+	while (candidate.iWalk < display.size() - 1)
+	{
+		candidate.iWalk++;
+		candidate.nWalkSamples++;
+		double n = display[candidate.iWalk];
+		double nComp = n - 1e-10;
+		if (n < candidate.nMin)
+		{
+			candidate.nMin = n;
+			candidate.iMin = candidate.iWalk;
 		}
+		if (nComp <= candidate.nPrev)
+			candidate.nDecreasing++;
 
-		//qDebug() << "Width:" << info.left.i << pt.i << info.right.i;
+		candidate.nPrev = n;
 
-		if (info.left.i + RADIUS < pt.i && info.right.i - RADIUS > pt.i)
+		double nFraction = double(candidate.nDecreasing) / candidate.nWalkSamples;
+		if (candidate.nWalkSamples > RADIUS / 2 && nFraction < 0.8)
 		{
-			// Check whether this peak has already been chosen by the user:
-			bool bChosen = false;
-			for (int iChosen = 0; iChosen < peaksChosen.size(); iChosen++)
-			{
-				if (peaksChosen[iChosen].didxs[1] == pt.i)
-				{
-					bChosen = true;
-					break;
-				}
-			}
-
-			info.bEnabled = !bChosen;
-			info.middle = pt;
-			//qDebug() << "\tOK";
-			peaks << info;
+			bEdge = true;
+			break;
 		}
 	}
+
+	// Reaching the end of the data only ends the walk once no more data will be appended
+	if (!bEdge && !bFinal)
+		return false;
+
+	double nMinThreshold = candidate.nMin + (pt.n - candidate.nMin) * 0.05;
+	int i;
+	for (i = pt.i + 1; i < candidate.iMin; i++)
+	{
+		if (display[i] <= nMinThreshold)
+			break;
+	}
+	i--;
+
+	candidate.info.right = WavePoint(i, display[i]);
+	return true;
 }
 
 int WaveInfo::findNextEadMin(int didxLeft, int didxRight) const
@@ -620,7 +730,8 @@ void WaveInfo::calcPeakArea(int iPeak)
 {
 	CHECK_PARAM_RET(iPeak >= 0 && iPeak < peaksChosen.size());
 
-	WavePeakChosenInfo& peak = peaksChosen[iPeak];
+	// Read through a const reference, so that the list is only detached from the edit history's copy if the area changes
+	const WavePeakChosenInfo& peak = peaksChosen.at(iPeak);
 	if (peak.type != MarkerType_FidPeak)
 		return;
 	
@@ -636,7 +747,8 @@ void WaveInfo::calcPeakArea(int iPeak)
 	int nWidth = peak.didxs[2] - peak.didxs[0] + 1;
 	nArea -= (nHeight * nWidth) / 2;
 
-	peak.nArea = nArea;
+	if (nArea != peak.nArea)
+		peaksChosen[iPeak].nArea = nArea;
 }
 
 void WaveInfo::calcPeakAreas()
@@ -651,12 +763,16 @@ void WaveInfo::calcAreaPercents()
 	double nTotal = 0;
 	for (int i = 0; i < peaksChosen.size(); i++)
 	{
-		if (peaksChosen[i].type == MarkerType_FidPeak)
-			nTotal += peaksChosen[i].nArea;
+		if (peaksChosen.at(i).type == MarkerType_FidPeak)
+			nTotal += peaksChosen.at(i).nArea;
 	}
 	for (int i = 0; i < peaksChosen.size(); i++)
 	{
-		if (peaksChosen[i].type == MarkerType_FidPeak)
-			peaksChosen[i].nPercent = peaksChosen[i].nArea / nTotal;
+		const WavePeakChosenInfo& peak = peaksChosen.at(i);
+		if (peak.type != MarkerType_FidPeak)
+			continue;
+		const double nPercent = peak.nArea / nTotal;
+		if (nPercent != peak.nPercent)
+			peaksChosen[i].nPercent = nPercent;
 	}
 }
@@ -59,6 +59,50 @@ public:
 	WavePoint right;
 };
 
+/// A maximum of an FID wave whose right edge is still being looked for
+class WavePeakCandidate
+{
+public:
+	/// left and middle are known, right is set once bDone
+	WavePeakInfo info;
+	bool bDone;
+	/// State of the walk to the right of the maximum
+	int iWalk;
+	int nWalkSamples;
+	int nDecreasing;
+	double nMin;
+	double nPrev;
+	int iMin;
+
+	WavePeakCandidate()
+		: bDone(false), iWalk(-1), nWalkSamples(0), nDecreasing(0), nMin(0), nPrev(0), iMin(-1)
+	{
+	}
+
+	explicit WavePeakCandidate(const WavePoint& pt)
+		: bDone(false), iWalk(pt.i), nWalkSamples(1), nDecreasing(0), nMin(pt.n), nPrev(pt.n), iMin(pt.i)
+	{
+		info.bEnabled = false;
+		info.middle = pt;
+	}
+};
+
+/// Progress of the FID peak detection through a wave's display data
+class WavePeakScan
+{
+public:
+	/// Whether the scan is consistent with the current display data
+	bool bValid;
+	/// Number of display samples which were available at the last scan
+	int nSamples;
+	/// Next sample to check for a maximum
+	int iNext;
+	/// Maximums whose right edges haven't been found yet, in order
+	QList<WavePeakCandidate> pending;
+
+	WavePeakScan();
+};
+
 class WavePeakChosenInfo
 {
 public:
@@ -73,6 +117,12 @@ public:
 	{
 		type = MarkerType_Generic;
 	}
+
+	/// Compares the marker's position; nArea and nPercent are left out, since they're calculated from the display data
+	bool operator==(const WavePeakChosenInfo& other) const
+	{
+		return type == other.type && didxs == other.didxs;
+	}
 };
 
 
@@ -90,6 +140,11 @@ public:
 		: bVisible(true), nVoltsPerDivision(1), nDivisionOffset(5)
 	{
 	}
+
+	bool operator==(const WavePos& other) const
+	{
+		return bVisible == other.bVisible && nVoltsPerDivision == other.nVoltsPerDivision && nDivisionOffset == other.nDivisionOffset;
+	}
 };
 
 
@@ -137,11 +192,21 @@ public:
 	/// Negative values shift the dataset to the left.
 	int shift() const;
 	void setShift(int nShift);
+	/// Remove the first nSamples samples, e.g. once they've been written to disk during continuous monitoring.
+	/// The shift is increased accordingly so that the remaining samples keep their position on the timeline.
+	/// Peaks which start in the removed samples are dropped.
+	void removeFront(int nSamples);
 
 	/// Convert the raw data to display data
 	void calcDisplayData(const QList<FilterTesterInfo*> filters);
 
+	/// Find all possible FID peaks and put them in peaks0
 	void findFidPeaks();
+	/// Continue finding FID peaks in the display data appended since the last call, e.g. while recording.
+	/// Peaks are added to peaks0 once their right edge is known; the work only depends on the number of new samples.
+	/// If the display data was replaced in the meantime, the search starts over.
+	/// @param bFinal true if no more data will be appended, so that peaks at the end of the data can be completed
+	void updateFidPeaks(bool bFinal = false);
 	bool findFidPeak(int didxLeft, int didxRight, WavePeakInfo* peak) const;
 
 	//int indexOfMax(int didxLeft, int didxRight) const;
@@ -167,10 +232,20 @@ public:
 
 private:
 	void findFidPeaks(const QList<WavePoint>& peaksAll, QList<WavePeakInfo>& peaks) const;
+	void scanFidPeaks(bool bFinal);
+	/// Whether display[i] is higher than all samples within RADIUS of it
+	bool isFidMaximum(int i) const;
+	bool isFidPeakWideEnough(const WavePeakInfo& info) const;
+	bool isPeakChosen(int didx) const;
+	WavePoint findFidPeakLeft(const WavePoint& pt) const;
+	/// Continue the walk to the right edge of the candidate peak
+	/// @returns true once the right edge has been found
+	bool findFidPeakRight(WavePeakCandidate& candidate, bool bFinal) const;
 
 private:
 	RecInfo* m_rec;
 	int m_nShift;
+	WavePeakScan m_peakScan;
 };
 
 #endif
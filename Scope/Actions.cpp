@@ -40,12 +40,25 @@ Actions::Actions(QObject *parent)
 		fileOpenRecentActions << act;
 	}
 
+	fileFindInCatalog = new QAction(tr("&Find in Catalog..."), this);
+	fileFindInCatalog->setShortcut(QKeySequence::Find);
+	fileFindInCatalog->setToolTip(tr("Search the saved projects by date, comment, wave names, markers and peak times"));
+
 	fileSave = new QAction(tr("&Save"), this);
 	fileSave->setShortcut(QKeySequence::Save);
 
 	fileSaveAs = new QAction(tr("Save &As..."), this);
 	fileSaveAs->setShortcut(QKeySequence::SaveAs);
 
+	fileCompact = new QAction(tr("Co&mpact Project File"), this);
+	fileCompact->setToolTip(tr("Rewrite the project file to free the space of data which is no longer used"));
+
+	fileSampleStore = new QAction(tr("Shared Sample S&tore..."), this);
+	fileSampleStore->setToolTip(tr("Save the recordings to a store which several projects can share, so that recordings imported into several projects are only stored once"));
+
+	fileCollectSampleStore = new QAction(tr("C&lean Up Sample Store"), this);
+	fileCollectSampleStore->setToolTip(tr("Delete the recordings from the shared sample store which no project uses anymore"));
+
 	fileComment = new QAction(tr("Edit File &Comment..."), this);
 	fileComment->setIcon(QIcon(":/images/comment-24x24.png"));
 	fileComment->setIconText(tr("Comment"));
@@ -65,6 +78,17 @@ Actions::Actions(QObject *parent)
 	fileExit = new QAction(tr("E&xit"), this);
 	fileExit->setShortcut(QKeySequence::Quit);
 
+	//
+	// Edit Menu
+	//
+
+	editUndo = new QAction(tr("&Undo"), this);
+	editUndo->setShortcut(QKeySequence::Undo);
+	editUndo->setToolTip(tr("Revert the last change to the waves, markers, filters or comment"));
+
+	editRedo = new QAction(tr("&Redo"), this);
+	editRedo->setShortcut(QKeySequence::Redo);
+
 	//
 	// View Menu
 	//
@@ -32,8 +32,12 @@ public:
 	QAction* fileNew;
 	QAction* fileOpen;
 	QList<QAction*> fileOpenRecentActions;
+	QAction* fileFindInCatalog;
 	QAction* fileSave;
 	QAction* fileSaveAs;
+	QAction* fileCompact;
+	QAction* fileSampleStore;
+	QAction* fileCollectSampleStore;
 	QAction* fileComment;
 	QAction* fileImport;
 	QAction* fileExportSignalData;
@@ -42,6 +46,9 @@ public:
 	QAction* fileLoadSampleProject;
 	QAction* fileExit;
 
+	QAction* editUndo;
+	QAction* editRedo;
+
 	QAction* viewViewMode;
 	QAction* viewMarkersMode;
 	QAction* viewPublishMode;
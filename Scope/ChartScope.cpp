@@ -1,12 +1,16 @@
 #include "ChartScope.h"
 
+#include <limits.h>
+
 #include <QtDebug>
 
 #include <Check.h>
 #include <EadEnums.h>
 #include <Globals.h>
 #include <IdacDriver/IdacSettings.h>
+#include <MonitorHistory.h>
 #include <PublisherSettings.h>
+#include <RecInfo.h>
 #include <Utils.h>
 #include <ViewSettings.h>
 #include <WaveInfo.h>
@@ -34,6 +38,7 @@ ChartScope::ChartScope(QObject* parent)
 	m_params.peakMode = EadMarkerMode_Show;
 	m_params.nPeakModeRecId = 0;
 
+	m_iScrollMin = 0;
 	m_iScrollMax = 0;
 	m_iScrollValue = 0;
 	m_nScrollPageStep = 1;
@@ -64,7 +69,10 @@ void ChartScope::setFile(EadFile* file)
 		m_params.file = file;
 
 		if (file != NULL)
+		{
 			connect(file, SIGNAL(waveListChanged()), this, SLOT(emitParamsChanged()));
+			connect(file, SIGNAL(displayChanged()), this, SLOT(on_file_displayChanged()));
+		}
 
 		// Zoom full if data available
 		if (file != NULL && file->recs().count() > 1)
@@ -175,10 +183,19 @@ void ChartScope::setRecordingOn(bool b)
 		// we might get the same WaveInfo address allocated to us again, which would make ChartPixmap think
 		// that it could still use the old RenderData. -- ellis, 2008-06-23
 		m_pixmap->clearRenderData();
+		m_params.previews.clear();
 		emit recordingLabelVisibleChanged(b);
 	}
 }
 
+void ChartScope::setPreview(const WaveInfo* wave, const RenderPreview* preview)
+{
+	if (preview != NULL)
+		m_params.previews[wave] = preview;
+	else
+		m_params.previews.remove(wave);
+}
+
 void ChartScope::setRecordingTime(int nSeconds)
 {
 	m_nRecordingTime = nSeconds;
@@ -211,8 +228,8 @@ void ChartScope::setSampleOffset(int nSampleOffset)
 {
 	if (nSampleOffset > m_iScrollMax)
 		nSampleOffset = m_iScrollMax;
-	if (nSampleOffset < 0)
-		nSampleOffset = 0;
+	if (nSampleOffset < m_iScrollMin)
+		nSampleOffset = m_iScrollMin;
 
 	if (nSampleOffset != m_params.nSampleOffset)
 	{
@@ -291,6 +308,25 @@ int ChartScope::sampleCount()
 	return nSamples;
 }
 
+int ChartScope::firstSample()
+{
+	int iFirst = 0;
+	if (m_params.view != NULL)
+	{
+		foreach (ViewWaveInfo* vwi, m_params.view->vwis())
+		{
+			const WaveInfo* wave = vwi->wave();
+			const MonitorHistory* history = (wave != NULL && wave->rec() != NULL) ? wave->rec()->monitorHistory() : NULL;
+			if (history != NULL)
+			{
+				qint64 n = wave->shift() - history->spilledSamples();
+				iFirst = int(qMin(qint64(iFirst), qMax(n, qint64(INT_MIN / 2))));
+			}
+		}
+	}
+	return iFirst;
+}
+
 void ChartScope::zoomOut()
 {
 	int iSample = m_pixmap->centerSample();
@@ -455,6 +491,12 @@ void ChartScope::updateScrollbar()
 	if (iMax < 0)
 		iMax = m_params.nSampleOffset;
 
+	int iMin = qMin(firstSample(), iMax);
+	if (iMin != m_iScrollMin)
+	{
+		m_iScrollMin = iMin;
+		emit scrollMinChanged(m_iScrollMin);
+	}
 	if (iMax != m_iScrollMax)
 	{
 		m_iScrollMax = iMax;
@@ -489,3 +531,9 @@ void ChartScope::on_view_changed(ViewChangeEvents events)
 		m_pixmap->clearRenderData();
 	emitParamsChanged();
 }
+
+void ChartScope::on_file_displayChanged()
+{
+	m_pixmap->clearRenderData();
+	emitParamsChanged();
+}
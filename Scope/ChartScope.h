@@ -30,6 +30,9 @@ public:
 	void setChartElementTimeMarker(ChartElementTimeMarker e, bool b);
 	void setRecordingOn(bool b);
 	void setRecordingTime(int nSeconds);
+	/// Draw the given recording wave from ready-made pixels (NULL to stop doing so).
+	/// The chart doesn't take ownership, and forgets all previews when recording is turned on or off.
+	void setPreview(const WaveInfo* wave, const RenderPreview* preview);
 
 	const ChartPixmapParams& params() { return m_params; }
 	const ChartPixmap* pixmap() { return m_pixmap; }
@@ -54,6 +57,9 @@ public:
 	void setHilight(ViewWaveInfo* vwi);
 
 	int sampleCount();
+	/// Earliest sample which can be scrolled to.
+	/// This is negative if a recording in the view is preceded by a monitoring history (see RecInfo::monitorHistory()).
+	int firstSample();
 
 	const ChartPixmap* draw(const QSize& sz);
 
@@ -63,6 +69,7 @@ signals:
 	void statusTextChanged(const QString& s);
 	void recordingLabelVisibleChanged(bool bVisible);
 	void recordingLabelTextChanged(const QString& sText);
+	void scrollMinChanged(int iScrollMin);
 	void scrollMaxChanged(int iScrollMax);
 	void scrollPageStepChanged(int nScrollPageStep);
 	void scrollSingleStepChanged(int nScrollSingleStep);
@@ -89,6 +96,8 @@ private:
 private slots:
 	void emitParamsChanged();
 	void on_view_changed(ViewChangeEvents events);
+	/// Called while a file is progressively loaded, when display data has been recalculated
+	void on_file_displayChanged();
 
 private:
 	ChartPixmapParams m_params;
@@ -107,6 +116,7 @@ private:
 	/// Seconds per division, for convenience
 	//double m_nSecondsPerDivision;
 
+	int m_iScrollMin;
 	int m_iScrollMax;
 	int m_nScrollPageStep;
 	int m_nScrollSingleStep;
@@ -17,6 +17,8 @@
 
 #include "MainScope.h"
 
+#include <math.h>
+
 #include <QtDebug>
 #include <QApplication>
 #include <QDir>
@@ -29,15 +31,25 @@
 #include <IdacDriver/IdacSettings.h>
 
 #include "AppDefines.h"
+#include "Catalog.h"
 #include "Check.h"
 #include "Globals.h"
 #include "MainScopeUi.h"
+#include "MonitorHistory.h"
 #include "RecordHandler.h"
+#include "SampleStore.h"
 #include "ViewSettings.h"
 
 #include "ChartScope.h"
 
 
+/// Number of samples which are moved to disk at once during continuous monitoring
+static int monitorChunkSamples(int nWindowSamples)
+{
+	return qMax(60 * EAD_SAMPLES_PER_SECOND, nWindowSamples / 10);
+}
+
+
 MainScope::MainScope(MainScopeUi* ui, IdacProxy* idac, QObject* parent)
 	: QObject(parent)
 {
@@ -57,6 +69,8 @@ MainScope::MainScope(MainScopeUi* ui, IdacProxy* idac, QObject* parent)
 
 	m_bRecentFilesMenuEnabled = false;
 	m_bWindowModified = false;
+	m_bKeepFileFormat = false;
+	m_bWaitingForSave = false;
 
 	m_bRecording = false;
 	m_vwiEad = NULL;
@@ -65,6 +79,10 @@ MainScope::MainScope(MainScopeUi* ui, IdacProxy* idac, QObject* parent)
 	m_recHandler = (m_idac != NULL) ? new RecordHandler(m_idac) : NULL;
 	m_recTimer = new QTimer(this);
 	m_recTimer->setInterval(200); // 200ms
+	m_iRecordingSampleOrigin = 0;
+	m_nPreviewSamplesPerPixel = 0;
+	m_nPreviewPixels = 0;
+	m_history = NULL;
 	connect(m_recTimer, SIGNAL(timeout()), this, SLOT(on_recTimer_timeout()));
 
 	updateActions();
@@ -79,9 +97,15 @@ MainScope::MainScope(MainScopeUi* ui, IdacProxy* idac, QObject* parent)
 	connect(m_actions->fileOpen, SIGNAL(triggered()), this, SLOT(on_actions_fileOpen_triggered()));
 	foreach (QAction* act, m_actions->fileOpenRecentActions)
 		connect(act, SIGNAL(triggered()), this, SLOT(on_actions_fileOpenRecentActions_triggered()));
+	connect(m_actions->fileFindInCatalog, SIGNAL(triggered()), this, SLOT(on_actions_fileFindInCatalog_triggered()));
 	connect(m_actions->fileSave, SIGNAL(triggered()), this, SLOT(on_actions_fileSave_triggered()));
 	connect(m_actions->fileSaveAs, SIGNAL(triggered()), this, SLOT(on_actions_fileSaveAs_triggered()));
+	connect(m_actions->fileCompact, SIGNAL(triggered()), this, SLOT(on_actions_fileCompact_triggered()));
+	connect(m_actions->fileSampleStore, SIGNAL(triggered()), this, SLOT(on_actions_fileSampleStore_triggered()));
+	connect(m_actions->fileCollectSampleStore, SIGNAL(triggered()), this, SLOT(on_actions_fileCollectSampleStore_triggered()));
 	connect(m_actions->fileComment, SIGNAL(triggered()), this, SLOT(on_actions_fileComment_triggered()));
+	connect(m_actions->editUndo, SIGNAL(triggered()), this, SLOT(on_actions_editUndo_triggered()));
+	connect(m_actions->editRedo, SIGNAL(triggered()), this, SLOT(on_actions_editRedo_triggered()));
 	//connect(m_actions->file, SIGNAL(triggered()), this, SLOT(on_actions_file()));
 	//connect(m_actions->file, SIGNAL(triggered()), this, SLOT(on_actions_file()));
 	connect(m_actions->fileLoadSampleProject, SIGNAL(triggered()), this, SLOT(on_actions_fileLoadSampleProject_triggered()));
@@ -135,10 +159,14 @@ void MainScope::setFile(EadFile* file)
 	{
 		delete m_file;
 		m_file = file;
+		m_bKeepFileFormat = false;
 		if (m_file != NULL)
 		{
 			connect(m_file, SIGNAL(dirtyChanged()), this, SLOT(on_file_dirtyChanged()));
+			connect(m_file, SIGNAL(saveProgress(int)), this, SLOT(on_file_saveProgress(int)));
+			connect(m_file, SIGNAL(saveFinished(bool)), this, SLOT(on_file_saveFinished(bool)));
 			connect(m_file, SIGNAL(waveListChanged()), this, SIGNAL(waveListChanged()));
+			connect(m_file, SIGNAL(historyChanged()), this, SLOT(updateActions()));
 		}
 
 		m_chart->setFile(m_file);
@@ -204,14 +232,19 @@ void MainScope::setComment(const QString& s)
 	if (s != m_file->comment())
 	{
 		m_file->setComment(s);
-		QString sDisplay = s.trimmed();
-		int iNL = sDisplay.indexOf(QRegExp("[\n\r]"));
-		if (iNL > 0)
-			sDisplay = sDisplay.left(iNL) + "...";
-		emit commentChanged(sDisplay);
+		emitCommentChanged();
 	}
 }
 
+void MainScope::emitCommentChanged()
+{
+	QString sDisplay = m_file->comment().trimmed();
+	int iNL = sDisplay.indexOf(QRegExp("[\n\r]"));
+	if (iNL > 0)
+		sDisplay = sDisplay.left(iNL) + "...";
+	emit commentChanged(sDisplay);
+}
+
 void MainScope::updatePeakMode()
 {
 	EadMarkerMode peakMode;
@@ -278,12 +311,18 @@ void MainScope::updateActions()
 	m_actions->fileOpen->setEnabled(!m_bRecording);
 	m_actions->fileSave->setEnabled(bHaveFile && (m_file->isDirty() || !bHaveData));
 	m_actions->fileSaveAs->setEnabled(bHaveFile);
+	m_actions->fileCompact->setEnabled(bHaveFile && !m_bRecording && m_file->unusedFileSize() > 0);
+	m_actions->fileSampleStore->setEnabled(bHaveFile && !m_bRecording);
+	m_actions->fileCollectSampleStore->setEnabled(bHaveFile && !m_bRecording && !m_file->sampleStore().isEmpty());
 	m_actions->fileImport->setEnabled(!m_bRecording);
 	m_actions->fileExportSignalData->setEnabled(bHaveData);
 	m_actions->fileExportAmplitudeData->setEnabled(bHaveData);
 	m_actions->fileExportRetentionData->setEnabled(bHaveData);
 	m_actions->fileLoadSampleProject->setEnabled(!m_bRecording);
 
+	m_actions->editUndo->setEnabled(bHaveFile && !m_bRecording && m_file->canUndo());
+	m_actions->editRedo->setEnabled(bHaveFile && !m_bRecording && m_file->canRedo());
+
 	bool bView = (m_taskType != EadTask_Publish);
 	m_actions->viewWaveComments->setEnabled(bView);
 
@@ -453,7 +492,9 @@ EadFile* MainScope::load(const QString& _sFilename, bool bImport)
 	
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));  // HACK: Calling QApplication here is a bad hack -- ellis, 2008-09-15
 	EadFile* file = new EadFile;
-	LoadSaveResult result = file->load(sFilename);
+	// Files which are opened for viewing finish their calculations in the background,
+	// but imported waves need to be complete before they are merged into the current file
+	LoadSaveResult result = file->load(sFilename, !bImport);
 	QApplication::restoreOverrideCursor();
 
 	if (result == LoadSaveResult_Ok)
@@ -465,6 +506,13 @@ EadFile* MainScope::load(const QString& _sFilename, bool bImport)
 		if (!bImport)
 			m_ui->showWarning(tr("You have imported a project from an old version of GcEad.  In order to preserve your changes, you may wish to save this project under a different filename."));
 	}
+	else if (result == LoadSaveResult_SamplesMissing)
+	{
+		delete file;
+		m_ui->showWarning(tr("Project file could not be loaded, because some of its recordings are missing from its shared sample store:\n%1").arg(_sFilename));
+		m_ui->showStatusMessage(tr("Error loading project"));
+		file = NULL;
+	}
 	else
 	{
 		delete file;
@@ -548,6 +596,16 @@ void MainScope::on_actions_fileOpenRecentActions_triggered()
 	}
 }
 
+void MainScope::on_actions_fileFindInCatalog_triggered()
+{
+	QString sFilename = m_ui->findInCatalog(Catalog::defaultFilename());
+	if (!sFilename.isEmpty() && checkSaveAndContinue())
+	{
+		Globals->setLastDir(QFileInfo(sFilename).absolutePath());
+		open(sFilename);
+	}
+}
+
 bool MainScope::on_actions_fileSave_triggered()
 {
 	CHECK_PRECOND_RETVAL(m_file != NULL, false);
@@ -555,7 +613,25 @@ bool MainScope::on_actions_fileSave_triggered()
 	if (m_file->filename().isEmpty())
 		return on_actions_fileSaveAs_triggered();
 	else
-		return save(m_file->filename());
+		return save(m_file->filename(), incrementalSaveMode());
+}
+
+SaveMode MainScope::incrementalSaveMode()
+{
+	// Files which older versions of GcEad can read have to be rewritten completely on every save,
+	// so offer to convert them, but only once per file
+	if (m_file->fileVersion() >= 3 || !m_file->sampleStore().isEmpty() || m_bKeepFileFormat)
+		return SaveMode_Incremental;
+
+	QMessageBox::StandardButton res = m_ui->question(
+		tr("Convert Project File"),
+		tr("This project is saved in a format which has to be rewritten completely every time it's saved.\n\nDo you want to convert it to the newer format, which only adds new recordings to the end of the file?  Older versions of GcEad will not be able to open it anymore."),
+		QMessageBox::Yes | QMessageBox::No);
+	if (res == QMessageBox::Yes)
+		return SaveMode_Convert;
+
+	m_bKeepFileFormat = true;
+	return SaveMode_Incremental;
 }
 
 bool MainScope::on_actions_fileSaveAs_triggered()
@@ -569,43 +645,155 @@ bool MainScope::on_actions_fileSaveAs_triggered()
 	if (!sFilename.toLower().endsWith(".ead"))
 		sFilename += ".ead";
 
-	return save(sFilename);
+	// A new file doesn't need any of the space that the old one may have been wasting
+	return save(sFilename, SaveMode_Rewrite);
 }
 
-bool MainScope::save(const QString& sFilename)
+void MainScope::on_actions_fileCompact_triggered()
 {
-	CHECK_PRECOND_RETVAL(m_file != NULL, false);
+	CHECK_PRECOND_RET(m_file != NULL && !m_file->filename().isEmpty());
+	save(m_file->filename(), SaveMode_Rewrite);
+}
 
+void MainScope::on_actions_fileSampleStore_triggered()
+{
+	CHECK_PRECOND_RET(m_file != NULL);
+
+	if (!m_file->sampleStore().isEmpty())
+	{
+		QMessageBox::StandardButton res = m_ui->question(
+			tr("Shared Sample Store"),
+			tr("This project saves its recordings to the shared sample store in %1.\n\nDo you want to keep the recordings in the project file itself instead?").arg(QDir::toNativeSeparators(m_file->sampleStore())),
+			QMessageBox::Yes | QMessageBox::No);
+		if (res == QMessageBox::Yes)
+			m_file->setSampleStore(QString());
+		return;
+	}
+
+	// Recordings which are imported into several projects are only stored once in a shared store
+	QString sPath = m_ui->getSampleStoreDirectory(Globals->lastDir());
+	if (!sPath.isEmpty())
+		m_file->setSampleStore(sPath);
+}
+
+void MainScope::on_actions_fileCollectSampleStore_triggered()
+{
+	CHECK_PRECOND_RET(m_file != NULL && !m_file->sampleStore().isEmpty());
+
+	// The blocks of a pending save need to be referenced before unused ones are looked for
+	m_file->waitForSave();
+
+	SampleStore store(m_file->sampleStore());
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-	bool bOk = m_file->saveAs(sFilename);
+	qint64 nBytesFreed = 0;
+	QStringList asProblems;
+	int nDeleted = store.collectGarbage(&nBytesFreed, &asProblems);
 	QApplication::restoreOverrideCursor();
 
+	// Projects which are out of reach may still need their recordings, so only the user can decide to forget them
+	if (nDeleted < 0 && !asProblems.isEmpty())
+	{
+		QStringList asNames;
+		foreach (const QString& sFile, asProblems)
+			asNames << QDir::toNativeSeparators(sFile);
+		QMessageBox::StandardButton res = m_ui->question(
+			tr("Error Cleaning Up Sample Store"),
+			tr("The sample store could not be cleaned up, because these projects which use it are missing, could not be read, or now use a different sample store:\n\n%1\n\nIf they have been deleted or moved on purpose, do you want to forget about them and clean up the sample store anyway?  Their recordings will be lost from the sample store.").arg(asNames.join("\n")),
+			QMessageBox::Yes | QMessageBox::No);
+		if (res != QMessageBox::Yes)
+			return;
+
+		foreach (const QString& sFile, asProblems)
+			store.removeReferrer(sFile);
+		QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+		nDeleted = store.collectGarbage(&nBytesFreed);
+		QApplication::restoreOverrideCursor();
+	}
+
+	if (nDeleted < 0)
+	{
+		m_ui->showError(
+			tr("Error Cleaning Up Sample Store"),
+			tr("The sample store could not be cleaned up, because not all of the projects which use it could be read."));
+	}
+	else
+		m_ui->showStatusMessage(tr("Removed %1 unused recordings (%2 MB) from the sample store").arg(nDeleted).arg(nBytesFreed / (1024.0 * 1024.0), 0, 'f', 1));
+}
+
+bool MainScope::save(const QString& sFilename, SaveMode mode)
+{
+	CHECK_PRECOND_RETVAL(m_file != NULL, false);
+
+	// Let a previous save finish first, so that its result gets reported
+	m_file->waitForSave();
+
+	// The file is written in the background, and on_file_saveFinished() reports the result
+	bool bOk = m_file->saveAsync(sFilename, mode);
+	if (bOk)
+		m_ui->showStatusMessage(tr("Saving recordings..."));
+	return bOk;
+}
+
+void MainScope::on_file_saveProgress(int nPercent)
+{
+	m_ui->showStatusMessage(tr("Saving recordings... %1%").arg(nPercent));
+}
+
+void MainScope::on_file_saveFinished(bool bOk)
+{
 	if (bOk)
 	{
 		m_ui->showStatusMessage(tr("Recordings saved"));
 		addRecentFile(m_file->filename());
+		updateCatalog();
 	}
 	else
 	{
-		m_ui->showError(
-			tr("Error Saving File"),
-			tr("The recordings could not be saved to disk! Please try saving under a different filename or at a different location."));
+		m_ui->showStatusMessage(tr("Error saving recordings"));
+		if (!m_bWaitingForSave)
+		{
+			m_ui->showError(
+				tr("Error Saving File"),
+				tr("The recordings could not be saved to disk! Please try saving under a different filename or at a different location."));
+		}
 	}
 
 	updateWindowTitle();
+}
 
-	return bOk;
+bool MainScope::saveAndWait()
+{
+	if (!on_actions_fileSave_triggered())
+		return false;
+
+	// Only for this save: the result of an earlier one is still reported by on_file_saveFinished()
+	m_bWaitingForSave = true;
+	bool bSaved = m_file->waitForSave();
+	m_bWaitingForSave = false;
+	return bSaved;
+}
+
+void MainScope::updateCatalog()
+{
+	// Problems with the catalog shouldn't get in the way of working with the file, so they're only logged
+	Catalog catalog(Catalog::defaultFilename());
+	if (catalog.isOpen())
+		catalog.update(Catalog::describe(m_file, m_file->filename()));
 }
 
 bool MainScope::checkSaveAndContinue()
 {
+	// A save which is still in progress may take care of the unsaved changes
+	if (m_file != NULL)
+		m_file->waitForSave();
+
 	// If there are unsaved changes to the project
 	if (isWindowModified())
 	{
 		QMessageBox::StandardButton ret = m_ui->warnAboutUnsavedChanged();
-		// Save
+		// Save, and don't continue until the data is safely on disk
 		if (ret == QMessageBox::Save)
-			return on_actions_fileSave_triggered();
+			return on_actions_fileSave_triggered() && m_file->waitForSave();
 		// Cancel
 		else if (ret == QMessageBox::Cancel)
 			return false;
@@ -619,6 +807,20 @@ void MainScope::on_actions_fileComment_triggered()
 	setComment(s);
 }
 
+void MainScope::on_actions_editUndo_triggered()
+{
+	CHECK_PRECOND_RET(!m_bRecording);
+	m_file->undo();
+	emitCommentChanged();
+}
+
+void MainScope::on_actions_editRedo_triggered()
+{
+	CHECK_PRECOND_RET(!m_bRecording);
+	m_file->redo();
+	emitCommentChanged();
+}
+
 void MainScope::on_actions_fileImport_triggered()
 {
 	QString sFilename = m_ui->getFileImportFilename(Globals->lastDir());
@@ -699,6 +901,44 @@ void MainScope::on_actions_recordRecord_triggered()
 		m_vwiFid->setShift(-nDelaySamplesFid);
 
 		m_recHandler->updateRawToVoltageFactors();
+		m_recHandler->updateFilters();
+		if (Globals->idacSettings()->bRecordOnTrigger)
+			m_recHandler->armTrigger(Globals->idacSettings()->nPreTrigger_s * EAD_SAMPLES_PER_SECOND);
+		else
+			m_recHandler->disarmTrigger();
+		// Force the preview timebase to be requested again once the first block arrives
+		m_nPreviewSamplesPerPixel = 0;
+		m_nPreviewPixels = 0;
+
+		// In continuous mode, the recording duration is the window which is kept in memory
+		int nDuration = Globals->idacSettings()->nRecordingDuration;
+		m_history = NULL;
+		if (Globals->idacSettings()->bContinuous && nDuration > 0)
+		{
+			QString sDir = (m_file->filename().isEmpty()) ? Globals->lastDir() : QFileInfo(m_file->filename()).absolutePath();
+			m_history = new MonitorHistory;
+			if (m_history->open(sDir))
+				m_file->newRec()->setMonitorHistory(m_history);
+			else
+			{
+				m_ui->showWarning(tr("Unable to create a directory for continuous monitoring in %0.  The recording will stop after %1 minutes.").arg(sDir).arg(nDuration));
+				delete m_history;
+				m_history = NULL;
+			}
+		}
+
+		// Reserve the wave storage for the whole recording so that appending blocks never reallocates
+		if (nDuration > 0)
+		{
+			int nSamplesMax = nDuration * 60 * EAD_SAMPLES_PER_SECOND;
+			if (m_history != NULL)
+				nSamplesMax += monitorChunkSamples(nSamplesMax);
+			foreach (ViewWaveInfo* vwi, view->vwis())
+			{
+				vwi->waveInfo()->raw.reserve(nSamplesMax);
+				vwi->waveInfo()->display.reserve(nSamplesMax);
+			}
+		}
 
 		// Enable and switch to the Recording view
 		m_actions->viewChartRecording->setEnabled(true);
@@ -761,6 +1001,22 @@ void MainScope::stopRecording(bool bSave, bool bAutoStop)
 
 	m_idac->stopSampling();
 	setIsRecording(false);
+	m_recHandler->disarmTrigger();
+
+	// Only the samples which are still in memory become part of the file.
+	// The earlier ones stay attached to the recording, so that the chart can page them back in.
+	QString sHistoryDir;
+	if (m_history != NULL)
+	{
+		if (m_history->spilledSamples() > 0)
+		{
+			sHistoryDir = m_history->directory();
+			m_history->finish();
+		}
+		else
+			m_file->newRec()->setMonitorHistory(NULL);
+		m_history = NULL;
+	}
 
 	if (bSave)
 	{
@@ -770,7 +1026,8 @@ void MainScope::stopRecording(bool bSave, bool bAutoStop)
 		setTaskType(EadTask_Review);
 		setViewType(EadView_Recording);
 
-		bool bSaved = on_actions_fileSave_triggered();
+		// The new recording is only safe once the background save has completed
+		bool bSaved = saveAndWait();
 
 		// Choose an appropriate message:
 		QString s;
@@ -789,6 +1046,9 @@ void MainScope::stopRecording(bool bSave, bool bAutoStop)
 				m_ui->showWarning(tr("WARNING: Your data has not yet been saved to disk!"));
 		}
 
+		if (!s.isEmpty() && !sHistoryDir.isEmpty())
+			s += "\n" + tr("The earlier data from the continuous monitoring is in %0.  Scroll to before the start of the recording to view it.").arg(QDir::toNativeSeparators(sHistoryDir));
+
 		if (!s.isEmpty() && !QFile::exists(QCoreApplication::applicationDirPath() + "/flag.TestRecording"))
 			m_ui->showInformation(tr("Recording Finished"), s);
 	}
@@ -812,7 +1072,7 @@ void MainScope::stopRecording(bool bSave, bool bAutoStop)
 
 void MainScope::on_recTimer_timeout()
 {
-	if (m_recHandler == NULL || !m_recHandler->check() || !m_recHandler->convert())
+	if (m_recHandler == NULL || !m_recHandler->check() || !m_recHandler->convert(false))
 		return;
 
 	/*if (!m_bDataReceived)
@@ -824,38 +1084,66 @@ void MainScope::on_recTimer_timeout()
 
 	// Store number of samples before the data is added to wave
 	int nSamples0 = m_vwiEad->wave()->raw.size();
+	// The pixels of the recording are counted from its first sample
+	if (nSamples0 == 0)
+		m_iRecordingSampleOrigin = m_recHandler->firstSample();
 
 	// Process digital signals (and handle trigger)
-	const QVector<short>& digital = m_recHandler->digitalRaw();
-	for (int i = 0; i < digital.size(); i++)
-	{
-		short n = digital[i];
-		bool b = ((n & 0x02) != 0);
-		WaveInfo* wave = m_vwiDig->waveInfo();
-		wave->raw << ((b) ? 1 : -1);
-		wave->display << ((b) ? 0.5 : -0.5);
-	}
+	m_recHandler->appendTo(0, m_vwiDig->waveInfo());
 
 	WaveInfo* wave;
 	// Display EAD data
 	wave = m_vwiEad->waveInfo();
-	wave->raw << m_recHandler->eadRaw();
-	wave->display << m_recHandler->eadDisplay();
+	m_recHandler->appendTo(1, wave);
 	m_recHandler->calcRawToVoltageFactors(1, wave->nRawToVoltageFactorNum, wave->nRawToVoltageFactorDen);
 	wave->nRawToVoltageFactor = double(wave->nRawToVoltageFactorNum) / wave->nRawToVoltageFactorDen;
 	// Display FID data
 	wave = m_vwiFid->waveInfo();
-	wave->raw << m_recHandler->fidRaw();
-	wave->display << m_recHandler->fidDisplay();
+	m_recHandler->appendTo(2, wave);
 	m_recHandler->calcRawToVoltageFactors(2, wave->nRawToVoltageFactorNum, wave->nRawToVoltageFactorDen);
 	wave->nRawToVoltageFactor = double(wave->nRawToVoltageFactorNum) / wave->nRawToVoltageFactorDen;
+	// Keep the candidate peaks up to date
+	wave->updateFidPeaks();
 
 	int nSamples = m_vwiEad->wave()->raw.size();
-	int nSeconds = nSamples / EAD_SAMPLES_PER_SECOND;
+
+	if (m_history != NULL)
+	{
+		m_history->addSamples(0, m_vwiDig->wave()->display.constData() + nSamples0, nSamples - nSamples0);
+		m_history->addSamples(1, m_vwiEad->wave()->display.constData() + nSamples0, nSamples - nSamples0);
+		m_history->addSamples(2, m_vwiFid->wave()->display.constData() + nSamples0, nSamples - nSamples0);
+
+		// Once the window is full, move its oldest chunk to disk
+		int nWindow = Globals->idacSettings()->nRecordingDuration * 60 * EAD_SAMPLES_PER_SECOND;
+		int nChunk = monitorChunkSamples(nWindow);
+		if (nWindow > 0 && nSamples >= nWindow + nChunk)
+		{
+			if (!m_history->spill(m_vwiDig->wave(), m_vwiEad->wave(), m_vwiFid->wave(), nChunk))
+			{
+				m_ui->showWarning(tr("Unable to write the continuous monitoring data to %0, so the recording has been stopped.").arg(QDir::toNativeSeparators(m_history->directory())));
+				stopRecording(true, false);
+				return;
+			}
+			m_vwiDig->waveInfo()->removeFront(nChunk);
+			m_vwiEad->waveInfo()->removeFront(nChunk);
+			m_vwiFid->waveInfo()->removeFront(nChunk);
+			m_iRecordingSampleOrigin += nChunk;
+			nSamples0 -= nChunk;
+			nSamples -= nChunk;
+			// The preview pixels are counted from the first sample in memory
+			m_nPreviewSamplesPerPixel = 0;
+			m_nPreviewPixels = 0;
+		}
+	}
+
+	// Timeline index after the last sample, before and after this block
+	int tidxEnd0 = nSamples0 + m_vwiEad->wave()->shift();
+	int tidxEnd = nSamples + m_vwiEad->wave()->shift();
+	int nSeconds = tidxEnd / EAD_SAMPLES_PER_SECOND;
 	m_chart->setRecordingTime(nSeconds);
 
 	// Check for end of recording
-	if (Globals->idacSettings()->nRecordingDuration > 0)
+	if (m_history == NULL && Globals->idacSettings()->nRecordingDuration > 0)
 	{
 		int nMinutes = nSeconds / 60;
 		if (nMinutes >= Globals->idacSettings()->nRecordingDuration)
@@ -868,10 +1156,54 @@ void MainScope::on_recTimer_timeout()
 		//if (nSamples > nSampleLast) {
 		//	qDebug() << "nSamples0:" << nSamples0 << "nSamples:" << nSamples << "nSampleFirst:" << m_chart->pixmap()->firstSample() << "nSampleLast:" << nSampleLast;
 		//}
-		if (nSamples0 <= nSampleLast && nSamples > nSampleLast) {
+		if (tidxEnd0 <= nSampleLast && tidxEnd > nSampleLast) {
 			m_chart->setSampleOffset(nSampleLast + 1);
 		}
+		updateRecordingPreview();
 		//if (!QFile::exists("flag.TestRecording"))
 			m_chart->redraw();
 	}
 }
+
+void MainScope::updateRecordingPreview()
+{
+	const ChartPixmap* pixmap = m_chart->pixmap();
+	double nSamplesPerPixel = pixmap->samplesPerPixel();
+	int nPixels = pixmap->borderRect().width();
+
+	// When zoomed in so far that a pixel covers less than a sample, the chart renders the data directly
+	bool bPreview = (nSamplesPerPixel >= 1 && nPixels > 0);
+	if (bPreview && (nSamplesPerPixel != m_nPreviewSamplesPerPixel || nPixels != m_nPreviewPixels))
+	{
+		m_nPreviewSamplesPerPixel = nSamplesPerPixel;
+		m_nPreviewPixels = nPixels;
+		m_recHandler->setPreviewTimebase(nSamplesPerPixel, nPixels, m_iRecordingSampleOrigin);
+	}
+	bPreview = bPreview && m_recHandler->updatePreview();
+
+	const WaveInfo* waves[3] = { m_vwiDig->wave(), m_vwiEad->wave(), m_vwiFid->wave() };
+	for (int iChan = 0; iChan < 3; iChan++)
+	{
+		const RenderPreview* preview = (bPreview) ? &m_recHandler->preview(iChan) : NULL;
+
+		// Summarize the visible part of the data which was spilled to disk
+		if (m_history != NULL && m_history->spilledSamples() > 0 && nSamplesPerPixel >= 1 && nPixels > 0)
+		{
+			RenderPreview& merged = m_historyPreviews[iChan];
+			int didxFirst = pixmap->firstSample() - waves[iChan]->shift();
+			int iPixelFirst = int(floor(didxFirst / nSamplesPerPixel)) - 1;
+			int iPixelEnd = qMin(iPixelFirst + nPixels + 2, 0);
+			if (iPixelFirst < iPixelEnd)
+			{
+				merged.nSamplesPerPixel = nSamplesPerPixel;
+				merged.iPixelFirst = iPixelFirst;
+				m_history->summarize(iChan, m_history->spilledSamples(), nSamplesPerPixel, iPixelFirst, iPixelEnd - iPixelFirst, merged.pixels);
+				if (preview != NULL && preview->iPixelFirst == 0 && iPixelEnd == 0)
+					merged.pixels += preview->pixels;
+				preview = &merged;
+			}
+		}
+
+		m_chart->setPreview(waves[iChan], preview);
+	}
+}
@@ -23,12 +23,14 @@
 #include <Actions.h>
 #include <EadEnums.h>
 #include <EadFile.h>
+#include <RenderData.h>
 
 #include "ChartScope.h"
 
 
 class IdacProxy;
 class MainScopeUi;
+class MonitorHistory;
 class RecordHandler;
 
 
@@ -86,7 +88,8 @@ public:
 
 	bool checkSaveAndContinue();
 	void open(const QString& sFilename);
-	bool save(const QString& sFilename);
+	/// Start saving the file in the background; the result is reported once the data has been written
+	bool save(const QString& sFilename, SaveMode mode = SaveMode_Incremental);
 
 public slots:
 	void updateActions();
@@ -114,20 +117,38 @@ private:
 	void updateChartElements();
 	void updateWindowTitle();
 	void addRecentFile(const QString& sFilename);
+	/// Add the saved file to the catalog, so that it can be found without opening it
+	void updateCatalog();
+	/// Emit commentChanged() with the first line of the file's comment
+	void emitCommentChanged();
 	void updateRecentFileActions();
+	/// Mode for saving the current file under its own name, after asking whether to convert an older format
+	SaveMode incrementalSaveMode();
+	/// Save the file and wait until it's on disk.  The caller reports a failure, not on_file_saveFinished().
+	bool saveAndWait();
 	bool checkHardware();
+	/// Let the sampling thread summarize the recording for the chart's current timebase
+	void updateRecordingPreview();
 
 private slots:
 	void on_idac_isAvailable();
 	void on_file_dirtyChanged();
+	void on_file_saveProgress(int nPercent);
+	void on_file_saveFinished(bool bOk);
 
 	void on_actions_fileNew_triggered();
 	void on_actions_fileOpen_triggered();
 	void on_actions_fileOpenRecentActions_triggered();
+	void on_actions_fileFindInCatalog_triggered();
 	bool on_actions_fileSave_triggered();
 	bool on_actions_fileSaveAs_triggered();
+	void on_actions_fileCompact_triggered();
+	void on_actions_fileSampleStore_triggered();
+	void on_actions_fileCollectSampleStore_triggered();
 	void on_actions_fileComment_triggered();
 	void on_actions_fileImport_triggered();
+	void on_actions_editUndo_triggered();
+	void on_actions_editRedo_triggered();
 	void on_actions_fileLoadSampleProject_triggered();
 
 	void on_actions_viewViewMode_triggered();
@@ -172,6 +193,10 @@ private:
 
 	QString m_sWindowTitle;
 	bool m_bWindowModified;
+	/// The user chose not to convert the current file to the appendable format
+	bool m_bKeepFileFormat;
+	/// saveAndWait() is in progress, so on_file_saveFinished() leaves error messages to its caller
+	bool m_bWaitingForSave;
 
 	bool m_bRecording;
 	ViewWaveInfo* m_vwiEad;
@@ -179,6 +204,16 @@ private:
 	ViewWaveInfo* m_vwiDig;
 	RecordHandler* m_recHandler;
 	QTimer* m_recTimer;
+	/// Sample index (counted from the start of sampling) of the recording's first sample
+	int m_iRecordingSampleOrigin;
+	/// Timebase which was last requested for the recording preview
+	double m_nPreviewSamplesPerPixel;
+	int m_nPreviewPixels;
+	/// Data which is spilled to disk during continuous monitoring, or NULL.
+	/// It belongs to the new recording (see RecInfo::monitorHistory()).
+	MonitorHistory* m_history;
+	/// Per channel, the history's summaries followed by the live preview
+	RenderPreview m_historyPreviews[3];
 };
 
 #endif
@@ -37,6 +37,11 @@ public:
 	virtual QString getFileOpenFilename(const QString& sLastDir) = 0;
 	virtual QString getFileSaveAsFilename(const QString& sCurrentFilename) = 0;
 	virtual QString getFileImportFilename(const QString& sLastDir) = 0;
+	/// Let user search the catalog of project files for one to open
+	/// @returns the chosen file, or an empty string if the search was canceled
+	virtual QString findInCatalog(const QString& sCatalog) = 0;
+	/// Let user choose the directory of a shared sample store
+	virtual QString getSampleStoreDirectory(const QString& sLastDir) = 0;
 	/// Let user edit the file comment
 	virtual QString getComment(const QString& sComment) = 0;
 	/// Return QMessageBox::Save, QMessageBox::Discard, or QMessageBox::Cancel
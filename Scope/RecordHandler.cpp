@@ -17,24 +17,32 @@
 
 #include "RecordHandler.h"
 
+#include <string.h>
+
 #include <QtDebug>
 #include <QMessageBox>
 
 #include <Check.h>
+#include <EadEnums.h>
 #include <Globals.h>
+#include <WaveInfo.h>
 
 #include <Idac/IdacProxy.h>
+#include <IdacDriver/IdacPreview.h>
 #include <IdacDriver/IdacSettings.h>
 
 
 RecordHandler::RecordHandler(IdacProxy* idac)
 {
+	for (int iChan = 0; iChan < 3; iChan++)
+		m_monitors[iChan] = IdacSignalMonitor(EAD_SAMPLES_PER_SECOND);
 	Q_ASSERT(idac != NULL);
 	m_idac = idac;
 	m_bReportingError = false;
-
-	for (int i = 0; i < 3; i++)
-		m_anBuffers[i] = new short[300];
+	m_nPreviewSamplesPerPixel = 0;
+	m_nPreviewPixels = 0;
+	m_iPreviewSampleOrigin = 0;
+	m_nSkip = 0;
 }
 
 void RecordHandler::updateRawToVoltageFactors()
@@ -71,6 +79,19 @@ void RecordHandler::calcRawToVoltageFactors(int iChan, int& nNum, int& nDen)
 	//qDebug() << "nNum:" << nNum << "nDen:" << nDen;
 }
 
+void RecordHandler::updateFilters()
+{
+	for (int iChan = 1; iChan < 3; iChan++)
+	{
+		double nCutoff_Hz = Globals->idacSettings()->anLiveLowpass_Hz[iChan];
+		if (nCutoff_Hz > 0 && nCutoff_Hz < EAD_SAMPLES_PER_SECOND / 2.0)
+			m_filters[iChan] = StreamFilter::lowpass(nCutoff_Hz, EAD_SAMPLES_PER_SECOND);
+		else
+			m_filters[iChan].clear();
+		m_filteredPreviews[iChan].restart(m_nPreviewPixels);
+	}
+}
+
 bool RecordHandler::check()
 {
 	if (m_idac->state() != IdacState_Sampling)
@@ -122,7 +143,7 @@ bool RecordHandler::check()
 	return bOk;
 }
 
-bool RecordHandler::convert()
+bool RecordHandler::convert(bool bDisplay)
 {
 	if (m_idac->state() != IdacState_Sampling)
 		return false;
@@ -131,51 +152,364 @@ bool RecordHandler::convert()
 	//uchar nDigitalInversionMask = (Globals->idacSettings()->channels[0].mInvert & nDigitalEnabledMask);
 	uchar nDigitalInversionMask = Globals->idacSettings()->channels[0].mInvert;
 
-	int nSamples = m_idac->takeData(m_anBuffers[0], m_anBuffers[1], m_anBuffers[2], 300);
+	// Release the previous blocks, so that the driver can recycle m_block
+	m_blocks.clear();
+	m_nSkip = 0;
 
-	// 2. Read data and send to display
-	bool bHaveData = false;
+	// Take ownership of the samples without copying them
+	if (!m_idac->takeBlock(m_block))
+		return false;
+
+	// 2. Convert the raw data in place
 	for (int iChan = 0; iChan < 3; iChan++)
 	{
-		// Size our data arrays appropriately
-		short* buffer = m_anBuffers[iChan];
-		QVector<short>& raw = m_anRaw[iChan];
-		QVector<double>& display = m_anDisplay[iChan];
-		raw.resize(nSamples);
-		display.resize(nSamples);
+		// We own the block now, so data() won't detach
+		short* raw = m_block.channel(iChan).data();
+		const int nSamples = m_block.size();
 
 		//if (iChan == 0)
 		//	qDebug() << "conver:" << QTime::currentTime().msec() << data.size();
 
-		for (int i = 0; i < nSamples; i++)
+		// Digital channel
+		if (iChan == 0)
 		{
-			short nRaw;
-			double nDisplay;
-
-			// Digital channel
-			if (iChan == 0)
+			for (int i = 0; i < nSamples; i++)
 			{
-				uchar n = (uchar) buffer[i]; // here, 0 = on
+				uchar n = (uchar) raw[i]; // here, 0 = on
 				n = ~n; // Switch it up so that 1 = on
 				n ^= nDigitalInversionMask; // Invert bits, if necessary
+				raw[i] = n;
+			}
+		}
+		// Analog channel
+		else
+		{
+			if (Globals->idacSettings()->channels[iChan].mInvert)
+			{
+				for (int i = 0; i < nSamples; i++)
+					raw[i] *= -1;
+			}
+			m_monitors[iChan].add(raw, nSamples);
+		}
+	}
 
-				nRaw = n;
-				nDisplay = ((n & 0x02) > 0) ? 0.5 : -0.5;
+	// 3. While waiting for the trigger, the blocks are only kept for the pre-trigger window.
+	// Once it fires, the window is handed over together with the current block.
+	if (m_preTrigger.isArmed())
+	{
+		if (!m_preTrigger.add(m_block))
+			return false;
+		m_blocks = m_preTrigger.takeBlocks(m_nSkip);
+		// The filters start on the first recorded sample, just like without a trigger
+		for (int iChan = 1; iChan < 3; iChan++)
+			m_filters[iChan].reset();
+	}
+	else
+		m_blocks << m_block;
+
+	const int nSamples = sampleCount();
+
+	// 4. If requested, send to display
+	for (int iChan = 0; iChan < 3; iChan++)
+	{
+		QVector<double>& display = m_anDisplay[iChan];
+		const bool bFiltered = isFiltered(iChan);
+		display.resize((bDisplay || bFiltered) ? nSamples : 0);
+		if (display.isEmpty())
+			continue;
+
+		double* out = display.data();
+		const double nFactor = m_anRawToVoltageFactors[iChan];
+		for (int iBlock = 0; iBlock < m_blocks.size(); iBlock++)
+		{
+			const QVector<short>& block = m_blocks[iBlock].channel(iChan);
+			const short* raw = block.constData();
+			const int iStart = (iBlock == 0) ? m_nSkip : 0;
+			// Digital channel
+			if (iChan == 0)
+			{
+				for (int i = iStart; i < block.size(); i++)
+					*out++ = ((raw[i] & 0x02) > 0) ? 0.5 : -0.5;
 			}
 			// Analog channel
 			else
 			{
-				nRaw = buffer[i];
-				if (Globals->idacSettings()->channels[iChan].mInvert)
-					nRaw *= -1;
-				nDisplay = nRaw * m_anRawToVoltageFactors[iChan];
+				for (int i = iStart; i < block.size(); i++)
+					*out++ = raw[i] * nFactor;
 			}
+		}
 
-			raw[i] = nRaw;
-			display[i] = nDisplay;
-			bHaveData = true;
+		if (bFiltered)
+		{
+			m_filters[iChan].process(display.data(), nSamples);
+			addFilteredPreview(iChan);
 		}
 	}
 
-	return bHaveData;
+	return (nSamples > 0);
+}
+
+void RecordHandler::resetSignalQuality()
+{
+	for (int iChan = 0; iChan < 3; iChan++)
+		m_monitors[iChan].reset();
+}
+
+void RecordHandler::armTrigger(int nPreTriggerSamples)
+{
+	// Bit 0 of the digital channel carries the trigger
+	m_preTrigger.arm(nPreTriggerSamples, 0x01);
+}
+
+void RecordHandler::disarmTrigger()
+{
+	m_preTrigger.disarm();
+}
+
+int RecordHandler::firstSample() const
+{
+	return (m_blocks.isEmpty()) ? m_block.iFirstSample : m_blocks.first().iFirstSample + m_nSkip;
+}
+
+int RecordHandler::sampleCount() const
+{
+	int nSamples = -m_nSkip;
+	foreach (const IdacSampleBlock& block, m_blocks)
+		nSamples += block.size();
+	return qMax(nSamples, 0);
+}
+
+void RecordHandler::appendTo(int iChan, WaveInfo* wave)
+{
+	CHECK_PARAM_RET(iChan >= 0 && iChan < 3);
+	CHECK_PARAM_RET(wave != NULL);
+
+	const int nSamples = sampleCount();
+	const int n0 = wave->raw.size();
+
+	// Digital channel: only the signal bit is stored
+	if (iChan == 0)
+	{
+		wave->raw.resize(n0 + nSamples);
+		wave->display.resize(n0 + nSamples);
+		short* raw = wave->raw.data() + n0;
+		double* display = wave->display.data() + n0;
+		for (int iBlock = 0; iBlock < m_blocks.size(); iBlock++)
+		{
+			const QVector<short>& block = m_blocks[iBlock].channel(iChan);
+			for (int i = (iBlock == 0) ? m_nSkip : 0; i < block.size(); i++)
+			{
+				bool b = ((block[i] & 0x02) != 0);
+				*raw++ = (b) ? 1 : -1;
+				*display++ = (b) ? 0.5 : -0.5;
+			}
+		}
+	}
+	// Analog channel
+	else
+	{
+		// A single block can be adopted as-is if it's the first one; after that it's a bulk append
+		if (m_blocks.size() == 1 && m_nSkip == 0)
+		{
+			const QVector<short>& block = m_blocks.first().channel(iChan);
+			if (n0 == 0 && wave->raw.capacity() == 0)
+				wave->raw = block;
+			else
+				wave->raw += block;
+		}
+		else
+		{
+			wave->raw.resize(n0 + nSamples);
+			short* raw = wave->raw.data() + n0;
+			for (int iBlock = 0; iBlock < m_blocks.size(); iBlock++)
+			{
+				const QVector<short>& block = m_blocks[iBlock].channel(iChan);
+				const int iStart = (iBlock == 0) ? m_nSkip : 0;
+				memcpy(raw, block.constData() + iStart, (block.size() - iStart) * sizeof(short));
+				raw += block.size() - iStart;
+			}
+		}
+
+		wave->display.resize(n0 + nSamples);
+		double* display = wave->display.data() + n0;
+		// The filter state has already moved past these samples, so use the output from convert()
+		if (isFiltered(iChan))
+		{
+			CHECK_ASSERT_RET(m_anDisplay[iChan].size() == nSamples);
+			memcpy(display, m_anDisplay[iChan].constData(), nSamples * sizeof(double));
+		}
+		else
+		{
+			const double nFactor = m_anRawToVoltageFactors[iChan];
+			const short* raw = wave->raw.constData() + n0;
+			for (int i = 0; i < nSamples; i++)
+				display[i] = raw[i] * nFactor;
+		}
+	}
+}
+
+void RecordHandler::setPreviewTimebase(double nSamplesPerPixel, int nPixels, int iSampleOrigin)
+{
+	CHECK_PARAM_RET(nSamplesPerPixel >= 1);
+
+	m_nPreviewSamplesPerPixel = nSamplesPerPixel;
+	m_nPreviewPixels = nPixels;
+	m_iPreviewSampleOrigin = iSampleOrigin;
+	for (int iChan = 0; iChan < 3; iChan++)
+	{
+		m_previews[iChan].clear();
+		m_filteredPreviews[iChan].restart(nPixels);
+	}
+
+	m_idac->setPreviewTimebase(nSamplesPerPixel, nPixels, iSampleOrigin);
+}
+
+bool RecordHandler::updatePreview()
+{
+	const IdacPreviewSnapshot* snap = m_idac->previewSnapshot();
+	if (snap == NULL)
+		return false;
+	// Ignore summaries which were made for a previous timebase
+	if (
+		snap->nSamplesPerBucket != m_nPreviewSamplesPerPixel ||
+		snap->buckets.size() != m_nPreviewPixels ||
+		snap->iSampleOrigin != m_iPreviewSampleOrigin)
+	{
+		return false;
+	}
+
+	const int iFirst = snap->iBucketFirst;
+	const int nPixels = snap->iBucketEnd - iFirst;
+
+	// Digital channel: a pixel is on at the top if the signal bit was on for any of its samples,
+	// and on at the bottom only if it was on for all of them.
+	// Before conversion, a raw bit counts as "on" when it equals the bit in the inversion mask (see convert()).
+	{
+		const bool bInvert = ((Globals->idacSettings()->channels[0].mInvert & 0x02) != 0);
+		RenderPreview& preview = m_previews[0];
+		preview.nSamplesPerPixel = snap->nSamplesPerBucket;
+		preview.iPixelFirst = iFirst;
+		preview.pixels.resize(nPixels);
+		MinMax* pixdata = preview.pixels.data();
+		for (int i = 0; i < nPixels; i++)
+		{
+			const IdacPreviewBucket& bucket = snap->bucket(iFirst + i);
+			bool bAnySet = ((bucket.anMax[0] & 0x02) != 0);
+			bool bAllSet = ((bucket.anMin[0] & 0x02) != 0);
+			bool bAnyOn = (bInvert) ? bAnySet : !bAllSet;
+			bool bAllOn = (bInvert) ? bAllSet : !bAnySet;
+			pixdata[i].yTop = (bAnyOn) ? 0.5 : -0.5;
+			pixdata[i].yBot = (bAllOn) ? 0.5 : -0.5;
+		}
+	}
+
+	// Analog channels
+	for (int iChan = 1; iChan < 3; iChan++)
+	{
+		if (isFiltered(iChan))
+		{
+			updateFilteredPreview(iChan);
+			continue;
+		}
+
+		const double nFactor = m_anRawToVoltageFactors[iChan];
+		const bool bInvert = Globals->idacSettings()->channels[iChan].mInvert;
+		RenderPreview& preview = m_previews[iChan];
+		preview.nSamplesPerPixel = snap->nSamplesPerBucket;
+		preview.iPixelFirst = iFirst;
+		preview.pixels.resize(nPixels);
+		MinMax* pixdata = preview.pixels.data();
+		for (int i = 0; i < nPixels; i++)
+		{
+			const IdacPreviewBucket& bucket = snap->bucket(iFirst + i);
+			if (bInvert)
+			{
+				pixdata[i].yBot = -bucket.anMax[iChan] * nFactor;
+				pixdata[i].yTop = -bucket.anMin[iChan] * nFactor;
+			}
+			else
+			{
+				pixdata[i].yBot = bucket.anMin[iChan] * nFactor;
+				pixdata[i].yTop = bucket.anMax[iChan] * nFactor;
+			}
+		}
+	}
+
+	return true;
+}
+
+void RecordHandler::FilteredPreview::restart(int nPixels)
+{
+	ring.resize(qMax(nPixels, 0));
+	iPixel = -1;
+	iPixelFirst = -1;
+	iPixelEnd = 0;
+}
+
+int RecordHandler::previewPixelStart(int iPixel) const
+{
+	return m_iPreviewSampleOrigin + int(iPixel * m_nPreviewSamplesPerPixel + 0.5);
+}
+
+void RecordHandler::addFilteredPreview(int iChan)
+{
+	FilteredPreview& fp = m_filteredPreviews[iChan];
+	if (fp.ring.isEmpty())
+		return;
+
+	const double* display = m_anDisplay[iChan].constData();
+	const int nSamples = m_anDisplay[iChan].size();
+	const int iFirstSample = firstSample();
+	for (int i = 0; i < nSamples; i++)
+	{
+		const int iSample = iFirstSample + i;
+		if (iSample < m_iPreviewSampleOrigin)
+			continue;
+
+		const double y = display[i];
+
+		// Complete the current pixel
+		if (fp.iPixel >= 0 && iSample >= fp.iPixelSampleEnd)
+		{
+			fp.ring[fp.iPixel % fp.ring.size()] = fp.pixel;
+			fp.iPixelEnd = fp.iPixel + 1;
+			fp.iPixel = -1;
+		}
+
+		// Start a new pixel
+		if (fp.iPixel < 0)
+		{
+			int iPixel = int((iSample - m_iPreviewSampleOrigin) / m_nPreviewSamplesPerPixel);
+			while (iPixel > 0 && previewPixelStart(iPixel) > iSample)
+				iPixel--;
+			while (previewPixelStart(iPixel + 1) <= iSample)
+				iPixel++;
+
+			fp.iPixel = iPixel;
+			fp.iPixelSampleEnd = previewPixelStart(iPixel + 1);
+			if (fp.iPixelFirst < 0)
+				fp.iPixelFirst = iPixel;
+			fp.pixel.yBot = fp.pixel.yTop = y;
+		}
+		else if (y < fp.pixel.yBot)
+			fp.pixel.yBot = y;
+		else if (y > fp.pixel.yTop)
+			fp.pixel.yTop = y;
+	}
+}
+
+void RecordHandler::updateFilteredPreview(int iChan)
+{
+	const FilteredPreview& fp = m_filteredPreviews[iChan];
+	RenderPreview& preview = m_previews[iChan];
+	const int iEnd = fp.iPixelEnd;
+	const int iFirst = (fp.iPixelFirst < 0) ? iEnd : qMax(fp.iPixelFirst, iEnd - fp.ring.size());
+	const int nPixels = iEnd - iFirst;
+
+	preview.nSamplesPerPixel = m_nPreviewSamplesPerPixel;
+	preview.iPixelFirst = iFirst;
+	preview.pixels.resize(nPixels);
+	MinMax* pixdata = preview.pixels.data();
+	for (int i = 0; i < nPixels; i++)
+		pixdata[i] = fp.ring[(iFirst + i) % fp.ring.size()];
 }
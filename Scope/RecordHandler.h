@@ -20,8 +20,17 @@
 
 #include <QVector>
 
+#include <QList>
+
+#include <IdacDriver/IdacPreTrigger.h>
+#include <IdacDriver/IdacSampleBlock.h>
+#include <IdacDriver/IdacSignalMonitor.h>
+#include <RenderData.h>
+#include <StreamFilter.h>
+
 
 class IdacProxy;
+class WaveInfo;
 
 
 class RecordHandler
@@ -29,25 +38,102 @@ class RecordHandler
 public:
 	RecordHandler(IdacProxy* idac);
 
-	const QVector<short>& digitalRaw() const { return m_anRaw[0]; }
-	const QVector<short>& eadRaw() const { return m_anRaw[1]; }
-	const QVector<short>& fidRaw() const { return m_anRaw[2]; }
+	const QVector<short>& digitalRaw() const { return m_block.digital; }
+	const QVector<short>& eadRaw() const { return m_block.analog1; }
+	const QVector<short>& fidRaw() const { return m_block.analog2; }
 	const QVector<double>& eadDisplay() const { return m_anDisplay[1]; }
 	const QVector<double>& fidDisplay() const { return m_anDisplay[2]; }
+	/// Index of the first sample which convert() took, counted from the start of sampling
+	int firstSample() const;
+	/// Number of samples which convert() took
+	int sampleCount() const;
+	/// Display pixels for the given channel, as of the last call to updatePreview()
+	const RenderPreview& preview(int iChan) const { return m_previews[iChan]; }
 
 	void updateRawToVoltageFactors();
 	void calcRawToVoltageFactors(int iChan, int& nNum, int &nDen);
+	/// Factor from raw values to display units (mV) for the given channel, as of updateRawToVoltageFactors()
+	double rawToVoltageFactor(int iChan) const { return m_anRawToVoltageFactors[iChan]; }
 	bool check();
-	bool convert();
+	/// Set up the live filters from the recording settings and reset their state.
+	/// Should be called before a new recording starts.
+	void updateFilters();
+	/// Whether the display data of the given channel is filtered
+	bool isFiltered(int iChan) const { return !m_filters[iChan].isEmpty(); }
+	/// Hold back the samples until the trigger fires, and then start with the nPreTriggerSamples samples before it.
+	/// Should be called before a new recording starts.
+	void armTrigger(int nPreTriggerSamples);
+	void disarmTrigger();
+	bool isWaitingForTrigger() const { return m_preTrigger.isArmed(); }
+	/// Signal quality of the given analog channel over the last second, updated by convert()
+	IdacSignalQuality signalQuality(int iChan) const { return m_monitors[iChan].quality(); }
+	/// Forget the samples seen by the signal quality monitors, e.g. after the channel settings have changed
+	void resetSignalQuality();
+	/// Take the latest block of samples from the IDAC and convert its raw values in place.
+	/// Filtered channels are always converted to display units, since their filter has to see every sample exactly once.
+	/// While waiting for the trigger, the block is only kept for the pre-trigger window and false is returned.
+	/// @param bDisplay whether to also fill eadDisplay() and fidDisplay()
+	bool convert(bool bDisplay = true);
+	/// Hand the samples taken by convert() over to the given recording wave.
+	/// When the trigger has just fired, these include the pre-trigger window.
+	/// The raw data is spliced into wave->raw and the display data is written directly into wave->display.
+	void appendTo(int iChan, WaveInfo* wave);
+	/// Have the sampling thread summarize the samples into pixels of the given width.
+	/// Pixel 0 starts at sample iSampleOrigin.
+	void setPreviewTimebase(double nSamplesPerPixel, int nPixels, int iSampleOrigin);
+	/// Fetch the pixels summarized by the sampling thread and convert them to display units.
+	/// The work is proportional to the number of pixels, not to the number of samples.
+	/// @returns false if no summaries for the current timebase are available yet
+	bool updatePreview();
+
+private:
+	/// Min/max pixels built from a channel's filtered samples, since the sampling thread only sees the raw ones
+	struct FilteredPreview
+	{
+		QVector<MinMax> ring;
+		/// Pixel currently being filled (-1 if none)
+		int iPixel;
+		/// Sample index at which iPixel ends
+		int iPixelSampleEnd;
+		MinMax pixel;
+		/// First pixel which was filled since the timebase was set (-1 if none)
+		int iPixelFirst;
+		/// One past the last completed pixel
+		int iPixelEnd;
+
+		FilteredPreview() : iPixel(-1), iPixelSampleEnd(0), iPixelFirst(-1), iPixelEnd(0) {}
+		void restart(int nPixels);
+	};
+
+	int previewPixelStart(int iPixel) const;
+	/// Add the filtered samples of the current block to the channel's pixels
+	void addFilteredPreview(int iChan);
+	/// Fill the channel's preview from the pixels built by addFilteredPreview()
+	void updateFilteredPreview(int iChan);
 
 private:
 	IdacProxy* m_idac;
 
 	double m_anRawToVoltageFactors[3];
 	bool m_bReportingError;
-	short* m_anBuffers[3];
-	QVector<short> m_anRaw[3];
+	/// The block of samples most recently taken from the IDAC
+	IdacSampleBlock m_block;
+	/// The blocks whose samples convert() took: normally just m_block, but also the pre-trigger window
+	/// when the trigger has fired.  The first one is used from sample m_nSkip on.
+	QList<IdacSampleBlock> m_blocks;
+	int m_nSkip;
+	IdacPreTrigger m_preTrigger;
+	/// Signal quality monitors for the analog channels (index 0 is unused)
+	IdacSignalMonitor m_monitors[3];
 	QVector<double> m_anDisplay[3];
+	/// Timebase requested in setPreviewTimebase()
+	double m_nPreviewSamplesPerPixel;
+	int m_nPreviewPixels;
+	int m_iPreviewSampleOrigin;
+	RenderPreview m_previews[3];
+	/// Causal filters applied to the display data of the analog channels while recording
+	StreamFilter m_filters[3];
+	FilteredPreview m_filteredPreviews[3];
 };
 
 #endif
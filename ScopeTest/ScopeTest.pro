@@ -1,19 +1,42 @@
 TEMPLATE = app
-QT += xml svg
+QT += xml svg concurrent sql
 CONFIG += warn_on link_prl
 
 HEADERS += \
 	TestBase.h \
 	WaitForHardwareDialog.h \
 	RecordDialog.h \
-	TestRecording.h
+	TestCsv.h \
+	TestFormats.h \
+	TestLoading.h \
+	TestPeaks.h \
+	TestPreTrigger.h \
+	TestPreview.h \
+	TestRecording.h \
+	TestReplay.h \
+	TestSaveAsync.h \
+	TestSignalMonitor.h \
+	TestUndo.h
 SOURCES += \
 	TestBase.cpp \
 	WaitForHardwareDialog.cpp \
 	RecordDialog.cpp \
+	TestCsv.cpp \
+	TestFormats.cpp \
+	TestLoading.cpp \
+	TestPeaks.cpp \
+	TestPreTrigger.cpp \
+	TestPreview.cpp \
 	TestRecording.cpp \
+	TestReplay.cpp \
+	TestSaveAsync.cpp \
+	TestSignalMonitor.cpp \
+	TestUndo.cpp \
 	./main.cpp
 
+# Files which the tests read
+DEFINES += SCOPETEST_DATA_DIR=\\\"$$PWD/data\\\"
+
 unix:!macx {
 	QMAKE_CFLAGS += -static-libgcc
 	QMAKE_CXXFLAGS += -static-libgcc
@@ -23,6 +23,9 @@
 #include "WaitForHardwareDialog.h"
 
 
+int TestBase::s_nFailures = 0;
+
+
 bool TestUi::waitForHardware(IdacProxy* idac, bool /*bCloseOnAvailable*/)
 {
 	if (idac == NULL)
@@ -106,6 +109,7 @@ bool TestBase::compare(const QImage& image, const QString& sFilename, const QStr
 	bool bEqual = (image == orig);
 	if (bEqual != bExpectEqual) {
 		qDebug() << "Comparison to" << sFilenameContrast << "failed.  See" << sFilename;
+		s_nFailures++;
 		return false;
 	}
 	return true;
@@ -119,3 +123,17 @@ void TestBase::compare(const QString& sLabel, const QString& sFilenameContrast,
 	if (!compare(image, sFilename, sFilenameContrast, bExpectEqual))
 		image.save(sFilename);
 }
+
+bool TestBase::expect(bool b, const QString& sWhat)
+{
+	if (!b) {
+		qDebug() << "Test" << id << "failed:" << sWhat;
+		s_nFailures++;
+	}
+	return b;
+}
+
+QString TestBase::dataDir()
+{
+	return SCOPETEST_DATA_DIR;
+}
@@ -46,6 +46,8 @@ public:
 	virtual QString getFileOpenFilename(const QString& sLastDir) { this->sLastDir = sLastDir; return s; }
 	virtual QString getFileSaveAsFilename(const QString& sCurrentFilename) { this->sCurrentFilename = sCurrentFilename; return s; }
 	virtual QString getFileImportFilename(const QString& sLastDir) { this->sLastDir = sLastDir; return s; }
+	virtual QString findInCatalog(const QString& /*sCatalog*/) { return s; }
+	virtual QString getSampleStoreDirectory(const QString& sLastDir) { this->sLastDir = sLastDir; return s; }
 	/// Let user edit the file comment
 	virtual QString getComment(const QString& sComment) { this->sComment = sComment; return s; }
 	/// Return QMessageBox::Save, QMessageBox::Discard, or QMessageBox::Cancel
@@ -79,6 +81,9 @@ public:
     TestBase(int id, bool bIdac);
 	~TestBase();
 
+	/// Number of failed checks and comparisons in all tests so far
+	static int failures() { return s_nFailures; }
+
 protected:
 	/// Construct a filename
 	QString getFilename(const QString& sLabel);
@@ -92,12 +97,21 @@ protected:
 
 	void contrast(const QString& sLabel, const QString& sFilename) { compare(sLabel, sFilename, false); }
 
+	/// Report a failure if b is false
+	/// @returns b
+	bool expect(bool b, const QString& sWhat);
+	/// Directory of the files which the tests read, e.g. recorded captures
+	static QString dataDir();
+
 protected:
     const int id;
 	TestUi* ui;
 	MainScope* scope;
 	QSize sz;
 	int iStep;
+
+private:
+	static int s_nFailures;
 };
 
 #endif
@@ -0,0 +1,204 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestCsv.h"
+
+#include <math.h>
+
+#include <QFile>
+#include <QMap>
+
+#include <EadFile.h>
+#include <RecInfo.h>
+#include <TextImporter.h>
+#include <WaveInfo.h>
+
+
+/// Number of times the recordings of the sample project are imported, so that the export has
+/// well over a hundred columns, and each of its chunks only holds a few hundred rows
+static const int WIDE_IMPORT_COUNT = 40;
+/// Number of rows of the imported files, which makes them several megabytes large
+static const int IMPORT_ROWS = 100000;
+
+
+/// Values of the imported columns: one which needs a fractional voltage factor, and one which needs a factor above 1
+static double importedEad(int iRow) { return 0.5 * sin((iRow + 1) / 100.0); }
+static double importedFid(int iRow) { return (iRow % 1000) * 100; }
+
+static bool writeFile(const QString& sFilename, const QByteArray& data)
+{
+	QFile file(sFilename);
+	return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size();
+}
+
+
+TestCsv::TestCsv(int id) : TestBase(id, false)
+{
+	if (!expect(m_dir.isValid(), "create a temporary directory"))
+		return;
+
+	testExport();
+	testImport();
+}
+
+void TestCsv::testExport()
+{
+	EadFile file;
+	file.createFakeData();
+	EadFile sample;
+	sample.createFakeData();
+	for (int i = 0; i < WIDE_IMPORT_COUNT; i++)
+		file.importWaves(&sample);
+
+	const QString sCsv = m_dir.path() + "/wide.csv";
+	QString sError;
+	if (!expect(file.exportData(sCsv, &sError), "export " + sCsv + ": " + sError))
+		return;
+
+	// Every wave with display data is a column, aligned on the common timeline
+	QList<const WaveInfo*> waves;
+	int nRows = 0;
+	foreach (RecInfo* rec, file.recs())
+	{
+		foreach (const WaveInfo* wave, rec->waves())
+		{
+			if (!wave->display.isEmpty())
+			{
+				waves << wave;
+				nRows = qMax(nRows, wave->shift() + wave->display.size());
+			}
+		}
+	}
+
+	QFile csv(sCsv);
+	if (!expect(csv.open(QIODevice::ReadOnly | QIODevice::Text), "open " + sCsv))
+		return;
+
+	const QList<QByteArray> names = csv.readLine().trimmed().split(',');
+	if (!expect(names.size() == waves.size(), QString("%0 columns instead of %1").arg(names.size()).arg(waves.size())))
+		return;
+	for (int iCol = 0; iCol < waves.size(); iCol++)
+		expect(names[iCol] == "\"" + waves[iCol]->sName.toLocal8Bit() + "\"", QString("name of column %0").arg(iCol));
+
+	// The values are written in the shortest form which reads back exactly
+	int iRow = 0;
+	while (!csv.atEnd())
+	{
+		const QList<QByteArray> fields = csv.readLine().trimmed().split(',');
+		if (!expect(fields.size() == waves.size(), QString("number of values in row %0").arg(iRow)))
+			return;
+		for (int iCol = 0; iCol < waves.size(); iCol++)
+		{
+			const WaveInfo* wave = waves[iCol];
+			const int didx = iRow - wave->shift();
+			const double n = (didx >= 0 && didx < wave->display.size()) ? wave->display[didx] : 0;
+			if (!expect(fields[iCol].toDouble() == n, QString("value in row %0, column %1: %2 instead of %3").arg(iRow).arg(iCol).arg(QString(fields[iCol])).arg(n)))
+				return;
+		}
+		iRow++;
+	}
+	expect(iRow == nRows, QString("%0 rows instead of %1").arg(iRow).arg(nRows));
+}
+
+void TestCsv::testImport()
+{
+	EadFile file;
+
+	//
+	// Semicolons, decimal commas, and a time column in minutes at our own sample rate
+	//
+
+	const QString sCsv = m_dir.path() + "/import.csv";
+	QByteArray csv = "# exported by another system\n\"Time (min)\";\"EAD\";\"FID\"\n";
+	for (int iRow = 0; iRow < IMPORT_ROWS; iRow++)
+	{
+		QByteArray line = QByteArray::number(iRow / (EAD_SAMPLES_PER_SECOND * 60.0), 'g', 12) + ';'
+			+ QByteArray::number(importedEad(iRow), 'g', 12) + ';'
+			+ QByteArray::number(importedFid(iRow), 'g', 12);
+		csv += line.replace('.', ',') + "\r\n";
+	}
+	if (!expect(writeFile(sCsv, csv), "write " + sCsv))
+		return;
+
+	TextImporter importer;
+	if (!expect(importer.open(sCsv), "open " + sCsv))
+		return;
+	expect(importer.columnNames() == QStringList() << "Time (min)" << "EAD" << "FID", "column names: " + importer.columnNames().join(", "));
+	expect(importer.timeColumn() == 0, "the time column is found");
+	expect(fabs(importer.sampleRate() - EAD_SAMPLES_PER_SECOND) < 0.01, QString("sample rate %0").arg(importer.sampleRate()));
+	if (expect(importer.previewRows().size() == 10, "number of preview rows"))
+	{
+		const QVector<double>& row = importer.previewRows()[5];
+		expect(row.size() == 3 && fabs(row[1] - importedEad(5)) < 1e-9 && row[2] == importedFid(5), "the preview values are parsed with a decimal comma");
+	}
+
+	RecInfo rec(&file, 1);
+	QMap<int, WaveInfo*> columns;
+	columns.insert(1, rec.ead());
+	columns.insert(2, rec.fid());
+	if (expect(importer.read(columns, importer.sampleRate()), "read " + sCsv))
+	{
+		const WaveInfo* ead = rec.ead();
+		const WaveInfo* fid = rec.fid();
+		expect(ead->nRawToVoltageFactor < 1 && fid->nRawToVoltageFactor > 1, "the voltage factors fit the values into the raw range");
+		if (expect(ead->raw.size() == IMPORT_ROWS && fid->raw.size() == IMPORT_ROWS, QString("%0 samples imported").arg(ead->raw.size())))
+		{
+			// Each raw value is within one quantization step of the original
+			for (int i = 0; i < IMPORT_ROWS; i++)
+			{
+				if (!expect(fabs(ead->raw[i] * ead->nRawToVoltageFactor - importedEad(i)) <= ead->nRawToVoltageFactor, QString("EAD sample %0").arg(i)))
+					break;
+				if (!expect(fabs(fid->raw[i] * fid->nRawToVoltageFactor - importedFid(i)) <= fid->nRawToVoltageFactor, QString("FID sample %0").arg(i)))
+					break;
+			}
+		}
+	}
+
+	//
+	// Tabs, no header and twice our sample rate
+	//
+
+	const QString sTsv = m_dir.path() + "/import.tsv";
+	QByteArray tsv;
+	for (int iRow = 0; iRow < IMPORT_ROWS; iRow++)
+		tsv += QByteArray::number(importedEad(iRow), 'g', 12) + '\t' + QByteArray::number(importedFid(iRow), 'g', 12) + '\n';
+	if (!expect(writeFile(sTsv, tsv), "write " + sTsv))
+		return;
+
+	if (!expect(importer.open(sTsv), "open " + sTsv))
+		return;
+	expect(importer.columnNames().size() == 2, "columns of a file without a header");
+	expect(importer.timeColumn() == -1 && importer.sampleRate() == 0, "no time column without a header");
+
+	RecInfo recTsv(&file, 2);
+	columns.clear();
+	columns.insert(0, recTsv.ead());
+	if (expect(importer.read(columns, 2 * EAD_SAMPLES_PER_SECOND), "read " + sTsv))
+	{
+		// Downsampling picks every other row
+		const WaveInfo* ead = recTsv.ead();
+		if (expect(ead->raw.size() == IMPORT_ROWS / 2, QString("%0 samples imported").arg(ead->raw.size())))
+		{
+			for (int i = 0; i < ead->raw.size(); i++)
+			{
+				if (!expect(fabs(ead->raw[i] * ead->nRawToVoltageFactor - importedEad(2 * i)) <= ead->nRawToVoltageFactor, QString("downsampled sample %0").arg(i)))
+					break;
+			}
+		}
+		expect(recTsv.fid()->raw.isEmpty(), "columns which aren't mapped are skipped");
+	}
+}
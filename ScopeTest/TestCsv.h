@@ -0,0 +1,41 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TESTCSV_H
+#define __TESTCSV_H
+
+#include <QTemporaryDir>
+
+#include "TestBase.h"
+
+
+/// Exports a file with many waves to CSV and checks every value which is read back,
+/// and imports CSV and TSV files which are large enough to be parsed in several chunks
+class TestCsv : public TestBase
+{
+public:
+	TestCsv(int id);
+
+private:
+	void testExport();
+	void testImport();
+
+private:
+	QTemporaryDir m_dir;
+};
+
+#endif
@@ -0,0 +1,300 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestFormats.h"
+
+#include <QDataStream>
+#include <QDir>
+#include <QDirIterator>
+#include <QFile>
+#include <QFileInfo>
+#include <QtEndian>
+
+#include <EadFile.h>
+#include <RecInfo.h>
+#include <SampleStore.h>
+#include <WaveInfo.h>
+
+
+static QByteArray readFile(const QString& sFilename)
+{
+	QFile file(sFilename);
+	if (!file.open(QIODevice::ReadOnly))
+		return QByteArray();
+	return file.readAll();
+}
+
+static bool writeFile(const QString& sFilename, const QByteArray& data)
+{
+	QFile file(sFilename);
+	return file.open(QIODevice::WriteOnly | QIODevice::Truncate) && file.write(data) == data.size();
+}
+
+/// Rewrite a version 4 file without a sample store in version 3, which GcEad no longer writes.
+/// Version 3 has the same layout, except that its index has neither the sample store nor the hashes.
+static bool convertToVersion3(const QString& sV4, const QString& sV3)
+{
+	QByteArray data = readFile(sV4);
+	// The index offset and "EADINDEX" end the file
+	if (data.size() < 24 || !data.endsWith("EADINDEX"))
+		return false;
+	const qint64 nIndexOffset = qFromBigEndian<qint64>((const uchar*) data.constData() + data.size() - 16);
+	if (nIndexOffset < 8 || nIndexOffset > data.size() - 16)
+		return false;
+
+	QDataStream in(data.mid(nIndexOffset));
+	in.setVersion(QDataStream::Qt_4_3);
+	QString xml, sSampleStore;
+	qint32 nWaves;
+	in >> xml >> sSampleStore >> nWaves;
+	QList<qint64> offsets;
+	for (int i = 0; i < nWaves; i++)
+	{
+		qint64 nOffset;
+		QByteArray hash;
+		in >> nOffset >> hash;
+		offsets << nOffset;
+	}
+	if (in.status() != QDataStream::Ok || !sSampleStore.isEmpty())
+		return false;
+
+	// The header and the sample blocks stay where they are
+	QByteArray v3 = data.left(nIndexOffset);
+	qToBigEndian<qint32>(3, (uchar*) v3.data() + 4);
+	QDataStream out(&v3, QIODevice::WriteOnly | QIODevice::Append);
+	out.setVersion(QDataStream::Qt_4_3);
+	out << xml << nWaves;
+	foreach (qint64 nOffset, offsets)
+		out << nOffset;
+	out << nIndexOffset;
+	out.writeRawData("EADINDEX", 8);
+	return writeFile(sV3, v3);
+}
+
+
+TestFormats::TestFormats(int id) : TestBase(id, false)
+{
+	if (!expect(m_dir.isValid(), "create a temporary directory"))
+		return;
+
+	EadFile original;
+	original.createFakeData();
+	// Settings which are saved with the waves
+	WaveInfo* waveEad1 = original.recs()[1]->ead();
+	waveEad1->sComment = "first EAD";
+	waveEad1->setShift(waveEad1->shift() + 5);
+
+	//
+	// Version 2
+	//
+
+	// A file which doesn't use a sample store is saved in the layout which older versions can read
+	const QString sV2 = m_dir.path() + "/v2.ead";
+	expect(original.saveAs(sV2), "save " + sV2);
+	expect(readVersion(sV2) == 2, "a new file is saved in version 2");
+	EadFile v2;
+	expect(v2.load(sV2) == LoadSaveResult_Ok, "load " + sV2);
+	expect(v2.fileVersion() == 2, "version of the loaded file");
+	expectSameRecordings(&original, &v2, "version 2");
+
+	// Load, save and load again
+	const QString sV2Again = m_dir.path() + "/v2-again.ead";
+	expect(v2.saveAs(sV2Again), "save " + sV2Again);
+	expect(readVersion(sV2Again) == 2, "a loaded version 2 file is saved in version 2");
+	EadFile v2Again;
+	expect(v2Again.load(sV2Again) == LoadSaveResult_Ok, "load " + sV2Again);
+	expectSameRecordings(&original, &v2Again, "version 2 saved again");
+
+	// Saving in place keeps the version, too
+	v2Again.setComment("saved in place");
+	expect(v2Again.saveAs(sV2Again), "save " + sV2Again + " in place");
+	expect(readVersion(sV2Again) == 2, "a version 2 file stays in version 2 when it's saved in place");
+
+	//
+	// Version 4
+	//
+
+	// Converting to the appendable format
+	const QString sV4 = m_dir.path() + "/v4.ead";
+	expect(v2.saveAs(sV4, SaveMode_Convert), "convert to " + sV4);
+	expect(readVersion(sV4) == 4, "a converted file is saved in version 4");
+	EadFile v4;
+	expect(v4.load(sV4) == LoadSaveResult_Ok, "load " + sV4);
+	expect(v4.fileVersion() == 4, "version of the loaded file");
+	expectSameRecordings(&original, &v4, "version 4");
+
+	// Saving in place only appends a new index
+	const QByteArray before = readFile(sV4);
+	const QString sCommentBefore = v4.comment();
+	v4.setComment("appended");
+	v4.recs()[1]->ead()->sComment = "appended EAD";
+	v4.setDirty();
+	expect(v4.saveAs(sV4), "save " + sV4 + " in place");
+	const QByteArray after = readFile(sV4);
+	expect(after.size() > before.size() && after.startsWith(before), "saving a version 4 file in place appends to it");
+	EadFile v4Appended;
+	expect(v4Appended.load(sV4) == LoadSaveResult_Ok, "load " + sV4 + " after appending");
+	expect(v4Appended.comment() == "appended", "the appended file comment is loaded");
+	expectSameRecordings(&v4, &v4Appended, "version 4 after appending");
+
+	// If saving is interrupted while appending, the index of the previous save is used
+	const QString sTruncated = m_dir.path() + "/v4-truncated.ead";
+	expect(writeFile(sTruncated, after.left(after.size() - 5)), "write " + sTruncated);
+	EadFile v4Truncated;
+	expect(v4Truncated.load(sTruncated) == LoadSaveResult_Ok, "load " + sTruncated);
+	expect(v4Truncated.comment() == sCommentBefore, "an incomplete append falls back to the previous index");
+	expectSameRecordings(&original, &v4Truncated, "version 4 with an incomplete append");
+	// The same holds for data which isn't an index at all
+	expect(writeFile(sTruncated, after + QByteArray(100, '\xff')), "write " + sTruncated);
+	EadFile v4Garbage;
+	expect(v4Garbage.load(sTruncated) == LoadSaveResult_Ok, "load " + sTruncated + " with trailing garbage");
+	expect(v4Garbage.comment() == "appended", "trailing garbage is skipped");
+
+	//
+	// Version 3
+	//
+
+	// Version 3 files are still read.  Saving one in place converts it to version 4,
+	// since it already needs a version of GcEad which reads the appendable format.
+	const QString sV3 = m_dir.path() + "/v3.ead";
+	if (expect(convertToVersion3(sV4, sV3), "write " + sV3))
+	{
+		EadFile v3;
+		expect(v3.load(sV3) == LoadSaveResult_Ok, "load " + sV3);
+		expect(v3.fileVersion() == 3, "version of the loaded file");
+		expectSameRecordings(&v4Appended, &v3, "version 3");
+		v3.setComment("saved in place");
+		expect(v3.saveAs(sV3), "save " + sV3 + " in place");
+		expect(readVersion(sV3) == 4, "a version 3 file is saved in version 4");
+		EadFile v3Saved;
+		expect(v3Saved.load(sV3) == LoadSaveResult_Ok, "load " + sV3 + " after saving");
+		expectSameRecordings(&v4Appended, &v3Saved, "version 3 saved in place");
+	}
+
+	//
+	// Sample store
+	//
+
+	const QString sStore = m_dir.path() + "/store";
+	const QString sStoredA = m_dir.path() + "/stored-a.ead";
+	const QString sStoredB = m_dir.path() + "/stored-b.ead";
+	EadFile storedA;
+	expect(storedA.load(sV2) == LoadSaveResult_Ok, "load " + sV2);
+	storedA.setSampleStore(sStore);
+	expect(storedA.saveAs(sStoredA), "save " + sStoredA);
+	expect(readVersion(sStoredA) == 4, "a file with a sample store is saved in version 4");
+	EadFile loadedA;
+	expect(loadedA.load(sStoredA) == LoadSaveResult_Ok, "load " + sStoredA);
+	expect(loadedA.sampleStore() == storedA.sampleStore(), "the sample store is loaded");
+	expectSameRecordings(&original, &loadedA, "sample store");
+
+	// A second file shares all blocks with the first, except that of one changed wave
+	EadFile storedB;
+	expect(storedB.load(sStoredA) == LoadSaveResult_Ok, "load " + sStoredA);
+	storedB.recs()[1]->ead()->raw[0] += 1;
+	storedB.setDirty();
+	expect(storedB.saveAs(sStoredB), "save " + sStoredB);
+	EadFile loadedB;
+	expect(loadedB.load(sStoredB) == LoadSaveResult_Ok, "load " + sStoredB);
+	expectSameRecordings(&storedB, &loadedB, "sample store shared by two files");
+
+	SampleStore store(sStore);
+	expect(store.collectGarbage() == 0, "all blocks in the store are used");
+
+	// A referring file which has gone missing may still need its blocks, so nothing is deleted
+	const QString sCanonicalB = QFileInfo(sStoredB).canonicalFilePath();
+	const QString sMovedB = m_dir.path() + "/moved-b.ead";
+	expect(QFile::rename(sStoredB, sMovedB), "move " + sStoredB);
+	QStringList asProblems;
+	expect(store.collectGarbage(NULL, &asProblems) == -1, "garbage isn't collected while a referring file is missing");
+	expect(asProblems == QStringList() << sCanonicalB, "the missing file is reported");
+	// Loading the moved file adds it to the referrers, but the missing one still counts
+	EadFile movedB;
+	expect(movedB.load(sMovedB) == LoadSaveResult_Ok, "load " + sMovedB);
+	expect(store.collectGarbage() == -1, "garbage isn't collected while a referring file is missing");
+	// Once the missing file is forgotten, the moved one keeps its block
+	expect(store.removeReferrer(sStoredB), "forget " + sStoredB);
+	expect(store.collectGarbage(NULL, &asProblems) == 0 && asProblems.isEmpty(), "the moved file's blocks are kept");
+
+	// Only the block which nothing refers to anymore is deleted
+	expect(QFile::remove(sMovedB), "delete " + sMovedB);
+	expect(store.removeReferrer(sMovedB), "forget " + sMovedB);
+	qint64 nBytesFreed = 0;
+	expect(store.collectGarbage(&nBytesFreed) == 1, "the block of the deleted file is collected");
+	expect(nBytesFreed > 0, "the size of the collected block is reported");
+	EadFile loadedAgainA;
+	expect(loadedAgainA.load(sStoredA) == LoadSaveResult_Ok, "load " + sStoredA + " after collecting garbage");
+	expectSameRecordings(&original, &loadedAgainA, "sample store after collecting garbage");
+
+	// A block whose contents no longer match its hash isn't loaded.
+	// Blocks are kept in subdirectories, next to the list of referrers.
+	QString sBlock;
+	QDirIterator itBlocks(sStore, QDir::Files, QDirIterator::Subdirectories);
+	while (sBlock.isEmpty() && itBlocks.hasNext())
+	{
+		const QString sFile = itBlocks.next();
+		if (QFileInfo(sFile).dir() != QDir(sStore))
+			sBlock = sFile;
+	}
+	const QByteArray block = readFile(sBlock);
+	if (expect(block.size() > 4, "find a block in " + sStore))
+	{
+		QByteArray corrupt = block;
+		corrupt[corrupt.size() - 1] = ~corrupt[corrupt.size() - 1];
+		expect(writeFile(sBlock, corrupt), "write " + sBlock);
+		EadFile corruptA;
+		expect(corruptA.load(sStoredA) != LoadSaveResult_Ok, "a file with a corrupt block doesn't load");
+		expect(writeFile(sBlock, block), "restore " + sBlock);
+	}
+}
+
+void TestFormats::expectSameRecordings(const EadFile* expected, const EadFile* actual, const QString& sWhat)
+{
+	if (!expect(actual->recs().size() == expected->recs().size(), sWhat + ": number of recordings"))
+		return;
+	// recs()[0] holds the averages, which are calculated from the others
+	for (int iRec = 1; iRec < expected->recs().size(); iRec++)
+	{
+		const QList<WaveInfo*>& wavesExpected = expected->recs()[iRec]->waves();
+		const QList<WaveInfo*>& wavesActual = actual->recs()[iRec]->waves();
+		if (!expect(wavesActual.size() == wavesExpected.size(), QString("%0: number of waves in recording %1").arg(sWhat).arg(iRec)))
+			continue;
+		for (int iWave = 0; iWave < wavesExpected.size(); iWave++)
+		{
+			const WaveInfo* waveExpected = wavesExpected[iWave];
+			const WaveInfo* waveActual = wavesActual[iWave];
+			const QString sWave = QString("%0: wave %1 of recording %2").arg(sWhat).arg(iWave).arg(iRec);
+			expect(waveActual->raw == waveExpected->raw, sWave + ": samples");
+			expect(waveActual->sName == waveExpected->sName, sWave + ": name");
+			expect(waveActual->sComment == waveExpected->sComment, sWave + ": comment");
+			expect(waveActual->nRawToVoltageFactor == waveExpected->nRawToVoltageFactor, sWave + ": voltage factor");
+			expect(waveActual->shift() == waveExpected->shift(), sWave + ": shift");
+		}
+	}
+}
+
+qint32 TestFormats::readVersion(const QString& sFilename)
+{
+	QFile file(sFilename);
+	if (!file.open(QIODevice::ReadOnly))
+		return -1;
+	// "EAD\0" followed by the big-endian version
+	const QByteArray header = file.read(8);
+	if (header.size() != 8 || !header.startsWith(QByteArray("EAD", 4)))
+		return -1;
+	return qFromBigEndian<qint32>((const uchar*) header.constData() + 4);
+}
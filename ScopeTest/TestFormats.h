@@ -0,0 +1,46 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TESTFORMATS_H
+#define __TESTFORMATS_H
+
+#include <QTemporaryDir>
+
+#include "TestBase.h"
+
+
+class EadFile;
+
+
+/// Saves and loads files in each of the .ead formats, without the user interface,
+/// and checks that the recordings come back unchanged
+class TestFormats : public TestBase
+{
+public:
+	TestFormats(int id);
+
+private:
+	/// Compare the samples and the saved settings of every recording
+	void expectSameRecordings(const EadFile* expected, const EadFile* actual, const QString& sWhat);
+	/// Format version in the header of an .ead file, or -1 if it can't be read
+	static qint32 readVersion(const QString& sFilename);
+
+private:
+	QTemporaryDir m_dir;
+};
+
+#endif
@@ -0,0 +1,111 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestLoading.h"
+
+#include <QCoreApplication>
+
+#include <EadFile.h>
+#include <RecInfo.h>
+#include <ViewInfo.h>
+#include <WaveInfo.h>
+
+
+void WaveListCounter::on_file_waveListChanged()
+{
+	if (nChanged++ > 0)
+		return;
+
+	nRecsFirst = file->recs().size();
+	nWavesWithSamplesFirst = 0;
+	foreach (RecInfo* rec, file->recs())
+	{
+		foreach (WaveInfo* wave, rec->waves())
+		{
+			if (!wave->raw.isEmpty())
+				nWavesWithSamplesFirst++;
+		}
+	}
+}
+
+
+TestLoading::TestLoading(int id) : TestBase(id, false)
+{
+	if (!expect(m_dir.isValid(), "create a temporary directory"))
+		return;
+
+	// A digital channel and a hidden recording, neither of which is on the first screen
+	EadFile original;
+	original.createFakeData();
+	QVector<short> digital(4000);
+	for (int i = 0; i < digital.size(); i++)
+		digital[i] = (i / 100) % 2;
+	original.recs()[1]->digital()->raw = digital;
+	original.recs()[2]->ead()->pos.bVisible = false;
+
+	// Each file is only loaded progressively once, so that the derived data cache doesn't come into play
+	const QString sFilename = m_dir.path() + "/progressive.ead";
+	const QString sFilenameEdited = m_dir.path() + "/progressive-edited.ead";
+	if (!expect(original.saveAs(sFilename) && original.saveAs(sFilenameEdited), "save " + sFilename))
+		return;
+
+	EadFile file;
+	WaveListCounter counter(&file);
+	QObject::connect(&file, SIGNAL(waveListChanged()), &counter, SLOT(on_file_waveListChanged()));
+	if (!expect(file.load(sFilename, true) == LoadSaveResult_Ok, "load " + sFilename))
+		return;
+
+	// The wave list comes before the samples
+	expect(counter.nChanged >= 2, QString("waveListChanged() emitted %0 times during load()").arg(counter.nChanged));
+	expect(counter.nRecsFirst == original.recs().size() && counter.nWavesWithSamplesFirst == 0,
+		QString("%0 recordings and %1 waves with samples at the first waveListChanged()").arg(counter.nRecsFirst).arg(counter.nWavesWithSamplesFirst));
+
+	// The first screen is there when load() returns, the rest follows once control returns to the event loop
+	expect(file.isLoading(), "still loading in the background");
+	expect(file.recs()[1]->ead()->raw == original.recs()[1]->ead()->raw, "a visible wave is loaded right away");
+	expect(!file.recs()[0]->fid()->display.isEmpty(), "the averages are there right away");
+	expect(file.recs()[1]->digital()->raw.isEmpty(), "the digital channel is left for the background");
+	expect(file.recs()[2]->ead()->raw.isEmpty(), "the hidden wave is left for the background");
+	expect(!file.canUndo(), "nothing to undo after load()");
+
+	file.finishLoading();
+	QCoreApplication::processEvents();
+	expect(!file.isLoading(), "finished loading");
+	expect(file.recs()[1]->digital()->raw == digital, "the digital channel is loaded in the background");
+	expect(file.recs()[2]->ead()->raw == original.recs()[2]->ead()->raw, "the hidden wave is loaded in the background");
+	expect(!file.recs()[1]->digital()->display.isEmpty(), "the digital channel has display data");
+	bool bDigitalShown = false;
+	foreach (ViewWaveInfo* vwi, file.viewInfo(EadView_All)->vwiExtras())
+		bDigitalShown = bDigitalShown || (vwi->waveInfo() == file.recs()[1]->digital());
+	expect(bDigitalShown, "the digital channel is added to the views");
+	expect(!file.canUndo() && !file.isDirty(), "loading in the background isn't an edit");
+
+	// An edit made before the background is done still leaves all the samples to undo to
+	EadFile edited;
+	if (!expect(edited.load(sFilenameEdited, true) == LoadSaveResult_Ok, "load " + sFilenameEdited))
+		return;
+	const QString sComment = edited.comment();
+	edited.setComment("edited while loading");
+	expect(edited.recs()[1]->digital()->raw == digital, "an edit waits for the background decoding");
+	expect(edited.canUndo(), "the edit can be undone");
+	edited.undo();
+	expect(edited.comment() == sComment, "undo restores the comment");
+	expect(edited.recs()[1]->digital()->raw == digital, "undo keeps the digital channel");
+	expect(edited.recs()[2]->ead()->raw == original.recs()[2]->ead()->raw, "undo keeps the hidden wave");
+	expect(!edited.canUndo(), "nothing else to undo");
+	edited.finishLoading();
+}
@@ -0,0 +1,59 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TESTLOADING_H
+#define __TESTLOADING_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include "TestBase.h"
+
+
+class EadFile;
+
+
+/// Counts the waveListChanged() signals of an EadFile, and remembers what was loaded at the first one
+class WaveListCounter : public QObject
+{
+	Q_OBJECT
+public:
+	EadFile* file;
+	int nChanged;
+	/// Number of recordings and of waves with samples at the first signal
+	int nRecsFirst;
+	int nWavesWithSamplesFirst;
+
+	WaveListCounter(EadFile* file) : file(file), nChanged(0), nRecsFirst(-1), nWavesWithSamplesFirst(-1) {}
+
+public slots:
+	void on_file_waveListChanged();
+};
+
+
+/// Loads a file progressively and checks which waves are there when load() returns,
+/// that the others follow in the background, and that edits made meanwhile can be undone
+class TestLoading : public TestBase
+{
+public:
+	TestLoading(int id);
+
+private:
+	QTemporaryDir m_dir;
+};
+
+#endif
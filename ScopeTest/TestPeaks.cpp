@@ -0,0 +1,127 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestPeaks.h"
+
+#include <math.h>
+
+#include <EadFile.h>
+#include <RecInfo.h>
+#include <WaveInfo.h>
+
+
+/// Number of samples of the random signal
+static const int PEAK_SIGNAL_SAMPLES = 30000;
+/// Number of signals, each with its own random peaks and block sizes
+static const int PEAK_SIGNAL_COUNT = 5;
+/// Largest block of samples which is appended at a time
+static const int PEAK_BLOCK_MAX = 400;
+
+
+/// Pseudo-random numbers which are the same on every platform, so that failures can be reproduced
+class PeakRandom
+{
+public:
+	PeakRandom(quint32 nSeed) : m_n(nSeed) {}
+
+	/// Random number in [0, 1)
+	double next()
+	{
+		m_n = m_n * 1664525u + 1013904223u;
+		return (m_n >> 8) / double(1 << 24);
+	}
+
+	/// Random integer in [nMin, nMax]
+	int next(int nMin, int nMax)
+	{
+		return nMin + qMin(int(next() * (nMax - nMin + 1)), nMax - nMin);
+	}
+
+private:
+	quint32 m_n;
+};
+
+
+/// A drifting, noisy baseline with Gaussian peaks of random height and width
+static QVector<double> createFidSignal(PeakRandom& random)
+{
+	QVector<double> signal(PEAK_SIGNAL_SAMPLES);
+	double nBaseline = 0;
+	for (int i = 0; i < signal.size(); i++)
+	{
+		nBaseline += (random.next() - 0.5) * 0.002;
+		signal[i] = nBaseline + (random.next() - 0.5) * 0.004;
+	}
+
+	for (int iPeak = random.next(50, 300); iPeak < signal.size(); iPeak += random.next(150, 900))
+	{
+		const double nHeight = 0.05 + random.next();
+		const double nWidth = random.next(5, 80);
+		for (int i = qMax(0, iPeak - 5 * int(nWidth)); i < qMin(signal.size(), iPeak + 5 * int(nWidth)); i++)
+			signal[i] += nHeight * exp(-0.5 * (i - iPeak) * (i - iPeak) / (nWidth * nWidth));
+	}
+	return signal;
+}
+
+
+TestPeaks::TestPeaks(int id) : TestBase(id, false)
+{
+	EadFile file;
+	RecInfo rec(&file, 1);
+	RecInfo recBlocks(&file, 2);
+
+	PeakRandom random(12345);
+	for (int iSignal = 0; iSignal < PEAK_SIGNAL_COUNT; iSignal++)
+	{
+		const QVector<double> signal = createFidSignal(random);
+
+		// The whole wave at once
+		WaveInfo* wave = rec.fid();
+		wave->display = signal;
+		wave->findFidPeaks();
+		const QList<WavePeakInfo> expected = wave->peaks0;
+		expect(!expected.isEmpty(), QString("signal %0 has peaks").arg(iSignal));
+
+		// The same wave in random blocks, sometimes without any new samples
+		WaveInfo* waveBlocks = recBlocks.fid();
+		waveBlocks->display.clear();
+		waveBlocks->peaks0.clear();
+		waveBlocks->updateFidPeaks();
+		while (waveBlocks->display.size() < signal.size())
+		{
+			const int nBlock = qMin(random.next(0, PEAK_BLOCK_MAX), signal.size() - waveBlocks->display.size());
+			waveBlocks->display << signal.mid(waveBlocks->display.size(), nBlock);
+			waveBlocks->updateFidPeaks();
+		}
+		waveBlocks->updateFidPeaks(true);
+
+		const QList<WavePeakInfo>& actual = waveBlocks->peaks0;
+		const QString sSignal = QString("signal %0: ").arg(iSignal);
+		if (!expect(actual.size() == expected.size(), sSignal + QString("%0 peaks instead of %1").arg(actual.size()).arg(expected.size())))
+			continue;
+		for (int i = 0; i < expected.size(); i++)
+		{
+			const WavePeakInfo& a = actual[i];
+			const WavePeakInfo& e = expected[i];
+			if (!expect(a.left.i == e.left.i && a.middle.i == e.middle.i && a.right.i == e.right.i && a.bEnabled == e.bEnabled,
+					sSignal + QString("peak %0 at %1-%2-%3 instead of %4-%5-%6").arg(i)
+						.arg(a.left.i).arg(a.middle.i).arg(a.right.i)
+						.arg(e.left.i).arg(e.middle.i).arg(e.right.i)))
+				break;
+		}
+	}
+}
@@ -0,0 +1,32 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TESTPEAKS_H
+#define __TESTPEAKS_H
+
+#include "TestBase.h"
+
+
+/// Feeds a random FID signal to the incremental peak detection in random block sizes,
+/// as while recording, and checks that it finds the same peaks as a scan of the whole wave
+class TestPeaks : public TestBase
+{
+public:
+	TestPeaks(int id);
+};
+
+#endif
@@ -0,0 +1,126 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestPreTrigger.h"
+
+#include <IdacDriver/IdacPreTrigger.h>
+
+
+/// Contiguous blocks of the given sizes (repeated as needed) with nSamples samples in all.
+/// The trigger bit 0x01 is off at first and toggles at each of the edges;
+/// bit 0x02 changes on every sample, but isn't the trigger.
+static QList<IdacSampleBlock> createBlocks(const QList<int>& anSizes, int nSamples, const QList<int>& aiEdges)
+{
+	QList<IdacSampleBlock> blocks;
+	int iSample = 0;
+	for (int iBlock = 0; iSample < nSamples; iBlock++)
+	{
+		IdacSampleBlock block(qMin(anSizes[iBlock % anSizes.size()], nSamples - iSample));
+		block.iFirstSample = iSample;
+		for (int i = 0; i < block.size(); i++, iSample++)
+		{
+			int nEdges = 0;
+			foreach (int iEdge, aiEdges)
+			{
+				if (iEdge <= iSample)
+					nEdges++;
+			}
+			block.digital[i] = ((nEdges % 2 == 1) ? 0x01 : 0) | ((iSample % 2 == 1) ? 0x02 : 0);
+			block.analog1[i] = block.analog2[i] = short(iSample % 10000);
+		}
+		blocks << block;
+	}
+	return blocks;
+}
+
+
+TestPreTrigger::TestPreTrigger(int id) : TestBase(id, false)
+{
+	const QList<int> an100 = QList<int>() << 100;
+
+	// The edge in the middle of a block
+	expectTrigger(createBlocks(an100, 600, QList<int>() << 350), 120, 350, "edge within a block");
+	// The edge on the first sample of a block, the sample before it in the previous block
+	expectTrigger(createBlocks(an100, 600, QList<int>() << 400), 120, 400, "edge at a block boundary");
+	// Without a window the recording starts right at the trigger
+	expectTrigger(createBlocks(an100, 600, QList<int>() << 400), 0, 400, "edge at a block boundary without a window");
+	// Fewer samples than the window before the trigger
+	expectTrigger(createBlocks(an100, 600, QList<int>() << 350), 1000, 350, "window longer than the wait");
+	// The trigger is already on when waiting starts, so it has to go off first
+	expectTrigger(createBlocks(an100, 600, QList<int>() << 0 << 150 << 420), 120, 420, "trigger on at the start");
+	// Blocks of very different sizes, including single samples
+	expectTrigger(createBlocks(QList<int>() << 1 << 37 << 250 << 3 << 64, 8000, QList<int>() << 5000), 300, 5000, "irregular blocks");
+	// A long wait, of which only the window is kept
+	expectTrigger(createBlocks(an100, 20000, QList<int>() << 19050), 120, 19050, "long wait");
+	// No edge at all
+	expectTrigger(createBlocks(an100, 600, QList<int>()), 120, -1, "no edge");
+}
+
+void TestPreTrigger::expectTrigger(const QList<IdacSampleBlock>& blocks, int nWindow, int iTriggerExpected, const QString& sWhat)
+{
+	IdacPreTrigger trigger;
+	trigger.arm(nWindow, 0x01);
+	expect(trigger.isArmed(), sWhat + ": armed");
+
+	int iBlockTrigger = -1;
+	for (int i = 0; i < blocks.size() && iBlockTrigger < 0; i++)
+	{
+		if (trigger.add(blocks[i]))
+			iBlockTrigger = i;
+	}
+
+	if (iTriggerExpected < 0)
+	{
+		expect(iBlockTrigger < 0, sWhat + ": trigger doesn't fire");
+		trigger.disarm();
+		expect(!trigger.isArmed(), sWhat + ": disarmed");
+		return;
+	}
+
+	if (!expect(iBlockTrigger >= 0, sWhat + ": trigger fires"))
+		return;
+	const IdacSampleBlock& blockTrigger = blocks[iBlockTrigger];
+	expect(trigger.triggerSample() == iTriggerExpected,
+		sWhat + QString(": trigger at sample %0 instead of %1").arg(trigger.triggerSample()).arg(iTriggerExpected));
+	expect(iTriggerExpected >= blockTrigger.iFirstSample && iTriggerExpected < blockTrigger.iFirstSample + blockTrigger.size(),
+		sWhat + ": trigger fires in the block with the edge");
+
+	int nSkip = -1;
+	const QList<IdacSampleBlock> taken = trigger.takeBlocks(nSkip);
+	expect(!trigger.isArmed(), sWhat + ": disarmed after taking the blocks");
+	if (!expect(!taken.isEmpty() && taken.size() <= iBlockTrigger + 1, sWhat + QString(": %0 blocks taken").arg(taken.size())))
+		return;
+
+	// The recording starts nWindow samples before the trigger, in the first block which is taken
+	const int iStart = qMax(0, iTriggerExpected - nWindow);
+	const IdacSampleBlock& first = taken.first();
+	expect(nSkip >= 0 && nSkip < first.size() && first.iFirstSample + nSkip == iStart,
+		sWhat + QString(": recording starts at sample %0 (skipping %1) instead of %2").arg(first.iFirstSample + nSkip).arg(nSkip).arg(iStart));
+
+	// The blocks are handed on without copying, ending with the one in which the trigger fired
+	const int iBlockFirst = iBlockTrigger + 1 - taken.size();
+	for (int i = 0; i < taken.size(); i++)
+	{
+		const IdacSampleBlock& block = blocks[iBlockFirst + i];
+		if (!expect(taken[i].iFirstSample == block.iFirstSample
+				&& taken[i].digital.constData() == block.digital.constData()
+				&& taken[i].analog1.constData() == block.analog1.constData()
+				&& taken[i].analog2.constData() == block.analog2.constData(),
+				sWhat + QString(": block %0 is handed on unchanged").arg(i)))
+			break;
+	}
+}
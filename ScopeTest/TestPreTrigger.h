@@ -0,0 +1,40 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TESTPRETRIGGER_H
+#define __TESTPRETRIGGER_H
+
+#include <QList>
+
+#include <IdacDriver/IdacSampleBlock.h>
+
+#include "TestBase.h"
+
+
+/// Feeds sample blocks with a trigger edge to IdacPreTrigger and checks
+/// where the trigger fires and which samples start the recording
+class TestPreTrigger : public TestBase
+{
+public:
+	TestPreTrigger(int id);
+
+private:
+	/// Arm with nWindow, add the blocks until the trigger fires and check the blocks which are taken
+	void expectTrigger(const QList<IdacSampleBlock>& blocks, int nWindow, int iTriggerExpected, const QString& sWhat);
+};
+
+#endif
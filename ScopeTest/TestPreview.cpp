@@ -0,0 +1,116 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestPreview.h"
+
+#include <IdacDriver/IdacPreview.h>
+
+
+/// Digital value of a sample: bit 0x01 on every eighth sample, bit 0x10 always on
+static short previewDigital(int iSample)
+{
+	return ((iSample % 8 == 0) ? 0x01 : 0) | 0x10;
+}
+
+/// First sample of a bucket, as documented for IdacPreview
+static int previewBucketStart(double nSamplesPerBucket, int iSampleOrigin, int iBucket)
+{
+	return iSampleOrigin + int(iBucket * nSamplesPerBucket + 0.5);
+}
+
+/// Bucket which contains the given sample
+static int previewBucketOf(double nSamplesPerBucket, int iSampleOrigin, int iSample)
+{
+	int iBucket = 0;
+	while (previewBucketStart(nSamplesPerBucket, iSampleOrigin, iBucket + 1) <= iSample)
+		iBucket++;
+	return iBucket;
+}
+
+
+TestPreview::TestPreview(int id) : TestBase(id, false)
+{
+	IdacPreview preview;
+	expect(preview.snapshot()->iBucketEnd == 0, "no buckets before the timebase is set");
+
+	// Buckets of a whole number of samples
+	preview.setTimebase(4, 20, 0);
+	preview.restart();
+	addSamples(preview, 0, 60);
+	expectBuckets(preview, 4, 20, 0, 0, 60, 1, "4 samples per bucket");
+
+	// A fractional number of samples per bucket, starting after sample 0, with more buckets than the ring holds
+	preview.setTimebase(7.3, 50, 10);
+	preview.restart();
+	addSamples(preview, 0, 400);
+	expectBuckets(preview, 7.3, 50, 10, 0, 400, 0, "7.3 samples per bucket");
+
+	// A new timebase while sampling, which takes effect with the next sample.
+	// Sampling continues in the middle of a bucket, and buckets of 2-3 samples aren't all published right away.
+	preview.setTimebase(2.5, 100, 10);
+	addSamples(preview, 1001, 1200);
+	expectBuckets(preview, 2.5, 100, 10, 1001, 1200, 2, "2.5 samples per bucket");
+
+	// Sampling goes on, and the ring keeps only the newest buckets
+	addSamples(preview, 1201, 1600);
+	expectBuckets(preview, 2.5, 100, 10, 1001, 1600, 2, "2.5 samples per bucket, ring full");
+}
+
+void TestPreview::addSamples(IdacPreview& preview, int iSampleFirst, int iSampleLast)
+{
+	for (int iSample = iSampleFirst; iSample <= iSampleLast; iSample++)
+		preview.addSample(iSample, previewDigital(iSample), short(iSample), short(-iSample));
+}
+
+void TestPreview::expectBuckets(IdacPreview& preview, double nSamplesPerBucket, int nBuckets, int iSampleOrigin,
+	int iSampleFirst, int iSampleLast, int nLagMax, const QString& sWhat)
+{
+	const IdacPreviewSnapshot* snap = preview.snapshot();
+	expect(snap->nSamplesPerBucket == nSamplesPerBucket && snap->iSampleOrigin == iSampleOrigin && snap->buckets.size() == nBuckets,
+		sWhat + ": timebase");
+
+	// The bucket with the last sample is still being filled
+	const int iBucketFirst = previewBucketOf(nSamplesPerBucket, iSampleOrigin, qMax(iSampleFirst, iSampleOrigin));
+	const int iBucketEnd = previewBucketOf(nSamplesPerBucket, iSampleOrigin, iSampleLast);
+	if (!expect(snap->iBucketEnd <= iBucketEnd && snap->iBucketEnd >= iBucketEnd - nLagMax,
+			sWhat + QString(": buckets end at %0 instead of %1").arg(snap->iBucketEnd).arg(iBucketEnd)))
+		return;
+	expect(snap->iBucketFirst == qMax(iBucketFirst, snap->iBucketEnd - nBuckets),
+		sWhat + QString(": buckets start at %0 instead of %1").arg(snap->iBucketFirst).arg(qMax(iBucketFirst, snap->iBucketEnd - nBuckets)));
+
+	for (int iBucket = snap->iBucketFirst; iBucket < snap->iBucketEnd; iBucket++)
+	{
+		const int iStart = qMax(iSampleFirst, previewBucketStart(nSamplesPerBucket, iSampleOrigin, iBucket));
+		const int iEnd = previewBucketStart(nSamplesPerBucket, iSampleOrigin, iBucket + 1);
+		short nAnd = previewDigital(iStart);
+		short nOr = nAnd;
+		for (int iSample = iStart + 1; iSample < iEnd; iSample++)
+		{
+			nAnd &= previewDigital(iSample);
+			nOr |= previewDigital(iSample);
+		}
+
+		const IdacPreviewBucket& bucket = snap->bucket(iBucket);
+		if (!expect(bucket.anMin[1] == iStart && bucket.anMax[1] == iEnd - 1
+				&& bucket.anMin[2] == -(iEnd - 1) && bucket.anMax[2] == -iStart
+				&& bucket.anMin[0] == nAnd && bucket.anMax[0] == nOr,
+				sWhat + QString(": bucket %0 covers samples %1-%2 with digital %3/%4 instead of %5-%6 with %7/%8")
+					.arg(iBucket).arg(bucket.anMin[1]).arg(bucket.anMax[1]).arg(bucket.anMin[0]).arg(bucket.anMax[0])
+					.arg(iStart).arg(iEnd - 1).arg(nAnd).arg(nOr)))
+			break;
+	}
+}
@@ -0,0 +1,43 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TESTPREVIEW_H
+#define __TESTPREVIEW_H
+
+#include "TestBase.h"
+
+
+class IdacPreview;
+
+
+/// Feeds numbered samples to IdacPreview and checks that each bucket
+/// summarizes exactly the samples which its timebase assigns to it
+class TestPreview : public TestBase
+{
+public:
+	TestPreview(int id);
+
+private:
+	/// Add the samples from iSampleFirst through iSampleLast
+	static void addSamples(IdacPreview& preview, int iSampleFirst, int iSampleLast);
+	/// Check the published buckets after the samples from iSampleFirst through iSampleLast were added.
+	/// The snapshot may be up to nLagMax buckets behind the last completed bucket.
+	void expectBuckets(IdacPreview& preview, double nSamplesPerBucket, int nBuckets, int iSampleOrigin,
+		int iSampleFirst, int iSampleLast, int nLagMax, const QString& sWhat);
+};
+
+#endif
@@ -0,0 +1,82 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestReplay.h"
+
+#include <QDir>
+#include <QElapsedTimer>
+#include <QThread>
+
+#include <IdacDriver/IdacSampleBlock.h>
+#include <IdacDriver2/IdacDriver2Replay.h>
+
+
+/// data/idac2-replay.usbcap holds four 51-byte interrupt transfers of ten 5-byte packets each.
+/// Every five packets carry the same values, so the driver's decimation by five yields
+/// eight samples with analog1 = -100 * (k + 1), analog2 = -(50 * (k + 1) + 7),
+/// and the trigger bit set on the odd samples.
+static const int REPLAY_SAMPLES = 8;
+
+
+TestReplay::TestReplay(int id) : TestBase(id, false)
+{
+	const QString sFilename = QDir(dataDir()).filePath("idac2-replay.usbcap");
+
+	IdacDriver2Replay driver(sFilename, false);
+	if (!expect(driver.isValid(), "read the header of " + sFilename))
+		return;
+	driver.init();
+	if (!expect(driver.startSampling(), "start the replay"))
+		return;
+
+	// The replay thread keeps running after the end of the capture until sampling is stopped
+	IdacSampleBlock all;
+	QElapsedTimer timer;
+	timer.start();
+	while (all.size() < REPLAY_SAMPLES && timer.elapsed() < 5000)
+	{
+		IdacSampleBlock block;
+		if (driver.takeBlock(block))
+		{
+			expect(block.iFirstSample == all.size(), "blocks are contiguous");
+			all.digital << block.digital;
+			all.analog1 << block.analog1;
+			all.analog2 << block.analog2;
+		}
+		else
+			QThread::msleep(10);
+	}
+	// Give the thread time to produce anything beyond the capture, which would be a decoding error
+	QThread::msleep(100);
+	IdacSampleBlock rest;
+	driver.takeBlock(rest);
+	driver.stopSampling();
+
+	expect(all.size() == REPLAY_SAMPLES, QString("replayed %0 samples instead of %1").arg(all.size()).arg(REPLAY_SAMPLES));
+	expect(rest.isEmpty(), QString("%0 samples beyond the end of the capture").arg(rest.size()));
+	for (int i = 0; i < all.size() && i < REPLAY_SAMPLES; i++)
+	{
+		const short nDigital = (i % 2 == 0) ? ~0 : ~1;
+		expect(all.analog1[i] == -100 * (i + 1), QString("analog1[%0] = %1").arg(i).arg(all.analog1[i]));
+		expect(all.analog2[i] == -(50 * (i + 1) + 7), QString("analog2[%0] = %1").arg(i).arg(all.analog2[i]));
+		expect(all.digital[i] == nDigital, QString("digital[%0] = %1").arg(i).arg(all.digital[i]));
+	}
+
+	const IdacTelemetrySnapshot telemetry = driver.telemetrySnapshot();
+	expect(telemetry.nInvalidPackets == 0, "no invalid packets");
+	expect(telemetry.nSamplesDropped == 0, "no dropped samples");
+}
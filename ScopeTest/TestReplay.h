@@ -0,0 +1,32 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TESTREPLAY_H
+#define __TESTREPLAY_H
+
+#include "TestBase.h"
+
+
+/// Replays a recorded IDAC2 capture through the decoder and the sample buffer,
+/// and checks that the expected samples come out
+class TestReplay : public TestBase
+{
+public:
+	TestReplay(int id);
+};
+
+#endif
@@ -0,0 +1,98 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestSaveAsync.h"
+
+#include <QCoreApplication>
+
+#include <EadFile.h>
+#include <RecInfo.h>
+#include <WaveInfo.h>
+
+
+TestSaveAsync::TestSaveAsync(int id) : TestBase(id, false)
+{
+	if (!expect(m_dir.isValid(), "create a temporary directory"))
+		return;
+
+	EadFile file;
+	file.createFakeData();
+	file.setComment("before saving");
+	SaveFinishedCounter counter;
+	QObject::connect(&file, SIGNAL(saveFinished(bool)), &counter, SLOT(on_file_saveFinished(bool)));
+
+	WaveInfo* waveRemoved = file.recs()[2]->fid();
+	WaveInfo* waveShifted = file.recs()[1]->ead();
+	const QVector<short> rawRemoved = waveRemoved->raw;
+	const int nShift = waveShifted->shift();
+
+	// Edit the project while it is being written
+	const QString sFilename = m_dir.path() + "/async.ead";
+	if (!expect(file.saveAsync(sFilename), "start saving " + sFilename))
+		return;
+	file.setComment("edited while saving");
+	file.remove(waveRemoved);
+	waveShifted->setShift(nShift + 7);
+
+	expect(file.waitForSave(), "save " + sFilename);
+	expect(!file.isSaving(), "no longer saving");
+	expect(counter.nFinished == 1 && counter.bOk, QString("saveFinished() emitted %0 times").arg(counter.nFinished));
+	expect(file.isDirty(), "the edits made while saving still need to be saved");
+	// The save has been completed by waitForSave(), so it isn't reported again
+	QCoreApplication::processEvents();
+	expect(counter.nFinished == 1, QString("saveFinished() emitted %0 times after processing events").arg(counter.nFinished));
+
+	// The file holds the project as it was when the save started
+	EadFile loaded;
+	if (expect(loaded.load(sFilename) == LoadSaveResult_Ok, "load " + sFilename))
+	{
+		expect(loaded.comment() == "before saving", "the comment as it was when the save started");
+		expect(loaded.recs().size() == file.recs().size(), "number of recordings");
+		if (loaded.recs().size() == file.recs().size())
+		{
+			expect(loaded.recs()[2]->fid()->raw == rawRemoved, "the samples of the wave which was removed while saving");
+			expect(loaded.recs()[1]->ead()->shift() == nShift, "the shift as it was when the save started");
+		}
+	}
+
+	// Saving again picks up the edits
+	if (expect(file.saveAsync(sFilename), "start saving " + sFilename + " again"))
+	{
+		expect(file.waitForSave(), "save " + sFilename + " again");
+		expect(!file.isDirty(), "nothing left to save");
+		expect(counter.nFinished == 2 && counter.bOk, QString("saveFinished() emitted %0 times").arg(counter.nFinished));
+	}
+	EadFile reloaded;
+	if (expect(reloaded.load(sFilename) == LoadSaveResult_Ok, "load " + sFilename + " again"))
+	{
+		expect(reloaded.comment() == "edited while saving", "the comment which was edited while saving");
+		if (expect(reloaded.recs().size() == file.recs().size(), "number of recordings after saving again"))
+			expect(reloaded.recs()[1]->ead()->shift() == nShift + 7, "the shift which was edited while saving");
+	}
+
+	// A save which fails leaves the project dirty and is reported once
+	file.setComment("not saved");
+	const QString sMissing = m_dir.path() + "/missing/async.ead";
+	if (expect(file.saveAsync(sMissing), "start saving " + sMissing))
+	{
+		expect(!file.waitForSave(), "saving to a directory which doesn't exist fails");
+		QCoreApplication::processEvents();
+		expect(counter.nFinished == 3 && !counter.bOk, QString("saveFinished() emitted %0 times").arg(counter.nFinished));
+		expect(file.isDirty(), "the project is still dirty after a failed save");
+		expect(file.filename() == sFilename, "the filename stays after a failed save");
+	}
+}
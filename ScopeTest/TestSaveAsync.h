@@ -0,0 +1,53 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef __TESTSAVEASYNC_H
+#define __TESTSAVEASYNC_H
+
+#include <QObject>
+#include <QTemporaryDir>
+
+#include "TestBase.h"
+
+
+/// Counts the saveFinished() signals of an EadFile
+class SaveFinishedCounter : public QObject
+{
+	Q_OBJECT
+public:
+	int nFinished;
+	bool bOk;
+
+	SaveFinishedCounter() : nFinished(0), bOk(false) {}
+
+public slots:
+	void on_file_saveFinished(bool bOk) { nFinished++; this->bOk = bOk; }
+};
+
+
+/// Saves on the worker thread while the project is being edited, and checks that the file
+/// holds the project as it was when the save started
+class TestSaveAsync : public TestBase
+{
+public:
+	TestSaveAsync(int id);
+
+private:
+	QTemporaryDir m_dir;
+};
+
+#endif
@@ -0,0 +1,142 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestSignalMonitor.h"
+
+#include <math.h>
+
+#include <IdacDriver/IdacSignalMonitor.h>
+
+
+/// Sampling rate of the signals, as for the EAD and FID channels
+static const int MONITOR_SAMPLES_PER_SECOND = 100;
+
+
+/// A constant plus a sinusoid of the given amplitude at 10 Hz, 50 Hz and 60 Hz each
+static QVector<short> createSignal(int nSeconds, double nOffset, double nAmplitude10, double nAmplitude50, double nAmplitude60)
+{
+	QVector<short> signal(nSeconds * MONITOR_SAMPLES_PER_SECOND);
+	for (int i = 0; i < signal.size(); i++)
+	{
+		const double t = double(i) / MONITOR_SAMPLES_PER_SECOND;
+		const double n = nOffset
+			+ nAmplitude10 * cos(2 * M_PI * 10 * t)
+			+ nAmplitude50 * cos(2 * M_PI * 50 * t)
+			+ nAmplitude60 * cos(2 * M_PI * 60 * t);
+		signal[i] = short(floor(n + 0.5));
+	}
+	return signal;
+}
+
+/// Add the signal in blocks of varying size, as the sampling thread hands them on
+static void addSignal(IdacSignalMonitor& monitor, const QVector<short>& signal)
+{
+	int nBlock = 1;
+	for (int i = 0; i < signal.size(); i += nBlock)
+	{
+		nBlock = qMin(1 + (i * 7) % 37, signal.size() - i);
+		monitor.add(signal.constData() + i, nBlock);
+	}
+}
+
+
+TestSignalMonitor::TestSignalMonitor(int id) : TestBase(id, false)
+{
+	IdacSignalMonitor monitor(MONITOR_SAMPLES_PER_SECOND);
+	IdacSignalQuality q = monitor.quality();
+	expect(q.nSamples == 0 && q.nRms == 0 && q.mains() == 0, "no figures before the first sample");
+
+	// Until the window is full, there are no mains figures
+	addSignal(monitor, createSignal(1, 500, 0, 0, 200).mid(0, 50));
+	q = monitor.quality();
+	expect(q.nSamples == 50, QString("half a window: %0 samples").arg(q.nSamples));
+	expect(q.mains() == 0, "half a window: no mains figures");
+
+	// A constant signal has no noise, no mains and no drift
+	monitor.reset();
+	addSignal(monitor, createSignal(10, 500, 0, 0, 0));
+	q = monitor.quality();
+	expect(q.nSamples == MONITOR_SAMPLES_PER_SECOND, QString("constant: %0 samples").arg(q.nSamples));
+	expectNear(q.nMean, 500, 1e-9, "constant: mean");
+	expectNear(q.nRms, 0, 1e-9, "constant: RMS");
+	expectNear(q.nMains50, 0, 0.05, "constant: 50 Hz");
+	expectNear(q.nMains60, 0, 0.05, "constant: 60 Hz");
+	expectNear(q.nDriftPerMinute, 0, 1e-9, "constant: drift");
+	expect(q.nClipped == 0, "constant: not clipped");
+
+	// 60 Hz mains of amplitude 200 has an RMS of 200 / sqrt(2)
+	monitor.reset();
+	addSignal(monitor, createSignal(10, 500, 0, 0, 200));
+	q = monitor.quality();
+	expectNear(q.nMean, 500, 0.5, "60 Hz: mean");
+	expectNear(q.nRms, 200 / M_SQRT2, 0.5, "60 Hz: RMS");
+	expectNear(q.nMains60, 200 / M_SQRT2, 0.5, "60 Hz: 60 Hz");
+	expectNear(q.nMains50, 0, 0.5, "60 Hz: 50 Hz");
+	expect(q.mainsFrequency() == 60, "60 Hz: mains frequency");
+
+	// 50 Hz lies on the Nyquist frequency, where the samples alternate between +300 and -300, so the RMS is 300
+	monitor.reset();
+	addSignal(monitor, createSignal(10, 500, 0, 300, 0));
+	q = monitor.quality();
+	expectNear(q.nRms, 300, 0.5, "50 Hz: RMS");
+	expectNear(q.nMains50, 300, 0.5, "50 Hz: 50 Hz");
+	expectNear(q.nMains60, 0, 0.5, "50 Hz: 60 Hz");
+	expect(q.mainsFrequency() == 50, "50 Hz: mains frequency");
+
+	// Both mains frequencies and a 10 Hz signal, each of which only shows up in its own figure
+	monitor.reset();
+	addSignal(monitor, createSignal(10, -1000, 400, 100, 200));
+	q = monitor.quality();
+	expectNear(q.nMean, -1000, 0.5, "mixed: mean");
+	expectNear(q.nRms, sqrt(400 * 400 / 2.0 + 100 * 100 + 200 * 200 / 2.0), 0.5, "mixed: RMS");
+	expectNear(q.nMains50, 100, 0.5, "mixed: 50 Hz");
+	expectNear(q.nMains60, 200 / M_SQRT2, 0.5, "mixed: 60 Hz");
+
+	// The sliding DFT stays accurate over a long recording
+	monitor.reset();
+	addSignal(monitor, createSignal(3600, 500, 0, 0, 200));
+	q = monitor.quality();
+	expectNear(q.nMains60, 200 / M_SQRT2, 0.5, "an hour of 60 Hz: 60 Hz");
+	expectNear(q.nMains50, 0, 0.5, "an hour of 60 Hz: 50 Hz");
+
+	// The mean rising by one each second is a drift of 60 per minute
+	monitor.reset();
+	QVector<short> ramp(120 * MONITOR_SAMPLES_PER_SECOND);
+	for (int i = 0; i < ramp.size(); i++)
+		ramp[i] = short(100 + i / MONITOR_SAMPLES_PER_SECOND);
+	addSignal(monitor, ramp);
+	q = monitor.quality();
+	expectNear(q.nDriftPerMinute, 60, 1e-6, "ramp: drift");
+
+	// Clipped samples are counted while they are in the window
+	monitor.reset();
+	QVector<short> clipped = createSignal(3, 0, 0, 0, 0);
+	for (int i = 0; i < 10; i++)
+		clipped[120 + i] = (i % 2 == 0) ? 32767 : -32767;
+	addSignal(monitor, clipped.mid(0, 150));
+	expect(monitor.quality().nClipped == 10, QString("clipped: %0 samples instead of 10").arg(monitor.quality().nClipped));
+	addSignal(monitor, clipped.mid(150));
+	expect(monitor.quality().nClipped == 0, QString("clipped: %0 samples after the window has passed").arg(monitor.quality().nClipped));
+
+	monitor.reset();
+	expect(monitor.quality().nSamples == 0, "reset");
+}
+
+bool TestSignalMonitor::expectNear(double nActual, double nExpected, double nTolerance, const QString& sWhat)
+{
+	return expect(fabs(nActual - nExpected) <= nTolerance, sWhat + QString(" is %0 instead of %1").arg(nActual).arg(nExpected));
+}
@@ -0,0 +1,74 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "TestUndo.h"
+
+#include <EadFile.h>
+#include <RecInfo.h>
+#include <WaveInfo.h>
+
+
+TestUndo::TestUndo(int id) : TestBase(id, false)
+{
+	if (!expect(m_dir.isValid(), "create a temporary directory"))
+		return;
+
+	// Loading starts with an empty history, unlike createFakeData()
+	const QString sFilename = m_dir.path() + "/undo.ead";
+	EadFile sample;
+	sample.createFakeData();
+	expect(sample.saveAs(sFilename), "save " + sFilename);
+	EadFile file;
+	if (!expect(file.load(sFilename) == LoadSaveResult_Ok, "load " + sFilename))
+		return;
+	expect(!file.canUndo() && !file.canRedo(), "a loaded file has no history");
+
+	WaveInfo* wave = file.recs()[2]->fid();
+	WaveInfo* waveAve = file.recs()[0]->fid();
+	const QVector<short> raw = wave->raw;
+	const QVector<double> displayAve = waveAve->display;
+	const QString sComment = file.comment();
+	expect(!raw.isEmpty(), "the wave has samples");
+
+	// Delete the wave
+	file.remove(wave);
+	expect(wave->raw.isEmpty(), "removing a wave deletes its samples");
+	expect(waveAve->display != displayAve, "the averaged wave no longer includes the removed wave");
+	expect(file.canUndo() && !file.canRedo(), "the removal can be undone");
+
+	// Undo
+	file.undo();
+	expect(wave->raw == raw, "undo restores the samples");
+	expect(!wave->display.isEmpty(), "undo recalculates the display data");
+	expect(waveAve->display == displayAve, "undo recalculates the averaged wave");
+	expect(!file.canUndo() && file.canRedo(), "the removal can be redone");
+
+	// Redo
+	file.redo();
+	expect(wave->raw.isEmpty(), "redo deletes the samples again");
+	expect(file.canUndo() && !file.canRedo(), "the removal can be undone again");
+
+	// A new edit after an undo discards the step which could have been redone
+	file.undo();
+	file.setComment("new edit");
+	expect(!file.canRedo(), "a new edit discards the redo step");
+	expect(wave->raw == raw, "a new edit keeps the restored samples");
+	file.undo();
+	expect(file.comment() == sComment, "undo restores the comment");
+	expect(wave->raw == raw, "undoing the comment leaves the samples alone");
+	expect(!file.canUndo(), "nothing is left to undo");
+}
@@ -35,7 +35,17 @@
 #include <Scope/MainScopeUi.h>
 
 #include "TestBase.h"
+#include "TestCsv.h"
+#include "TestFormats.h"
+#include "TestLoading.h"
+#include "TestPeaks.h"
+#include "TestPreTrigger.h"
+#include "TestPreview.h"
 #include "TestRecording.h"
+#include "TestReplay.h"
+#include "TestSaveAsync.h"
+#include "TestSignalMonitor.h"
+#include "TestUndo.h"
 
 
 class TestActions : public TestBase
@@ -321,6 +331,16 @@ int main(int argc, char *argv[])
 
     TestActions(1);
     TestSaving(2);
+	TestReplay(4);
+	TestFormats(5);
+	TestCsv(6);
+	TestUndo(7);
+	TestPeaks(8);
+	TestPreTrigger(9);
+	TestSignalMonitor(10);
+	TestPreview(11);
+	TestSaveAsync(12);
+	TestLoading(13);
 
 	if (false) {
         TestRecording(3);
@@ -330,5 +350,10 @@ int main(int argc, char *argv[])
 
 	delete Globals;
 
+	if (TestBase::failures() > 0)
+	{
+		qDebug() << TestBase::failures() << "checks failed";
+		return 1;
+	}
 	return 0;
 }
@@ -0,0 +1,289 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#include "CatalogDialog.h"
+
+#include <QCheckBox>
+#include <QDateEdit>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QDirIterator>
+#include <QDoubleSpinBox>
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QFutureWatcher>
+#include <QGridLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QLineEdit>
+#include <QMessageBox>
+#include <QPixmap>
+#include <QProgressDialog>
+#include <QPushButton>
+#include <QSpinBox>
+#include <QTimer>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+#include <QtConcurrentMap>
+
+
+CatalogDialog::CatalogDialog(const QString& sCatalog, QWidget* parent)
+	: QDialog(parent), m_catalog(sCatalog)
+{
+	setWindowTitle(tr("Find in Catalog"));
+	setupWidgets();
+
+	m_searchTimer = new QTimer(this);
+	m_searchTimer->setSingleShot(true);
+	m_searchTimer->setInterval(250);
+	connect(m_searchTimer, SIGNAL(timeout()), this, SLOT(search()));
+
+	connect(m_edtComment, SIGNAL(textChanged(QString)), this, SLOT(on_conditionChanged()));
+	connect(m_edtWaveName, SIGNAL(textChanged(QString)), this, SLOT(on_conditionChanged()));
+	connect(m_chkDate, SIGNAL(toggled(bool)), this, SLOT(on_conditionChanged()));
+	connect(m_edtDateFrom, SIGNAL(dateChanged(QDate)), this, SLOT(on_conditionChanged()));
+	connect(m_edtDateTo, SIGNAL(dateChanged(QDate)), this, SLOT(on_conditionChanged()));
+	connect(m_spnMarkers, SIGNAL(valueChanged(int)), this, SLOT(on_conditionChanged()));
+	connect(m_chkPeakTime, SIGNAL(toggled(bool)), this, SLOT(on_conditionChanged()));
+	connect(m_spnPeakTimeFrom, SIGNAL(valueChanged(double)), this, SLOT(on_conditionChanged()));
+	connect(m_spnPeakTimeTo, SIGNAL(valueChanged(double)), this, SLOT(on_conditionChanged()));
+	connect(m_results, SIGNAL(itemDoubleClicked(QTreeWidgetItem*,int)), this, SLOT(on_results_itemDoubleClicked(QTreeWidgetItem*)));
+	connect(m_results, SIGNAL(itemSelectionChanged()), this, SLOT(on_results_itemSelectionChanged()));
+
+	if (!m_catalog.isOpen())
+		m_lblStatus->setText(tr("The catalog could not be opened: %1").arg(QDir::toNativeSeparators(sCatalog)));
+	else
+		search();
+}
+
+void CatalogDialog::setupWidgets()
+{
+	QVBoxLayout* vbox = new QVBoxLayout();
+	QGridLayout* grid = new QGridLayout();
+
+	int iRow = 0;
+	m_edtComment = new QLineEdit();
+	m_edtComment->setToolTip(tr("Words which the project comment must contain"));
+	grid->addWidget(new QLabel(tr("Comment:")), iRow, 0);
+	grid->addWidget(m_edtComment, iRow, 1, 1, 3);
+	iRow++;
+
+	m_edtWaveName = new QLineEdit();
+	m_edtWaveName->setToolTip(tr("Beginning of the name of any of the project's waves"));
+	grid->addWidget(new QLabel(tr("Wave name:")), iRow, 0);
+	grid->addWidget(m_edtWaveName, iRow, 1, 1, 3);
+	iRow++;
+
+	m_chkDate = new QCheckBox(tr("Recorded from:"));
+	m_edtDateFrom = new QDateEdit(QDate::currentDate().addMonths(-1));
+	m_edtDateFrom->setCalendarPopup(true);
+	m_edtDateTo = new QDateEdit(QDate::currentDate());
+	m_edtDateTo->setCalendarPopup(true);
+	grid->addWidget(m_chkDate, iRow, 0);
+	grid->addWidget(m_edtDateFrom, iRow, 1);
+	grid->addWidget(new QLabel(tr("to")), iRow, 2);
+	grid->addWidget(m_edtDateTo, iRow, 3);
+	iRow++;
+
+	m_chkPeakTime = new QCheckBox(tr("FID peak between:"));
+	m_spnPeakTimeFrom = new QDoubleSpinBox();
+	m_spnPeakTimeFrom->setRange(0, 1000);
+	m_spnPeakTimeFrom->setDecimals(2);
+	m_spnPeakTimeFrom->setSuffix(tr(" min"));
+	m_spnPeakTimeTo = new QDoubleSpinBox();
+	m_spnPeakTimeTo->setRange(0, 1000);
+	m_spnPeakTimeTo->setDecimals(2);
+	m_spnPeakTimeTo->setSuffix(tr(" min"));
+	m_spnPeakTimeTo->setValue(60);
+	grid->addWidget(m_chkPeakTime, iRow, 0);
+	grid->addWidget(m_spnPeakTimeFrom, iRow, 1);
+	grid->addWidget(new QLabel(tr("and")), iRow, 2);
+	grid->addWidget(m_spnPeakTimeTo, iRow, 3);
+	iRow++;
+
+	m_spnMarkers = new QSpinBox();
+	m_spnMarkers->setRange(0, 10000);
+	grid->addWidget(new QLabel(tr("At least:")), iRow, 0);
+	grid->addWidget(m_spnMarkers, iRow, 1);
+	grid->addWidget(new QLabel(tr("markers")), iRow, 2);
+	iRow++;
+
+	vbox->addLayout(grid);
+
+	m_results = new QTreeWidget();
+	m_results->setRootIsDecorated(false);
+	m_results->setIconSize(QSize(160, 64));
+	m_results->setHeaderLabels(QStringList() << tr("Preview") << tr("Recorded") << tr("File") << tr("Comment") << tr("Waves") << tr("Markers"));
+	m_results->setMinimumSize(800, 400);
+	vbox->addWidget(m_results, 1);
+
+	m_lblStatus = new QLabel();
+	vbox->addWidget(m_lblStatus);
+
+	QDialogButtonBox* buttons = new QDialogButtonBox(QDialogButtonBox::Open | QDialogButtonBox::Cancel);
+	QPushButton* btnAddFolder = buttons->addButton(tr("&Add Folder..."), QDialogButtonBox::ActionRole);
+	btnAddFolder->setToolTip(tr("Add the projects in a folder and its subfolders to the catalog"));
+	btnAddFolder->setEnabled(m_catalog.isOpen());
+	connect(btnAddFolder, SIGNAL(clicked()), this, SLOT(on_btnAddFolder_clicked()));
+	m_btnOpen = buttons->button(QDialogButtonBox::Open);
+	m_btnOpen->setEnabled(false);
+	connect(buttons, SIGNAL(accepted()), this, SLOT(accept()));
+	connect(buttons, SIGNAL(rejected()), this, SLOT(reject()));
+	vbox->addWidget(buttons);
+
+	setLayout(vbox);
+}
+
+QString CatalogDialog::selectedFilename() const
+{
+	QTreeWidgetItem* item = m_results->currentItem();
+	if (item == NULL || !item->isSelected())
+		return QString();
+	return item->data(0, Qt::UserRole).toString();
+}
+
+CatalogQuery CatalogDialog::query() const
+{
+	CatalogQuery query;
+	query.sComment = m_edtComment->text();
+	query.sWaveName = m_edtWaveName->text().trimmed();
+	if (m_chkDate->isChecked())
+	{
+		query.dateFrom = m_edtDateFrom->date();
+		query.dateTo = m_edtDateTo->date();
+	}
+	query.nMinMarkers = m_spnMarkers->value();
+	if (m_chkPeakTime->isChecked())
+	{
+		query.nPeakTimeFrom = m_spnPeakTimeFrom->value();
+		query.nPeakTimeTo = m_spnPeakTimeTo->value();
+	}
+	return query;
+}
+
+void CatalogDialog::on_conditionChanged()
+{
+	m_searchTimer->start();
+}
+
+void CatalogDialog::search()
+{
+	if (!m_catalog.isOpen())
+		return;
+
+	QElapsedTimer timer;
+	timer.start();
+
+	const CatalogQuery q = query();
+	QList<CatalogEntry> entries = m_catalog.find(q);
+
+	m_results->clear();
+	foreach (const CatalogEntry& entry, entries)
+	{
+		QTreeWidgetItem* item = new QTreeWidgetItem(m_results);
+		item->setData(0, Qt::UserRole, entry.sFilename);
+		// Only the previews of the results are read from the catalog
+		QPixmap pixmap;
+		if (pixmap.loadFromData(m_catalog.thumbnail(entry.sFilename), "PNG"))
+			item->setIcon(0, QIcon(pixmap));
+		item->setText(1, entry.timeOfRecording.toString(Qt::SystemLocaleShortDate));
+		item->setText(2, QDir::toNativeSeparators(entry.sFilename));
+		item->setToolTip(2, QDir::toNativeSeparators(entry.sFilename));
+		item->setText(3, entry.sComment.section('\n', 0, 0));
+		item->setToolTip(3, entry.sComment);
+		item->setText(4, entry.waveNames.join(", "));
+		item->setText(5, QString::number(entry.nMarkers));
+	}
+	m_results->resizeColumnToContents(0);
+	m_results->resizeColumnToContents(1);
+
+	QString sStatus = tr("%1 projects found in %2 ms").arg(entries.size()).arg(timer.elapsed());
+	if (entries.size() >= q.nMaxResults)
+		sStatus = tr("Only the first %1 projects are shown; please narrow down the search").arg(q.nMaxResults);
+	m_lblStatus->setText(sStatus);
+	on_results_itemSelectionChanged();
+}
+
+void CatalogDialog::on_results_itemDoubleClicked(QTreeWidgetItem* item)
+{
+	m_results->setCurrentItem(item);
+	accept();
+}
+
+void CatalogDialog::on_results_itemSelectionChanged()
+{
+	m_btnOpen->setEnabled(!selectedFilename().isEmpty());
+}
+
+void CatalogDialog::on_btnAddFolder_clicked()
+{
+	QString sDir = QFileDialog::getExistingDirectory(this, tr("Add Projects to Catalog"));
+	if (sDir.isEmpty())
+		return;
+
+	// Only the files which changed since they were last added need to be loaded
+	QStringList files;
+	QDirIterator it(sDir, QStringList() << "*.ead" << "*.EAD", QDir::Files, QDirIterator::Subdirectories);
+	while (it.hasNext())
+	{
+		QFileInfo fi(it.next());
+		if (!m_catalog.isCurrent(fi))
+			files << fi.absoluteFilePath();
+	}
+	if (files.isEmpty())
+	{
+		m_catalog.removeMissing();
+		search();
+		return;
+	}
+
+	// The files are loaded and summarized in parallel, then added to the catalog all at once
+	QProgressDialog progress(tr("Adding projects to the catalog..."), tr("Cancel"), 0, files.size(), this);
+	progress.setWindowModality(Qt::WindowModal);
+	QFutureWatcher<CatalogEntry> watcher;
+	QEventLoop loop;
+	connect(&watcher, SIGNAL(progressValueChanged(int)), &progress, SLOT(setValue(int)));
+	connect(&progress, SIGNAL(canceled()), &watcher, SLOT(cancel()));
+	connect(&watcher, SIGNAL(finished()), &loop, SLOT(quit()));
+	watcher.setFuture(QtConcurrent::mapped(files, Catalog::describeFile));
+	progress.show();
+	loop.exec();
+	watcher.waitForFinished();
+	progress.reset();
+
+	QList<CatalogEntry> entries;
+	int nFailed = 0;
+	for (int i = 0; i < files.size(); i++)
+	{
+		if (!watcher.future().isResultReadyAt(i))
+			continue;
+		CatalogEntry entry = watcher.future().resultAt(i);
+		if (entry.sFilename.isEmpty())
+			nFailed++;
+		else
+			entries << entry;
+	}
+	m_catalog.update(entries);
+	m_catalog.removeMissing();
+
+	if (nFailed > 0)
+		QMessageBox::warning(this, tr("Add Projects to Catalog"), tr("%1 project files could not be read.").arg(nFailed));
+	search();
+}
@@ -0,0 +1,78 @@
+/**
+ * Copyright (C) 2026  Ellis Whitehead
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+
+#ifndef __CATALOGDIALOG_H
+#define __CATALOGDIALOG_H
+
+#include <QDialog>
+
+#include <Catalog.h>
+
+
+class QCheckBox;
+class QDateEdit;
+class QDoubleSpinBox;
+class QLabel;
+class QLineEdit;
+class QPushButton;
+class QSpinBox;
+class QTimer;
+class QTreeWidget;
+class QTreeWidgetItem;
+
+
+/// Search the catalog of project files, with thumbnail previews, and choose one to open
+class CatalogDialog : public QDialog
+{
+	Q_OBJECT
+public:
+	CatalogDialog(const QString& sCatalog, QWidget* parent = 0);
+
+	/// File which the user chose to open
+	QString selectedFilename() const;
+
+private:
+	void setupWidgets();
+	CatalogQuery query() const;
+
+private slots:
+	/// Search again once the user has stopped typing for a moment
+	void on_conditionChanged();
+	void search();
+	void on_results_itemDoubleClicked(QTreeWidgetItem* item);
+	void on_results_itemSelectionChanged();
+	void on_btnAddFolder_clicked();
+
+private:
+	Catalog m_catalog;
+	QLineEdit* m_edtComment;
+	QLineEdit* m_edtWaveName;
+	QCheckBox* m_chkDate;
+	QDateEdit* m_edtDateFrom;
+	QDateEdit* m_edtDateTo;
+	QSpinBox* m_spnMarkers;
+	QCheckBox* m_chkPeakTime;
+	QDoubleSpinBox* m_spnPeakTimeFrom;
+	QDoubleSpinBox* m_spnPeakTimeTo;
+	QTreeWidget* m_results;
+	QLabel* m_lblStatus;
+	QPushButton* m_btnOpen;
+	QTimer* m_searchTimer;
+};
+
+#endif
@@ -76,6 +76,7 @@ ChartWidget::ChartWidget(MainScope* mainS, QWidget* parent)
 	connect(m_chartS, SIGNAL(recordingLabelVisibleChanged(bool)), this, SLOT(on_scope_recordingLabelVisibleChanged(bool)));
 	connect(m_chartS, SIGNAL(recordingLabelTextChanged(QString)), this, SLOT(on_scope_recordingLabelTextChanged(QString)));
 	connect(m_chartS, SIGNAL(timebaseChanged(QString)), this, SLOT(on_scope_timebaseChanged(QString)));
+	connect(m_chartS, SIGNAL(scrollMinChanged(int)), this, SLOT(on_scope_scrollMinChanged(int)));
 	connect(m_chartS, SIGNAL(scrollMaxChanged(int)), this, SLOT(on_scope_scrollMaxChanged(int)));
 	connect(m_chartS, SIGNAL(scrollPageStepChanged(int)), this, SLOT(on_scope_scrollPageStepChanged(int)));
 	connect(m_chartS, SIGNAL(scrollSingleStepChanged(int)), this, SLOT(on_scope_scrollSingleStepChanged(int)));
@@ -174,6 +175,7 @@ void ChartWidget::on_scope_timebaseChanged(const QString& s)
 	m_bForceStatusUpdate = true;
 }
 
+void ChartWidget::on_scope_scrollMinChanged(int i) { m_scrollbar->setMinimum(i); }
 void ChartWidget::on_scope_scrollMaxChanged(int i) { m_scrollbar->setMaximum(i); }
 void ChartWidget::on_scope_scrollPageStepChanged(int n) { m_scrollbar->setPageStep(n); }
 void ChartWidget::on_scope_scrollSingleStepChanged(int n) { m_scrollbar->setSingleStep(n); }
@@ -79,6 +79,7 @@ private:
 private slots:
 	//void on_timerUpdate_timeout();
 	void on_scope_timebaseChanged(const QString& s);
+	void on_scope_scrollMinChanged(int i);
 	void on_scope_scrollMaxChanged(int i);
 	void on_scope_scrollPageStepChanged(int n);
 	void on_scope_scrollSingleStepChanged(int n);
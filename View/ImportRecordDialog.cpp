@@ -7,9 +7,10 @@
 #include <QRadioButton>
 #include <QVBoxLayout>
 
-ImportRecordDialog::ImportRecordDialog(const QStringList& asNames, QWidget *parent) :
+ImportRecordDialog::ImportRecordDialog(const QStringList& asNames, QWidget *parent, const QStringList& asPreviews) :
 	QDialog(parent),
-	m_asNames(asNames)
+	m_asNames(asNames),
+	m_asPreviews(asPreviews)
 {
 	setupWidgets();
 }
@@ -28,6 +29,8 @@ void ImportRecordDialog::setupWidgets()
 	grid->addWidget(new QLabel("FID"), iRow, 2);
 	//grid->addWidget(new QLabel("Digital"), iRow, 3);
 	grid->addWidget(new QLabel("Skip"), iRow, 4);
+	if (!m_asPreviews.isEmpty())
+		grid->addWidget(new QLabel("Preview"), iRow, 5);
 	iRow++;
 
 	for (int i = 0; i < m_asNames.size(); i++) {
@@ -63,6 +66,12 @@ void ImportRecordDialog::setupWidgets()
 		m_skps << rdo;
 		connect(rdo, SIGNAL(toggled(bool)), this, SLOT(on_skp()));
 
+		if (i < m_asPreviews.size()) {
+			lbl = new QLabel(m_asPreviews[i]);
+			lbl->setEnabled(false);
+			grid->addWidget(lbl, iRow, 5);
+		}
+
 		iRow++;
 	}
 
@@ -15,7 +15,8 @@ class ImportRecordDialog : public QDialog
 {
     Q_OBJECT
 public:
-	ImportRecordDialog(const QStringList& asNames, QWidget *parent = 0);
+	/// @param asPreviews optional sample values to show next to each signal name
+	ImportRecordDialog(const QStringList& asNames, QWidget *parent = 0, const QStringList& asPreviews = QStringList());
 
 	const QMap<QString, WaveType>& map() const { return m_map; }
 
@@ -37,6 +38,7 @@ private:
 	QList<QRadioButton*> m_skps;
 
 	const QStringList m_asNames;
+	const QStringList m_asPreviews;
 	QMap<QString, WaveType> m_map;
 };
 
@@ -23,7 +23,9 @@
 #include <QCheckBox>
 #include <QCloseEvent>
 #include <QComboBox>
+#include <QDir>
 #include <QFileDialog>
+#include <QInputDialog>
 #include <QLabel>
 #include <QMessageBox>
 #include <QQuickView>
@@ -52,6 +54,7 @@
 #include "TaskPanel.h"
 #include "TaskPublishWidget.h"
 #include "TaskReviewWidget.h"
+#include "TextImporter.h"
 #include "ViewTabs.h"
 
 
@@ -193,9 +196,13 @@ void MainWindow::setupActions()
 	foreach (QAction* act, m_scope->actions()->fileOpenRecentActions)
 		m_recentFilesMenu->addAction(act);
 	m_recentFilesMenu->setEnabled(false);
+	ui.mnuFile->addAction(actions->fileFindInCatalog);
 	ui.mnuFile->addSeparator();
 	ui.mnuFile->addAction(actions->fileSave);
 	ui.mnuFile->addAction(actions->fileSaveAs);
+	ui.mnuFile->addAction(actions->fileCompact);
+	ui.mnuFile->addAction(actions->fileSampleStore);
+	ui.mnuFile->addAction(actions->fileCollectSampleStore);
 	ui.mnuFile->addSeparator();
 	ui.mnuFile->addAction(actions->fileComment);
 	ui.mnuFile->addSeparator();
@@ -207,6 +214,9 @@ void MainWindow::setupActions()
 	ui.mnuFile->addSeparator();
 	ui.mnuFile->addAction(actions->fileExit);
 
+	ui.mnuEdit->addAction(actions->editUndo);
+	ui.mnuEdit->addAction(actions->editRedo);
+
 	ui.mnuView->addAction(actions->viewViewMode);
 	ui.mnuView->addAction(actions->viewMarkersMode);
 	ui.mnuView->addAction(actions->viewPublishMode);
@@ -357,7 +367,7 @@ void MainWindow::actions_fileImport_triggered()
 		QObject::tr("Import Wave from Another Project"),
 		sLastDir,
 		//QObject::tr("GC-EAD and ASC files (*.ead *.asc)"));
-		QObject::tr("GC-EAD files (*.ead)"));
+		QObject::tr("GC-EAD and text files (*.ead *.csv *.tsv *.txt);;GC-EAD files (*.ead);;Text files (*.csv *.tsv *.txt)"));
 
 	if (sFilename.isEmpty())
 		return;
@@ -369,6 +379,9 @@ void MainWindow::actions_fileImport_triggered()
 	else if (fi.suffix().toLower() == "asc") {
 		importAsc(sFilename);
 	}
+	else if (QStringList(QStringList() << "csv" << "tsv" << "txt").contains(fi.suffix().toLower())) {
+		importText(sFilename);
+	}
 	else {
 		QMessageBox::warning(this, tr("Unknown file extension"), tr("The file you selected has an unrecognized extension."));
 	}
@@ -558,22 +571,100 @@ LoadSaveResult MainWindow::importAsc(const QString &sFilename)
 	return LoadSaveResult_Ok;
 }
 
+LoadSaveResult MainWindow::importText(const QString& sFilename)
+{
+	// Only the first chunk of the file is read until the user has chosen the columns
+	TextImporter importer;
+	if (!importer.open(sFilename)) {
+		QMessageBox::critical(this, tr("Error loading file"), tr("Unable to open the file."));
+		return LoadSaveResult_CouldNotOpen;
+	}
+
+	// Offer all columns except for the time, along with their first few values
+	QStringList asNames;
+	QStringList asPreviews;
+	QList<int> columns;
+	for (int i = 0; i < importer.columnNames().size(); i++) {
+		if (i == importer.timeColumn())
+			continue;
+		QStringList asValues;
+		foreach (const QVector<double>& row, importer.previewRows()) {
+			if (asValues.size() == 4)
+				break;
+			asValues << QString::number(row[i]);
+		}
+		asNames << importer.columnNames()[i];
+		asPreviews << asValues.join("   ");
+		columns << i;
+	}
+
+	// Show dialog asking for catagories
+	ImportRecordDialog dlg(asNames, this, asPreviews);
+	if (dlg.exec() != QDialog::Accepted)
+		return LoadSaveResult_Ok;
+
+	QMap<QString, WaveType> map = dlg.map();
+	if (map.size() == 0)
+		return LoadSaveResult_Ok;
+
+	double nSampleRate = importer.sampleRate();
+	if (nSampleRate <= 0) {
+		bool bOk;
+		nSampleRate = QInputDialog::getDouble(this, tr("Sample Rate"), tr("The file has no time column.  Please enter its sample rate (Hz):"), EAD_SAMPLES_PER_SECOND, 0.01, 100000, 2, &bOk);
+		if (!bOk)
+			return LoadSaveResult_Ok;
+	}
+
+	RecInfo* rec = new RecInfo(m_scope->file(), m_scope->file()->recs().size());
+	QMap<int, WaveInfo*> waves;
+	for (int i = 0; i < asNames.size(); i++) {
+		if (map.contains(asNames[i]))
+			waves.insert(columns[i], rec->wave(map[asNames[i]]));
+	}
+
+	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
+	bool bRead = importer.read(waves, nSampleRate);
+	QApplication::restoreOverrideCursor();
+	if (!bRead) {
+		delete rec;
+		QMessageBox::critical(this, tr("Error loading file"), tr("The file doesn't contain any data."));
+		return LoadSaveResult_DataCorrupt;
+	}
+
+	m_scope->file()->addImportedRecording(rec);
+
+	return LoadSaveResult_Ok;
+}
+
 void MainWindow::actions_fileExportSignalData_triggered()
 {
 	CHECK_PRECOND_RET(m_scope->file() != NULL);
 
+	const QString sFilterCsv = tr("Comma Separated Values (*.csv)");
+	const QString sFilterNpy = tr("NumPy Array (*.npy)");
+	const QString sFilterNpz = tr("NumPy Archive (*.npz)");
+	QString sFilter = sFilterCsv;
 	QString sFilename = QFileDialog::getSaveFileName(
 		this,
 		tr("Export Data"),
 		Globals->lastDir(),
-		tr("Comma Separated Values (*.csv)"));
+		sFilterCsv + ";;" + sFilterNpy + ";;" + sFilterNpz,
+		&sFilter);
 
 	if (sFilename.isEmpty())
 		return;
 
 	QFileInfo fi(sFilename);
 	if (fi.suffix().isEmpty())
-		sFilename += ".csv";
+	{
+		if (sFilter == sFilterNpy)
+			sFilename += ".npy";
+		else if (sFilter == sFilterNpz)
+			sFilename += ".npz";
+		else
+			sFilename += ".csv";
+	}
+	QString sSuffix = QFileInfo(sFilename).suffix().toLower();
 
 	QMessageBox msg(QMessageBox::Information, tr("Exporting..."), tr("The project data is currently being exported."));
 	msg.setStandardButtons(QMessageBox::NoButton);
@@ -582,8 +673,19 @@ void MainWindow::actions_fileExportSignalData_triggered()
 	QApplication::processEvents();
 
 	QApplication::setOverrideCursor(QCursor(Qt::WaitCursor));
-	m_scope->file()->exportData(sFilename /*, EadFile::CSV*/);
+	QString sError;
+	bool bOk;
+	if (sSuffix == "npy" || sSuffix == "npz")
+		bOk = m_scope->file()->exportNumpy(sFilename, &sError);
+	else
+		bOk = m_scope->file()->exportData(sFilename /*, EadFile::CSV*/, &sError);
 	QApplication::restoreOverrideCursor();
+
+	if (!bOk)
+	{
+		msg.hide();
+		QMessageBox::warning(this, tr("Export Failed"), tr("Unable to export the data to %0:\n%1").arg(QDir::toNativeSeparators(sFilename)).arg(sError));
+	}
 }
 
 // REFACTOR: almost completely duplicates the above function
@@ -68,6 +68,7 @@ private:
 
     LoadSaveResult importEad(const QString& sFilename);
     LoadSaveResult importAsc(const QString& sFilename);
+    LoadSaveResult importText(const QString& sFilename);
 
 private slots:
 	void idac_statusErrorChanged(QString sError);
@@ -27,6 +27,7 @@
 #include <QVBoxLayout>
 
 #include "AppDefines.h"
+#include "CatalogDialog.h"
 #include "RecordDialog.h"
 #include "RecordSettingsDialog.h"
 #include "WaitForHardwareDialog.h"
@@ -67,6 +68,22 @@ QString MainWindowUi::getFileImportFilename(const QString& sLastDir)
 	return sFilename;
 }
 
+QString MainWindowUi::findInCatalog(const QString& sCatalog)
+{
+	CatalogDialog dlg(sCatalog, m_widget);
+	if (dlg.exec() != QDialog::Accepted)
+		return QString();
+	return dlg.selectedFilename();
+}
+
+QString MainWindowUi::getSampleStoreDirectory(const QString& sLastDir)
+{
+	return QFileDialog::getExistingDirectory(
+		m_widget,
+		QObject::tr("Choose Shared Sample Store"),
+		sLastDir);
+}
+
 QString MainWindowUi::getComment(const QString& sComment)
 {
 	QDialog dlg(m_widget);
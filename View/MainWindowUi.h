@@ -37,6 +37,8 @@ public:
 	QString getFileOpenFilename(const QString& sLastDir);
 	QString getFileSaveAsFilename(const QString& sCurrentFilename);
 	QString getFileImportFilename(const QString& sLastDir);
+	QString findInCatalog(const QString& sCatalog);
+	QString getSampleStoreDirectory(const QString& sLastDir);
 	QString getComment(const QString& sComment);
 	QMessageBox::StandardButton warnAboutUnsavedChanged();
 	QMessageBox::StandardButton question(const QString& title, const QString& text, QMessageBox::StandardButtons buttons, QMessageBox::StandardButton defaultButton);
@@ -17,6 +17,8 @@
 
 #include "RecordDialog.h"
 
+#include <math.h>
+
 #include <QComboBox>
 #include <QFile>
 #include <QHBoxLayout>
@@ -61,6 +63,8 @@ RecordDialog::RecordDialog(IdacProxy* idac, QWidget* parent)
 	m_handler = new RecordHandler(m_idac);
 
 	m_bDataReceived = false;
+	m_nPreviewSamplesPerPixel = 0;
+	m_nPreviewPixels = 0;
 	m_bOptionsDialogOpen = false;
 
 	loadSettings();
@@ -108,6 +112,31 @@ void RecordDialog::updateSens()
 	ui.lblSens->setText(tr("%0 mV").arg(m_nVoltsPerDivision));
 }
 
+void RecordDialog::updatePreviewTimebase()
+{
+	int nSamples = ui.spnWindow->value() * EAD_SAMPLES_PER_SECOND;
+	int nWidth = qMax(ui.eadSignal->width(), 1);
+	// One value per pixel, unless there are fewer samples than pixels
+	double nSamplesPerPixel = qMax(1.0, double(nSamples) / nWidth);
+	int nPixels = qMax(int(ceil(nSamples / nSamplesPerPixel)), 1);
+
+	// Requesting a new timebase discards the summaries collected so far
+	if (nSamplesPerPixel == m_nPreviewSamplesPerPixel && nPixels == m_nPreviewPixels)
+		return;
+	m_nPreviewSamplesPerPixel = nSamplesPerPixel;
+	m_nPreviewPixels = nPixels;
+
+	ui.eadSignal->setSampleCount(nPixels);
+	ui.fidSignal->setSampleCount(nPixels);
+	m_handler->setPreviewTimebase(nSamplesPerPixel, nPixels, 0);
+}
+
+void RecordDialog::resizeEvent(QResizeEvent* e)
+{
+	QDialog::resizeEvent(e);
+	updatePreviewTimebase();
+}
+
 void RecordDialog::done(int r)
 {
 	QDialog::done(r);
@@ -138,6 +167,7 @@ void RecordDialog::updateStatus()
 		ui.btnConnect->setEnabled(true);
 		ui.btnRecord->setEnabled(false);
 		m_handler->updateRawToVoltageFactors();
+		m_handler->updateFilters();
 		break;
 	
 	case IdacState_Sampling:
@@ -157,6 +187,9 @@ void RecordDialog::updateStatus()
 			// We need to call m_handler->updateRawToVoltageFactors() 
 			// before m_handle->convert() gets called in this->getData()
 			settingsChanged();
+			// The driver may not have existed when the timebase was first requested
+			m_nPreviewPixels = 0;
+			updatePreviewTimebase();
 		}
 		break;
 	}
@@ -175,11 +208,14 @@ void RecordDialog::updateStatus()
 void RecordDialog::settingsChanged()
 {
 	m_handler->updateRawToVoltageFactors();
+	m_handler->updateFilters();
+	m_handler->resetSignalQuality();
 }
 
 void RecordDialog::getData()
 {
-	if (!m_handler->check() || !m_handler->convert())
+	// Only the digital samples are needed here; the graphs are drawn from the sampling thread's summaries
+	if (!m_handler->check() || !m_handler->convert(false))
 		return;
 
 	if (!m_bDataReceived)
@@ -208,13 +244,43 @@ void RecordDialog::getData()
 	}
 
 	// Display EAD and FID data
-	ui.eadSignal->addSamples(m_handler->eadDisplay());
-	ui.fidSignal->addSamples(m_handler->fidDisplay());
+	if (m_handler->updatePreview())
+	{
+		const RenderPreview& ead = m_handler->preview(1);
+		const RenderPreview& fid = m_handler->preview(2);
+		ui.eadSignal->setMinMax(ead.pixels, ead.iPixelFirst);
+		ui.fidSignal->setMinMax(fid.pixels, fid.iPixelFirst);
+	}
+
+	updateSignalQuality();
 
 	if (iRecording >= 0 || QFile::exists(QCoreApplication::applicationDirPath() + "/flag.TestRecording"))
 		accept();
 }
 
+void RecordDialog::updateSignalQuality()
+{
+	ui.lblEadQuality->setText(signalQualityText(1));
+	ui.lblFidQuality->setText(signalQualityText(2));
+}
+
+QString RecordDialog::signalQualityText(int iChan) const
+{
+	IdacSignalQuality q = m_handler->signalQuality(iChan);
+	if (q.nSamples == 0)
+		return QString();
+
+	const double nFactor = m_handler->rawToVoltageFactor(iChan);
+	QString s = tr("Noise: %0 mV RMS    Drift: %1 mV/min    Mains (%2 Hz): %3 mV RMS")
+		.arg(q.nRms * nFactor, 0, 'g', 3)
+		.arg(q.nDriftPerMinute * nFactor, 0, 'g', 3)
+		.arg(q.mainsFrequency())
+		.arg(q.mains() * nFactor, 0, 'g', 3);
+	if (q.nClipped > 0)
+		s += "    <span style=\"color:#cc0000; font-weight:600;\">" + tr("CLIPPING") + "</span>";
+	return s;
+}
+
 void RecordDialog::on_btnSensDec_clicked()
 {
     m_nVoltsPerDivision = changeVoltsPerDivision(m_nVoltsPerDivision, 1);
@@ -232,9 +298,8 @@ void RecordDialog::on_btnSensInc_clicked()
 void RecordDialog::on_spnWindow_valueChanged(int)
 {
 	int nSamples = ui.spnWindow->value() * EAD_SAMPLES_PER_SECOND;
-	ui.eadSignal->setSampleCount(nSamples);
-	ui.fidSignal->setSampleCount(nSamples);
 	ui.digitalSignals->setSampleCount(nSamples);
+	updatePreviewTimebase();
 }
 
 void RecordDialog::on_btnRecord_clicked()
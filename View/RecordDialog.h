@@ -19,6 +19,7 @@
 #define RECORDDIALOG_H
 
 #include <QDialog>
+#include <QString>
 #include "ui_RecordDialog.h"
 
 class IdacProxy;
@@ -38,11 +39,19 @@ public:
 public:
 	void done(int r);
 
+protected:
+	void resizeEvent(QResizeEvent* e);
+
 private:
 	void setupWidgets();
 	void loadSettings();
 	void saveSettings();
 	void updateSens();
+	/// Request one min/max value per pixel of the signal graphs from the sampling thread
+	void updatePreviewTimebase();
+	/// Show the signal quality of the analog channels
+	void updateSignalQuality();
+	QString signalQualityText(int iChan) const;
 
 private slots:
 	void updateStatus();
@@ -67,6 +76,9 @@ private:
 	RecordHandler* m_handler;
 
 	bool m_bDataReceived;
+	/// Timebase which was last requested for the signal graphs
+	double m_nPreviewSamplesPerPixel;
+	int m_nPreviewPixels;
 	/// True when RecordSettingsDialog is open, in order to prevent triggers from initiating recording
 	bool m_bOptionsDialogOpen;
 };
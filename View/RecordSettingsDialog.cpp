@@ -55,6 +55,8 @@ RecordSettingsDialog::RecordSettingsDialog(IdacProxy* idac, bool bSendChanges, Q
 	if (settings->nRecordingDuration <= 0)
 		settings->nRecordingDuration = 30;
 	ui.edtRecordingDuration->setValue(settings->nRecordingDuration);
+	ui.chkContinuous->setChecked(settings->bContinuous);
+	updateRecordingDurationLabel();
 
 	ui.edtGcDelay->setValue(settings->nGcDelay_ms);
 
@@ -85,6 +87,7 @@ RecordSettingsDialog::RecordSettingsDialog(IdacProxy* idac, bool bSendChanges, Q
 	ui.cmbRange_1->setCurrentIndex(chan->iRange);
 	ui.edtOffset_1->setValue(convOffsetSamplesToMicrovolts(chan->nOffset));
 	ui.edtExternalAmplification_1->setValue(chan->nExternalAmplification);
+	ui.edtLiveLowpass_1->setValue(settings->anLiveLowpass_Hz[1]);
 	// Hide this label, but make sure it has the appropriate width
 	ui.lblDelay_1->setMinimumWidth(ui.lblDelay_1->sizeHint().width());
 	ui.lblDelay_1->setText("");
@@ -105,9 +108,12 @@ RecordSettingsDialog::RecordSettingsDialog(IdacProxy* idac, bool bSendChanges, Q
     ui.cmbRange_2->setValidator(NULL);
 	ui.edtOffset_2->setValue(convOffsetSamplesToMicrovolts(chan->nOffset));
 	ui.edtExternalAmplification_2->setValue(chan->nExternalAmplification);
+	ui.edtLiveLowpass_2->setValue(settings->anLiveLowpass_Hz[2]);
 	
 	chan = &settings->channels[0];
 	ui.chkRecordOnTrigger->setChecked(settings->bRecordOnTrigger);
+	ui.edtPreTrigger->setValue(settings->nPreTrigger_s);
+	ui.edtPreTrigger->setEnabled(settings->bRecordOnTrigger);
 	ui.chkInvert_3->setChecked(chan->mInvert & 0x01);
 
 	ui.chkEnabled_4->setChecked(chan->mEnabled & 0x02);
@@ -160,16 +166,28 @@ void RecordSettingsDialog::on_edtRecordingDuration_editingFinished()
 	settings->nRecordingDuration = ui.edtRecordingDuration->value();
 }
 
+void RecordSettingsDialog::on_chkContinuous_clicked()
+{
+	IdacSettings* settings = Globals->idacSettings();
+	settings->bContinuous = ui.chkContinuous->isChecked();
+	updateRecordingDurationLabel();
+}
+
+void RecordSettingsDialog::updateRecordingDurationLabel()
+{
+	if (ui.chkContinuous->isChecked())
+		ui.lblRecordingDuration->setText(tr("Minutes to keep in memory:"));
+	else
+		ui.lblRecordingDuration->setText(tr("Maximum recording duration (minutes):"));
+}
+
 void RecordSettingsDialog::on_cmbGeneralRange_activated(int i)
 {
 	IdacSettings* settings = Globals->idacSettings();
 	settings->channels[1].iRange = i;
 	settings->channels[2].iRange = i;
 	if (m_idac != NULL)
-	{
-		m_idac->stopSampling();
-		m_idac->startSampling(settings->channels);
-	}
+		m_idac->setChannelSettings(settings->channels);
 	emit settingsChanged();
 }
 
@@ -211,10 +229,7 @@ void RecordSettingsDialog::on_cmbRange_activated(int iChan, int i)
 	IdacChannelSettings* chan = &settings->channels[iChan];
 	chan->iRange = i;
 	if (m_idac != NULL)
-	{
-		m_idac->stopSampling();
-		m_idac->startSampling(settings->channels);
-	}
+		m_idac->setChannelSettings(settings->channels);
 	emit settingsChanged();
 }
 
@@ -254,6 +269,14 @@ void RecordSettingsDialog::on_edtExternalAmplification_editingFinished(int iChan
 	emit settingsChanged();
 }
 
+void RecordSettingsDialog::on_edtLiveLowpass_valueChanged(int iChan, double n)
+{
+	IdacSettings* settings = Globals->idacSettings();
+	// 0 turns the filter off (see RecordHandler::updateFilters())
+	settings->anLiveLowpass_Hz[iChan] = n;
+	emit settingsChanged();
+}
+
 //
 // EAD
 //
@@ -288,6 +311,11 @@ void RecordSettingsDialog::on_edtExternalAmplification_1_editingFinished()
 	on_edtExternalAmplification_editingFinished(1, ui.edtExternalAmplification_1->value());
 }
 
+void RecordSettingsDialog::on_edtLiveLowpass_1_valueChanged(double n)
+{
+	on_edtLiveLowpass_valueChanged(1, n);
+}
+
 //
 // FID
 //
@@ -322,6 +350,11 @@ void RecordSettingsDialog::on_edtExternalAmplification_2_editingFinished()
 	on_edtExternalAmplification_editingFinished(2, ui.edtExternalAmplification_2->value());
 }
 
+void RecordSettingsDialog::on_edtLiveLowpass_2_valueChanged(double n)
+{
+	on_edtLiveLowpass_valueChanged(2, n);
+}
+
 void RecordSettingsDialog::on_edtGcDelay_valueChanged(int n)
 {
 	IdacSettings* settings = Globals->idacSettings();
@@ -336,6 +369,13 @@ void RecordSettingsDialog::on_chkRecordOnTrigger_clicked()
 {
 	IdacSettings* settings = Globals->idacSettings();
 	settings->bRecordOnTrigger = ui.chkRecordOnTrigger->isChecked();
+	ui.edtPreTrigger->setEnabled(settings->bRecordOnTrigger);
+}
+
+void RecordSettingsDialog::on_edtPreTrigger_valueChanged(int n)
+{
+	IdacSettings* settings = Globals->idacSettings();
+	settings->nPreTrigger_s = n;
 }
 
 void RecordSettingsDialog::on_chkInvert_3_clicked()
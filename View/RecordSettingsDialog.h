@@ -42,6 +42,7 @@ private:
 	int convOffsetSamplesToMicrovolts(int nSamples) const;
 	int convOffsetMicrovoltsToSamples(int nMicrovolts) const;
 	int convOffsetSamplesToSlider(int nSamples) const;
+	void updateRecordingDurationLabel();
 
 private:
 	void on_cmbLowcut_activated(int iChan, int i);
@@ -51,11 +52,13 @@ private:
 	int on_edtOffset_valueChanged(int iChan, int n);
 	int on_sliderOffset_sliderMoved(int n);
 	void on_edtExternalAmplification_editingFinished(int iChan, int n);
+	void on_edtLiveLowpass_valueChanged(int iChan, double n);
 
 private slots:
 	// Recording duration
 	//void on_chkRecordingDuration_clicked();
 	void on_edtRecordingDuration_editingFinished();
+	void on_chkContinuous_clicked();
 	void on_cmbGeneralRange_activated(int n);
 
 	// EAD
@@ -65,6 +68,7 @@ private slots:
 	void on_cmbRange_1_activated(int i);
 	void on_edtOffset_1_valueChanged(int n);
 	void on_edtExternalAmplification_1_editingFinished();
+	void on_edtLiveLowpass_1_valueChanged(double n);
 
 	// FID
 	void on_cmbLowcut_2_activated(int i);
@@ -73,10 +77,12 @@ private slots:
 	void on_cmbRange_2_activated(int i);
 	void on_edtOffset_2_valueChanged(int n);
 	void on_edtExternalAmplification_2_editingFinished();
+	void on_edtLiveLowpass_2_valueChanged(double n);
 	void on_edtGcDelay_valueChanged(int n);
 
 	// Trigger
 	void on_chkRecordOnTrigger_clicked();
+	void on_edtPreTrigger_valueChanged(int n);
 	void on_chkInvert_3_clicked();
 
 	// Digital Signal
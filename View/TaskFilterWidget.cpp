@@ -75,12 +75,24 @@ void TaskFilterWidget::on_scope_fileChanged()
 		else if (filter->waveType() == WaveType_FID)
 			m_filterFid = filter;
 	}
+	// Undo and redo can change the filter settings
+	connect(m_scope->file(), SIGNAL(filterModeChanged()), this, SLOT(on_file_filterModeChanged()));
+}
+
+void TaskFilterWidget::on_file_filterModeChanged()
+{
+	m_cmbEad->setCurrentIndex(m_filterEad->filterId());
+	m_cmbFid->setCurrentIndex(m_filterFid->filterId());
+	updateEditWidget(m_filterEad, m_edtEadProperties);
+	updateEditWidget(m_filterFid, m_edtFidProperties);
 }
 
 void TaskFilterWidget::on_cmbEad_currentIndexChanged()
 {
 	int id = m_cmbEad->currentIndex();
 	m_filterEad->setFilterId(id);
+	// Choosing another filter can be undone, like changing its properties
+	m_scope->file()->checkpoint();
 	updateEditWidget(m_filterEad, m_edtEadProperties);
 }
 
@@ -93,6 +105,7 @@ void TaskFilterWidget::on_cmbFid_currentIndexChanged()
 {
 	int id = m_cmbFid->currentIndex();
 	m_filterFid->setFilterId(id);
+	m_scope->file()->checkpoint();
 	updateEditWidget(m_filterFid, m_edtFidProperties);
 }
 
@@ -125,7 +138,6 @@ void TaskFilterWidget::run(FilterTesterInfo* filter, QString sProperties)
 				mapProperties.insert(sVar, sVal);
 		}
 	}
-	m_scope->file()->updateDisplay();
-	m_scope->file()->updateAveWaves();
+	m_scope->file()->applyFilters();
 	m_scope->chart()->redraw(); // NOTE: This doesn't work, because there is a check in ChartPixmap::drawWaveform() which doesn't re-render waveforms if their position hasn't changed -- ellis, 2010-10-04
 }
@@ -24,6 +24,7 @@ private:
 
 private slots:
 	void on_scope_fileChanged();
+	void on_file_filterModeChanged();
 	void on_cmbEad_currentIndexChanged();
 	void on_btnEad_clicked();
 	void on_cmbFid_currentIndexChanged();
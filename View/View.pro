@@ -1,6 +1,8 @@
 TEMPLATE = app
 TARGET = GcEad
 QT += printsupport \
+    concurrent \
+    sql \
     xml \
     svg \
 	qml \
@@ -66,7 +68,8 @@ HEADERS += ./WaitCursor.h \
     TaskFilterWidget.h \
     TaskFilterWidgetModel.h \
     ImportRecordDialog.h \
-	ImportEadDialog.h
+	ImportEadDialog.h \
+	CatalogDialog.h
 SOURCES += ./DataListItem.cpp \
     ./TaskReviewWidget.cpp \
     ./MainWindow.cpp \
@@ -94,7 +97,8 @@ SOURCES += ./DataListItem.cpp \
     TaskFilterWidget.cpp \
     TaskFilterWidgetModel.cpp \
     ImportRecordDialog.cpp \
-	ImportEadDialog.cpp
+	ImportEadDialog.cpp \
+	CatalogDialog.cpp
 
 # Forms
 FORMS += ./MainWindow.ui \
@@ -35,6 +35,7 @@ SweepWidget::SweepWidget(QWidget* parent)
 	m_nRange = 1;
 	m_nMin = 0;
 	m_nMax = 0;
+	m_bMinMax = false;
 	setSampleCount(100);
 }
 
@@ -44,14 +45,18 @@ void SweepWidget::clear()
 	m_iEnd = 0;
 	m_nMin = 0;
 	m_nMax = 0;
+	m_iMinMaxBegin = -1;
+	m_iMinMaxEnd = -1;
 	update();
 }
 
 void SweepWidget::setSampleCount(int nSamples)
 {
 	m_nSamples = nSamples;
-	m_points.reserve(m_nSamples);
-	m_points.resize(m_nSamples);
+	// Min/max values take two points each
+	m_points.reserve(2 * m_nSamples);
+	m_points.resize(2 * m_nSamples);
+	m_minmax.resize(m_nSamples);
 	clear();
 }
 
@@ -99,8 +104,56 @@ void SweepWidget::addSamples(const QVector<double>& data)
 	update();
 }
 
+void SweepWidget::setMinMax(const QVector<MinMax>& pixels, int iFirst)
+{
+	CHECK_PRECOND_RET(m_nSamples > 0);
+
+	int iEnd = iFirst + pixels.size();
+	// Start over if the positions went backwards (e.g. because sampling was restarted)
+	if (iEnd < m_iMinMaxEnd)
+		clear();
+	m_bMinMax = true;
+
+	// Only the last m_nSamples positions fit onto the graph
+	int i0 = qMax(0, pixels.size() - m_nSamples);
+	for (int i = i0; i < pixels.size(); i++)
+		m_minmax[(iFirst + i) % m_nSamples] = pixels[i];
+
+	// Previously set positions remain valid if there's no gap
+	int iBegin = iFirst + i0;
+	if (m_iMinMaxEnd >= 0 && iFirst <= m_iMinMaxEnd)
+		iBegin = qMin(iBegin, m_iMinMaxBegin);
+	m_iMinMaxBegin = qMax(iBegin, iEnd - m_nSamples);
+	m_iMinMaxEnd = iEnd;
+	m_iEnd = iEnd % m_nSamples;
+
+	if (m_bAutoRange)
+		updateMinMax();
+
+	update();
+}
+
 void SweepWidget::updateMinMax()
 {
+	if (m_bMinMax)
+	{
+		if (m_iMinMaxBegin >= m_iMinMaxEnd)
+			return;
+
+		const MinMax& first = m_minmax[m_iMinMaxBegin % m_nSamples];
+		m_nMin = first.yBot;
+		m_nMax = first.yTop;
+		for (int i = m_iMinMaxBegin; i < m_iMinMaxEnd; i++)
+		{
+			const MinMax& mm = m_minmax[i % m_nSamples];
+			if (mm.yBot < m_nMin)
+				m_nMin = mm.yBot;
+			if (mm.yTop > m_nMax)
+				m_nMax = mm.yTop;
+		}
+		return;
+	}
+
 	m_nMin = m_nMax = m_data[0];
 	foreach (double n, m_data)
 	{
@@ -191,7 +244,19 @@ void SweepWidget::paintEvent(QPaintEvent* e)
 	// blank area is in the middle, resulting in two line segments to draw
 	QPen pen(Qt::red, 2);
 	p.setPen(pen);
-	if (xStart < width())
+	if (m_bMinMax)
+	{
+		// Draw the absolute positions which are still visible, split where they wrap around
+		int iGap = qMin(iStart - m_iEnd, m_nSamples);
+		int i0 = qMax(m_iMinMaxBegin, m_iMinMaxEnd - m_nSamples + iGap);
+		while (i0 < m_iMinMaxEnd)
+		{
+			int i1 = qMin(m_iMinMaxEnd, (i0 / m_nSamples + 1) * m_nSamples);
+			drawMinMax(p, i0, i1);
+			i0 = i1;
+		}
+	}
+	else if (xStart < width())
 	{
 		drawPoints(p, 0, m_iEnd);
 		drawPoints(p, iStart, m_nSamples);
@@ -219,3 +284,18 @@ void SweepWidget::drawPoints(QPainter& p, int i0, int i1)
 	if (i0 < i1)
 		p.drawPolyline(m_points.data() + i0, i1 - i0);
 }
+
+void SweepWidget::drawMinMax(QPainter& p, int i0, int i1)
+{
+	// Each position contributes a vertical stroke from its min to its max value
+	int n = 0;
+	for (int i = i0; i < i1; i++)
+	{
+		const MinMax& mm = m_minmax[i % m_nSamples];
+		double x = (i % m_nSamples) * m_nSampleToXFactor;
+		m_points[n++] = QPointF(x, m_yOffset + mm.yBot * m_nValueToYFactor);
+		m_points[n++] = QPointF(x, m_yOffset + mm.yTop * m_nValueToYFactor);
+	}
+	if (n > 0)
+		p.drawPolyline(m_points.data(), n);
+}
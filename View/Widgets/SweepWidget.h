@@ -22,6 +22,8 @@
 #include <QList>
 #include <QVector>
 
+#include <RenderData.h>
+
 
 class SweepWidget : public QWidget
 {
@@ -44,6 +46,10 @@ public:
 	/// Add the given samples to the graph.
 	/// This method calls update().
 	void addSamples(const QVector<double>& data);
+	/// Show ready-made min/max values instead of samples, one per position on the graph.
+	/// pixels[i] belongs to the absolute position iFirst + i, which is drawn at (iFirst + i) modulo the sample count.
+	/// This method calls update().
+	void setMinMax(const QVector<MinMax>& pixels, int iFirst);
 
 // Overrides for QWidget
 protected:
@@ -54,6 +60,7 @@ private:
 	void updateMinMax();
 	void calcDrawingParameters();
 	void drawPoints(QPainter& p, int i0, int i1);
+	void drawMinMax(QPainter& p, int i0, int i1);
 
 private:
 	bool m_bAutoRange;
@@ -69,6 +76,15 @@ private:
 	/// Index to the end of the data ring, where the next sample will be placed.
 	int m_iEnd;
 
+	/// True if the graph shows min/max values passed to setMinMax()
+	bool m_bMinMax;
+	/// Ring of min/max values
+	QVector<MinMax> m_minmax;
+	/// First absolute position which has been set since the last clear()
+	int m_iMinMaxBegin;
+	/// One past the last absolute position which has been set
+	int m_iMinMaxEnd;
+
 	// Drawing parameters
 	double m_nSampleToXFactor;
 	double m_nValueToYFactor;
@@ -0,0 +1,203 @@
+#include "Benchmark.h"
+
+#include <iostream>
+using namespace std;
+
+#include <QElapsedTimer>
+
+#include "Check.h"
+
+#include "Key.h"
+#include "Node.h"
+#include "NodeManager.h"
+#include "Server.h"
+
+
+LegacyServer::LegacyServer(QObject *parent) :
+	QObject(parent)
+{
+}
+
+void LegacyServer::add(const QVariantMap& entry) {
+	CHECK_PARAM_RET(entry.contains(KEY));
+	const QString& sKey = entry.value(KEY).toString();
+	CHECK_PARAM_RET(!sKey.isEmpty());
+
+	m_database.insert(sKey, entry);
+	emit entryAdded(entry);
+}
+
+void LegacyServer::remove(const QString& key) {
+	CHECK_PARAM_RET(m_database.contains(key));
+	m_database.remove(key);
+	emit entriesRemoved(QStringList(key));
+}
+
+
+LegacyNodeManager::LegacyNodeManager(LegacyServer* server, QObject *parent) :
+	QObject(parent)
+{
+	connect(server, SIGNAL(entryAdded(const QVariantMap&)), this, SLOT(on_server_add(QVariantMap)));
+	connect(server, SIGNAL(entriesRemoved(const QStringList&)), this, SLOT(on_server_remove(QStringList)));
+}
+
+void LegacyNodeManager::on_server_add(const QVariantMap& entry) {
+	const QString sKey = entry.value(KEY).toString();
+	if (m_nodes.contains(sKey))
+		return;
+
+	Key key = Key::parse(sKey);
+	Node* node = new Node(this);
+	m_nodes.insert(sKey, node);
+	node->setParent(m_nodes.value(key.sParent));
+}
+
+void LegacyNodeManager::on_server_remove(const QStringList& keys) {
+	foreach (const QString& sKey, keys) {
+		delete m_nodes.take(sKey);
+	}
+}
+
+
+/// Keys of a two-level tree: a "run" entity for every 100 entities, with the others as its "peak" children
+static QString entityKey(int i) {
+	if (i % 100 == 0)
+		return QString("run=%1").arg(i / 100);
+	return QString("run=%1:peak=%2").arg(i / 100).arg(i);
+}
+
+static void report(const char* sOperation, qint64 nLegacyMs, qint64 nStoreMs) {
+	cout << "  " << sOperation << ": " << nLegacyMs << " ms -> " << nStoreMs << " ms" << endl;
+}
+
+void runBenchmark(int nEntities) {
+	CHECK_PARAM_RET(nEntities > 0);
+	cout << nEntities << " entities (QVariantMap -> EntityStore):" << endl;
+
+	QList<QVariantMap> entries;
+	QStringList keys;
+	for (int i = 0; i < nEntities; i++) {
+		QVariantMap entry;
+		entry[KEY] = entityKey(i);
+		entry["time"] = (i * 7) % 360000;
+		entry["amplitude"] = (i % 1000) / 10.0;
+		entry["comment"] = QString("peak %1").arg(i % 50);
+		entries << entry;
+		keys << entityKey(i);
+	}
+
+	QElapsedTimer timer;
+	qint64 nLegacy;
+	qint64 nStore;
+
+	// Add all entities; the legacy server notifies its listener once per entity
+	LegacyServer legacy;
+	LegacyNodeManager legacyNodes(&legacy);
+	timer.start();
+	foreach (const QVariantMap& entry, entries) {
+		legacy.add(entry);
+	}
+	nLegacy = timer.elapsed();
+
+	Server server;
+	EntityStore* store = server.store();
+	NodeManager nodes(store);
+	timer.start();
+	server.addAll(entries);
+	nStore = timer.elapsed();
+	report("add", nLegacy, nStore);
+
+	// Read one field of every entity
+	double nSumLegacy = 0;
+	timer.start();
+	foreach (const QVariantMap& entry, legacy.database()) {
+		nSumLegacy += entry.value("amplitude").toDouble();
+	}
+	nLegacy = timer.elapsed();
+
+	double nSumStore = 0;
+	const int iAmplitude = store->column("amplitude");
+	timer.start();
+	for (EntityHandle h = 0; h < store->handleLimit(); h++) {
+		if (store->isValid(h) && store->hasValue(h, iAmplitude))
+			nSumStore += store->doubleValue(h, iAmplitude);
+	}
+	nStore = timer.elapsed();
+	report("scan field", nLegacy, nStore);
+	CHECK_ASSERT_NORET(qAbs(nSumLegacy - nSumStore) < 1e-6 * qAbs(nSumLegacy) + 1e-6);
+
+	// Look entities up by key
+	const int nLookups = qMin(nEntities, 100000);
+	qint64 nTotalLegacy = 0;
+	timer.start();
+	for (int i = 0; i < nLookups; i++) {
+		nTotalLegacy += legacy.database().value(keys[(i * 7919) % nEntities]).value("time").toLongLong();
+	}
+	nLegacy = timer.elapsed();
+
+	qint64 nTotalStore = 0;
+	const int iTime = store->column("time");
+	timer.start();
+	for (int i = 0; i < nLookups; i++) {
+		nTotalStore += store->intValue(store->find(keys[(i * 7919) % nEntities]), iTime);
+	}
+	nStore = timer.elapsed();
+	report("look up by key", nLegacy, nStore);
+	CHECK_ASSERT_NORET(nTotalLegacy == nTotalStore);
+
+	// Find the entities within a time range, by scanning or through a secondary index
+	int nFoundLegacy = 0;
+	timer.start();
+	foreach (const QVariantMap& entry, legacy.database()) {
+		const qint64 nTime = entry.value("time").toLongLong();
+		if (nTime >= 1000 && nTime <= 2000)
+			nFoundLegacy++;
+	}
+	nLegacy = timer.elapsed();
+
+	timer.start();
+	store->addIndex(iTime);
+	const qint64 nIndex = timer.elapsed();
+	timer.start();
+	const int nFoundStore = store->findRange(iTime, 1000, 2000).size();
+	nStore = timer.elapsed();
+	report("find time range", nLegacy, nStore);
+	cout << "  (building the time index: " << nIndex << " ms)" << endl;
+	CHECK_ASSERT_NORET(nFoundLegacy == nFoundStore);
+
+	// Change a field of every 10th entity
+	timer.start();
+	for (int i = 0; i < nEntities; i += 10) {
+		QVariantMap entry = legacy.database().value(keys[i]);
+		entry["comment"] = "changed";
+		legacy.add(entry);
+	}
+	nLegacy = timer.elapsed();
+
+	const int iComment = store->column("comment");
+	timer.start();
+	store->begin();
+	for (int i = 0; i < nEntities; i += 10) {
+		store->setString(store->find(keys[i]), iComment, "changed");
+	}
+	store->commit();
+	nStore = timer.elapsed();
+	report("update", nLegacy, nStore);
+
+	// Remove every 10th peak, which are all leaves
+	timer.start();
+	for (int i = 5; i < nEntities; i += 10) {
+		legacy.remove(keys[i]);
+	}
+	nLegacy = timer.elapsed();
+
+	timer.start();
+	store->begin();
+	for (int i = 5; i < nEntities; i += 10) {
+		store->remove(store->find(keys[i]));
+	}
+	store->commit();
+	nStore = timer.elapsed();
+	report("remove", nLegacy, nStore);
+	CHECK_ASSERT_NORET(legacy.database().size() == store->size());
+}
@@ -0,0 +1,55 @@
+#ifndef __BENCHMARK_H
+#define __BENCHMARK_H
+
+#include <QMap>
+#include <QObject>
+#include <QStringList>
+#include <QVariantMap>
+
+class Node;
+
+
+/// The original design of Server, which keeps each entry in a QVariantMap and signals every change separately
+class LegacyServer : public QObject
+{
+	Q_OBJECT
+public:
+	explicit LegacyServer(QObject *parent = 0);
+
+	const QMap<QString, QVariantMap>& database() const { return m_database; }
+
+signals:
+	void entryAdded(const QVariantMap& entry);
+	void entriesRemoved(const QStringList& keys);
+
+public slots:
+	void add(const QVariantMap& entry);
+	void remove(const QString& key);
+
+private:
+	QMap<QString, QVariantMap> m_database;
+};
+
+
+/// The original NodeManager, which links each entry into the tree as its signal arrives
+class LegacyNodeManager : public QObject
+{
+	Q_OBJECT
+public:
+	explicit LegacyNodeManager(LegacyServer* server, QObject *parent = 0);
+
+private slots:
+	void on_server_add(const QVariantMap& entry);
+	void on_server_remove(const QStringList& keys);
+
+private:
+	/// All nodes, mapped by key
+	QMap<QString, Node*> m_nodes;
+};
+
+
+/// Compare Server's EntityStore with the original QVariantMap design on nEntities entities,
+/// and print the time of each operation
+void runBenchmark(int nEntities);
+
+#endif
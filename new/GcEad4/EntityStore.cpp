@@ -0,0 +1,402 @@
+#include "EntityStore.h"
+
+#include <math.h>
+
+#include "Check.h"
+
+#include "Key.h"
+
+
+EntityStore::EntityStore(QObject *parent) :
+	QObject(parent),
+	m_nSize(0),
+	m_nTransactionDepth(0)
+{
+}
+
+int EntityStore::addColumn(const QString& sName, ColumnType type) {
+	const int iExisting = column(sName);
+	if (iExisting >= 0) {
+		CHECK_ASSERT_NORET(m_columns[iExisting].type == type);
+		return iExisting;
+	}
+
+	Column col;
+	col.sName = sName;
+	col.type = type;
+	col.bIndexed = false;
+	const int nRows = m_keys.size();
+	switch (type) {
+	case ColumnType_Int: col.ints.fill(0, nRows); break;
+	case ColumnType_Double: col.doubles.fill(0, nRows); break;
+	case ColumnType_String: col.strings.resize(nRows); break;
+	}
+	col.has.fill(false, nRows);
+
+	m_columns.append(col);
+	m_columnIndexes.insert(sName, m_columns.size() - 1);
+	return m_columns.size() - 1;
+}
+
+void EntityStore::addIndex(int iColumn) {
+	CHECK_PARAM_RET(iColumn >= 0 && iColumn < m_columns.size());
+	Column& col = m_columns[iColumn];
+	if (col.bIndexed)
+		return;
+
+	col.bIndexed = true;
+	for (EntityHandle h = 0; h < m_keys.size(); h++) {
+		if (col.has[h])
+			indexValue(col, h);
+	}
+}
+
+void EntityStore::begin() {
+	m_nTransactionDepth++;
+}
+
+void EntityStore::commit() {
+	CHECK_PRECOND_RET(m_nTransactionDepth > 0);
+	if (--m_nTransactionDepth > 0)
+		return;
+
+	// Entities which were both added and removed within the transaction aren't reported at all
+	EntityChangeSet changes;
+	foreach (EntityHandle h, m_changes.added) {
+		if ((m_txFlags[h] & TxFlag_Removed) == 0)
+			changes.added.append(h);
+		m_txFlags[h] = 0;
+	}
+	foreach (EntityHandle h, m_changes.changed) {
+		if ((m_txFlags[h] & TxFlag_Removed) == 0)
+			changes.changed.append(h);
+		m_txFlags[h] = 0;
+	}
+	foreach (EntityHandle h, m_changes.adopted) {
+		if ((m_txFlags[h] & TxFlag_Removed) == 0)
+			changes.adopted.append(h);
+		m_txFlags[h] = 0;
+	}
+	changes.removed = m_changes.removed;
+	changes.removedKeys = m_changes.removedKeys;
+	changes.columns = m_changes.columns;
+
+	foreach (EntityHandle h, m_freeOnCommit)
+		m_txFlags[h] = 0;
+	m_free += m_freeOnCommit;
+	m_freeOnCommit.clear();
+	m_changes = EntityChangeSet();
+
+	if (!changes.isEmpty())
+		emit changed(changes);
+}
+
+EntityHandle EntityStore::allocate() {
+	if (!m_free.isEmpty()) {
+		EntityHandle h = m_free.last();
+		m_free.removeLast();
+		return h;
+	}
+
+	const EntityHandle h = m_keys.size();
+	m_alive.append(false);
+	m_keys.append(QString());
+	m_names.append(QString());
+	m_kindIds.append(0);
+	m_parents.append(InvalidEntity);
+	m_children.append(QVector<EntityHandle>());
+	m_txFlags.append(0);
+	for (int i = 0; i < m_columns.size(); i++) {
+		Column& col = m_columns[i];
+		switch (col.type) {
+		case ColumnType_Int: col.ints.append(0); break;
+		case ColumnType_Double: col.doubles.append(0); break;
+		case ColumnType_String: col.strings.append(QString()); break;
+		}
+		col.has.append(false);
+	}
+	return h;
+}
+
+int EntityStore::kindId(const QString& sKind) {
+	int id = m_kindIndex.value(sKind, -1);
+	if (id < 0) {
+		id = m_kinds.size();
+		m_kinds.append(sKind);
+		m_kindIndex.insert(sKind, id);
+	}
+	return id;
+}
+
+EntityHandle EntityStore::add(const QString& sKey) {
+	EntityHandle h = find(sKey);
+	if (h != InvalidEntity)
+		return h;
+
+	Key key = Key::parse(sKey);
+	CHECK_PARAM_RETVAL(!key.name.isEmpty(), InvalidEntity);
+
+	begin();
+
+	h = allocate();
+	const int idKind = kindId(key.kind);
+	m_alive[h] = true;
+	m_keys[h] = sKey;
+	m_names[h] = key.name;
+	m_kindIds[h] = idKind;
+	m_keyIndex.insert(sKey, h);
+	m_kindMembers.insert(idKind, h);
+	m_nSize++;
+
+	EntityHandle hParent = (key.sParent.isEmpty()) ? InvalidEntity : find(key.sParent);
+	m_parents[h] = hParent;
+	if (hParent != InvalidEntity)
+		m_children[hParent].append(h);
+	else if (!key.sParent.isEmpty())
+		m_orphans.insert(key.sParent, h);
+
+	// Entities which were added before their parent are linked to it now
+	if (m_orphans.contains(sKey)) {
+		foreach (EntityHandle hChild, m_orphans.values(sKey)) {
+			m_parents[hChild] = h;
+			m_children[h].append(hChild);
+			if ((m_txFlags[hChild] & (TxFlag_Added | TxFlag_Adopted)) == 0) {
+				m_txFlags[hChild] |= TxFlag_Adopted;
+				m_changes.adopted.append(hChild);
+			}
+		}
+		m_orphans.remove(sKey);
+	}
+
+	m_txFlags[h] |= TxFlag_Added;
+	m_changes.added.append(h);
+
+	commit();
+	return h;
+}
+
+void EntityStore::remove(EntityHandle h) {
+	CHECK_PARAM_RET(isValid(h));
+
+	begin();
+
+	const EntityHandle hParent = m_parents[h];
+	if (hParent != InvalidEntity) {
+		m_children[hParent].removeOne(h);
+	}
+	else {
+		const int iColonLast = m_keys[h].lastIndexOf(':');
+		if (iColonLast > 0)
+			m_orphans.remove(m_keys[h].left(iColonLast), h);
+	}
+	removeRecursive(h);
+
+	commit();
+}
+
+void EntityStore::removeRecursive(EntityHandle h) {
+	foreach (EntityHandle hChild, m_children[h])
+		removeRecursive(hChild);
+
+	for (int i = 0; i < m_columns.size(); i++) {
+		Column& col = m_columns[i];
+		if (col.has[h]) {
+			unindexValue(col, h);
+			if (col.type == ColumnType_String)
+				col.strings[h].clear();
+			col.has[h] = false;
+		}
+	}
+
+	m_keyIndex.remove(m_keys[h]);
+	m_kindMembers.remove(m_kindIds[h], h);
+
+	// Listeners never heard of entities which were added in the same transaction
+	if ((m_txFlags[h] & TxFlag_Added) == 0) {
+		m_changes.removed.append(h);
+		m_changes.removedKeys.append(m_keys[h]);
+	}
+	m_txFlags[h] |= TxFlag_Removed;
+	m_freeOnCommit.append(h);
+
+	m_alive[h] = false;
+	m_keys[h].clear();
+	m_names[h].clear();
+	m_parents[h] = InvalidEntity;
+	m_children[h].clear();
+	m_nSize--;
+}
+
+QVector<EntityHandle> EntityStore::roots() const {
+	QVector<EntityHandle> roots;
+	for (EntityHandle h = 0; h < m_keys.size(); h++) {
+		if (m_alive[h] && m_parents[h] == InvalidEntity)
+			roots.append(h);
+	}
+	return roots;
+}
+
+QVariant EntityStore::value(EntityHandle h, int iColumn) const {
+	CHECK_PARAM_RETVAL(isValid(h) && iColumn >= 0 && iColumn < m_columns.size(), QVariant());
+	const Column& col = m_columns[iColumn];
+	if (!col.has[h])
+		return QVariant();
+	switch (col.type) {
+	case ColumnType_Int: return col.ints[h];
+	case ColumnType_Double: return col.doubles[h];
+	case ColumnType_String: return col.strings[h];
+	}
+	return QVariant();
+}
+
+void EntityStore::setInt(EntityHandle h, int iColumn, qint64 n) {
+	CHECK_PARAM_RET(isValid(h) && iColumn >= 0 && iColumn < m_columns.size());
+	Column& col = m_columns[iColumn];
+	CHECK_PARAM_RET(col.type == ColumnType_Int);
+	if (col.has[h] && col.ints[h] == n)
+		return;
+
+	begin();
+	unindexValue(col, h);
+	col.ints[h] = n;
+	col.has[h] = true;
+	indexValue(col, h);
+	markChanged(h, iColumn);
+	commit();
+}
+
+void EntityStore::setDouble(EntityHandle h, int iColumn, double n) {
+	CHECK_PARAM_RET(isValid(h) && iColumn >= 0 && iColumn < m_columns.size());
+	Column& col = m_columns[iColumn];
+	CHECK_PARAM_RET(col.type == ColumnType_Double);
+	if (col.has[h] && col.doubles[h] == n)
+		return;
+
+	begin();
+	unindexValue(col, h);
+	col.doubles[h] = n;
+	col.has[h] = true;
+	indexValue(col, h);
+	markChanged(h, iColumn);
+	commit();
+}
+
+void EntityStore::setString(EntityHandle h, int iColumn, const QString& s) {
+	CHECK_PARAM_RET(isValid(h) && iColumn >= 0 && iColumn < m_columns.size());
+	Column& col = m_columns[iColumn];
+	CHECK_PARAM_RET(col.type == ColumnType_String);
+	if (col.has[h] && col.strings[h] == s)
+		return;
+
+	begin();
+	unindexValue(col, h);
+	col.strings[h] = s;
+	col.has[h] = true;
+	indexValue(col, h);
+	markChanged(h, iColumn);
+	commit();
+}
+
+void EntityStore::setValue(EntityHandle h, int iColumn, const QVariant& v) {
+	CHECK_PARAM_RET(iColumn >= 0 && iColumn < m_columns.size());
+	if (!v.isValid()) {
+		clearValue(h, iColumn);
+		return;
+	}
+	switch (m_columns[iColumn].type) {
+	case ColumnType_Int: setInt(h, iColumn, v.toLongLong()); break;
+	case ColumnType_Double: setDouble(h, iColumn, v.toDouble()); break;
+	case ColumnType_String: setString(h, iColumn, v.toString()); break;
+	}
+}
+
+void EntityStore::clearValue(EntityHandle h, int iColumn) {
+	CHECK_PARAM_RET(isValid(h) && iColumn >= 0 && iColumn < m_columns.size());
+	Column& col = m_columns[iColumn];
+	if (!col.has[h])
+		return;
+
+	begin();
+	unindexValue(col, h);
+	switch (col.type) {
+	case ColumnType_Int: col.ints[h] = 0; break;
+	case ColumnType_Double: col.doubles[h] = 0; break;
+	case ColumnType_String: col.strings[h].clear(); break;
+	}
+	col.has[h] = false;
+	markChanged(h, iColumn);
+	commit();
+}
+
+void EntityStore::markChanged(EntityHandle h, int iColumn) {
+	// New entities are reported as added, with all of their values
+	if ((m_txFlags[h] & (TxFlag_Added | TxFlag_Changed)) == 0) {
+		m_txFlags[h] |= TxFlag_Changed;
+		m_changes.changed.append(h);
+	}
+	if (!m_changes.columns.contains(iColumn))
+		m_changes.columns.append(iColumn);
+}
+
+void EntityStore::indexValue(Column& col, EntityHandle h) {
+	if (!col.bIndexed || !col.has[h])
+		return;
+	switch (col.type) {
+	case ColumnType_Int: col.intIndex.insert(col.ints[h], h); break;
+	case ColumnType_Double: col.doubleIndex.insert(col.doubles[h], h); break;
+	case ColumnType_String: col.stringIndex.insert(col.strings[h], h); break;
+	}
+}
+
+void EntityStore::unindexValue(Column& col, EntityHandle h) {
+	if (!col.bIndexed || !col.has[h])
+		return;
+	switch (col.type) {
+	case ColumnType_Int: col.intIndex.remove(col.ints[h], h); break;
+	case ColumnType_Double: col.doubleIndex.remove(col.doubles[h], h); break;
+	case ColumnType_String: col.stringIndex.remove(col.strings[h], h); break;
+	}
+}
+
+QVector<EntityHandle> EntityStore::findByKind(const QString& sKind) const {
+	const int idKind = m_kindIndex.value(sKind, -1);
+	if (idKind < 0)
+		return QVector<EntityHandle>();
+	return QVector<EntityHandle>::fromList(m_kindMembers.values(idKind));
+}
+
+QVector<EntityHandle> EntityStore::findEqual(int iColumn, const QVariant& v) const {
+	CHECK_PARAM_RETVAL(iColumn >= 0 && iColumn < m_columns.size(), QVector<EntityHandle>());
+	const Column& col = m_columns[iColumn];
+	CHECK_PRECOND_RETVAL(col.bIndexed, QVector<EntityHandle>());
+
+	QList<EntityHandle> list;
+	switch (col.type) {
+	case ColumnType_Int: list = col.intIndex.values(v.toLongLong()); break;
+	case ColumnType_Double: list = col.doubleIndex.values(v.toDouble()); break;
+	case ColumnType_String: list = col.stringIndex.values(v.toString()); break;
+	}
+	return QVector<EntityHandle>::fromList(list);
+}
+
+QVector<EntityHandle> EntityStore::findRange(int iColumn, double nFrom, double nTo) const {
+	QVector<EntityHandle> handles;
+	CHECK_PARAM_RETVAL(iColumn >= 0 && iColumn < m_columns.size(), handles);
+	const Column& col = m_columns[iColumn];
+	CHECK_PRECOND_RETVAL(col.bIndexed, handles);
+
+	if (col.type == ColumnType_Int) {
+		QMultiMap<qint64, EntityHandle>::const_iterator it = col.intIndex.lowerBound(qint64(ceil(nFrom)));
+		for (; it != col.intIndex.constEnd() && it.key() <= nTo; ++it)
+			handles.append(it.value());
+	}
+	else if (col.type == ColumnType_Double) {
+		QMultiMap<double, EntityHandle>::const_iterator it = col.doubleIndex.lowerBound(nFrom);
+		for (; it != col.doubleIndex.constEnd() && it.key() <= nTo; ++it)
+			handles.append(it.value());
+	}
+	else {
+		CHECK_FAILURE_RETVAL(handles);
+	}
+	return handles;
+}
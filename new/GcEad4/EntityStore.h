@@ -0,0 +1,178 @@
+#ifndef __ENTITYSTORE_H
+#define __ENTITYSTORE_H
+
+#include <QHash>
+#include <QList>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QVariant>
+#include <QVector>
+
+
+/// Index of an entity in an EntityStore.
+/// The handles of removed entities are reused once the transaction which removed them has been committed.
+typedef int EntityHandle;
+const EntityHandle InvalidEntity = -1;
+
+enum ColumnType {
+	ColumnType_Int,
+	ColumnType_Double,
+	ColumnType_String
+};
+
+
+/// Everything that changed in one transaction of an EntityStore
+class EntityChangeSet
+{
+public:
+	/// Entities which were added
+	QVector<EntityHandle> added;
+	/// Entities which were removed; their handles are still valid, but only as identifiers
+	QVector<EntityHandle> removed;
+	/// Keys of the removed entities, in the same order as removed
+	QStringList removedKeys;
+	/// Existing entities whose fields changed
+	QVector<EntityHandle> changed;
+	/// Existing entities which got a parent because their parent was added
+	QVector<EntityHandle> adopted;
+	/// Columns which changed in any of the entities
+	QList<int> columns;
+
+	bool isEmpty() const {
+		return added.isEmpty() && removed.isEmpty() && changed.isEmpty() && adopted.isEmpty();
+	}
+};
+
+
+/// Entities stored by column rather than as one QVariantMap each.
+/// Every entity has a key of the form "kind=name" or "parentKey:kind=name", and a value in each typed column.
+/// Changes are grouped into transactions, and changed() is emitted once per transaction.
+/// Keys, kinds and parents are always indexed; other columns can be indexed with addIndex().
+class EntityStore : public QObject
+{
+	Q_OBJECT
+public:
+	explicit EntityStore(QObject *parent = 0);
+
+	int columnCount() const { return m_columns.size(); }
+	/// Add a column, or return the existing column of that name
+	int addColumn(const QString& sName, ColumnType type);
+	/// @returns the column's index, or -1 if there is no such column
+	int column(const QString& sName) const { return m_columnIndexes.value(sName, -1); }
+	const QString& columnName(int iColumn) const { return m_columns[iColumn].sName; }
+	ColumnType columnType(int iColumn) const { return m_columns[iColumn].type; }
+	/// Maintain an index of the column's values for findEqual() and findRange()
+	void addIndex(int iColumn);
+
+	/// Start a transaction; transactions may be nested
+	void begin();
+	/// End a transaction; when the outermost transaction ends, changed() is emitted if anything changed
+	void commit();
+	bool inTransaction() const { return m_nTransactionDepth > 0; }
+
+	/// Number of entities
+	int size() const { return m_nSize; }
+	/// Upper limit of the handles, for iterating over all entities together with isValid()
+	int handleLimit() const { return m_keys.size(); }
+	bool isValid(EntityHandle h) const { return h >= 0 && h < m_alive.size() && m_alive[h]; }
+
+	/// Add an entity, or return the existing entity with that key
+	EntityHandle add(const QString& sKey);
+	/// Remove an entity along with all of its descendants
+	void remove(EntityHandle h);
+	/// @returns the entity with that key, or InvalidEntity
+	EntityHandle find(const QString& sKey) const { return m_keyIndex.value(sKey, InvalidEntity); }
+
+	const QString& key(EntityHandle h) const { return m_keys[h]; }
+	const QString& kind(EntityHandle h) const { return m_kinds[m_kindIds[h]]; }
+	const QString& name(EntityHandle h) const { return m_names[h]; }
+	EntityHandle parent(EntityHandle h) const { return m_parents[h]; }
+	const QVector<EntityHandle>& children(EntityHandle h) const { return m_children[h]; }
+	/// Entities whose parent isn't in the store
+	QVector<EntityHandle> roots() const;
+
+	bool hasValue(EntityHandle h, int iColumn) const { return m_columns[iColumn].has[h]; }
+	qint64 intValue(EntityHandle h, int iColumn) const { return m_columns[iColumn].ints[h]; }
+	double doubleValue(EntityHandle h, int iColumn) const { return m_columns[iColumn].doubles[h]; }
+	const QString& stringValue(EntityHandle h, int iColumn) const { return m_columns[iColumn].strings[h]; }
+	/// Get a value of any column type, or an invalid QVariant if the entity has none
+	QVariant value(EntityHandle h, int iColumn) const;
+
+	void setInt(EntityHandle h, int iColumn, qint64 n);
+	void setDouble(EntityHandle h, int iColumn, double n);
+	void setString(EntityHandle h, int iColumn, const QString& s);
+	/// Set a value of any column type, converting it to the column's type
+	void setValue(EntityHandle h, int iColumn, const QVariant& v);
+	void clearValue(EntityHandle h, int iColumn);
+
+	QVector<EntityHandle> findByKind(const QString& sKind) const;
+	/// Find the entities with the given value in an indexed column
+	QVector<EntityHandle> findEqual(int iColumn, const QVariant& v) const;
+	/// Find the entities whose value in an indexed numeric column is within [nFrom, nTo]
+	QVector<EntityHandle> findRange(int iColumn, double nFrom, double nTo) const;
+
+signals:
+	void changed(const EntityChangeSet& changes);
+
+private:
+	struct Column {
+		QString sName;
+		ColumnType type;
+		/// Only the vector for the column's type is used
+		QVector<qint64> ints;
+		QVector<double> doubles;
+		QVector<QString> strings;
+		QVector<bool> has;
+		bool bIndexed;
+		QMultiMap<qint64, EntityHandle> intIndex;
+		QMultiMap<double, EntityHandle> doubleIndex;
+		QMultiHash<QString, EntityHandle> stringIndex;
+	};
+
+	/// Flags of the entities which have already been recorded in the current transaction's change set
+	enum TxFlag {
+		TxFlag_Added = 1,
+		TxFlag_Changed = 2,
+		TxFlag_Removed = 4,
+		TxFlag_Adopted = 8
+	};
+
+private:
+	EntityHandle allocate();
+	void removeRecursive(EntityHandle h);
+	void unindexValue(Column& col, EntityHandle h);
+	void indexValue(Column& col, EntityHandle h);
+	void markChanged(EntityHandle h, int iColumn);
+	int kindId(const QString& sKind);
+
+private:
+	QVector<Column> m_columns;
+	QHash<QString, int> m_columnIndexes;
+
+	int m_nSize;
+	QVector<bool> m_alive;
+	QVector<QString> m_keys;
+	QVector<QString> m_names;
+	QVector<int> m_kindIds;
+	QVector<EntityHandle> m_parents;
+	QVector<QVector<EntityHandle> > m_children;
+	/// Handles which can be reused
+	QVector<EntityHandle> m_free;
+	/// Handles which were removed in the current transaction, and which can be reused once it's committed
+	QVector<EntityHandle> m_freeOnCommit;
+
+	QHash<QString, EntityHandle> m_keyIndex;
+	QStringList m_kinds;
+	QHash<QString, int> m_kindIndex;
+	QMultiHash<int, EntityHandle> m_kindMembers;
+	/// Entities whose parent hasn't been added yet, by the parent's key
+	QMultiHash<QString, EntityHandle> m_orphans;
+
+	int m_nTransactionDepth;
+	EntityChangeSet m_changes;
+	QVector<quint8> m_txFlags;
+};
+
+#endif
@@ -0,0 +1,140 @@
+#include "EntityStoreTest.h"
+
+#include <iostream>
+using namespace std;
+
+
+EntityChangeRecorder::EntityChangeRecorder(EntityStore* store, QObject *parent) :
+	QObject(parent)
+{
+	connect(store, SIGNAL(changed(const EntityChangeSet&)), this, SLOT(on_store_changed(EntityChangeSet)));
+}
+
+void EntityChangeRecorder::on_store_changed(const EntityChangeSet& changeSet) {
+	changes << changeSet;
+}
+
+
+static int g_nFailures = 0;
+
+static void expect(bool b, const char* sCondition, int iLine) {
+	if (!b) {
+		g_nFailures++;
+		cout << "  FAILED at line " << iLine << ": " << sCondition << endl;
+	}
+}
+
+#define EXPECT(x) expect((x), #x, __LINE__)
+
+
+int runEntityStoreTest() {
+	g_nFailures = 0;
+	cout << "EntityStore test:" << endl;
+
+	EntityStore store;
+	EntityChangeRecorder recorder(&store);
+	const int iTime = store.addColumn("time", ColumnType_Int);
+	const int iAmplitude = store.addColumn("amplitude", ColumnType_Double);
+	const int iComment = store.addColumn("comment", ColumnType_String);
+	EXPECT(store.addColumn("time", ColumnType_Int) == iTime);
+	EXPECT(store.column("amplitude") == iAmplitude);
+
+	// A child may be added before its parent, and a transaction is reported once
+	store.begin();
+	const EntityHandle hPeak = store.add("run=1:peak=1");
+	const EntityHandle hRun = store.add("run=1");
+	store.setInt(hPeak, iTime, 100);
+	EXPECT(recorder.changes.isEmpty());
+	store.commit();
+	EXPECT(recorder.changes.size() == 1);
+	if (recorder.changes.size() == 1) {
+		const EntityChangeSet& changes = recorder.changes.last();
+		EXPECT(changes.added.size() == 2);
+		// New entities are only reported as added, with all their values
+		EXPECT(changes.adopted.isEmpty());
+		EXPECT(changes.changed.isEmpty());
+	}
+	EXPECT(store.size() == 2);
+	EXPECT(store.parent(hPeak) == hRun);
+	EXPECT(store.children(hRun) == QVector<EntityHandle>() << hPeak);
+	EXPECT(store.roots() == QVector<EntityHandle>() << hRun);
+	EXPECT(store.find("run=1:peak=1") == hPeak);
+	EXPECT(store.kind(hPeak) == "peak");
+	EXPECT(store.name(hPeak) == "1");
+	EXPECT(store.findByKind("peak") == QVector<EntityHandle>() << hPeak);
+
+	// Adding an existing key changes nothing
+	EXPECT(store.add("run=1") == hRun);
+	EXPECT(store.size() == 2);
+	EXPECT(recorder.changes.size() == 1);
+
+	// A child which was reported on its own is adopted by its parent later
+	const EntityHandle hOrphan = store.add("run=2:peak=5");
+	EXPECT(store.parent(hOrphan) == InvalidEntity);
+	const EntityHandle hRun2 = store.add("run=2");
+	EXPECT(recorder.changes.size() == 3);
+	EXPECT(recorder.changes.last().added == QVector<EntityHandle>() << hRun2);
+	EXPECT(recorder.changes.last().adopted == QVector<EntityHandle>() << hOrphan);
+	EXPECT(store.parent(hOrphan) == hRun2);
+
+	// Values
+	store.setDouble(hPeak, iAmplitude, 1.5);
+	EXPECT(recorder.changes.size() == 4);
+	EXPECT(recorder.changes.last().changed == QVector<EntityHandle>() << hPeak);
+	EXPECT(recorder.changes.last().columns == QList<int>() << iAmplitude);
+	store.setDouble(hPeak, iAmplitude, 1.5);
+	EXPECT(recorder.changes.size() == 4);
+	EXPECT(store.doubleValue(hPeak, iAmplitude) == 1.5);
+	store.setValue(hPeak, iComment, QVariant(42));
+	EXPECT(store.stringValue(hPeak, iComment) == "42");
+	store.clearValue(hPeak, iComment);
+	EXPECT(!store.hasValue(hPeak, iComment));
+	EXPECT(!store.value(hPeak, iComment).isValid());
+
+	// Secondary indexes follow changes to the values
+	store.addIndex(iTime);
+	store.setInt(hOrphan, iTime, 200);
+	EXPECT(store.findEqual(iTime, 100) == QVector<EntityHandle>() << hPeak);
+	EXPECT(store.findRange(iTime, 150, 250) == QVector<EntityHandle>() << hOrphan);
+	store.setInt(hPeak, iTime, 210);
+	EXPECT(store.findEqual(iTime, 100).isEmpty());
+	EXPECT(store.findRange(iTime, 150, 250).size() == 2);
+	store.addIndex(iComment);
+	store.setString(hRun, iComment, "a");
+	EXPECT(store.findEqual(iComment, "a") == QVector<EntityHandle>() << hRun);
+
+	// Removing an entity removes its descendants, and their handles are only reused after the commit
+	const int nChanges = recorder.changes.size();
+	const int nSize = store.size();
+	store.begin();
+	store.remove(hRun);
+	const EntityHandle hRun3 = store.add("run=3");
+	EXPECT(hRun3 != hRun && hRun3 != hPeak);
+	const EntityHandle hTemp = store.add("run=4");
+	store.remove(hTemp);
+	store.commit();
+	EXPECT(recorder.changes.size() == nChanges + 1);
+	if (recorder.changes.size() == nChanges + 1) {
+		const EntityChangeSet& changes = recorder.changes.last();
+		EXPECT(changes.removed.size() == 2);
+		EXPECT(changes.removed.contains(hRun) && changes.removed.contains(hPeak));
+		EXPECT(changes.removedKeys.contains("run=1") && changes.removedKeys.contains("run=1:peak=1"));
+		// Listeners never hear of an entity which was added and removed in the same transaction
+		EXPECT(changes.added == QVector<EntityHandle>() << hRun3);
+	}
+	EXPECT(store.size() == nSize - 1);
+	EXPECT(!store.isValid(hRun) && !store.isValid(hPeak) && !store.isValid(hTemp));
+	EXPECT(store.find("run=1:peak=1") == InvalidEntity);
+	EXPECT(store.findEqual(iTime, 210).isEmpty());
+	EXPECT(store.findEqual(iComment, "a").isEmpty());
+	EXPECT(store.findByKind("peak") == QVector<EntityHandle>() << hOrphan);
+
+	const int nHandleLimit = store.handleLimit();
+	const EntityHandle hReused = store.add("run=5");
+	EXPECT(hReused == hRun || hReused == hPeak || hReused == hTemp);
+	EXPECT(store.handleLimit() == nHandleLimit);
+	EXPECT(!store.hasValue(hReused, iTime) && !store.hasValue(hReused, iComment));
+
+	cout << "  " << g_nFailures << " failures" << endl;
+	return g_nFailures;
+}
@@ -0,0 +1,28 @@
+#ifndef __ENTITYSTORETEST_H
+#define __ENTITYSTORETEST_H
+
+#include <QList>
+#include <QObject>
+
+#include "EntityStore.h"
+
+
+/// Records the change sets which an EntityStore emits
+class EntityChangeRecorder : public QObject
+{
+	Q_OBJECT
+public:
+	explicit EntityChangeRecorder(EntityStore* store, QObject *parent = 0);
+
+	QList<EntityChangeSet> changes;
+
+private slots:
+	void on_store_changed(const EntityChangeSet& changeSet);
+};
+
+
+/// Check EntityStore's parent links, transactions, handle reuse and indexes, and print every failed check
+/// @returns the number of failed checks
+int runEntityStoreTest();
+
+#endif
@@ -16,7 +16,10 @@ SOURCES += main.cpp\
     Key.cpp \
     Entry.cpp \
     Node.cpp \
-    NodeManager.cpp
+    NodeManager.cpp \
+    EntityStore.cpp \
+    Benchmark.cpp \
+    EntityStoreTest.cpp
 
 HEADERS  += MainWindow.h \
     Server.h \
@@ -25,7 +28,10 @@ HEADERS  += MainWindow.h \
     Node.h \
     NodeManager.h \
     Check.h \
-    Defines.h
+    Defines.h \
+    EntityStore.h \
+    Benchmark.h \
+    EntityStoreTest.h
 
 FORMS    += MainWindow.ui
 
@@ -12,7 +12,7 @@ Key Key::parse(const QString& sKey) {
 
 	const QString sParent = (iColonLast > 0) ? sKey.left(iColonLast) : QString();
 	const QString sSelf = sKey.mid(iColonLast + 1);
-	const int iEqual = sKey.indexOf('=');
+	const int iEqual = sSelf.indexOf('=');
 	CHECK_ASSERT_RETVAL(iEqual > 0, Key::empty);
 
 	const QString sKind = sSelf.left(iEqual);
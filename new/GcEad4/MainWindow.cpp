@@ -12,7 +12,7 @@ MainWindow::MainWindow(QWidget *parent) :
 {
     ui->setupUi(this);
 	m_server = new Server(this);
-	m_nodeManager = new NodeManager(m_server, this);
+	m_nodeManager = new NodeManager(m_server->store(), this);
 }
 
 MainWindow::~MainWindow()
@@ -32,4 +32,5 @@ void MainWindow::on_btnAdd_clicked()
 			entry.insert(ls[0], ls[1]);
 	}
 	m_server->add(entry);
+	m_nodeManager->printTree();
 }
@@ -7,13 +7,16 @@ using namespace std;
 
 
 Node::Node(QObject *parent) :
-    QObject(parent)
+    QObject(parent),
+	m_store(NULL),
+	m_handle(InvalidEntity)
 {
 }
 
-Node::Node(const QVariantMap& entry, QObject *parent) :
+Node::Node(const EntityStore* store, EntityHandle handle, QObject *parent) :
 	QObject(parent),
-	m_entry(entry)
+	m_store(store),
+	m_handle(handle)
 {
 }
 
@@ -39,7 +42,7 @@ void Node::removeChild(Node* child) {
 
 void Node::printTree(int nIndent) const {
 	const QString sIndent = QString(nIndent, ' ');
-	const QString sKey = m_entry[KEY].toString();
+	const QString sKey = (m_store != NULL) ? m_store->key(m_handle) : QString();
 	cout << qPrintable(sIndent) << qPrintable(sKey) << endl;
 	foreach (Node* child, m_children) {
 		child->printTree(nIndent + 1);
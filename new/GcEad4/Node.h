@@ -4,9 +4,8 @@
 #include <QList>
 #include <QObject>
 #include <QPointer>
-#include <QVariantMap>
 
-#include "Defines.h" // for convenience of KEY constant
+#include "EntityStore.h"
 
 
 class Node : public QObject
@@ -14,7 +13,9 @@ class Node : public QObject
     Q_OBJECT
 public:
 	explicit Node(QObject *parent = 0);
-	explicit Node(const QVariantMap& entry, QObject *parent = 0);
+	Node(const EntityStore* store, EntityHandle handle, QObject *parent = 0);
+
+	EntityHandle handle() const { return m_handle; }
 
 	Node* parentNode() const { return m_parent; }
 	void setParent(Node* parent);
@@ -30,7 +31,8 @@ private:
 	void removeChild(Node* child);
 
 private:
-	QVariantMap m_entry;
+	const EntityStore* m_store;
+	EntityHandle m_handle;
 	QList<Node*> m_children;
 	QPointer<Node> m_parent;
 };
@@ -2,37 +2,54 @@
 
 #include "Check.h"
 
-#include "Key.h"
 #include "Node.h"
-#include "Server.h"
 
 
-NodeManager::NodeManager(Server* server, QObject *parent) :
+NodeManager::NodeManager(EntityStore* store, QObject *parent) :
     QObject(parent)
 {
-	m_server = server;
-	connect(m_server, SIGNAL(entryAdded(const QVariantMap&)), this, SLOT(on_server_add(QVariantMap)));
+	m_store = store;
+	connect(m_store, SIGNAL(changed(const EntityChangeSet&)), this, SLOT(on_store_changed(const EntityChangeSet&)));
 }
 
-void NodeManager::on_server_add(const QVariantMap& entry) {
-	CHECK_PARAM_RET(entry.contains(KEY));
-	const QString& sKey = entry.value(KEY).toString();
-	CHECK_PARAM_RET(!sKey.isEmpty());
+QList<Node*> NodeManager::roots() const {
+	QList<Node*> roots;
+	foreach (Node* node, m_nodes) {
+		if (node->parentNode() == NULL)
+			roots << node;
+	}
+	return roots;
+}
 
-	Key key = Key::parse(sKey);
-	Node* node = new Node(entry, this);
+void NodeManager::printTree() const {
+	foreach (Node* root, roots()) {
+		root->printTree(0);
+	}
+}
 
-	const QString& sKeyParent = key.sParent;
-	if (m_nodes.contains(sKeyParent)) {
-		Node* parent = m_nodes[sKeyParent];
-		node->setParent(parent);
+void NodeManager::on_store_changed(const EntityChangeSet& changes) {
+	CHECK_PRECOND_RET(!m_store.isNull());
+
+	// Removed descendants are removed along with their ancestors, so detach all of them before deleting any
+	QList<Node*> removed;
+	foreach (EntityHandle handle, changes.removed) {
+		Node* node = m_nodes.take(handle);
+		if (node != NULL) {
+			node->setParent(NULL);
+			removed << node;
+		}
 	}
-	else {
-		m_roots.insert(sKey, node);
-		m_nodes.insert(sKey, node);
+	qDeleteAll(removed);
+
+	// Create all new nodes first, since a parent may have been added after its children
+	foreach (EntityHandle handle, changes.added) {
+		CHECK_ASSERT_RET(!m_nodes.contains(handle));
+		m_nodes.insert(handle, new Node(m_store, handle, this));
 	}
 
-	foreach (Node* root, m_roots) {
-		root->printTree(0);
+	foreach (EntityHandle handle, changes.added + changes.adopted) {
+		Node* node = m_nodes.value(handle);
+		CHECK_ASSERT_RET(node != NULL);
+		node->setParent(m_nodes.value(m_store->parent(handle)));
 	}
 }
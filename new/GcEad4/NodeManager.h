@@ -1,32 +1,37 @@
 #ifndef __NODEMANAGER_H
 #define __NODEMANAGER_H
 
-#include <QMap>
+#include <QHash>
+#include <QList>
 #include <QObject>
 #include <QPointer>
-#include <QVariantMap>
+
+#include "EntityStore.h"
 
 class Node;
-class Server;
 
 
 class NodeManager : public QObject
 {
     Q_OBJECT
 public:
-	explicit NodeManager(Server* server, QObject *parent = 0);
+	explicit NodeManager(EntityStore* store, QObject *parent = 0);
+
+	Node* node(EntityHandle handle) const { return m_nodes.value(handle); }
+	/// Nodes without a parent
+	QList<Node*> roots() const;
+	void printTree() const;
 
 signals:
 
 private slots:
-	void on_server_add(const QVariantMap& entry);
+	/// Update the tree with all the changes of a transaction at once
+	void on_store_changed(const EntityChangeSet& changes);
 
 private:
-	QPointer<Server> m_server;
-	/// Root nodes, mapped by key
-	QMap<QString, Node*> m_roots;
-	/// All nodes, mapped by key
-	QMap<QString, Node*> m_nodes;
+	QPointer<EntityStore> m_store;
+	/// All nodes, mapped by entity handle
+	QHash<EntityHandle, Node*> m_nodes;
 };
 
 #endif
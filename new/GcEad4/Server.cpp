@@ -1,30 +1,74 @@
 #include "Server.h"
 
-#include <QtDebug>
-
 #include "Check.h"
 
 
+/// Column type for the values of a field, according to the type of its first value
+static ColumnType columnType(const QVariant& v) {
+	switch (v.type()) {
+	case QVariant::Bool:
+	case QVariant::Int:
+	case QVariant::UInt:
+	case QVariant::LongLong:
+	case QVariant::ULongLong:
+		return ColumnType_Int;
+	case QVariant::Double:
+		return ColumnType_Double;
+	default:
+		return ColumnType_String;
+	}
+}
+
+
 Server::Server(QObject *parent) :
     QObject(parent)
 {
+	m_store = new EntityStore(this);
 }
 
 void Server::add(const QVariantMap& entry) {
+	m_store->begin();
+	addEntry(entry);
+	m_store->commit();
+}
+
+void Server::addAll(const QList<QVariantMap>& entries) {
+	m_store->begin();
+	foreach (const QVariantMap& entry, entries) {
+		addEntry(entry);
+	}
+	m_store->commit();
+}
+
+void Server::addEntry(const QVariantMap& entry) {
 	CHECK_PARAM_RET(entry.contains(KEY));
 	const QString& sKey = entry.value(KEY).toString();
 	CHECK_PARAM_RET(!sKey.isEmpty());
 
-	m_database.insert(sKey, entry);
+	const bool bExisting = (m_store->find(sKey) != InvalidEntity);
+	const EntityHandle handle = m_store->add(sKey);
+	CHECK_PARAM_RET(handle != InvalidEntity);
 
-	qDebug() << "database:";
-	qDebug() << m_database;
+	for (QVariantMap::const_iterator it = entry.constBegin(); it != entry.constEnd(); ++it) {
+		if (it.key() == KEY)
+			continue;
+		int iColumn = m_store->column(it.key());
+		if (iColumn < 0)
+			iColumn = m_store->addColumn(it.key(), columnType(it.value()));
+		m_store->setValue(handle, iColumn, it.value());
+	}
 
-	emit entryAdded(entry);
+	// The entry replaces all fields of an existing one
+	if (bExisting) {
+		for (int iColumn = 0; iColumn < m_store->columnCount(); iColumn++) {
+			if (!entry.contains(m_store->columnName(iColumn)))
+				m_store->clearValue(handle, iColumn);
+		}
+	}
 }
 
 void Server::remove(const QString& key) {
-	CHECK_PARAM_RET(m_database.contains(key));
-	m_database.remove(key);
-	emit entriesRemoved(QStringList(key));
+	const EntityHandle handle = m_store->find(key);
+	CHECK_PARAM_RET(handle != InvalidEntity);
+	m_store->remove(handle);
 }
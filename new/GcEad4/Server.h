@@ -1,11 +1,12 @@
 #ifndef __SERVER_H
 #define __SERVER_H
 
+#include <QList>
 #include <QObject>
 #include <QVariantMap>
-#include <QStringList>
 
 #include "Defines.h"
+#include "EntityStore.h"
 
 
 class Server : public QObject
@@ -14,16 +15,21 @@ class Server : public QObject
 public:
 	explicit Server(QObject *parent = 0);
 
-signals:
-	void entryAdded(const QVariantMap& entry);
-	void entriesRemoved(const QStringList& keys);
+	/// Entities are kept in typed columns; listen to its changed() signal for updates
+	EntityStore* store() { return m_store; }
 
 public slots:
+	/// Add an entry, or replace the fields of an existing entry with the same key
 	void add(const QVariantMap& entry);
+	/// Add several entries in a single transaction, so that listeners are only notified once
+	void addAll(const QList<QVariantMap>& entries);
 	void remove(const QString& key);
 
 private:
-	QMap<QString, QVariantMap> m_database;
+	void addEntry(const QVariantMap& entry);
+
+private:
+	EntityStore* m_store;
 };
 
 #endif
@@ -2,13 +2,33 @@
 
 #include <QApplication>
 #include <QDateTime>
+#include <QStringList>
 
+#include "Benchmark.h"
+#include "EntityStoreTest.h"
 #include "MainWindow.h"
 
 
 int main(int argc, char *argv[])
 {
     QApplication a(argc, argv);
+
+	// "GcEad4 --benchmark [n...]" compares the EntityStore with the original QVariantMap design
+	const QStringList args = a.arguments();
+	if (args.size() >= 2 && args[1] == "--benchmark") {
+		QList<int> sizes;
+		for (int i = 2; i < args.size(); i++)
+			sizes << args[i].toInt();
+		if (sizes.isEmpty())
+			sizes << 100000 << 1000000;
+		foreach (int nEntities, sizes)
+			runBenchmark(nEntities);
+		return 0;
+	}
+	// "GcEad4 --test" checks the EntityStore, and fails if any of the checks fail
+	if (args.size() >= 2 && args[1] == "--test")
+		return (runEntityStoreTest() == 0) ? 0 : 1;
+
     MainWindow w;
     w.show();
 